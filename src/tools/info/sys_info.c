@@ -10,6 +10,7 @@
 
 #include "ucx_info.h"
 
+#include <ucs/arch/cpu.h>
 #include <ucs/sys/sys.h>
 #include <ucs/time/time.h>
 #include <sys/mman.h>
@@ -28,7 +29,14 @@ static const char* cpu_model_names[] = {
     [UCS_CPU_MODEL_ARM_AARCH64]       = "ARM 64-bit"
 };
 
-static double measure_memcpy_bandwidth(size_t size)
+typedef void (*memcpy_func_t)(void *dst, const void *src, size_t len);
+
+static void memcpy_libc(void *dst, const void *src, size_t len)
+{
+    memcpy(dst, src, len);
+}
+
+static double measure_memcpy_bandwidth(size_t size, memcpy_func_t memcpy_func)
 {
     ucs_time_t start_time, end_time;
     void *src, *dst;
@@ -47,12 +55,12 @@ static double measure_memcpy_bandwidth(size_t size)
 
     memset(dst, 0, size);
     memset(src, 0, size);
-    memcpy(dst, src, size);
+    memcpy_func(dst, src, size);
 
     iter = 0;
     start_time = ucs_get_time();
     do {
-        memcpy(dst, src, size);
+        memcpy_func(dst, src, size);
         end_time = ucs_get_time();
         ++iter;
     } while (end_time < start_time + ucs_time_from_sec(0.5));
@@ -68,14 +76,34 @@ out:
 
 void print_sys_info()
 {
-    size_t size;
+    size_t size, nt_thresh;
+    double bw, nt_bw;
 
     printf("# Timer frequency: %.3f MHz\n", ucs_get_cpu_clocks_per_sec() / 1e6);
     printf("# CPU model: %s\n", cpu_model_names[ucs_arch_get_cpu_model()]);
+    printf("# Last-level cache size: %zu\n", ucs_get_llc_size());
 
-    printf("# Memcpy bandwidth:\n");
+    /* Suggest the smallest size from which non-temporal copy is not slower
+     * than regular memcpy */
+    nt_thresh = UCS_CONFIG_MEMUNITS_INF;
+
+    printf("# Memcpy bandwidth (regular / non-temporal):\n");
     for (size = 4096; size <= 256 * UCS_MBYTE; size *= 2) {
-        printf("#     %10zu bytes: %.3f MB/s\n", size,
-               measure_memcpy_bandwidth(size) / UCS_MBYTE);
+        bw    = measure_memcpy_bandwidth(size, memcpy_libc);
+        nt_bw = measure_memcpy_bandwidth(size, ucs_memcpy_nontemporal);
+        printf("#     %10zu bytes: %.3f / %.3f MB/s\n", size, bw / UCS_MBYTE,
+               nt_bw / UCS_MBYTE);
+
+        if (nt_bw < bw) {
+            nt_thresh = UCS_CONFIG_MEMUNITS_INF;
+        } else if (nt_thresh == UCS_CONFIG_MEMUNITS_INF) {
+            nt_thresh = size;
+        }
+    }
+
+    if (nt_thresh == UCS_CONFIG_MEMUNITS_INF) {
+        printf("# Suggested UCX_MEMCPY_NT_THRESH: inf\n");
+    } else {
+        printf("# Suggested UCX_MEMCPY_NT_THRESH: %zu\n", nt_thresh);
     }
 }
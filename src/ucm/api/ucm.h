@@ -33,6 +33,7 @@ typedef enum ucm_event_type {
     UCM_EVENT_SHMDT           = UCS_BIT(4),
     UCM_EVENT_SBRK            = UCS_BIT(5),
     UCM_EVENT_MADVISE         = UCS_BIT(6),
+    UCM_EVENT_MPROTECT        = UCS_BIT(7),
 
     /* Aggregate events */
     UCM_EVENT_VM_MAPPED       = UCS_BIT(16),
@@ -149,6 +150,17 @@ typedef union ucm_event {
         int            advice;
     } madvise;
 
+    /*
+     * UCM_EVENT_MPROTECT
+     * mprotect() is called.
+     */
+    struct {
+        int            result;
+        void           *addr;
+        size_t         length;
+        int            prot;
+    } mprotect;
+
     /*
      * UCM_EVENT_VM_MAPPED, UCM_EVENT_VM_UNMAPPED
      *
@@ -354,6 +366,12 @@ int ucm_orig_brk(void *addr);
 int ucm_orig_madvise(void *addr, size_t length, int advice);
 
 
+/**
+ * @brief Call the original implementation of @ref mprotect without triggering events.
+ */
+int ucm_orig_mprotect(void *addr, size_t length, int prot);
+
+
 /**
  * @brief Call the original implementation of @ref mmap and all handlers
  * associated with it.
@@ -423,6 +441,13 @@ int ucm_brk(void *addr);
 int ucm_madvise(void *addr, size_t length, int advice);
 
 
+/**
+ * @brief Call the original implementation of @ref mprotect and all handlers
+ * associated with it.
+ */
+int ucm_mprotect(void *addr, size_t length, int prot);
+
+
 END_C_DECLS
 
 #endif
@@ -13,6 +13,7 @@
 
 #include <ucm/bistro/bistro.h>
 #include <ucm/bistro/bistro_int.h>
+#include <ucm/api/ucm.h>
 
 ucs_status_t ucm_bistro_remove_restore_point(ucm_bistro_restore_point_t *rp)
 {
@@ -32,7 +33,8 @@ static ucs_status_t ucm_bistro_protect(void *addr, size_t len, int prot)
     size_t size   = addr - aligned + len;
     int res;
 
-    res = mprotect(aligned, size, prot) ? UCS_ERR_INVALID_PARAM : UCS_OK;
+    /* mprotect() itself may be hooked or being patched, so do not call it */
+    res = ucm_orig_mprotect(aligned, size, prot) ? UCS_ERR_INVALID_PARAM : UCS_OK;
     if (res) {
         ucm_error("Failed to change page protection: %m");
         return UCS_ERR_INVALID_PARAM;
@@ -14,7 +14,7 @@
 #include <ucm/malloc/malloc_hook.h>
 #include <ucm/util/sys.h>
 #include <ucs/arch/cpu.h>
-#include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/shash.h>
 #include <ucs/sys/compiler.h>
 #include <ucs/sys/module.h>
 
@@ -28,14 +28,14 @@
 
 UCS_LIST_HEAD(ucm_event_installer_list);
 
-static pthread_spinlock_t ucm_kh_lock;
-#define ucm_ptr_hash(_ptr)  kh_int64_hash_func((uintptr_t)(_ptr))
-KHASH_INIT(ucm_ptr_size, const void*, size_t, 1, ucm_ptr_hash, kh_int64_hash_equal)
+static pthread_spinlock_t ucm_shmat_lock;
+UCS_SHASH_INIT(ucm_ptr_size, const void*, size_t, 1, ucs_shash_ptr_hash_func,
+               ucs_shash_equal)
 
 static pthread_rwlock_t ucm_event_lock = PTHREAD_RWLOCK_INITIALIZER;
 static ucs_list_link_t ucm_event_handlers;
 static int ucm_external_events = 0;
-static khash_t(ucm_ptr_size) ucm_shmat_ptrs;
+static ucs_shash_t(ucm_ptr_size) ucm_shmat_ptrs;
 
 static size_t ucm_shm_size(int shmid)
 {
@@ -102,6 +102,13 @@ static void ucm_event_call_orig(ucm_event_type_t event_type, ucm_event_t *event,
                                                      event->madvise.advice);
         }
         break;
+    case UCM_EVENT_MPROTECT:
+        if (event->mprotect.result == -1) {
+            event->mprotect.result = ucm_orig_mprotect(event->mprotect.addr,
+                                                       event->mprotect.length,
+                                                       event->mprotect.prot);
+        }
+        break;
     default:
         ucm_warn("Got unknown event %d", event_type);
         break;
@@ -116,7 +123,7 @@ static ucm_event_handler_t ucm_event_orig_handler = {
     .list     = UCS_LIST_INITIALIZER(&ucm_event_handlers, &ucm_event_handlers),
     .events   = UCM_EVENT_MMAP | UCM_EVENT_MUNMAP | UCM_EVENT_MREMAP |
                 UCM_EVENT_SHMAT | UCM_EVENT_SHMDT | UCM_EVENT_SBRK |
-                UCM_EVENT_MADVISE,      /* All events */
+                UCM_EVENT_MADVISE | UCM_EVENT_MPROTECT, /* All events */
     .priority = 0,                      /* Between negative and positive handlers */
     .cb       = ucm_event_call_orig
 };
@@ -266,7 +273,7 @@ void *ucm_shmat(int shmid, const void *shmaddr, int shmflg)
 {
     uintptr_t attach_addr;
     ucm_event_t event;
-    khiter_t iter;
+    ucs_shash_iter_t iter;
     size_t size;
     int result;
 
@@ -291,16 +298,17 @@ void *ucm_shmat(int shmid, const void *shmaddr, int shmflg)
     event.shmat.shmflg  = shmflg;
     ucm_event_dispatch(UCM_EVENT_SHMAT, &event);
 
-    pthread_spin_lock(&ucm_kh_lock);
+    pthread_spin_lock(&ucm_shmat_lock);
     if (event.shmat.result != MAP_FAILED) {
-        iter = kh_put(ucm_ptr_size, &ucm_shmat_ptrs, event.mmap.result, &result);
+        iter = ucs_shash_put(ucm_ptr_size, &ucm_shmat_ptrs, event.mmap.result,
+                             &result);
         if (result != -1) {
-            kh_value(&ucm_shmat_ptrs, iter) = size;
+            ucs_shash_value(&ucm_shmat_ptrs, iter) = size;
         }
-        pthread_spin_unlock(&ucm_kh_lock);
+        pthread_spin_unlock(&ucm_shmat_lock);
         ucm_dispatch_vm_mmap(event.shmat.result, size);
     } else {
-        pthread_spin_unlock(&ucm_kh_lock);
+        pthread_spin_unlock(&ucm_shmat_lock);
     }
 
     ucm_event_leave();
@@ -311,22 +319,22 @@ void *ucm_shmat(int shmid, const void *shmaddr, int shmflg)
 int ucm_shmdt(const void *shmaddr)
 {
     ucm_event_t event;
-    khiter_t iter;
+    ucs_shash_iter_t iter;
     size_t size;
 
     ucm_event_enter();
 
     ucm_debug("ucm_shmdt(shmaddr=%p)", shmaddr);
 
-    pthread_spin_lock(&ucm_kh_lock);
-    iter = kh_get(ucm_ptr_size, &ucm_shmat_ptrs, shmaddr);
-    if (iter != kh_end(&ucm_shmat_ptrs)) {
-        size = kh_value(&ucm_shmat_ptrs, iter);
-        kh_del(ucm_ptr_size, &ucm_shmat_ptrs, iter);
+    pthread_spin_lock(&ucm_shmat_lock);
+    iter = ucs_shash_get(ucm_ptr_size, &ucm_shmat_ptrs, shmaddr);
+    if (iter != ucs_shash_end(&ucm_shmat_ptrs)) {
+        size = ucs_shash_value(&ucm_shmat_ptrs, iter);
+        ucs_shash_del(ucm_ptr_size, &ucm_shmat_ptrs, iter);
     } else {
         size = ucm_get_shm_seg_size(shmaddr);
     }
-    pthread_spin_unlock(&ucm_kh_lock);
+    pthread_spin_unlock(&ucm_shmat_lock);
 
     ucm_dispatch_vm_munmap((void*)shmaddr, size);
 
@@ -433,6 +441,25 @@ int ucm_madvise(void *addr, size_t length, int advice)
     return event.madvise.result;
 }
 
+int ucm_mprotect(void *addr, size_t length, int prot)
+{
+    ucm_event_t event;
+
+    ucm_event_enter();
+
+    ucm_trace("ucm_mprotect(addr=%p length=%zu prot=0x%x)", addr, length, prot);
+
+    event.mprotect.result = -1;
+    event.mprotect.addr   = addr;
+    event.mprotect.length = length;
+    event.mprotect.prot   = prot;
+    ucm_event_dispatch(UCM_EVENT_MPROTECT, &event);
+
+    ucm_event_leave();
+
+    return event.mprotect.result;
+}
+
 void ucm_event_handler_add(ucm_event_handler_t *handler)
 {
     ucm_event_handler_t *elem;
@@ -585,11 +612,11 @@ void ucm_unset_event_handler(int events, ucm_event_callback_t cb, void *arg)
 }
 
 UCS_STATIC_INIT {
-    pthread_spin_init(&ucm_kh_lock, PTHREAD_PROCESS_PRIVATE);
-    kh_init_inplace(ucm_ptr_size, &ucm_shmat_ptrs);
+    pthread_spin_init(&ucm_shmat_lock, PTHREAD_PROCESS_PRIVATE);
+    ucs_shash_init_inplace(ucm_ptr_size, &ucm_shmat_ptrs);
 }
 
 UCS_STATIC_CLEANUP {
-    kh_destroy_inplace(ucm_ptr_size, &ucm_shmat_ptrs);
-    pthread_spin_destroy(&ucm_kh_lock);
+    ucs_shash_destroy_inplace(ucm_ptr_size, &ucm_shmat_ptrs);
+    pthread_spin_destroy(&ucm_shmat_lock);
 }
@@ -58,6 +58,7 @@ static ucm_mmap_func_t ucm_mmap_funcs[] = {
     { {"brk",     ucm_override_brk},     UCM_EVENT_SBRK,    0, UCM_HOOK_BISTRO},
 #endif
     { {"madvise", ucm_override_madvise}, UCM_EVENT_MADVISE, 0, UCM_HOOK_BOTH},
+    { {"mprotect", ucm_override_mprotect}, UCM_EVENT_MPROTECT, 0, UCM_HOOK_BOTH},
     { {NULL, NULL}, 0}
 };
 
@@ -100,6 +101,17 @@ void ucm_fire_mmap_events(int events)
             ucm_debug("mmap failed: %m");
         }
     }
+
+    if (events & UCM_EVENT_MPROTECT) {
+        p = mmap(NULL, ucm_get_page_size(), PROT_READ|PROT_WRITE,
+                 MAP_PRIVATE|MAP_ANON, -1, 0);
+        if (p != MAP_FAILED) {
+            mprotect(p, ucm_get_page_size(), PROT_READ);
+            munmap(p, ucm_get_page_size());
+        } else {
+            ucm_debug("mmap failed: %m");
+        }
+    }
 }
 
 /* Called with lock held */
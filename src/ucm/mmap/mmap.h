@@ -33,6 +33,7 @@ void *ucm_sbrk_select(intptr_t increment);
 int ucm_override_brk(void *addr);
 void *ucm_brk_syscall(void *addr);
 int ucm_override_madvise(void *addr, size_t length, int advice);
+int ucm_override_mprotect(void *addr, size_t length, int prot);
 void ucm_fire_mmap_events(int events);
 
 static UCS_F_ALWAYS_INLINE ucm_mmap_hook_mode_t ucm_mmap_hook_mode(void)
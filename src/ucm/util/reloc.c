@@ -17,6 +17,7 @@
 #include "reloc.h"
 
 #include <ucs/sys/compiler.h>
+#include <ucm/api/ucm.h>
 #include <ucm/util/log.h>
 #include <ucm/util/sys.h>
 
@@ -190,7 +191,9 @@ ucm_reloc_modify_got(ElfW(Addr) base, const ElfW(Phdr) *phdr, const char *phname
                       basename(phname), entry);
 
             page  = (void *)((intptr_t)entry & ~(page_size - 1));
-            ret = mprotect(page, page_size, PROT_READ|PROT_WRITE);
+            /* mprotect() may be hooked, and its hook must not be called
+             * while relocations are being patched */
+            ret = ucm_orig_mprotect(page, page_size, PROT_READ|PROT_WRITE);
             if (ret < 0) {
                 ucm_error("failed to modify GOT page %p to rw: %m", page);
                 return UCS_ERR_UNSUPPORTED;
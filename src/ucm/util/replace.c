@@ -34,11 +34,13 @@ UCM_DEFINE_REPLACE_FUNC(shmdt,   int,   -1,         const void*)
 UCM_DEFINE_REPLACE_FUNC(sbrk,    void*, MAP_FAILED, intptr_t)
 UCM_DEFINE_REPLACE_FUNC(brk,     int,   -1,         void*)
 UCM_DEFINE_REPLACE_FUNC(madvise, int,   -1,         void*, size_t, int)
+UCM_DEFINE_REPLACE_FUNC(mprotect, int,  -1,         void*, size_t, int)
 
 UCM_DEFINE_SELECT_FUNC(mmap, void*, MAP_FAILED, SYS_mmap, void*, size_t, int, int, int, off_t)
 UCM_DEFINE_SELECT_FUNC(munmap, int, -1, SYS_munmap, void*, size_t)
 UCM_DEFINE_SELECT_FUNC(mremap, void*, MAP_FAILED, SYS_mremap, void*, size_t, size_t, int)
 UCM_DEFINE_SELECT_FUNC(madvise, int, -1, SYS_madvise, void*, size_t, int)
+UCM_DEFINE_SELECT_FUNC(mprotect, int, -1, SYS_mprotect, void*, size_t, int)
 
 #if UCM_BISTRO_HOOKS
 #if HAVE_DECL_SYS_SHMAT
@@ -164,8 +164,34 @@ enum ucp_worker_params_field {
     UCP_WORKER_PARAM_FIELD_CPU_MASK     = UCS_BIT(1), /**< Worker's CPU bitmap */
     UCP_WORKER_PARAM_FIELD_EVENTS       = UCS_BIT(2), /**< Worker's events bitmap */
     UCP_WORKER_PARAM_FIELD_USER_DATA    = UCS_BIT(3), /**< User data */
-    UCP_WORKER_PARAM_FIELD_EVENT_FD     = UCS_BIT(4)  /**< External event file
+    UCP_WORKER_PARAM_FIELD_EVENT_FD     = UCS_BIT(4), /**< External event file
                                                            descriptor */
+    UCP_WORKER_PARAM_FIELD_FLAGS        = UCS_BIT(5)  /**< Worker flags */
+};
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief UCP worker creation flags.
+ *
+ * The enumeration list describes the flags which can be passed in
+ * @ref ucp_worker_params_t::flags.
+ */
+enum ucp_worker_params_flags {
+    /**
+     * Create a thread which progresses the worker in the background, so
+     * protocols such as rendezvous advance while the application does not
+     * call @ref ucp_worker_progress. The worker is created in
+     * UCS_THREAD_MODE_MULTI mode to be shared by the progress thread and the
+     * application. The thread is bound to @ref ucp_worker_params_t::cpu_mask,
+     * if it is set. If the context was created with @ref UCP_FEATURE_WAKEUP,
+     * the thread sleeps while there are no events on the worker, otherwise it
+     * polls the worker continuously. Since the thread uses the worker event
+     * file descriptor, @ref ucp_worker_get_efd, @ref ucp_worker_arm and
+     * @ref ucp_worker_wait return UCS_ERR_UNSUPPORTED on such a worker, and
+     * this flag cannot be combined with @ref ucp_worker_params_t::event_fd.
+     */
+    UCP_WORKER_PARAM_FLAG_PROGRESS_THREAD = UCS_BIT(0)
 };
 
 
@@ -486,6 +512,29 @@ typedef struct ucp_dt_iov {
 } ucp_dt_iov_t;
 
 
+/**
+ * @ingroup UCP_DATATYPE
+ * @brief Maximal number of levels of a strided datatype.
+ */
+#define UCP_DT_STRIDED_MAX_LEVELS 4
+
+
+/**
+ * @ingroup UCP_DATATYPE
+ * @brief Level of a strided data type.
+ *
+ * This structure describes one level of a strided datatype, which is
+ * created by @ref ucp_dt_create_strided "ucp_dt_create_strided()". The level
+ * consists of @a count items, each of them is an item of the lower level, or
+ * a contiguous block for the lowest level.
+ */
+typedef struct ucp_dt_strided_level {
+    size_t  count;    /**< Number of items in this level */
+    size_t  stride;   /**< Distance in bytes between the beginnings of
+                           consecutive items */
+} ucp_dt_strided_level_t;
+
+
 /**
  * @ingroup UCP_DATATYPE
  * @brief UCP generic data type descriptor
@@ -847,6 +896,14 @@ typedef struct ucp_worker_params {
      */
     int                     event_fd;
 
+    /**
+     * Worker flags, using bits from @ref ucp_worker_params_flags.
+     * This value is optional.
+     * If it's not set (along with its corresponding bit in the field_mask -
+     * UCP_WORKER_PARAM_FIELD_FLAGS), it will default to 0.
+     */
+    uint64_t                flags;
+
 } ucp_worker_params_t;
 
 
@@ -922,6 +979,31 @@ typedef struct {
     uint8_t     reserved[16];
 } ucp_stream_poll_ep_t;
 
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Output parameter of @ref ucp_worker_poll_completions function.
+ *
+ * The structure defines a completed request and the cookie which was
+ * associated with it by @ref ucp_request_set_cookie.
+ */
+typedef struct {
+    /**
+     * Completed request handle.
+     */
+    void         *request;
+
+    /**
+     * User cookie passed to @ref ucp_request_set_cookie.
+     */
+    void         *cookie;
+
+    /**
+     * Completion status of the request.
+     */
+    ucs_status_t status;
+} ucp_completion_t;
+
 /**
  * @ingroup UCP_MEM
  * @brief Tuning parameters for the UCP memory mapping.
@@ -1361,6 +1443,34 @@ ssize_t ucp_stream_worker_poll(ucp_worker_h worker,
                                unsigned flags);
 
 
+/**
+ * @ingroup UCP_WORKER
+ * @brief Poll for completed requests which have a user cookie.
+ *
+ * This non-blocking routine returns requests on a worker which were completed
+ * after a cookie was associated with them by @ref ucp_request_set_cookie. The
+ * completions are placed in @a entries array in the order of completion, and
+ * the function return value indicates how many are there. The routine does
+ * not progress communications, @ref ucp_worker_progress should be called to
+ * complete outstanding requests.
+ *
+ * The application is still responsible for releasing the returned requests
+ * using @ref ucp_request_free "ucp_request_free()".
+ *
+ * @param [in]   worker       Worker to poll.
+ * @param [out]  entries      Pointer to array of completions, should be
+ *                            allocated by user.
+ * @param [in]   max_entries  Maximal number of completions which should be
+ *                            filled in @a entries.
+ *
+ * @return Actual number of completions filled in @a entries array (less or
+ *         equal @a max_entries).
+ */
+unsigned ucp_worker_poll_completions(ucp_worker_h worker,
+                                     ucp_completion_t *entries,
+                                     unsigned max_entries);
+
+
 /**
  * @ingroup UCP_WAKEUP
  * @brief Obtain an event file descriptor for event notification.
@@ -1411,9 +1521,16 @@ ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd);
  * The second is by using this function to perform an internal wait for the next
  * event associated with the specified worker.
  *
- * @note During the blocking call the wake-up mechanism relies on other means of
+ * @note While blocked, the wake-up mechanism relies on other means of
  * notification and may not progress some of the requests as it would when
- * calling @ref ucp_worker_progress (which is not invoked in that duration).
+ * calling @ref ucp_worker_progress, which is not invoked while blocked.
+ *
+ * @note Before blocking, the routine may poll the worker for a short time, as
+ * configured by UCX_WAIT_SPIN_TIME, to avoid the wake-up latency when events
+ * arrive at a high rate. The polling calls @ref ucp_worker_progress, so
+ * request completion callbacks and active message handlers may be invoked
+ * from this routine. If the polling makes progress, the routine returns
+ * without blocking.
  *
  * @note UCP @ref ucp_feature "features" have to be triggered
  *   with @ref UCP_FEATURE_WAKEUP to select proper transport
@@ -2645,6 +2762,117 @@ ucs_status_ptr_t ucp_get_nb(ucp_ep_h ep, void *buffer, size_t length,
                             uint64_t remote_addr, ucp_rkey_h rkey,
                             ucp_send_callback_t cb);
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Create an RMA completion counter.
+ *
+ * This routine creates a @ref ucp_rma_counter_h "completion counter" on the
+ * worker, with an initial value of 0. The counter can be associated with
+ * remote memory access operations on any endpoint of the worker.
+ *
+ * @param [in]  worker      Worker whose operations are counted.
+ * @param [out] counter_p   Filled with a handle to the new counter.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_rma_counter_create(ucp_worker_h worker,
+                                    ucp_rma_counter_h *counter_p);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Destroy an RMA completion counter.
+ *
+ * @param [in]  counter     Counter to destroy. All the operations associated
+ *                          with the counter must be completed.
+ */
+void ucp_rma_counter_destroy(ucp_rma_counter_h counter);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Read the value of an RMA completion counter.
+ *
+ * This routine returns the number of operations associated with the counter
+ * which were completed locally. It does not progress the worker.
+ *
+ * @param [in]  counter     Counter to read.
+ *
+ * @return Number of completed operations.
+ */
+uint64_t ucp_rma_counter_read(ucp_rma_counter_h counter);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Wait until an RMA completion counter reaches a value.
+ *
+ * This routine progresses the worker of the counter until at least @a value
+ * operations associated with it are completed locally.
+ *
+ * @param [in]  counter     Counter to wait on.
+ * @param [in]  value       Number of completed operations to wait for.
+ *
+ * @return UCS_OK if all the counted operations completed successfully,
+ *         otherwise the error of the first one which failed.
+ */
+ucs_status_t ucp_rma_counter_wait(ucp_rma_counter_h counter, uint64_t value);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking remote memory put operation with a completion counter.
+ *
+ * This routine initiates a storage of contiguous block of data like
+ * @ref ucp_put_nbi "ucp_put_nbi()", and increments @a counter by one when the
+ * operation is completed locally, i.e. the local source address @e buffer can
+ * be reused.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  buffer       Pointer to the local source address.
+ * @param [in]  length       Length of the data (in bytes) stored under the
+ *                           source address.
+ * @param [in]  remote_addr  Pointer to the destination remote memory address
+ *                           to write to.
+ * @param [in]  rkey         Remote memory key associated with the
+ *                           remote memory address.
+ * @param [in]  counter      Completion counter created on the worker of @a ep.
+ *
+ * @return UCS_OK    - The operation was started, and its completion is
+ *                     counted by @a counter.
+ * @return otherwise - The operation failed and the counter is not updated.
+ */
+ucs_status_t ucp_put_nbc(ucp_ep_h ep, const void *buffer, size_t length,
+                         uint64_t remote_addr, ucp_rkey_h rkey,
+                         ucp_rma_counter_h counter);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking remote memory get operation with a completion counter.
+ *
+ * This routine initiates a load of contiguous block of data like
+ * @ref ucp_get_nbi "ucp_get_nbi()", and increments @a counter by one when the
+ * remote data is loaded and stored under the local address @e buffer.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  buffer       Pointer to the local destination address.
+ * @param [in]  length       Length of the data (in bytes) to load.
+ * @param [in]  remote_addr  Pointer to the source remote memory address
+ *                           to read from.
+ * @param [in]  rkey         Remote memory key associated with the
+ *                           remote memory address.
+ * @param [in]  counter      Completion counter created on the worker of @a ep.
+ *
+ * @return UCS_OK    - The operation was started, and its completion is
+ *                     counted by @a counter.
+ * @return otherwise - The operation failed and the counter is not updated.
+ */
+ucs_status_t ucp_get_nbc(ucp_ep_h ep, void *buffer, size_t length,
+                         uint64_t remote_addr, ucp_rkey_h rkey,
+                         ucp_rma_counter_h counter);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Post an atomic memory operation.
@@ -2738,6 +2966,32 @@ ucp_atomic_fetch_nb(ucp_ep_h ep, ucp_atomic_fetch_op_t opcode,
 ucs_status_t ucp_request_check_status(void *request);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Report the completion of non-blocking request to the worker
+ *        completion queue.
+ *
+ * This routine associates a user cookie with an outstanding request. When the
+ * request completes, it is added to the completion queue of @a worker, which
+ * is harvested by @ref ucp_worker_poll_completions. If the request is already
+ * completed, it is added to the completion queue immediately. A completion
+ * callback of the request, if any, is still invoked.
+ *
+ * If the request is released by @ref ucp_request_free before it completes,
+ * its completion is not reported. A request which was provided by the user,
+ * such as for @ref ucp_tag_recv_nbr, must not be reused before its completion
+ * is returned by @ref ucp_worker_poll_completions.
+ *
+ * @param [in]  worker      Worker which the request was posted on.
+ * @param [in]  request     Non-blocking request to report.
+ * @param [in]  cookie      User cookie to return with the completion.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_request_set_cookie(ucp_worker_h worker, void *request,
+                                    void *cookie);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Check the status and currently available state of non-blocking request
@@ -2853,6 +3107,44 @@ ucs_status_t ucp_dt_create_generic(const ucp_generic_dt_ops_t *ops, void *contex
                                    ucp_datatype_t *datatype_p);
 
 
+/**
+ * @ingroup UCP_DATATYPE
+ * @brief Create a strided datatype.
+ *
+ * This routine creates a strided (vector) datatype object, which describes
+ * contiguous blocks of @a blocklength bytes placed at regular distances in
+ * memory, for example a column of a matrix or a face of a multi-dimensional
+ * array. The blocks are described by up to @ref UCP_DT_STRIDED_MAX_LEVELS
+ * nested levels, starting from the innermost one. For example, a column of
+ * a row-major matrix of doubles with @a nrows rows and @a ncols columns is
+ * described by blocklength = sizeof(double) and a single level with
+ * count = @a nrows and stride = @a ncols * sizeof(double).
+ *
+ * When the datatype is used with a count of elements greater than 1, the
+ * elements are continuing the outermost level: element @a i starts at
+ * @a i * levels[num_levels - 1].count * levels[num_levels - 1].stride bytes
+ * from the beginning of the buffer.
+ * The application is responsible for releasing the @a datatype_p object using
+ * @ref ucp_dt_destroy "ucp_dt_destroy()" routine.
+ *
+ * @param [in]  blocklength  Size in bytes of a contiguous block.
+ * @param [in]  levels       Array of @a num_levels levels, the first one is
+ *                           the innermost.
+ * @param [in]  num_levels   Number of levels, up to
+ *                           @ref UCP_DT_STRIDED_MAX_LEVELS.
+ * @param [out] datatype_p   A pointer to datatype object.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ *
+ * @note In case of partial receive, any number of bytes can be filled
+ *       according to the blocks layout.
+ */
+ucs_status_t ucp_dt_create_strided(size_t blocklength,
+                                   const ucp_dt_strided_level_t *levels,
+                                   unsigned num_levels,
+                                   ucp_datatype_t *datatype_p);
+
+
 /**
  * @ingroup UCP_DATATYPE
  * @brief Destroy a datatype and release its resources.
@@ -2860,7 +3152,8 @@ ucs_status_t ucp_dt_create_generic(const ucp_generic_dt_ops_t *ops, void *contex
  * This routine destroys the @a datatype object and
  * releases any resources that are associated with the object.
  * The @a datatype object must be allocated using @ref ucp_dt_create_generic
- * "ucp_dt_create_generic()" routine.
+ * "ucp_dt_create_generic()" or @ref ucp_dt_create_strided
+ * "ucp_dt_create_strided()" routine.
  *
  * @warning
  * @li Once the @a datatype object is released an access to this object may
@@ -143,6 +143,18 @@ typedef enum {
 typedef struct ucp_rkey                  *ucp_rkey_h;
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief UCP RMA completion counter
+ *
+ * Completion counter is an opaque object which counts the local completions
+ * of the remote memory access operations associated with it, such as
+ * @ref ucp_put_nbc and @ref ucp_get_nbc. It allows waiting for a known number
+ * of outstanding operations without flushing the endpoint or the worker.
+ */
+typedef struct ucp_rma_counter           *ucp_rma_counter_h;
+
+
 /**
  * @ingroup UCP_MEM
  * @brief UCP Memory handle
@@ -113,6 +113,9 @@ enum ucp_cb_param_flags {
  * @param [in]  flags       Dictates how an Active Message is handled on the remote endpoint.
  *                          Currently only UCP_AM_FLAG_WHOLE_MSG is supported, which indicates
  *                          the callback will not be invoked until all data has arrived.
+ *                          If it is not set, the callback is invoked only for messages
+ *                          which are received in a single fragment, and larger messages
+ *                          are dropped.
  *
  * @return error code if the worker does not support active messages or 
  *         requested callback flags
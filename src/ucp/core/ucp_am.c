@@ -0,0 +1,887 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "ucp_am.h"
+
+#include <ucp/core/ucp_ep.h>
+#include <ucp/core/ucp_ep.inl>
+#include <ucp/core/ucp_worker.h>
+#include <ucp/core/ucp_context.h>
+#include <ucp/core/ucp_request.inl>
+#include <ucp/proto/proto_am.inl>
+#include <ucp/tag/rndv.h>
+#include <ucp/dt/dt.h>
+#include <ucp/dt/dt.inl>
+#include <ucs/datastruct/shash.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/profile/profile.h>
+#include <inttypes.h>
+
+
+/* Granularity of growing the callbacks array */
+#define UCP_AM_CB_BLOCK_SIZE 16
+
+
+UCS_SHASH_IMPL(ucp_am_unfinished, static UCS_F_MAYBE_UNUSED inline, uint64_t,
+               ucp_am_unfinished_t, 1, ucs_shash_int64_hash_func,
+               ucs_shash_equal);
+
+
+/* @verbatim
+ * Receive descriptor of an active message which the user may keep by returning
+ * UCS_INPROGRESS from the callback. It is always located right before the data
+ * which is passed to the callback, so @ref ucp_am_data_release can find it:
+ *
+ * Single fragment, received into UCT descriptor:
+ * |------------------------------------------------------------------------|
+ * | UCT headroom | \\\\ ucp_recv_desc_t \\\\\ | payload                    |
+ * |              | ucp_am_hdr_t/reply_hdr_t |                            |
+ * |------------------------------------------------------------------------|
+ *   The receive descriptor is shifted by the AM header size, and overwrites
+ *   the header which was already consumed. priv_length holds the negative
+ *   shift, so releasing the descriptor finds the start of the UCT descriptor.
+ *
+ * Multi-fragment or rendezvous, assembled into a buffer allocated by UCP:
+ * |------------------------------------------------------------------------|
+ * | ucp_recv_desc_t (UCP_RECV_DESC_FLAG_MALLOC) | payload                  |
+ * |------------------------------------------------------------------------|
+ * @endverbatim
+ */
+
+
+void ucp_am_ep_init(ucp_ep_h ep)
+{
+    ucp_ep_ext_proto_t *ep_ext = ucp_ep_ext_proto(ep);
+
+    if (ep->worker->context->config.features & UCP_FEATURE_AM) {
+        ep_ext->am.started_ams = NULL;
+    }
+}
+
+void ucp_am_ep_cleanup(ucp_ep_h ep)
+{
+    ucp_ep_ext_proto_t *ep_ext = ucp_ep_ext_proto(ep);
+    ucp_am_unfinished_t unfinished;
+    uint64_t msg_id;
+    unsigned count;
+
+    if (!(ep->worker->context->config.features & UCP_FEATURE_AM) ||
+        (ep_ext->am.started_ams == NULL)) {
+        return;
+    }
+
+    count = ucs_shash_size(ep_ext->am.started_ams);
+    ucs_shash_foreach(ep_ext->am.started_ams, msg_id, unfinished, {
+        ucs_trace("ep %p: drop active message msg_id %"PRIu64, ep, msg_id);
+        ucs_free(unfinished.all_data);
+    });
+    ucs_shash_destroy_inplace(ucp_am_unfinished, ep_ext->am.started_ams);
+    ucs_free(ep_ext->am.started_ams);
+    ep_ext->am.started_ams = NULL;
+
+    if (count > 0) {
+        ucs_warn("ep %p: dropped %u partially received active messages", ep,
+                 count);
+    }
+}
+
+UCS_PROFILE_FUNC_VOID(ucp_am_data_release, (worker, data),
+                      ucp_worker_h worker, void *data)
+{
+    ucp_recv_desc_t *rdesc = (ucp_recv_desc_t*)data - 1;
+
+    ucs_trace_data("worker %p: release am data %p", worker, data);
+
+    if (rdesc->flags & UCP_RECV_DESC_FLAG_MALLOC) {
+        ucs_free(rdesc);
+        return;
+    }
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    ucp_recv_desc_release(rdesc);
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_set_am_handler,
+                 (worker, id, cb, arg, flags),
+                 ucp_worker_h worker, uint16_t id, ucp_am_callback_t cb,
+                 void *arg, uint32_t flags)
+{
+    ucp_worker_am_entry_t *am_cbs;
+    unsigned num_entries;
+    ucs_status_t status;
+
+    UCP_CONTEXT_CHECK_FEATURE_FLAGS(worker->context, UCP_FEATURE_AM,
+                                    return UCS_ERR_INVALID_PARAM);
+
+    if (flags & ~UCP_AM_FLAG_WHOLE_MSG) {
+        ucs_error("unsupported active message callback flags 0x%x", flags);
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+
+    if (id >= worker->am_cb_array_len) {
+        num_entries = ucs_align_up_pow2(id + 1, UCP_AM_CB_BLOCK_SIZE);
+        am_cbs      = ucs_realloc(worker->am_cbs,
+                                  num_entries * sizeof(*am_cbs),
+                                  "ucp_am_cbs");
+        if (am_cbs == NULL) {
+            ucs_error("failed to grow active message callbacks array to %u",
+                      num_entries);
+            status = UCS_ERR_NO_MEMORY;
+            goto out;
+        }
+
+        memset(am_cbs + worker->am_cb_array_len, 0,
+               (num_entries - worker->am_cb_array_len) * sizeof(*am_cbs));
+        worker->am_cbs          = am_cbs;
+        worker->am_cb_array_len = num_entries;
+    }
+
+    worker->am_cbs[id].cb      = cb;
+    worker->am_cbs[id].context = arg;
+    worker->am_cbs[id].flags   = flags;
+    status                     = UCS_OK;
+
+out:
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+    return status;
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_am_handler_is_set(ucp_worker_h worker, uint16_t am_id)
+{
+    return (am_id < worker->am_cb_array_len) &&
+           (worker->am_cbs[am_id].cb != NULL);
+}
+
+/* A message which does not fit a single fragment can be passed only to a
+ * callback which was registered with UCP_AM_FLAG_WHOLE_MSG */
+static int ucp_am_handler_check_whole_msg(ucp_worker_h worker, uint16_t am_id)
+{
+    if (ucs_likely(worker->am_cbs[am_id].flags & UCP_AM_FLAG_WHOLE_MSG)) {
+        return 1;
+    }
+
+    ucs_warn("active message with id %u was dropped, because it consists of "
+             "multiple fragments, and its callback was not registered with "
+             "UCP_AM_FLAG_WHOLE_MSG", am_id);
+    return 0;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_am_invoke_cb(ucp_worker_h worker, uint16_t am_id, void *data,
+                 size_t length, ucp_ep_h reply_ep, unsigned flags)
+{
+    ucp_worker_am_entry_t *am_cb = &worker->am_cbs[am_id];
+
+    return am_cb->cb(am_cb->context, data, length, reply_ep, flags);
+}
+
+static UCS_F_ALWAYS_INLINE void ucp_am_fill_hdr(ucp_am_hdr_t *hdr, uint16_t id,
+                                                uint16_t flags)
+{
+    hdr->am_hdr.am_id   = id;
+    hdr->am_hdr.flags   = flags;
+    hdr->am_hdr.padding = 0;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_am_send_short(ucp_ep_h ep, uint16_t id, const void *payload, size_t length)
+{
+    ucp_am_hdr_t hdr;
+
+    UCS_STATIC_ASSERT(sizeof(ucp_am_hdr_t) == sizeof(uint64_t));
+    ucp_am_fill_hdr(&hdr, id, 0);
+    return uct_ep_am_short(ucp_ep_get_am_uct_ep(ep), UCP_AM_ID_SINGLE, hdr.u64,
+                           (void*)payload, length);
+}
+
+static ucs_status_t ucp_am_contig_short(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_am_hdr_t hdr;
+    ucs_status_t status;
+
+    hdr.u64 = req->send.tag.tag;
+    status  = ucp_am_send_short(req->send.ep, hdr.am_hdr.am_id,
+                                req->send.buffer, req->send.length);
+    if (ucs_likely(status == UCS_OK)) {
+        ucp_request_complete_send(req, UCS_OK);
+    }
+    return status;
+}
+
+static size_t ucp_am_pack_data_single(void *dest, ucp_request_t *req)
+{
+    size_t length;
+
+    ucs_assert(req->send.state.dt.offset == 0);
+
+    length = ucp_dt_pack(req->send.ep->worker, req->send.datatype,
+                         req->send.mem_type, dest, req->send.buffer,
+                         &req->send.state.dt, req->send.length,
+                         ucp_request_pack_nontemporal(req));
+    ucs_assert(length == req->send.length);
+    return length;
+}
+
+static size_t ucp_am_bcopy_pack_args_single(void *dest, void *arg)
+{
+    ucp_am_hdr_t  *hdr = dest;
+    ucp_request_t *req = arg;
+
+    hdr->u64 = req->send.tag.tag;
+    return sizeof(*hdr) + ucp_am_pack_data_single(hdr + 1, req);
+}
+
+static size_t ucp_am_bcopy_pack_args_single_reply(void *dest, void *arg)
+{
+    ucp_am_reply_hdr_t *reply_hdr = dest;
+    ucp_request_t      *req       = arg;
+
+    reply_hdr->super.u64 = req->send.tag.tag;
+    reply_hdr->ep_ptr    = ucp_request_get_dest_ep_ptr(req);
+    return sizeof(*reply_hdr) + ucp_am_pack_data_single(reply_hdr + 1, req);
+}
+
+static void ucp_am_fill_long_hdr(ucp_am_long_hdr_t *hdr, ucp_request_t *req)
+{
+    ucp_am_hdr_t am_hdr;
+
+    am_hdr.u64      = req->send.tag.tag;
+    hdr->ep_ptr     = ucp_request_get_dest_ep_ptr(req);
+    hdr->msg_id     = req->send.tag.message_id;
+    hdr->total_size = req->send.length;
+    hdr->offset     = req->send.state.dt.offset;
+    hdr->am_id      = am_hdr.am_hdr.am_id;
+    hdr->flags      = am_hdr.am_hdr.flags;
+}
+
+static size_t ucp_am_bcopy_pack_args_multi(void *dest, void *arg)
+{
+    ucp_am_long_hdr_t *hdr = dest;
+    ucp_request_t     *req = arg;
+    size_t            length;
+
+    ucp_am_fill_long_hdr(hdr, req);
+    length = ucs_min(ucp_ep_get_max_bcopy(req->send.ep, req->send.lane) -
+                     sizeof(*hdr), req->send.length - hdr->offset);
+
+    return sizeof(*hdr) + ucp_dt_pack(req->send.ep->worker, req->send.datatype,
+                                      req->send.mem_type, hdr + 1,
+                                      req->send.buffer, &req->send.state.dt,
+                                      length,
+                                      ucp_request_pack_nontemporal(req));
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_am_bcopy_single_common(uct_pending_req_t *self, uint8_t am_id,
+                           uct_pack_callback_t pack_cb)
+{
+    ucs_status_t status;
+
+    status = ucp_do_am_bcopy_single(self, am_id, pack_cb);
+    if (status == UCS_OK) {
+        ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+        ucp_request_send_generic_dt_finish(req);
+        ucp_request_complete_send(req, UCS_OK);
+    }
+    return status;
+}
+
+static ucs_status_t ucp_am_bcopy_single(uct_pending_req_t *self)
+{
+    return ucp_am_bcopy_single_common(self, UCP_AM_ID_SINGLE,
+                                      ucp_am_bcopy_pack_args_single);
+}
+
+static ucs_status_t ucp_am_bcopy_single_reply(uct_pending_req_t *self)
+{
+    return ucp_am_bcopy_single_common(self, UCP_AM_ID_SINGLE_REPLY,
+                                      ucp_am_bcopy_pack_args_single_reply);
+}
+
+static ucs_status_t ucp_am_bcopy_multi(uct_pending_req_t *self)
+{
+    ucs_status_t status = ucp_do_am_bcopy_multi(self, UCP_AM_ID_MULTI,
+                                                UCP_AM_ID_MULTI,
+                                                sizeof(ucp_am_long_hdr_t),
+                                                ucp_am_bcopy_pack_args_multi,
+                                                ucp_am_bcopy_pack_args_multi, 1);
+    if (status == UCS_OK) {
+        ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+        ucp_request_send_generic_dt_finish(req);
+        ucp_request_complete_send(req, UCS_OK);
+    } else if (status == UCP_STATUS_PENDING_SWITCH) {
+        status = UCS_OK;
+    }
+    return status;
+}
+
+static ucs_status_t ucp_am_zcopy_single(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_am_hdr_t  hdr;
+
+    hdr.u64 = req->send.tag.tag;
+    return ucp_do_am_zcopy_single(self, UCP_AM_ID_SINGLE, &hdr, sizeof(hdr),
+                                  ucp_proto_am_zcopy_req_complete);
+}
+
+static ucs_status_t ucp_am_zcopy_single_reply(uct_pending_req_t *self)
+{
+    ucp_request_t      *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_am_reply_hdr_t reply_hdr;
+
+    reply_hdr.super.u64 = req->send.tag.tag;
+    reply_hdr.ep_ptr    = ucp_request_get_dest_ep_ptr(req);
+    return ucp_do_am_zcopy_single(self, UCP_AM_ID_SINGLE_REPLY, &reply_hdr,
+                                  sizeof(reply_hdr),
+                                  ucp_proto_am_zcopy_req_complete);
+}
+
+static ucs_status_t ucp_am_zcopy_multi(uct_pending_req_t *self)
+{
+    ucp_request_t     *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_am_long_hdr_t hdr;
+
+    /* Every call sends a single fragment, so the offset is up-to-date */
+    ucp_am_fill_long_hdr(&hdr, req);
+    return ucp_do_am_zcopy_multi(self, UCP_AM_ID_MULTI, UCP_AM_ID_MULTI,
+                                 &hdr, sizeof(hdr), &hdr, sizeof(hdr),
+                                 ucp_proto_am_zcopy_req_complete, 1);
+}
+
+static void ucp_am_send_req_init(ucp_request_t *req, ucp_ep_h ep,
+                                 const void *buffer, uintptr_t datatype,
+                                 size_t count, uint16_t am_id, uint16_t flags)
+{
+    ucp_am_hdr_t hdr;
+
+    ucp_am_fill_hdr(&hdr, am_id, flags);
+
+    req->flags             = 0;
+    req->send.ep           = ep;
+    req->send.buffer       = (void*)buffer;
+    req->send.datatype     = datatype;
+    req->send.tag.tag      = hdr.u64;
+    req->send.lane         = ep->am_lane;
+    ucp_request_send_state_init(req, datatype, count);
+    req->send.length       = ucp_dt_length(req->send.datatype, count,
+                                           req->send.buffer,
+                                           &req->send.state.dt);
+    ucp_request_send_nontemporal_init(req);
+    ucp_memory_type_detect_mds(ep->worker->context, (void*)buffer,
+                               req->send.length, &req->send.mem_type);
+}
+
+static UCS_F_ALWAYS_INLINE size_t
+ucp_am_get_rndv_threshold(const ucp_request_t *req)
+{
+    const ucp_ep_config_t *config = ucp_ep_config(req->send.ep);
+
+    if (UCP_DT_IS_GENERIC(req->send.datatype)) {
+        return config->tag.rndv.am_thresh;
+    }
+
+    return ucs_min(config->tag.rndv.rma_thresh, config->tag.rndv.am_thresh);
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_ptr_t
+ucp_am_send_req(ucp_request_t *req, size_t count,
+                const ucp_ep_msg_config_t *msg_config, ssize_t max_short,
+                ucp_send_callback_t cb, const ucp_proto_t *proto)
+{
+    size_t rndv_thresh  = ucp_am_get_rndv_threshold(req);
+    size_t zcopy_thresh = ucp_proto_get_zcopy_threshold(req, msg_config,
+                                                        count, rndv_thresh);
+    ucs_status_t status;
+
+    ucs_trace_req("select am request(%p) progress algorithm datatype=%lx "
+                  "buffer=%p length=%zu max_short=%zd rndv_thresh=%zu "
+                  "zcopy_thresh=%zu", req, req->send.datatype,
+                  req->send.buffer, req->send.length, max_short, rndv_thresh,
+                  zcopy_thresh);
+
+    status = ucp_request_send_start(req, max_short, zcopy_thresh, rndv_thresh,
+                                    count, msg_config, proto);
+    if (ucs_unlikely(status != UCS_OK)) {
+        if (status == UCS_ERR_NO_PROGRESS) {
+            /* RMA/AM rendezvous */
+            ucs_assert(req->send.length >= rndv_thresh);
+            status = ucp_am_send_start_rndv(req);
+        }
+
+        if (status != UCS_OK) {
+            ucp_request_put(req);
+            return UCS_STATUS_PTR(status);
+        }
+    }
+
+    /*
+     * Start the request.
+     * If it is completed immediately, release the request and return the status.
+     * Otherwise, return the request.
+     */
+    status = ucp_request_send(req, 0);
+    if (req->flags & UCP_REQUEST_FLAG_COMPLETED) {
+        ucs_trace_req("releasing send request %p, returning status %s", req,
+                      ucs_status_string(status));
+        ucp_request_put(req);
+        return UCS_STATUS_PTR(status);
+    }
+
+    ucp_request_set_callback(req, send.cb, cb)
+    ucs_trace_req("returning send request %p", req);
+    return req + 1;
+}
+
+UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_am_send_nb,
+                 (ep, id, payload, count, datatype, cb, flags),
+                 ucp_ep_h ep, uint16_t id, const void *payload,
+                 size_t count, uintptr_t datatype,
+                 ucp_send_callback_t cb, unsigned flags)
+{
+    ucp_request_t    *req;
+    size_t           length;
+    ucs_status_t     status;
+    ucs_status_ptr_t ret;
+
+    UCP_CONTEXT_CHECK_FEATURE_FLAGS(ep->worker->context, UCP_FEATURE_AM,
+                                    return UCS_STATUS_PTR(UCS_ERR_INVALID_PARAM));
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(ep->worker);
+
+    ucs_trace_req("am_send_nb id %u buffer %p count %zu to %s cb %p flags %u",
+                  id, payload, count, ucp_ep_peer_name(ep), cb, flags);
+
+    if (ucs_unlikely(flags & ~UCP_AM_SEND_REPLY)) {
+        ret = UCS_STATUS_PTR(UCS_ERR_INVALID_PARAM);
+        goto out;
+    }
+
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        ret = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
+    status = ucp_ep_resolve_dest_ep_ptr(ep, ep->am_lane);
+    if (status != UCS_OK) {
+        ret = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
+    if (ucs_likely(!(flags & UCP_AM_SEND_REPLY) &&
+                   UCP_DT_IS_CONTIG(datatype))) {
+        length = ucp_contig_dt_length(datatype, count);
+        if (ucs_likely((ssize_t)length <= ucp_ep_config(ep)->am.max_short)) {
+            status = UCS_PROFILE_CALL(ucp_am_send_short, ep, id, payload,
+                                      length);
+            if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
+                ret = UCS_STATUS_PTR(status); /* UCS_OK also goes here */
+                goto out;
+            }
+        }
+    }
+
+    req = ucp_request_get(ep->worker);
+    if (ucs_unlikely(req == NULL)) {
+        ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+        goto out;
+    }
+
+    ucp_am_send_req_init(req, ep, payload, datatype, count, id, flags);
+
+    if (flags & UCP_AM_SEND_REPLY) {
+        /* Reply header does not fit into the 64-bit header of short AM */
+        ret = ucp_am_send_req(req, count, &ucp_ep_config(ep)->am, -1, cb,
+                              ucp_ep_config(ep)->am_u.reply_proto);
+    } else {
+        ret = ucp_am_send_req(req, count, &ucp_ep_config(ep)->am,
+                              ucp_proto_get_short_max(req,
+                                                      &ucp_ep_config(ep)->am),
+                              cb, ucp_ep_config(ep)->am_u.proto);
+    }
+
+out:
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(ep->worker);
+    return ret;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_am_handler_common(ucp_worker_h worker, void *hdr_end, size_t hdr_size,
+                      size_t total_length, ucp_ep_h reply_ep, uint16_t am_id,
+                      unsigned am_flags)
+{
+    ucp_recv_desc_t *rdesc;
+    unsigned flags;
+    ucs_status_t status;
+
+    if (ucs_unlikely(!ucp_am_handler_is_set(worker, am_id))) {
+        ucs_warn("active message with id %u was dropped, because there is "
+                 "no registered callback for it", am_id);
+        return UCS_OK;
+    }
+
+    flags  = (am_flags & UCT_CB_PARAM_FLAG_DESC) ? UCP_CB_PARAM_FLAG_DATA : 0;
+    status = ucp_am_invoke_cb(worker, am_id, hdr_end, total_length - hdr_size,
+                              reply_ep, flags);
+    if (ucs_likely(status != UCS_INPROGRESS)) {
+        return UCS_OK;
+    }
+
+    if (ucs_unlikely(!(am_flags & UCT_CB_PARAM_FLAG_DESC))) {
+        ucs_error("active message callback id %u returned UCS_INPROGRESS "
+                  "without UCP_CB_PARAM_FLAG_DATA", am_id);
+        return UCS_OK;
+    }
+
+    /* Keep the UCT descriptor, see the layout description above */
+    rdesc                 = (ucp_recv_desc_t*)hdr_end - 1;
+    rdesc->flags          = UCP_RECV_DESC_FLAG_UCT_DESC;
+    rdesc->priv_length    = -(int16_t)hdr_size;
+    rdesc->length         = total_length - hdr_size;
+    rdesc->payload_offset = 0;
+    return UCS_INPROGRESS;
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_am_handler,
+                 (am_arg, am_data, am_length, am_flags),
+                 void *am_arg, void *am_data, size_t am_length,
+                 unsigned am_flags)
+{
+    ucp_worker_h worker = am_arg;
+    ucp_am_hdr_t *hdr   = am_data;
+
+    ucs_assert(am_length >= sizeof(*hdr));
+
+    return ucp_am_handler_common(worker, hdr + 1, sizeof(*hdr), am_length,
+                                 NULL, hdr->am_hdr.am_id, am_flags);
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_am_handler_reply,
+                 (am_arg, am_data, am_length, am_flags),
+                 void *am_arg, void *am_data, size_t am_length,
+                 unsigned am_flags)
+{
+    ucp_worker_h       worker    = am_arg;
+    ucp_am_reply_hdr_t *hdr      = am_data;
+    ucp_ep_h           reply_ep;
+
+    ucs_assert(am_length >= sizeof(*hdr));
+
+    reply_ep = ucp_worker_get_ep_by_ptr(worker, hdr->ep_ptr);
+    return ucp_am_handler_common(worker, hdr + 1, sizeof(*hdr), am_length,
+                                 reply_ep, hdr->super.am_hdr.am_id, am_flags);
+}
+
+static ucp_recv_desc_t*
+ucp_am_alloc_all_data(const ucp_am_long_hdr_t *long_hdr)
+{
+    ucp_recv_desc_t *all_data;
+
+    all_data = ucs_malloc(sizeof(*all_data) + long_hdr->total_size,
+                          "ucp_am_all_data");
+    if (all_data == NULL) {
+        ucs_error("failed to allocate %zu bytes for active message id %u, "
+                  "dropping it", long_hdr->total_size, long_hdr->am_id);
+        return NULL;
+    }
+
+    all_data->flags          = UCP_RECV_DESC_FLAG_MALLOC;
+    all_data->length         = long_hdr->total_size;
+    all_data->payload_offset = 0;
+    return all_data;
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_am_long_handler,
+                 (am_arg, am_data, am_length, am_flags),
+                 void *am_arg, void *am_data, size_t am_length,
+                 unsigned am_flags)
+{
+    ucp_worker_h        worker      = am_arg;
+    ucp_am_long_hdr_t   *long_hdr   = am_data;
+    size_t              frag_length = am_length - sizeof(*long_hdr);
+    ucp_am_unfinished_t *unfinished;
+    ucp_recv_desc_t     *all_data;
+    ucp_ep_ext_proto_t  *ep_ext;
+    ucs_shash_t(ucp_am_unfinished) *started_ams;
+    ucs_shash_iter_t    iter;
+    ucp_ep_h            ep;
+    ucs_status_t        status;
+    int                 ret;
+
+    ucs_assert(am_length >= sizeof(*long_hdr));
+    ucs_assert(long_hdr->offset + frag_length <= long_hdr->total_size);
+
+    ep     = ucp_worker_get_ep_by_ptr(worker, long_hdr->ep_ptr);
+    ep_ext = ucp_ep_ext_proto(ep);
+    if (ucs_unlikely(ep_ext->am.started_ams == NULL)) {
+        ep_ext->am.started_ams = ucs_malloc(sizeof(*ep_ext->am.started_ams),
+                                            "ucp_am_started_ams");
+        if (ep_ext->am.started_ams == NULL) {
+            ucs_error("failed to allocate active messages hash");
+            return UCS_OK;
+        }
+
+        ucs_shash_init_inplace(ucp_am_unfinished, ep_ext->am.started_ams);
+    }
+
+    started_ams = ep_ext->am.started_ams;
+    iter        = ucs_shash_get(ucp_am_unfinished, started_ams,
+                                long_hdr->msg_id);
+    if (iter == ucs_shash_end(started_ams)) {
+        iter = ucs_shash_put(ucp_am_unfinished, started_ams,
+                             long_hdr->msg_id, &ret);
+        if (ucs_unlikely(ret < 0)) {
+            ucs_error("failed to track active message id %u msg_id %"PRIu64,
+                      long_hdr->am_id, long_hdr->msg_id);
+            return UCS_OK;
+        }
+
+        /* If the message is dropped, keep the entry with NULL data until all
+         * its fragments arrive, so they would not start a new message */
+        unfinished = &ucs_shash_value(started_ams, iter);
+        unfinished->left = long_hdr->total_size;
+        if (ucs_unlikely(!ucp_am_handler_is_set(worker, long_hdr->am_id))) {
+            ucs_warn("active message with id %u was dropped, because there "
+                     "is no registered callback for it", long_hdr->am_id);
+            unfinished->all_data = NULL;
+        } else if (ucs_unlikely(!ucp_am_handler_check_whole_msg(worker,
+                                                       long_hdr->am_id))) {
+            unfinished->all_data = NULL;
+        } else {
+            unfinished->all_data = ucp_am_alloc_all_data(long_hdr);
+        }
+    } else {
+        unfinished = &ucs_shash_value(started_ams, iter);
+    }
+
+    ucs_assert(unfinished->left >= frag_length);
+    all_data          = unfinished->all_data;
+    unfinished->left -= frag_length;
+    if (all_data != NULL) {
+        memcpy(UCS_PTR_BYTE_OFFSET(all_data + 1, long_hdr->offset),
+               long_hdr + 1, frag_length);
+    }
+
+    if (unfinished->left > 0) {
+        return UCS_OK;
+    }
+
+    /* Last fragment arrived, the whole message is ready */
+    ucs_shash_del(ucp_am_unfinished, started_ams, iter);
+    if (all_data == NULL) {
+        return UCS_OK;
+    }
+
+    if (ucs_unlikely(!ucp_am_handler_is_set(worker, long_hdr->am_id))) {
+        ucs_warn("active message with id %u was dropped, because its "
+                 "callback was removed", long_hdr->am_id);
+        ucs_free(all_data);
+        return UCS_OK;
+    }
+
+    status = ucp_am_invoke_cb(worker, long_hdr->am_id, all_data + 1,
+                              long_hdr->total_size,
+                              (long_hdr->flags & UCP_AM_SEND_REPLY) ? ep : NULL,
+                              UCP_CB_PARAM_FLAG_DATA);
+    if (status != UCS_INPROGRESS) {
+        ucs_free(all_data);
+    }
+
+    return UCS_OK;
+}
+
+static void ucp_am_rndv_recv_completed(void *request, ucs_status_t status,
+                                       ucp_tag_recv_info_t *info)
+{
+    ucp_request_t   *rreq  = (ucp_request_t*)request - 1;
+    ucp_worker_h    worker = rreq->recv.worker;
+    ucp_recv_desc_t *rdesc;
+    ucp_am_hdr_t    am_hdr;
+    ucp_ep_h        reply_ep;
+
+    if (rreq->recv.buffer == NULL) {
+        /* The message was dropped when rendezvous started */
+        return;
+    }
+
+    rdesc      = (ucp_recv_desc_t*)rreq->recv.buffer - 1;
+    am_hdr.u64 = info->sender_tag;
+
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_error("failed to receive active message id %u: %s",
+                  am_hdr.am_hdr.am_id, ucs_status_string(status));
+        ucs_free(rdesc);
+        return;
+    }
+
+    if (ucs_unlikely(!ucp_am_handler_is_set(worker, am_hdr.am_hdr.am_id))) {
+        ucs_warn("active message with id %u was dropped, because its "
+                 "callback was removed", am_hdr.am_hdr.am_id);
+        ucs_free(rdesc);
+        return;
+    }
+
+    reply_ep = (am_hdr.am_hdr.flags & UCP_AM_SEND_REPLY) ?
+               rdesc->am_reply_ep : NULL;
+    status   = ucp_am_invoke_cb(worker, am_hdr.am_hdr.am_id, rdesc + 1,
+                                info->length, reply_ep, UCP_CB_PARAM_FLAG_DATA);
+    if (status != UCS_INPROGRESS) {
+        ucs_free(rdesc);
+    }
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_am_rndv_rts_handler,
+                 (am_arg, am_data, am_length, am_flags),
+                 void *am_arg, void *am_data, size_t am_length,
+                 unsigned am_flags)
+{
+    ucp_worker_h       worker       = am_arg;
+    ucp_rndv_rts_hdr_t *rndv_rts_hdr = am_data;
+    ucp_recv_desc_t    *rdesc;
+    ucp_request_t      *rreq;
+    ucp_am_hdr_t       am_hdr;
+
+    am_hdr.u64 = rndv_rts_hdr->super.tag;
+
+    rreq = ucp_request_get(worker);
+    if (rreq == NULL) {
+        ucs_error("failed to allocate receive request for active message");
+        return UCS_OK;
+    }
+
+    /* The data is fetched directly to the buffer, which is then passed to the
+     * callback. If the message is dropped, rendezvous completes as truncated
+     * and releases the sender. */
+    if (ucs_unlikely(!ucp_am_handler_is_set(worker, am_hdr.am_hdr.am_id))) {
+        ucs_warn("active message with id %u was dropped, because there is "
+                 "no registered callback for it", am_hdr.am_hdr.am_id);
+        rdesc = NULL;
+    } else if (ucs_unlikely(!ucp_am_handler_check_whole_msg(worker,
+                                                   am_hdr.am_hdr.am_id))) {
+        rdesc = NULL;
+    } else {
+        rdesc = ucs_malloc(sizeof(*rdesc) + rndv_rts_hdr->size,
+                           "ucp_am_rndv_data");
+        if (rdesc == NULL) {
+            ucs_error("failed to allocate %zu bytes for active message id %u",
+                      rndv_rts_hdr->size, am_hdr.am_hdr.am_id);
+        }
+    }
+
+    if (rdesc != NULL) {
+        rdesc->flags          = UCP_RECV_DESC_FLAG_MALLOC;
+        rdesc->length         = rndv_rts_hdr->size;
+        rdesc->payload_offset = 0;
+        rdesc->am_reply_ep    = ucp_worker_get_ep_by_ptr(worker,
+                                                     rndv_rts_hdr->sreq.ep_ptr);
+        rreq->recv.buffer     = rdesc + 1;
+        rreq->recv.length     = rndv_rts_hdr->size;
+    } else {
+        rreq->recv.buffer     = NULL;
+        rreq->recv.length     = 0;
+    }
+
+    rreq->flags         = UCP_REQUEST_FLAG_CALLBACK | UCP_REQUEST_FLAG_RELEASED;
+    rreq->recv.worker   = worker;
+    rreq->recv.datatype = ucp_dt_make_contig(1);
+    rreq->recv.mem_type = UCT_MD_MEM_TYPE_HOST;
+    rreq->recv.tag.cb   = ucp_am_rndv_recv_completed;
+    ucp_dt_recv_state_init(&rreq->recv.state, rreq->recv.buffer,
+                           rreq->recv.datatype, rreq->recv.length);
+
+    ucp_rndv_matched(worker, rreq, rndv_rts_hdr);
+    return UCS_OK;
+}
+
+static void ucp_am_dump(ucp_worker_h worker, uct_am_trace_type_t type,
+                        uint8_t id, const void *data, size_t length,
+                        char *buffer, size_t max)
+{
+    const ucp_am_hdr_t       *hdr          = data;
+    const ucp_am_reply_hdr_t *reply_hdr    = data;
+    const ucp_am_long_hdr_t  *long_hdr     = data;
+    const ucp_rndv_rts_hdr_t *rndv_rts_hdr = data;
+    ucp_am_hdr_t             am_hdr;
+    size_t                   header_len;
+    char                     *p;
+
+    switch (id) {
+    case UCP_AM_ID_SINGLE:
+        snprintf(buffer, max, "AM id %u", hdr->am_hdr.am_id);
+        header_len = sizeof(*hdr);
+        break;
+    case UCP_AM_ID_SINGLE_REPLY:
+        snprintf(buffer, max, "AM id %u reply ep_ptr 0x%lx",
+                 reply_hdr->super.am_hdr.am_id, reply_hdr->ep_ptr);
+        header_len = sizeof(*reply_hdr);
+        break;
+    case UCP_AM_ID_MULTI:
+        snprintf(buffer, max, "AM_MULTI id %u msg_id %"PRIu64" offset %zu "
+                 "total %zu ep_ptr 0x%lx%s", long_hdr->am_id, long_hdr->msg_id,
+                 long_hdr->offset, long_hdr->total_size, long_hdr->ep_ptr,
+                 (long_hdr->flags & UCP_AM_SEND_REPLY) ? " reply" : "");
+        header_len = sizeof(*long_hdr);
+        break;
+    case UCP_AM_ID_AM_RNDV_RTS:
+        am_hdr.u64 = rndv_rts_hdr->super.tag;
+        snprintf(buffer, max, "AM_RNDV_RTS id %u ep_ptr 0x%lx sreq 0x%lx "
+                 "address 0x%"PRIx64" size %zu%s", am_hdr.am_hdr.am_id,
+                 rndv_rts_hdr->sreq.ep_ptr, rndv_rts_hdr->sreq.reqptr,
+                 rndv_rts_hdr->address, rndv_rts_hdr->size,
+                 (am_hdr.am_hdr.flags & UCP_AM_SEND_REPLY) ? " reply" : "");
+        return;
+    default:
+        return;
+    }
+
+    p = buffer + strlen(buffer);
+    ucp_dump_payload(worker->context, p, buffer + max - p,
+                     UCS_PTR_BYTE_OFFSET(data, header_len),
+                     length - header_len);
+}
+
+const ucp_proto_t ucp_am_proto = {
+    .contig_short            = ucp_am_contig_short,
+    .bcopy_single            = ucp_am_bcopy_single,
+    .bcopy_multi             = ucp_am_bcopy_multi,
+    .zcopy_single            = ucp_am_zcopy_single,
+    .zcopy_multi             = ucp_am_zcopy_multi,
+    .zcopy_completion        = ucp_proto_am_zcopy_completion,
+    .only_hdr_size           = sizeof(ucp_am_hdr_t),
+    .first_hdr_size          = sizeof(ucp_am_long_hdr_t),
+    .mid_hdr_size            = sizeof(ucp_am_long_hdr_t)
+};
+
+const ucp_proto_t ucp_am_reply_proto = {
+    .contig_short            = NULL,
+    .bcopy_single            = ucp_am_bcopy_single_reply,
+    .bcopy_multi             = ucp_am_bcopy_multi,
+    .zcopy_single            = ucp_am_zcopy_single_reply,
+    .zcopy_multi             = ucp_am_zcopy_multi,
+    .zcopy_completion        = ucp_proto_am_zcopy_completion,
+    .only_hdr_size           = sizeof(ucp_am_reply_hdr_t),
+    .first_hdr_size          = sizeof(ucp_am_long_hdr_t),
+    .mid_hdr_size            = sizeof(ucp_am_long_hdr_t)
+};
+
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_SINGLE, ucp_am_handler,
+              ucp_am_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_SINGLE_REPLY, ucp_am_handler_reply,
+              ucp_am_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_MULTI, ucp_am_long_handler,
+              ucp_am_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_AM_RNDV_RTS, ucp_am_rndv_rts_handler,
+              ucp_am_dump, 0);
+
+UCP_DEFINE_AM_PROXY(UCP_AM_ID_SINGLE);
+UCP_DEFINE_AM_PROXY(UCP_AM_ID_SINGLE_REPLY);
+UCP_DEFINE_AM_PROXY(UCP_AM_ID_MULTI);
+UCP_DEFINE_AM_PROXY(UCP_AM_ID_AM_RNDV_RTS);
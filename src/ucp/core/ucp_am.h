@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_AM_H_
+#define UCP_AM_H_
+
+#include "ucp_ep.h"
+
+#include <ucp/api/ucpx.h>
+#include <ucp/proto/proto.h>
+
+
+/*
+ * Header of a single fragment active message. It is 64 bits long so it can be
+ * passed as the header argument of uct_ep_am_short().
+ */
+typedef union {
+    struct {
+        uint16_t              am_id;      /* Index into callback array */
+        uint16_t              flags;      /* Send flags, @ref ucp_send_am_flags */
+        uint32_t              padding;
+    } am_hdr;
+    uint64_t                  u64;        /* Used for short messages */
+} UCS_S_PACKED ucp_am_hdr_t;
+
+
+/*
+ * Header of a single fragment active message sent with UCP_AM_SEND_REPLY.
+ */
+typedef struct {
+    ucp_am_hdr_t              super;
+    uintptr_t                 ep_ptr;     /* Remote endpoint to reply on */
+} UCS_S_PACKED ucp_am_reply_hdr_t;
+
+
+/*
+ * Header of every fragment of a multi-fragment active message. Fragments may
+ * arrive on different lanes, so each one carries its own offset.
+ */
+typedef struct {
+    uintptr_t                 ep_ptr;     /* Remote endpoint, which holds the
+                                             messages being assembled */
+    uint64_t                  msg_id;     /* Matches fragments of the same AM */
+    size_t                    total_size; /* Total length of the message */
+    size_t                    offset;     /* Offset of the fragment data */
+    uint16_t                  am_id;      /* Index into callback array */
+    uint16_t                  flags;      /* Send flags, @ref ucp_send_am_flags */
+} UCS_S_PACKED ucp_am_long_hdr_t;
+
+
+extern const ucp_proto_t ucp_am_proto;
+extern const ucp_proto_t ucp_am_reply_proto;
+
+
+void ucp_am_ep_init(ucp_ep_h ep);
+
+void ucp_am_ep_cleanup(ucp_ep_h ep);
+
+#endif
@@ -8,6 +8,8 @@
 #include "ucp_context.h"
 #include "ucp_request.h"
 #include <ucp/proto/proto.h>
+#include <ucp/proto/proto_tune.h>
+#include <ucp/wireup/address.h>
 
 #include <ucs/config/parser.h>
 #include <ucs/algorithm/crc.h>
@@ -104,6 +106,13 @@ static ucs_config_field_t ucp_config_table[] = {
    "Issue a warning in case of invalid device and/or transport configuration.",
    ucs_offsetof(ucp_config_t, warn_invalid_config), UCS_CONFIG_TYPE_BOOL},
 
+  {"PROTO_TUNE_FILE", "",
+   "File of tuned protocol thresholds. If the file exists, the thresholds in it\n"
+   "override the computed ones for the transports it lists. If PROTO_TUNE is\n"
+   "enabled, the tuned thresholds are written to the file when a worker is\n"
+   "destroyed. Each line holds <transport>/<device> <zcopy threshold> <rndv threshold>.",
+   ucs_offsetof(ucp_config_t, proto_tune_file), UCS_CONFIG_TYPE_STRING},
+
   {"BCOPY_THRESH", "0",
    "Threshold for switching from short to bcopy protocol",
    ucs_offsetof(ucp_config_t, ctx.bcopy_thresh), UCS_CONFIG_TYPE_MEMUNITS},
@@ -128,18 +137,24 @@ static ucs_config_field_t ucp_config_table[] = {
    ucs_offsetof(ucp_config_t, ctx.rndv_perf_diff), UCS_CONFIG_TYPE_DOUBLE},
 
   {"MAX_EAGER_LANES", NULL, "",
-   ucs_offsetof(ucp_config_t, ctx.max_eager_lanes), UCS_CONFIG_TYPE_UINT},
+   ucs_offsetof(ucp_config_t, ctx.max_eager_lanes), UCS_CONFIG_TYPE_ULUNITS},
 
   {"MAX_EAGER_RAILS", "1",
-   "Maximal number of devices on which an eager operation may be executed in parallel",
-   ucs_offsetof(ucp_config_t, ctx.max_eager_lanes), UCS_CONFIG_TYPE_UINT},
+   "Maximal number of devices on which an eager operation may be executed in parallel.\n"
+   "The fragments of a multi-fragment eager message are sent on the devices in\n"
+   "round-robin order, in equal shares regardless of the device bandwidth, and\n"
+   "reassembled by the receiver.\n"
+   "\"auto\" means to use up to the number of local devices.",
+   ucs_offsetof(ucp_config_t, ctx.max_eager_lanes), UCS_CONFIG_TYPE_ULUNITS},
 
   {"MAX_RNDV_LANES", NULL,"",
-   ucs_offsetof(ucp_config_t, ctx.max_rndv_lanes), UCS_CONFIG_TYPE_UINT},
+   ucs_offsetof(ucp_config_t, ctx.max_rndv_lanes), UCS_CONFIG_TYPE_ULUNITS},
 
-  {"MAX_RNDV_RAILS", "2",
-   "Maximal number of devices on which a rendezvous operation may be executed in parallel",
-   ucs_offsetof(ucp_config_t, ctx.max_rndv_lanes), UCS_CONFIG_TYPE_UINT},
+  {"MAX_RNDV_RAILS", "auto",
+   "Maximal number of devices on which a rendezvous operation may be executed in parallel.\n"
+   "The data is split between the devices in proportion to their bandwidth.\n"
+   "\"auto\" means to use up to the number of local devices.",
+   ucs_offsetof(ucp_config_t, ctx.max_rndv_lanes), UCS_CONFIG_TYPE_ULUNITS},
 
   {"RNDV_SCHEME", "auto",
    "Communication scheme in RNDV protocol.\n"
@@ -152,6 +167,11 @@ static ucs_config_field_t ucp_config_table[] = {
    "Threshold for switching from buffer copy to zero copy protocol",
    ucs_offsetof(ucp_config_t, ctx.zcopy_thresh), UCS_CONFIG_TYPE_MEMUNITS},
 
+  {"STRIDED_ZCOPY_MIN_BLOCK", "1k",
+   "Minimal size of a contiguous block of a strided datatype for using zero\n"
+   "copy protocol. Strided data with smaller blocks is always packed.",
+   ucs_offsetof(ucp_config_t, ctx.strided_zcopy_min_block), UCS_CONFIG_TYPE_MEMUNITS},
+
   {"BCOPY_BW", "5800mb",
    "Estimation of buffer copy bandwidth",
    ucs_offsetof(ucp_config_t, ctx.bcopy_bw), UCS_CONFIG_TYPE_MEMUNITS},
@@ -211,6 +231,14 @@ static ucs_config_field_t ucp_config_table[] = {
    "cases (non-contig buffer, or sender wildcard).",
    ucs_offsetof(ucp_config_t, ctx.tm_force_thresh), UCS_CONFIG_TYPE_MEMUNITS},
 
+  {"TM_UNEXP_MAX", "inf",
+   "Maximal total size of unexpected tag messages held by a worker. When it is\n"
+   "exceeded, the peers are asked to send tag messages with rendezvous protocol,\n"
+   "until the size of unexpected messages drops below half of this value.\n"
+   "Only the peers to which the worker has an already connected endpoint are\n"
+   "notified.",
+   ucs_offsetof(ucp_config_t, ctx.tm_unexp_max), UCS_CONFIG_TYPE_MEMUNITS},
+
   {"NUM_EPS", "auto",
    "An optimization hint of how many endpoints would be created on this context.\n"
    "Does not affect semantics, but only transport selection criteria and the\n"
@@ -233,6 +261,72 @@ static ucs_config_field_t ucp_config_table[] = {
    "another thread, or incoming active messages, but consumes more resources.",
    ucs_offsetof(ucp_config_t, ctx.flush_worker_eps), UCS_CONFIG_TYPE_BOOL},
 
+  {"PROGRESS_TRYLOCK", "n",
+   "In multi-threaded mode, return from ucp_worker_progress() without progress\n"
+   "if the worker is locked by another thread, instead of waiting for the lock.\n"
+   "This way threads which poll the same worker do not wait for each other, and\n"
+   "a sending thread competes with at most one progressing thread.",
+   ucs_offsetof(ucp_config_t, ctx.progress_trylock), UCS_CONFIG_TYPE_BOOL},
+
+  {"WAIT_SPIN_TIME", "20us",
+   "Maximal time to poll the worker in ucp_worker_wait() before arming it and\n"
+   "going to sleep. Events which arrive during this time are handled without the\n"
+   "latency of a wakeup. 0 means to go to sleep immediately.",
+   ucs_offsetof(ucp_config_t, ctx.wait_spin_time), UCS_CONFIG_TYPE_TIME},
+
+  {"WAIT_SPIN_ADAPTIVE", "y",
+   "Adjust the polling time of ucp_worker_wait() to the recent time between the\n"
+   "events, up to WAIT_SPIN_TIME. If the events are expected to arrive later\n"
+   "than WAIT_SPIN_TIME, go to sleep without polling.",
+   ucs_offsetof(ucp_config_t, ctx.wait_spin_adaptive), UCS_CONFIG_TYPE_BOOL},
+
+  {"PROTO_TUNE", "n",
+   "Measure the completion time of tagged sends of every protocol and message\n"
+   "size, and move the zero-copy and rendezvous thresholds of each transport\n"
+   "towards the faster protocol. The measured sends keep their semantics, and\n"
+   "their time lasts until the local completion: for eager protocols until the\n"
+   "buffer can be reused, and for rendezvous until the receiver has fetched the\n"
+   "data. Therefore the rendezvous time includes the matching by the receiver,\n"
+   "and the tuning favors eager protocols when the receives are posted late. A\n"
+   "threshold is not moved further than 4 times from its computed value.",
+   ucs_offsetof(ucp_config_t, ctx.proto_tune), UCS_CONFIG_TYPE_BOOL},
+
+  {"PROTO_TUNE_EXPLORE", "16",
+   "When protocol tuning is enabled, send every N-th message whose size is next\n"
+   "to a threshold with the protocol on the other side of the threshold, and\n"
+   "measure it and the message which follows it. N is at least 2.",
+   ucs_offsetof(ucp_config_t, ctx.proto_tune_explore), UCS_CONFIG_TYPE_UINT},
+
+  {"LAZY_EP_CONNECT", "n",
+   "Establish the connection of an endpoint created from a worker address only\n"
+   "when it's used for the first time. This saves the resources of endpoints\n"
+   "which are created to all peers but used to communicate with a few of them.",
+   ucs_offsetof(ucp_config_t, ctx.lazy_ep_connect), UCS_CONFIG_TYPE_BOOL},
+
+  {"RKEY_UNPACK_CACHE", "0",
+   "Number of released remote keys to keep in the cache of every endpoint, to\n"
+   "reuse them when the same packed key is unpacked again. If greater than 0,\n"
+   "unpacking a packed key which is already unpacked on the endpoint returns\n"
+   "the same reference-counted remote key handle. This is safe only if the\n"
+   "remote side does not register a different memory region with an identical\n"
+   "packed key while a cached key of the old region exists.",
+   ucs_offsetof(ucp_config_t, ctx.rkey_unpack_cache), UCS_CONFIG_TYPE_UINT},
+
+  {"RMA_AGGREGATE_SIZE", "0",
+   "Size of a per-endpoint buffer which combines small ucp_put_nbi() operations\n"
+   "to contiguous remote addresses with the same remote key into one put. The\n"
+   "buffer is sent when it is full, when the next put is not contiguous, and by\n"
+   "flush, fence, and worker progress. 0 disables the aggregation.",
+   ucs_offsetof(ucp_config_t, ctx.rma_aggr_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"AMO_SW_BATCH", "0",
+   "Maximal number of non-fetching atomic operations, emulated in software by\n"
+   "active messages, to send in one message. Operations of the same type and\n"
+   "size on the same remote address are combined to one. The batch is sent\n"
+   "when it is full, and by fetching atomics, flush, fence, and worker\n"
+   "progress. 0 disables the batching.",
+   ucs_offsetof(ucp_config_t, ctx.amo_sw_batch), UCS_CONFIG_TYPE_UINT},
+
   {"UNIFIED_MODE", "n",
    "Enable various optimizations intended for homogeneous environment.\n"
    "Enabling this mode implies that the local transport resources/devices\n"
@@ -664,6 +758,8 @@ static const char* ucp_feature_flag_str(unsigned feature_flag)
         return "UCP_FEATURE_WAKEUP";
     case UCP_FEATURE_STREAM:
         return "UCP_FEATURE_STREAM";
+    case UCP_FEATURE_EXPERIMENTAL:
+        return "UCP_FEATURE_EXPERIMENTAL";
     default:
         ucs_fatal("Unknown feature flag value %u", feature_flag);
     }
@@ -881,6 +977,27 @@ static ucs_status_t ucp_check_resources(ucp_context_h context,
     return ucp_check_tl_names(context);
 }
 
+static void ucp_fill_max_lanes_config(ucp_context_h context,
+                                      size_t *max_lanes_p, const char *title)
+{
+    uint64_t dev_bitmap = 0;
+    ucp_rsc_index_t i;
+
+    if ((*max_lanes_p != UCS_CONFIG_ULUNITS_AUTO) &&
+        (*max_lanes_p != UCS_CONFIG_ULUNITS_INF)) {
+        return;
+    }
+
+    /* Lane selection uses every device at most once, so there could not be
+     * more lanes than local devices */
+    for (i = 0; i < context->num_tls; ++i) {
+        dev_bitmap |= UCS_BIT(context->tl_rscs[i].dev_index);
+    }
+
+    *max_lanes_p = ucs_min(ucs_popcount(dev_bitmap), UCP_MAX_LANES);
+    ucs_debug("using up to %zu %s lanes", *max_lanes_p, title);
+}
+
 static ucs_status_t ucp_fill_resources(ucp_context_h context,
                                        const ucp_config_t *config)
 {
@@ -985,6 +1102,11 @@ static ucs_status_t ucp_fill_resources(ucp_context_h context,
         goto err_free_context_resources;
     }
 
+    ucp_fill_max_lanes_config(context, &context->config.ext.max_eager_lanes,
+                              "eager");
+    ucp_fill_max_lanes_config(context, &context->config.ext.max_rndv_lanes,
+                              "rendezvous");
+
     uct_release_md_resource_list(md_rscs);
 
     if (config->warn_invalid_config) {
@@ -1137,6 +1259,24 @@ static ucs_status_t ucp_fill_config(ucp_context_h context,
         }
     }
 
+    context->config.proto_tune.file  = ucs_strdup(config->proto_tune_file,
+                                                  "proto_tune_file");
+    context->config.proto_tune.table = NULL;
+    context->config.proto_tune.count = 0;
+    if (context->config.proto_tune.file == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err_free;
+    }
+
+    if (strlen(context->config.proto_tune.file) > 0) {
+        status = ucp_proto_tune_load(context->config.proto_tune.file,
+                                     &context->config.proto_tune.table,
+                                     &context->config.proto_tune.count);
+        if (status != UCS_OK) {
+            goto err_free_proto_tune_file;
+        }
+    }
+
     /* Need to check MAX_BCOPY value if it is enabled only */
     if (context->config.ext.tm_max_bb_size > context->config.ext.tm_thresh) {
         if (context->config.ext.tm_max_bb_size < sizeof(ucp_request_hdr_t)) {
@@ -1158,6 +1298,8 @@ static ucs_status_t ucp_fill_config(ucp_context_h context,
 
     return UCS_OK;
 
+err_free_proto_tune_file:
+    ucs_free(context->config.proto_tune.file);
 err_free:
     ucs_free(context->config.alloc_methods);
 err:
@@ -1167,6 +1309,8 @@ err:
 
 static void ucp_free_config(ucp_context_h context)
 {
+    ucs_free(context->config.proto_tune.table);
+    ucs_free(context->config.proto_tune.file);
     ucs_free(context->config.alloc_methods);
 }
 
@@ -1233,6 +1377,8 @@ ucs_status_t ucp_init_version(unsigned api_major_version, unsigned api_minor_ver
         goto err_free_resources;
     }
 
+    ucp_address_cache_init(context);
+
     if (dfl_config != NULL) {
         ucp_config_release(dfl_config);
     }
@@ -1260,6 +1406,7 @@ err:
 
 void ucp_cleanup(ucp_context_h context)
 {
+    ucp_address_cache_cleanup(context);
     ucs_mpool_cleanup(&context->rkey_mp, 1);
     ucp_free_resources(context);
     ucp_free_config(context);
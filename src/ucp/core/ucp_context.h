@@ -15,6 +15,7 @@
 #include <ucp/api/ucp.h>
 #include <uct/api/uct.h>
 #include <ucs/datastruct/mpool.h>
+#include <ucs/datastruct/shash.h>
 #include <ucs/datastruct/queue_types.h>
 #include <ucs/memory/memtype_cache.h>
 #include <ucs/type/spinlock.h>
@@ -46,6 +47,8 @@ typedef struct ucp_context_config {
     double                                 rndv_perf_diff;
     /** Threshold for switching UCP to zero copy protocol */
     size_t                                 zcopy_thresh;
+    /** Minimal block size of strided datatype for zero copy protocol */
+    size_t                                 strided_zcopy_min_block;
     /** Communication scheme in RNDV protocol */
     ucp_rndv_mode_t                        rndv_mode;
     /** Estimation of bcopy bandwidth */
@@ -62,6 +65,9 @@ typedef struct ucp_context_config {
     /** Upper bound for posting tm offload receives with internal UCP
      *  preregistered bounce buffers. */
     size_t                                 tm_max_bb_size;
+    /** Maximal total size of unexpected tag messages, before pausing eager
+     *  protocol of the peers */
+    size_t                                 tm_unexp_max;
     /** Maximal size of worker name for debugging */
     unsigned                               max_worker_name;
     /** Atomic mode */
@@ -71,15 +77,33 @@ typedef struct ucp_context_config {
     /** On-demand progress */
     int                                    adaptive_progress;
     /** Eager-am multi-lane support */
-    unsigned                               max_eager_lanes;
+    size_t                                 max_eager_lanes;
     /** Rendezvous-get multi-lane support */
-    unsigned                               max_rndv_lanes;
+    size_t                                 max_rndv_lanes;
     /** Estimated number of endpoints */
     size_t                                 estimated_num_eps;
     /** Memtype cache */
     int                                    enable_memtype_cache;
     /** Enable flushing endpoints while flushing a worker */
     int                                    flush_worker_eps;
+    /** Do not wait for the worker lock in multi-threaded progress */
+    int                                    progress_trylock;
+    /** Maximal time to poll the worker in ucp_worker_wait() before sleeping */
+    double                                 wait_spin_time;
+    /** Adjust the polling time of ucp_worker_wait() to the event rate */
+    int                                    wait_spin_adaptive;
+    /** Tune protocol thresholds by measured send times */
+    int                                    proto_tune;
+    /** Explore the other protocol every N sends near a threshold */
+    unsigned                               proto_tune_explore;
+    /** Connect endpoints to worker address on first use */
+    int                                    lazy_ep_connect;
+    /** Number of released remote keys to cache per endpoint */
+    unsigned                               rkey_unpack_cache;
+    /** Size of the per-endpoint buffer for aggregating small puts */
+    size_t                                 rma_aggr_size;
+    /** Maximal number of software atomic posts to send in one message */
+    unsigned                               amo_sw_batch;
     /** Enable optimizations suitable for homogeneous systems */
     int                                    unified_mode;
 } ucp_context_config_t;
@@ -98,6 +122,8 @@ struct ucp_config {
     UCS_CONFIG_STRING_ARRAY_FIELD(aux_tls) sockaddr_aux_tls;
     /** Warn on invalid configuration */
     int                                    warn_invalid_config;
+    /** File to load tuned protocol thresholds from, and save them to */
+    char                                   *proto_tune_file;
     /** Configuration saved directly in the context */
     ucp_context_config_t                   ctx;
 };
@@ -135,6 +161,9 @@ typedef struct ucp_tl_md {
 } ucp_tl_md_t;
 
 
+UCS_SHASH_TYPE(ucp_address_templates, ucp_address_template_t*, char)
+
+
 /**
  * UCP context
  */
@@ -158,6 +187,9 @@ typedef struct ucp_context {
 
     ucs_mpool_t                   rkey_mp;    /* Pool for memory keys */
 
+    /* Templates of remote worker addresses stored by all workers */
+    ucs_shash_t(ucp_address_templates) address_templates;
+
     struct {
 
         /* Bitmap of features supported by the context */
@@ -186,6 +218,13 @@ typedef struct ucp_context {
         /* Bitmap of sockaddr auxiliary transports to pack for client/server flow */
         uint64_t                  sockaddr_aux_rscs_bitmap;
 
+        /* Tuned protocol thresholds */
+        struct {
+            char                   *file;  /* File to load and save the table */
+            ucp_proto_tune_entry_t *table; /* Thresholds loaded from the file */
+            unsigned               count;  /* Number of entries in the table */
+        } proto_tune;
+
         /* Configuration supplied by the user */
         ucp_context_config_t      ext;
 
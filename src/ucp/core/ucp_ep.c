@@ -6,6 +6,7 @@
 
 #include "ucp_ep.h"
 #include "ucp_worker.h"
+#include "ucp_mm.h"
 #include "ucp_ep.inl"
 #include "ucp_request.inl"
 
@@ -14,7 +15,9 @@
 #include <ucp/tag/eager.h>
 #include <ucp/tag/offload.h>
 #include <ucp/stream/stream.h>
+#include <ucp/rma/rma.h>
 #include <ucp/core/ucp_listener.h>
+#include <ucp/core/ucp_am.h>
 #include <ucs/datastruct/queue.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/debug/log.h>
@@ -86,6 +89,7 @@ ucs_status_t ucp_ep_new(ucp_worker_h worker, const char *peer_name,
     ucp_ep_ext_gen(ep)->user_data   = NULL;
     ucp_ep_ext_gen(ep)->dest_ep_ptr = 0;
     ucp_ep_ext_gen(ep)->err_cb      = NULL;
+    ucp_ep_ext_gen(ep)->rkey_cache  = NULL;
     UCS_STATIC_ASSERT(sizeof(ucp_ep_ext_gen(ep)->ep_match) >=
                       sizeof(ucp_ep_ext_gen(ep)->listener));
     UCS_STATIC_ASSERT(sizeof(ucp_ep_ext_gen(ep)->ep_match) >=
@@ -94,6 +98,8 @@ ucs_status_t ucp_ep_new(ucp_worker_h worker, const char *peer_name,
            sizeof(ucp_ep_ext_gen(ep)->ep_match));
 
     ucp_stream_ep_init(ep);
+    ucp_am_ep_init(ep);
+    ucp_rma_aggr_ep_init(ep);
 
     for (lane = 0; lane < UCP_MAX_LANES; ++lane) {
         ep->uct_eps[lane] = NULL;
@@ -123,6 +129,8 @@ err:
 
 void ucp_ep_delete(ucp_ep_h ep)
 {
+    ucp_rkey_cache_purge(ep);
+    ucp_rma_aggr_cleanup(ep);
     UCS_STATS_NODE_FREE(ep->stats);
     ucs_list_del(&ucp_ep_ext_gen(ep)->ep_list);
     ucs_strided_alloc_put(&ep->worker->ep_alloc, ep);
@@ -175,8 +183,10 @@ void ucp_ep_config_key_set_params(ucp_ep_config_key_t *key,
 
 int ucp_ep_is_sockaddr_stub(ucp_ep_h ep)
 {
-    /* Only a sockaddr client-side endpoint may be created as a "stub" */
-    return ucp_ep_get_rsc_index(ep, 0) == UCP_NULL_RESOURCE;
+    /* Only a sockaddr client-side endpoint may be created as a "stub", besides
+     * an endpoint which is connected on first use */
+    return (ucp_ep_get_rsc_index(ep, 0) == UCP_NULL_RESOURCE) &&
+           !(ep->flags & UCP_EP_FLAG_CONNECT_LAZY);
 }
 
 static ucs_status_t
@@ -258,12 +268,20 @@ err_free_address_list:
 err_free_address_buffer:
     ucs_free(address_buffer);
 err_cleanup_eps:
+    ucp_worker_destroy_mem_type_endpoints(worker);
+    return status;
+}
+
+void ucp_worker_destroy_mem_type_endpoints(ucp_worker_h worker)
+{
+    unsigned i;
+
     for (i = 0; i < UCT_MD_MEM_TYPE_LAST; i++) {
         if (worker->mem_type_ep[i]) {
            ucp_ep_destroy_internal(worker->mem_type_ep[i]);
+           worker->mem_type_ep[i] = NULL;
         }
     }
-    return status;
 }
 
 ucs_status_t ucp_ep_init_create_wireup(ucp_ep_h ep,
@@ -341,6 +359,140 @@ err:
     return status;
 }
 
+/*
+ * Create an endpoint which is connected to the remote worker only when it's
+ * used for the first time. Until then, it has a stub wireup endpoint which
+ * keeps a copy of the remote address.
+ */
+static ucs_status_t
+ucp_ep_create_lazy_to_worker_addr(ucp_worker_h worker,
+                                  const ucp_ep_params_t *params,
+                                  const ucp_unpacked_address_t *remote_address,
+                                  ucp_ep_h *ep_p)
+{
+    uint8_t addr_indices[UCP_MAX_LANES];
+    ucp_ep_config_key_t lanes_key, key;
+    ucp_wireup_ep_t *wireup_ep;
+    ucs_status_t status;
+    ucp_ep_h ep;
+
+    status = ucp_ep_new(worker, remote_address->name, "from api call, lazy",
+                        &ep);
+    if (status != UCS_OK) {
+        goto err;
+    }
+
+    /* report unreachable peer on creation, as if the ep was connected */
+    status = ucp_wireup_select_lanes(ep, params, 0, remote_address->address_count,
+                                     remote_address->address_list,
+                                     addr_indices, &lanes_key);
+    if (status != UCS_OK) {
+        goto err_delete;
+    }
+
+    status = ucp_ep_init_create_wireup(ep, params, &wireup_ep);
+    if (status != UCS_OK) {
+        goto err_delete;
+    }
+
+    /* allow unpacking remote keys before the lanes are connected */
+    key                  = ucp_ep_config(ep)->key;
+    key.reachable_md_map = lanes_key.reachable_md_map;
+    ep->cfg_index        = ucp_worker_get_ep_config(worker, &key);
+
+    /* connection request is not sent until the endpoint is used */
+    ep->flags &= ~UCP_EP_FLAG_CONNECT_REQ_QUEUED;
+    ep->flags |= UCP_EP_FLAG_CONNECT_LAZY;
+
+    status = ucp_wireup_ep_set_lazy_address(&wireup_ep->super.super,
+                                            params->address);
+    if (status != UCS_OK) {
+        goto err_cleanup_lanes;
+    }
+
+    status = ucp_ep_adjust_params(ep, params);
+    if (status != UCS_OK) {
+        goto err_cleanup_lanes;
+    }
+
+    *ep_p = ep;
+    return UCS_OK;
+
+err_cleanup_lanes:
+    ucp_ep_cleanup_lanes(ep);
+err_delete:
+    ucp_ep_delete(ep);
+err:
+    return status;
+}
+
+ucs_status_t ucp_ep_connect_lazy(ucp_ep_h ep)
+{
+    ucp_worker_h worker = ep->worker;
+    uint8_t addr_indices[UCP_MAX_LANES];
+    ucp_unpacked_address_t remote_address;
+    ucp_cached_address_t *cached_address;
+    ucp_ep_params_t params;
+    ucs_status_t status;
+    void *address;
+
+    UCS_ASYNC_BLOCK(&worker->async);
+
+    /* the lanes could be already created by a connection request from the
+     * remote peer */
+    if (!(ep->flags & UCP_EP_FLAG_CONNECT_LAZY)) {
+        status = UCS_OK;
+        goto out;
+    }
+
+    ucs_debug("ep %p: connect on first use", ep);
+
+    /* the flag is cleared when the lanes replace the stub */
+    cached_address = ucp_wireup_ep_extract_lazy_address(ep->uct_eps[0]);
+    ucs_assert(cached_address != NULL);
+
+    status = ucp_address_cache_restore(worker, cached_address, &address);
+    ucp_address_cache_release(worker, cached_address);
+    if (status != UCS_OK) {
+        goto out_failed;
+    }
+
+    status = ucp_address_unpack(worker, address, &remote_address);
+    if (status != UCS_OK) {
+        goto out_free_address;
+    }
+
+    /* nothing was sent on the stub endpoint, so just replace it by real
+     * transport endpoints */
+    uct_ep_destroy(ep->uct_eps[0]);
+    ep->uct_eps[0] = NULL;
+
+    params.field_mask = UCP_EP_PARAM_FIELD_ERR_HANDLING_MODE;
+    params.err_mode   = ucp_ep_config(ep)->key.err_mode;
+
+    status = ucp_wireup_init_lanes(ep, &params, 0, remote_address.address_count,
+                                   remote_address.address_list, addr_indices);
+    ucs_free(remote_address.address_list);
+    if (status != UCS_OK) {
+        goto out_free_address;
+    }
+
+    if (!(ep->flags & UCP_EP_FLAG_LOCAL_CONNECTED)) {
+        status = ucp_wireup_send_request(ep);
+    }
+
+out_free_address:
+    ucs_free(address);
+out_failed:
+    if (status != UCS_OK) {
+        ep->flags &= ~UCP_EP_FLAG_CONNECT_LAZY;
+        ucp_worker_set_ep_failed(worker, ep, NULL, UCP_NULL_LANE, status);
+    }
+out:
+    UCS_ASYNC_UNBLOCK(&worker->async);
+    return status;
+}
+
 static ucs_status_t ucp_ep_create_to_sock_addr(ucp_worker_h worker,
                                                const ucp_ep_params_t *params,
                                                ucp_ep_h *ep_p)
@@ -539,6 +691,20 @@ ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
         goto out_free_address;
     }
 
+    flags = UCP_PARAM_VALUE(EP, params, flags, FLAGS, 0);
+    if (worker->context->config.ext.lazy_ep_connect &&
+        (remote_address.uuid != worker->uuid)) {
+        status = ucp_ep_create_lazy_to_worker_addr(worker, params,
+                                                   &remote_address, &ep);
+        if (status != UCS_OK) {
+            goto out_free_address;
+        }
+
+        ep->conn_sn = conn_sn;
+        ucp_ep_match_insert_exp(&worker->ep_match_ctx, remote_address.uuid, ep);
+        goto out_free_address;
+    }
+
     status = ucp_ep_create_to_worker_addr(worker, params, &remote_address, 0,
                                           "from api call", &ep);
     if (status != UCS_OK) {
@@ -553,7 +719,6 @@ ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
      * Otherwise, add the new ep to the matching context as an expected endpoint,
      * waiting for connection request from the peer endpoint
      */
-    flags = UCP_PARAM_VALUE(EP, params, flags, FLAGS, 0);
     if ((remote_address.uuid == worker->uuid) &&
         !(flags & UCP_EP_PARAMS_FLAGS_NO_LOOPBACK)) {
         ucp_ep_update_dest_ep_ptr(ep, (uintptr_t)ep);
@@ -701,6 +866,7 @@ void ucp_ep_disconnected(ucp_ep_h ep, int force)
                             ucp_listener_accept_cb_remove_filter, ep);
 
     ucp_stream_ep_cleanup(ep);
+    ucp_am_ep_cleanup(ep);
 
     ep->flags &= ~UCP_EP_FLAG_USED;
     ep->flags |= UCP_EP_FLAG_CLOSED;
@@ -1131,6 +1297,8 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
     config->tag.rndv.rkey_size          = ucp_rkey_packed_size(context,
                                                                config->key.rma_bw_md_map);
     config->stream.proto                = &ucp_stream_am_proto;
+    config->am_u.proto                  = &ucp_am_proto;
+    config->am_u.reply_proto            = &ucp_am_reply_proto;
     config->tag.offload.max_eager_short = -1;
     config->tag.max_eager_short         = -1;
     max_rndv_thresh                     = SIZE_MAX;
@@ -1168,16 +1336,20 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
         }
     }
 
-    if (rndv_max_bw > 0) {
-        for (i = 0; (i < config->key.num_lanes) &&
-                    (config->key.rma_bw_lanes[i] != UCP_NULL_LANE); ++i) {
-            lane      = config->key.rma_bw_lanes[i];
-            rsc_index = config->key.lanes[lane].rsc_index;
+    for (i = 0; (i < config->key.num_lanes) &&
+                (config->key.rma_bw_lanes[i] != UCP_NULL_LANE); ++i) {
+        lane      = config->key.rma_bw_lanes[i];
+        rsc_index = config->key.lanes[lane].rsc_index;
 
-            if (rsc_index != UCP_NULL_RESOURCE) {
-                iface_attr = ucp_worker_iface_get_attr(worker, rsc_index);
-                config->tag.rndv.scale[lane] = iface_attr->bandwidth / rndv_max_bw;
-            }
+        iface_attr = (rsc_index != UCP_NULL_RESOURCE) ?
+                     ucp_worker_iface_get_attr(worker, rsc_index) : NULL;
+        if ((iface_attr != NULL) && (iface_attr->bandwidth > 0)) {
+            /* rndv_max_bw is positive, since it is the maximum over lanes
+             * which include this one */
+            config->tag.rndv.scale[lane] = iface_attr->bandwidth / rndv_max_bw;
+        } else {
+            /* unknown bandwidth, split the data equally */
+            config->tag.rndv.scale[lane] = 1.0;
         }
     }
 
@@ -47,6 +47,13 @@ enum {
                                                         worker address from the client) */
     UCP_EP_FLAG_CONNECT_PRE_REQ_QUEUED = UCS_BIT(9), /* Pre-Connection request was queued */
     UCP_EP_FLAG_CLOSED                 = UCS_BIT(10),/* EP was closed */
+    UCP_EP_FLAG_TAG_EAGER_PAUSED       = UCS_BIT(11),/* Remote peer paused eager
+                                                        protocol for tag messages */
+    UCP_EP_FLAG_CONNECT_LAZY           = UCS_BIT(12),/* EP has a stub lane, which is
+                                                        connected on first use */
+    UCP_EP_FLAG_RMA_DIRTY              = UCS_BIT(13),/* EP has RMA/AMO operations which
+                                                        were not flushed by a worker
+                                                        flush */
 
     /* DEBUG bits */
     UCP_EP_FLAG_CONNECT_REQ_SENT       = UCS_BIT(16),/* DEBUG: Connection request was sent */
@@ -243,6 +250,9 @@ typedef struct ucp_ep_config {
             /* Maximal total size for RNDV offload */
             size_t          max_rndv_zcopy;
         } offload;
+
+        /* Online tuning of the thresholds, NULL if disabled */
+        ucp_proto_tune_t    *tune;
     } tag;
 
     struct {
@@ -250,6 +260,13 @@ typedef struct ucp_ep_config {
          * (currently it's only AM based). */
         const ucp_proto_t   *proto;
     } stream;
+
+    struct {
+        /* Protocols used for active message operations
+         * (currently it's only AM based). */
+        const ucp_proto_t   *proto;
+        const ucp_proto_t   *reply_proto;
+    } am_u;
 } ucp_ep_config_t;
 
 
@@ -295,6 +312,7 @@ typedef struct {
     void                          *user_data;    /* User data associated with ep */
     ucs_list_link_t               ep_list;       /* List entry in worker's all eps list */
     ucp_err_handler_cb_t          err_cb;        /* Error handler */
+    ucp_rkey_cache_t              *rkey_cache;   /* Cache of unpacked remote keys */
 
     /* Endpoint match context and remote completion status are mutually exclusive,
      * since remote completions are counted only after the endpoint is already
@@ -308,6 +326,20 @@ typedef struct {
 } ucp_ep_ext_gen_t;
 
 
+/*
+ * Multi-fragment active message which was partially received.
+ */
+typedef struct {
+    ucp_recv_desc_t               *all_data;     /* Buffer for all fragments, or
+                                                    NULL if its allocation failed
+                                                    and the fragments are dropped */
+    size_t                        left;          /* How many bytes are still missing */
+} ucp_am_unfinished_t;
+
+
+UCS_SHASH_TYPE(ucp_am_unfinished, uint64_t, ucp_am_unfinished_t)
+
+
 /*
  * Endpoint extension for specific protocols
  */
@@ -316,7 +348,19 @@ typedef struct {
         ucs_list_link_t           ready_list;    /* List entry in worker's EP list */
         ucs_queue_head_t          match_q;       /* Queue of receive data or requests,
                                                     depends on UCP_EP_FLAG_STREAM_HAS_DATA */
+        ucs_queue_head_t          rndv_q;        /* Data received with rendezvous
+                                                    which is still being fetched,
+                                                    and data which arrived after it */
     } stream;
+
+    struct {
+        ucs_shash_t(ucp_am_unfinished) *started_ams; /* Active messages which
+                                                        are being reassembled,
+                                                        by message id. Allocated
+                                                        on first use. */
+    } am;
+
+    ucp_rma_aggr_t                *rma_aggr;     /* Buffer of aggregated puts */
 } ucp_ep_ext_proto_t;
 
 
@@ -388,6 +432,8 @@ void ucp_ep_destroy_internal(ucp_ep_h ep);
 
 void ucp_ep_cleanup_lanes(ucp_ep_h ep);
 
+ucs_status_t ucp_ep_connect_lazy(ucp_ep_h ep);
+
 int ucp_ep_is_sockaddr_stub(ucp_ep_h ep);
 
 void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config);
@@ -405,4 +451,6 @@ size_t ucp_ep_config_get_zcopy_auto_thresh(size_t iovcnt,
 
 ucs_status_t ucp_worker_create_mem_type_endpoints(ucp_worker_h worker);
 
+void ucp_worker_destroy_mem_type_endpoints(ucp_worker_h worker);
+
 #endif
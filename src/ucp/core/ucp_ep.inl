@@ -164,6 +164,19 @@ ucp_ep_resolve_dest_ep_ptr(ucp_ep_h ep, ucp_lane_index_t lane)
     return ucp_wireup_connect_remote(ep, lane);
 }
 
+/*
+ * Connect an endpoint which was created with lazy connection, before the first
+ * operation selects a protocol according to its configuration.
+ */
+static UCS_F_ALWAYS_INLINE ucs_status_t ucp_ep_connect_on_use(ucp_ep_h ep)
+{
+    if (ucs_likely(!(ep->flags & UCP_EP_FLAG_CONNECT_LAZY))) {
+        return UCS_OK;
+    }
+
+    return ucp_ep_connect_lazy(ep);
+}
+
 static inline void ucp_ep_update_dest_ep_ptr(ucp_ep_h ep, uintptr_t ep_ptr)
 {
     if (ep->flags & UCP_EP_FLAG_DEST_EP) {
@@ -23,6 +23,9 @@
  */
 #define UCP_RKEY_MPOOL_MAX_MD     3
 
+typedef struct ucp_rkey_cache_entry ucp_rkey_cache_entry_t;
+
+
 /**
  * Remote memory key structure.
  * Contains remote keys for UCT MDs.
@@ -43,6 +46,8 @@ typedef struct ucp_rkey {
     } cache;
     ucp_md_map_t                  md_map;  /* Which *remote* MDs have valid memory handles */
     uct_memory_type_t             mem_type;/* Memory type of remote key memory */
+    ucp_rkey_cache_entry_t        *cache_entry; /* Entry in the unpack cache of
+                                                   the endpoint, or NULL */
 #if ENABLE_PARAMS_CHECK
     ucp_ep_h                      ep;
 #endif
@@ -135,6 +140,19 @@ ssize_t ucp_rkey_pack_uct(ucp_context_h context, ucp_md_map_t md_map,
 
 void ucp_rkey_dump_packed(const void *rkey_buffer, char *buffer, size_t max);
 
+/**
+ * Unpack a remote key without looking it up in the unpack cache of the
+ * endpoint. Used for remote keys which are released right after the operation.
+ */
+ucs_status_t ucp_ep_rkey_unpack_uncached(ucp_ep_h ep, const void *rkey_buffer,
+                                         ucp_rkey_h *rkey_p);
+
+/**
+ * Release the remote keys cached by the endpoint. Keys which are still in use
+ * are detached from the cache, and released by @ref ucp_rkey_destroy.
+ */
+void ucp_rkey_cache_purge(ucp_ep_h ep);
+
 ucs_status_t ucp_mem_type_reg_buffers(ucp_worker_h worker, void *remote_addr,
                                       size_t length, uct_memory_type_t mem_type,
                                       unsigned md_index, uct_mem_h *memh,
@@ -7,6 +7,7 @@
 #include "ucp_proxy_ep.h"
 #include "ucp_ep.inl"
 
+#include <ucp/wireup/wireup_ep.h>
 #include <ucs/debug/log.h>
 
 
@@ -196,7 +197,8 @@ static void ucp_proxy_ep_replace_if_owned(uct_ep_h uct_ep, uct_ep_h owned_ep,
 {
     ucp_proxy_ep_t *proxy_ep;
 
-    if (ucp_proxy_ep_test(uct_ep)) {
+    /* wireup ep is a proxy ep as well */
+    if (ucp_proxy_ep_test(uct_ep) || ucp_wireup_ep_test(uct_ep)) {
         proxy_ep = ucs_derived_of(uct_ep, ucp_proxy_ep_t);
         if (proxy_ep->uct_ep == owned_ep) {
             proxy_ep->uct_ep = replacement_ep;
@@ -221,6 +223,13 @@ void ucp_proxy_ep_replace(ucp_proxy_ep_t *proxy_ep)
         }
     }
 
+    if (tl_ep == NULL) {
+        /* the proxy ep is not a lane by itself but the next ep of another
+         * proxy ep, e.g a signaling ep wrapped by a wireup ep */
+        tl_ep            = proxy_ep->uct_ep;
+        proxy_ep->uct_ep = NULL;
+    }
+
     /* go through the lanes and check if the proxy ep that is being destroyed,
      * is pointed to by another proxy ep. if so, redirect that other proxy ep
      * to point to the underlying uct ep. */
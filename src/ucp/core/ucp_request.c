@@ -64,6 +64,7 @@ ucp_request_release_common(void *request, uint8_t cb_flag, const char *debug_nam
     ucp_request_t *req = (ucp_request_t*)request - 1;
     ucp_worker_h UCS_V_UNUSED worker = ucs_container_of(ucs_mpool_obj_owner(req),
                                                         ucp_worker_t, req_mp);
+    ucp_request_cq_entry_t *entry;
     uint16_t flags;
 
     UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
@@ -75,6 +76,18 @@ ucp_request_release_common(void *request, uint8_t cb_flag, const char *debug_nam
     ucs_assert(!(flags & UCP_REQUEST_DEBUG_FLAG_EXTERNAL));
     ucs_assert(!(flags & UCP_REQUEST_FLAG_RELEASED));
 
+    if (ucs_unlikely(flags & UCP_REQUEST_FLAG_COMPLETION_QUEUE)) {
+        entry = *ucp_request_cq(req);
+        flags &= ~UCP_REQUEST_FLAG_COMPLETION_QUEUE;
+        if (flags & UCP_REQUEST_FLAG_COMPLETED) {
+            /* released before its completion was polled, the entry is skipped
+             * and released by ucp_worker_poll_completions() */
+            entry->req = NULL;
+        } else {
+            ucs_mpool_put_inline(entry);
+        }
+    }
+
     if (ucs_likely(flags & UCP_REQUEST_FLAG_COMPLETED)) {
         ucp_request_put(req);
     } else {
@@ -84,6 +97,41 @@ ucp_request_release_common(void *request, uint8_t cb_flag, const char *debug_nam
     UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
 }
 
+ucs_status_t ucp_request_set_cookie(ucp_worker_h worker, void *request,
+                                    void *cookie)
+{
+    ucp_request_t *req = (ucp_request_t*)request - 1;
+    ucp_request_cq_entry_t *entry;
+    ucs_status_t status;
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+
+    ucs_assert(!(req->flags & (UCP_REQUEST_FLAG_RELEASED |
+                               UCP_REQUEST_FLAG_COMPLETION_QUEUE)));
+
+    entry = ucs_mpool_get_inline(&worker->cq_mp);
+    if (entry == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto out;
+    }
+
+    entry->worker        = worker;
+    entry->req           = req;
+    entry->cookie        = cookie;
+    *ucp_request_cq(req) = entry;
+    req->flags          |= UCP_REQUEST_FLAG_COMPLETION_QUEUE;
+    if (req->flags & UCP_REQUEST_FLAG_COMPLETED) {
+        ucs_queue_push(&worker->completions, &entry->queue);
+    }
+
+    ucs_trace_req("request %p (%p) cookie %p", req, req + 1, cookie);
+    status = UCS_OK;
+
+out:
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+    return status;
+}
+
 UCS_PROFILE_FUNC_VOID(ucp_request_release, (request), void *request)
 {
     /* mark request as released */
@@ -107,6 +155,7 @@ UCS_PROFILE_FUNC_VOID(ucp_request_cancel, (worker, request),
 
     if (req->flags & UCP_REQUEST_FLAG_EXPECTED) {
         UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+        UCP_TAG_MATCH_CS_ENTER(&worker->tm);
 
         ucp_tag_exp_remove(&worker->tm, req);
         /* If tag posted to the transport need to wait its completion */
@@ -114,6 +163,7 @@ UCS_PROFILE_FUNC_VOID(ucp_request_cancel, (worker, request),
             ucp_request_complete_tag_recv(req, UCS_ERR_CANCELED);
         }
 
+        UCP_TAG_MATCH_CS_EXIT(&worker->tm);
         UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
     }
 }
@@ -154,6 +204,13 @@ ucs_mpool_ops_t ucp_rndv_get_mpool_ops = {
     .obj_cleanup   = NULL
 };
 
+ucs_mpool_ops_t ucp_request_cq_mpool_ops = {
+    .chunk_alloc   = ucs_mpool_chunk_malloc,
+    .chunk_release = ucs_mpool_chunk_free,
+    .obj_init      = NULL,
+    .obj_cleanup   = NULL
+};
+
 int ucp_request_pending_add(ucp_request_t *req, ucs_status_t *req_status,
                             unsigned pending_flags)
 {
@@ -222,6 +279,16 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_request_memory_reg,
         ucp_trace_req(req_dbg, "mem reg md_map 0x%"PRIx64"/0x%"PRIx64,
                       state->dt.contig.md_map, md_map);
         break;
+    case UCP_DATATYPE_STRIDED:
+        /* Register the memory span which contains all blocks */
+        ucs_assert(ucs_popcount(md_map) <= UCP_MAX_OP_MDS);
+        status = ucp_mem_rereg_mds(context, md_map, buffer,
+                                   ucp_dt_strided_span(datatype, length), flags,
+                                   NULL, mem_type, NULL, state->dt.contig.memh,
+                                   &state->dt.contig.md_map);
+        ucp_trace_req(req_dbg, "mem reg strided md_map 0x%"PRIx64"/0x%"PRIx64,
+                      state->dt.contig.md_map, md_map);
+        break;
     case UCP_DATATYPE_IOV:
         iovcnt = state->dt.iov.iovcnt;
         iov    = buffer;
@@ -275,6 +342,7 @@ UCS_PROFILE_FUNC_VOID(ucp_request_memory_dereg, (context, datatype, state, req_d
 
     switch (datatype & UCP_DATATYPE_CLASS_MASK) {
     case UCP_DATATYPE_CONTIG:
+    case UCP_DATATYPE_STRIDED:
         ucp_request_dt_dereg(context, &state->dt.contig, 1, req_dbg);
         break;
     case UCP_DATATYPE_IOV:
@@ -352,6 +420,9 @@ ucp_request_send_start(ucp_request_t *req, ssize_t max_short,
                 multi = ucp_dt_iov_count_nonempty(req->send.buffer, dt_count) >
                         msg_config->max_iov;
             }
+        } else if (ucs_unlikely(UCP_DT_IS_STRIDED(req->send.datatype))) {
+            multi = ucp_dt_strided_num_blocks(req->send.datatype, length) >
+                    msg_config->max_iov;
         } else {
             multi = 0;
         }
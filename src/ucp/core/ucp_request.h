@@ -31,15 +31,18 @@
 enum {
     UCP_REQUEST_FLAG_COMPLETED            = UCS_BIT(0),
     UCP_REQUEST_FLAG_RELEASED             = UCS_BIT(1),
+    UCP_REQUEST_FLAG_COMPLETION_QUEUE     = UCS_BIT(2),
     UCP_REQUEST_FLAG_EXPECTED             = UCS_BIT(3),
     UCP_REQUEST_FLAG_LOCAL_COMPLETED      = UCS_BIT(4),
     UCP_REQUEST_FLAG_REMOTE_COMPLETED     = UCS_BIT(5),
     UCP_REQUEST_FLAG_CALLBACK             = UCS_BIT(6),
     UCP_REQUEST_FLAG_RECV                 = UCS_BIT(7),
     UCP_REQUEST_FLAG_SYNC                 = UCS_BIT(8),
+    UCP_REQUEST_FLAG_PROTO_TUNE           = UCS_BIT(9),
     UCP_REQUEST_FLAG_OFFLOADED            = UCS_BIT(10),
     UCP_REQUEST_FLAG_BLOCK_OFFLOAD        = UCS_BIT(11),
     UCP_REQUEST_FLAG_STREAM_RECV_WAITALL  = UCS_BIT(12),
+    UCP_REQUEST_FLAG_PACK_NONTEMPORAL     = UCS_BIT(13),
 
 #if ENABLE_ASSERT
     UCP_REQUEST_FLAG_STREAM_RECV          = UCS_BIT(14),
@@ -71,7 +74,8 @@ enum {
     UCP_RECV_DESC_FLAG_EAGER_ONLY     = UCS_BIT(2), /* Eager tag message with single fragment */
     UCP_RECV_DESC_FLAG_EAGER_SYNC     = UCS_BIT(3), /* Eager tag message which requires reply */
     UCP_RECV_DESC_FLAG_EAGER_OFFLOAD  = UCS_BIT(4), /* Eager tag from offload */
-    UCP_RECV_DESC_FLAG_RNDV           = UCS_BIT(5)  /* Rendezvous request */
+    UCP_RECV_DESC_FLAG_RNDV           = UCS_BIT(5), /* Rendezvous request */
+    UCP_RECV_DESC_FLAG_MALLOC         = UCS_BIT(6)  /* Descriptor allocated by malloc */
 };
 
 
@@ -79,11 +83,25 @@ enum {
  * Receive descriptor list pointers
  */
 enum {
-    UCP_RDESC_HASH_LIST = 0,
-    UCP_RDESC_ALL_LIST  = 1
+    UCP_RDESC_HASH_LIST    = 0,
+    UCP_RDESC_ALL_LIST     = 1,
+    UCP_RDESC_ANY_SRC_LIST = 2,
+    UCP_RDESC_LIST_LAST
 };
 
 
+/**
+ * Completion of a request which has a user cookie, see ucp_request_set_cookie().
+ */
+typedef struct ucp_request_cq_entry {
+    ucs_queue_elem_t              queue;   /* Element in worker completion queue */
+    ucp_worker_h                  worker;  /* Worker to report completion to */
+    ucp_request_t                 *req;    /* Request, or NULL if it was released
+                                              before the completion was polled */
+    void                          *cookie; /* User cookie of the completion */
+} ucp_request_cq_entry_t;
+
+
 /**
  * Request in progress.
  */
@@ -96,6 +114,8 @@ struct ucp_request {
         /* "send" part - used for tag_send, stream_send,  put, get, and atomic
          * operations */
         struct {
+            ucp_request_cq_entry_t *cq;     /* Completion queue entry, must be
+                                               first, see ucp_request_cq() */
             ucp_ep_h              ep;
             void                  *buffer;  /* Send buffer */
             ucp_datatype_t        datatype; /* Send type */
@@ -109,7 +129,8 @@ struct ucp_request {
 
                 /* Tagged send */
                 struct {
-                    ucp_tag_t        tag;
+                    ucp_tag_t        tag;         /* Tag, or packed header of
+                                                     active message */
                     uint64_t         message_id;  /* message ID used in AM */
                     ucp_lane_index_t am_bw_index; /* AM BW lane index */
                     uintptr_t        rreq_ptr;    /* receive request ptr on the
@@ -119,6 +140,10 @@ struct ucp_request {
                 struct {
                     uint64_t      remote_addr; /* Remote address */
                     ucp_rkey_h    rkey;     /* Remote memory key */
+                    void          *aggr_buffer; /* Buffer of aggregated puts,
+                                                   released on completion */
+                    ucp_rma_counter_h counter; /* Counter to increment on
+                                                  completion */
                 } rma;
 
                 struct {
@@ -126,6 +151,8 @@ struct ucp_request {
                     uint8_t       am_id;
                     ucs_status_t  status;
                     ucp_tag_t     sender_tag;  /* Sender tag, which is sent back in sync ack */
+                    uint8_t       eager_pause; /* Whether to pause eager protocol,
+                                                  sent in eager flow control */
                     ucp_request_callback_t comp_cb; /* Called to complete the request */
                 } proto;
 
@@ -141,6 +168,8 @@ struct ucp_request {
                     ucp_rkey_h           rkey;           /* key for remote send buffer */
                     ucp_lane_map_t       lanes_map;      /* used lanes map */
                     ucp_lane_index_t     lane_count;     /* number of lanes used in transaction */
+                    double               lanes_scale;    /* sum of bandwidth scale
+                                                            factors of the used lanes */
                 } rndv_get;
 
                 struct {
@@ -209,12 +238,17 @@ struct ucp_request {
             ucp_lane_index_t      pending_lane; /* Lane on which request was moved
                                                  * to pending state */
             ucp_lane_index_t      lane;     /* Lane on which this request is being sent */
+            uint8_t               tune_proto; /* Protocol to account the send
+                                                 time to */
             uct_pending_req_t     uct;      /* UCT pending request */
             ucp_mem_desc_t        *mdesc;
+            ucs_time_t            tune_start; /* Send start time, when the
+                                                 protocol tuning is enabled */
         } send;
 
         /* "receive" part - used for tag_recv and stream_recv operations */
         struct {
+            ucp_request_cq_entry_t *cq;     /* Completion queue entry */
             ucs_queue_elem_t      queue;    /* Expected queue element */
             void                  *buffer;  /* Buffer to receive data to */
             ucp_datatype_t        datatype; /* Receive type */
@@ -236,6 +270,9 @@ struct ucp_request {
                     ucp_worker_iface_t      *wiface;  /* Cached iface this request
                                                          is received on. Used in
                                                          tag offload expected callbacks*/
+                    ucp_recv_desc_t         *stream_rdesc; /* Stream data descriptor,
+                                                              if receiving stream
+                                                              data with rendezvous */
                 } tag;
 
                 struct {
@@ -247,11 +284,14 @@ struct ucp_request {
         } recv;
 
         struct {
+            ucp_request_cq_entry_t *cq;     /* Completion queue entry */
             ucp_worker_h          worker;   /* Worker to flush */
             ucp_send_callback_t   cb;       /* Completion callback */
             uct_worker_cb_id_t    prog_id;  /* Progress callback ID */
             int                   comp_count; /* Countdown to request completion */
             ucp_ep_ext_gen_t      *next_ep; /* Next endpoint to flush */
+            ucp_request_t         *next_req; /* Worker flush which starts after
+                                                this one is completed */
         } flush_worker;
     };
 };
@@ -274,9 +314,22 @@ struct ucp_request {
  */
 struct ucp_recv_desc {
     union {
-        ucs_list_link_t     tag_list[2];    /* Hash list TAG-element */
+        ucs_list_link_t     tag_list[UCP_RDESC_LIST_LAST];
+                                            /* Hash lists TAG-element */
         ucs_queue_elem_t    stream_queue;   /* Queue STREAM-element */
         ucs_queue_elem_t    tag_frag_queue; /* Tag fragments queue */
+        ucp_ep_h            am_reply_ep;    /* Sender endpoint of active message
+                                               received with rendezvous */
+        struct {
+            ucs_queue_elem_t queue;         /* Same as stream_queue */
+            ucp_ep_h         ep;            /* Receiving endpoint, or NULL if it
+                                               was closed */
+            ucp_request_t    *rreq;         /* Posted receive request the data
+                                               is fetched to, or NULL if the
+                                               data is fetched to the
+                                               descriptor */
+        } stream_rndv;                      /* Stream data received with
+                                               rendezvous */
     };
     uint32_t                length;         /* Received length */
     uint32_t                payload_offset; /* Offset from end of the descriptor
@@ -292,6 +345,7 @@ struct ucp_recv_desc {
 
 extern ucs_mpool_ops_t ucp_request_mpool_ops;
 extern ucs_mpool_ops_t ucp_rndv_get_mpool_ops;
+extern ucs_mpool_ops_t ucp_request_cq_mpool_ops;
 
 
 int ucp_request_pending_add(ucp_request_t *req, ucs_status_t *req_status,
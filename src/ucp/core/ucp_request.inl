@@ -13,6 +13,8 @@
 
 #include <ucp/core/ucp_worker.h>
 #include <ucp/dt/dt.h>
+#include <ucp/proto/proto_tune.h>
+#include <ucs/config/global_opts.h>
 #include <ucs/profile/profile.h>
 #include <ucs/datastruct/mpool.inl>
 #include <ucp/dt/dt.inl>
@@ -20,19 +22,20 @@
 
 
 #define UCP_REQUEST_FLAGS_FMT \
-    "%c%c%c%c%c%c%c"
+    "%c%c%c%c%c%c%c%c"
 
 #define UCP_REQUEST_FLAGS_ARG(_flags) \
-    (((_flags) & UCP_REQUEST_FLAG_COMPLETED)       ? 'd' : '-'), \
-    (((_flags) & UCP_REQUEST_FLAG_RELEASED)        ? 'f' : '-'), \
-    (((_flags) & UCP_REQUEST_FLAG_EXPECTED)        ? 'e' : '-'), \
-    (((_flags) & UCP_REQUEST_FLAG_LOCAL_COMPLETED) ? 'L' : '-'), \
-    (((_flags) & UCP_REQUEST_FLAG_CALLBACK)        ? 'c' : '-'), \
-    (((_flags) & UCP_REQUEST_FLAG_RECV)            ? 'r' : '-'), \
-    (((_flags) & UCP_REQUEST_FLAG_SYNC)            ? 's' : '-')
+    (((_flags) & UCP_REQUEST_FLAG_COMPLETED)        ? 'd' : '-'), \
+    (((_flags) & UCP_REQUEST_FLAG_RELEASED)         ? 'f' : '-'), \
+    (((_flags) & UCP_REQUEST_FLAG_COMPLETION_QUEUE) ? 'q' : '-'), \
+    (((_flags) & UCP_REQUEST_FLAG_EXPECTED)         ? 'e' : '-'), \
+    (((_flags) & UCP_REQUEST_FLAG_LOCAL_COMPLETED)  ? 'L' : '-'), \
+    (((_flags) & UCP_REQUEST_FLAG_CALLBACK)         ? 'c' : '-'), \
+    (((_flags) & UCP_REQUEST_FLAG_RECV)             ? 'r' : '-'), \
+    (((_flags) & UCP_REQUEST_FLAG_SYNC)             ? 's' : '-')
 
 #define UCP_RECV_DESC_FMT \
-    "rdesc %p %c%c%c%c%c%c len %u+%u"
+    "rdesc %p %c%c%c%c%c%c%c len %u+%u"
 
 #define UCP_RECV_DESC_ARG(_rdesc) \
     (_rdesc), \
@@ -42,6 +45,7 @@
     (((_rdesc)->flags & UCP_RECV_DESC_FLAG_EAGER_SYNC)    ? 's' : '-'), \
     (((_rdesc)->flags & UCP_RECV_DESC_FLAG_EAGER_OFFLOAD) ? 'f' : '-'), \
     (((_rdesc)->flags & UCP_RECV_DESC_FLAG_RNDV)          ? 'r' : '-'), \
+    (((_rdesc)->flags & UCP_RECV_DESC_FLAG_MALLOC)        ? 'm' : '-'), \
     (_rdesc)->payload_offset, \
     ((_rdesc)->length - (_rdesc)->payload_offset)
 
@@ -66,8 +70,9 @@
             (_req)->_cb((_req) + 1, (_status), ## __VA_ARGS__); \
         } \
         if (ucs_unlikely(((_req)->flags  |= UCP_REQUEST_FLAG_COMPLETED) & \
-                         UCP_REQUEST_FLAG_RELEASED)) { \
-            ucp_request_put(_req); \
+                         (UCP_REQUEST_FLAG_RELEASED | \
+                          UCP_REQUEST_FLAG_COMPLETION_QUEUE))) { \
+            ucp_request_complete_slow(_req); \
         } \
     }
 
@@ -87,6 +92,31 @@ ucp_request_put(ucp_request_t *req)
     ucs_mpool_put_inline(req);
 }
 
+/* Completion queue entry of a request which has a user cookie */
+static UCS_F_ALWAYS_INLINE ucp_request_cq_entry_t**
+ucp_request_cq(ucp_request_t *req)
+{
+    UCS_STATIC_ASSERT(ucs_offsetof(ucp_request_t, send.cq) ==
+                      ucs_offsetof(ucp_request_t, recv.cq));
+    UCS_STATIC_ASSERT(ucs_offsetof(ucp_request_t, send.cq) ==
+                      ucs_offsetof(ucp_request_t, flush_worker.cq));
+    return &req->send.cq;
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_request_complete_slow(ucp_request_t *req)
+{
+    ucp_request_cq_entry_t *entry;
+
+    if (req->flags & UCP_REQUEST_FLAG_RELEASED) {
+        ucp_request_put(req);
+    } else {
+        ucs_assert(req->flags & UCP_REQUEST_FLAG_COMPLETION_QUEUE);
+        entry = *ucp_request_cq(req);
+        ucs_queue_push(&entry->worker->completions, &entry->queue);
+    }
+}
+
 static UCS_F_ALWAYS_INLINE void
 ucp_request_complete_send(ucp_request_t *req, ucs_status_t status)
 {
@@ -94,6 +124,14 @@ ucp_request_complete_send(ucp_request_t *req, ucs_status_t status)
                   req, req + 1, UCP_REQUEST_FLAGS_ARG(req->flags),
                   ucs_status_string(status));
     UCS_PROFILE_REQUEST_EVENT(req, "complete_send", status);
+    if (ucs_unlikely(req->flags & UCP_REQUEST_FLAG_PROTO_TUNE)) {
+        if (status == UCS_OK) {
+            ucp_proto_tune_sample(ucp_ep_config(req->send.ep), req->send.length,
+                                  (ucp_proto_tune_id_t)req->send.tune_proto,
+                                  ucs_get_time() - req->send.tune_start);
+        }
+        req->flags &= ~UCP_REQUEST_FLAG_PROTO_TUNE;
+    }
     ucp_request_complete(req, send.cb, status);
 }
 
@@ -227,6 +265,25 @@ void ucp_request_recv_generic_dt_finish(ucp_request_t *req)
     }
 }
 
+/*
+ * Decide by the total length of a send request whether its data is packed to
+ * transport buffers with non-temporal stores. The decision is made once, so
+ * all fragments of a message are copied the same way.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucp_request_send_nontemporal_init(ucp_request_t *req)
+{
+    if (ucs_unlikely(req->send.length >= ucs_global_opts.memcpy_nt_thresh)) {
+        req->flags |= UCP_REQUEST_FLAG_PACK_NONTEMPORAL;
+    }
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_request_pack_nontemporal(const ucp_request_t *req)
+{
+    return req->flags & UCP_REQUEST_FLAG_PACK_NONTEMPORAL;
+}
+
 static UCS_F_ALWAYS_INLINE void
 ucp_request_send_state_init(ucp_request_t *req, ucp_datatype_t datatype,
                             size_t dt_count)
@@ -243,6 +300,7 @@ ucp_request_send_state_init(ucp_request_t *req, ucp_datatype_t datatype,
 
     switch (datatype & UCP_DATATYPE_CLASS_MASK) {
     case UCP_DATATYPE_CONTIG:
+    case UCP_DATATYPE_STRIDED:
         req->send.state.dt.dt.contig.md_map     = 0;
         return;
     case UCP_DATATYPE_IOV:
@@ -456,6 +514,11 @@ ucp_request_recv_data_unpack(ucp_request_t *req, const void *data,
         req->recv.state.offset += length;
         return UCS_OK;
 
+    case UCP_DATATYPE_STRIDED:
+        UCS_PROFILE_CALL_VOID(ucp_dt_strided_scatter, req->recv.buffer,
+                              req->recv.datatype, data, offset, length);
+        return UCS_OK;
+
     case UCP_DATATYPE_GENERIC:
         dt_gen = ucp_dt_generic(req->recv.datatype);
         status = UCS_PROFILE_NAMED_CALL("dt_unpack", dt_gen->ops.unpack,
@@ -520,6 +583,8 @@ ucp_recv_desc_release(ucp_recv_desc_t *rdesc)
         uct_iface_release_desc(UCS_PTR_BYTE_OFFSET(rdesc,
                                                    -(UCP_WORKER_HEADROOM_PRIV_SIZE -
                                                      rdesc->priv_length)));
+    } else if (ucs_unlikely(rdesc->flags & UCP_RECV_DESC_FLAG_MALLOC)) {
+        ucs_free(rdesc);
     } else {
         ucs_mpool_put_inline(rdesc);
     }
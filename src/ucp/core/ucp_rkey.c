@@ -6,13 +6,65 @@
 
 #include "ucp_mm.h"
 #include "ucp_request.h"
+#include "ucp_worker.h"
 #include "ucp_ep.inl"
 
 #include <ucp/rma/rma.h>
+#include <ucs/algorithm/crc.h>
 #include <ucs/datastruct/mpool.inl>
+#include <ucs/datastruct/shash.h>
 #include <inttypes.h>
 
 
+/* Packed remote key, used to look up the unpack cache */
+typedef struct {
+    const void                    *buffer;
+    size_t                        length;
+} ucp_rkey_cache_key_t;
+
+
+struct ucp_rkey_cache_entry {
+    ucp_rkey_cache_t              *cache;    /* Owner cache, or NULL if the
+                                                endpoint was destroyed */
+    ucp_rkey_h                    rkey;      /* Unpacked remote key */
+    unsigned                      refcount;  /* Number of unpack calls which
+                                                returned the key */
+    ucs_list_link_t               list;      /* Entry in the released keys list */
+    size_t                        length;    /* Length of the packed key */
+    uint8_t                       buffer[0]; /* Packed key */
+};
+
+
+static UCS_F_ALWAYS_INLINE uint64_t
+ucp_rkey_cache_key_hash(ucp_rkey_cache_key_t key)
+{
+    return ucs_crc16(key.buffer, key.length);
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_rkey_cache_key_equal(ucp_rkey_cache_key_t key1, ucp_rkey_cache_key_t key2)
+{
+    return (key1.length == key2.length) &&
+           !memcmp(key1.buffer, key2.buffer, key1.length);
+}
+
+UCS_SHASH_INIT(ucp_rkey_cache, ucp_rkey_cache_key_t, ucp_rkey_h, 1,
+               ucp_rkey_cache_key_hash, ucp_rkey_cache_key_equal);
+
+
+/**
+ * Remote keys unpacked on an endpoint, by their packed buffer. Keys which were
+ * destroyed by the user are kept on the released list, up to the configured
+ * limit, in order of release.
+ */
+struct ucp_rkey_cache {
+    ucp_ep_h                      ep;
+    ucs_shash_t(ucp_rkey_cache)   hash;
+    ucs_list_link_t               released;
+    unsigned                      num_released;
+};
+
+
 static struct {
     ucp_md_map_t md_map;
     uint8_t      mem_type;
@@ -164,8 +216,8 @@ void ucp_rkey_buffer_release(void *rkey_buffer)
     ucs_free(rkey_buffer);
 }
 
-ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, const void *rkey_buffer,
-                                ucp_rkey_h *rkey_p)
+ucs_status_t ucp_ep_rkey_unpack_uncached(ucp_ep_h ep, const void *rkey_buffer,
+                                         ucp_rkey_h *rkey_p)
 {
     ucp_context_t *context = ep->worker->context;
     unsigned remote_md_index;
@@ -210,8 +262,9 @@ ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, const void *rkey_buffer,
     /* Read memory type */
     mem_type = *((uint8_t*)p++);
 
-    rkey->md_map   = md_map;
-    rkey->mem_type = mem_type;
+    rkey->md_map      = md_map;
+    rkey->mem_type    = mem_type;
+    rkey->cache_entry = NULL;
 #if ENABLE_PARAMS_CHECK
     rkey->ep       = ep;
 #endif
@@ -265,6 +318,215 @@ err:
     return status;
 }
 
+static size_t ucp_rkey_packed_length(const void *rkey_buffer)
+{
+    const void *p = rkey_buffer;
+    ucp_md_map_t md_map;
+    unsigned md_index;
+
+    md_map = *(ucp_md_map_t*)p;
+    p     += sizeof(ucp_md_map_t) + sizeof(uint8_t);
+    ucs_for_each_bit(md_index, md_map) {
+        p += sizeof(uint8_t) + *(uint8_t*)p;
+    }
+
+    return p - rkey_buffer;
+}
+
+static void ucp_rkey_release(ucp_rkey_h rkey)
+{
+    ucp_context_h UCS_V_UNUSED context;
+    unsigned num_rkeys;
+    unsigned i;
+
+    num_rkeys = ucs_popcount(rkey->md_map);
+
+    for (i = 0; i < num_rkeys; ++i) {
+        uct_rkey_release(&rkey->uct[i]);
+    }
+
+    if (ucs_popcount(rkey->md_map) <= UCP_RKEY_MPOOL_MAX_MD) {
+        context = ucs_container_of(ucs_mpool_obj_owner(rkey), ucp_context_t,
+                                   rkey_mp);
+        UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
+        ucs_mpool_put_inline(rkey);
+        UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
+    } else {
+        ucs_free(rkey);
+    }
+}
+
+static void ucp_rkey_cache_entry_free(ucp_rkey_cache_entry_t *entry)
+{
+    ucp_rkey_release(entry->rkey);
+    ucs_free(entry);
+}
+
+static void ucp_rkey_cache_evict(ucp_rkey_cache_t *cache)
+{
+    ucp_rkey_cache_entry_t *entry;
+    ucp_rkey_cache_key_t key;
+    ucs_shash_iter_t iter;
+
+    entry = ucs_list_extract_head(&cache->released, ucp_rkey_cache_entry_t,
+                                  list);
+    --cache->num_released;
+
+    key.buffer = entry->buffer;
+    key.length = entry->length;
+    iter       = ucs_shash_get(ucp_rkey_cache, &cache->hash, key);
+    ucs_assert(iter != ucs_shash_end(&cache->hash));
+    ucs_shash_del(ucp_rkey_cache, &cache->hash, iter);
+
+    ucs_trace("ep %p: evicted rkey %p from unpack cache", cache->ep,
+              entry->rkey);
+    ucp_rkey_cache_entry_free(entry);
+}
+
+static ucs_status_t
+ucp_rkey_cache_unpack(ucp_ep_h ep, const void *rkey_buffer, ucp_rkey_h *rkey_p)
+{
+    ucp_rkey_cache_t *cache = ucp_ep_ext_gen(ep)->rkey_cache;
+    ucp_rkey_cache_entry_t *entry;
+    ucp_rkey_cache_key_t key;
+    ucs_shash_iter_t iter;
+    ucs_status_t status;
+    ucp_rkey_h rkey;
+    int ret;
+
+    if (cache == NULL) {
+        cache = ucs_malloc(sizeof(*cache), "ucp_rkey_cache");
+        if (cache == NULL) {
+            return UCS_ERR_NO_MEMORY;
+        }
+
+        cache->ep           = ep;
+        cache->num_released = 0;
+        ucs_list_head_init(&cache->released);
+        ucs_shash_init_inplace(ucp_rkey_cache, &cache->hash);
+        ucp_ep_ext_gen(ep)->rkey_cache = cache;
+    }
+
+    key.buffer = rkey_buffer;
+    key.length = ucp_rkey_packed_length(rkey_buffer);
+    iter       = ucs_shash_get(ucp_rkey_cache, &cache->hash, key);
+    if (iter != ucs_shash_end(&cache->hash)) {
+        rkey  = ucs_shash_value(&cache->hash, iter);
+        entry = rkey->cache_entry;
+        if (entry->refcount++ == 0) {
+            ucs_list_del(&entry->list);
+            --cache->num_released;
+        }
+
+        ucs_trace("ep %p: found rkey %p in unpack cache, refcount %u", ep,
+                  rkey, entry->refcount);
+        *rkey_p = rkey;
+        return UCS_OK;
+    }
+
+    entry = ucs_malloc(sizeof(*entry) + key.length, "ucp_rkey_cache_entry");
+    if (entry == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err;
+    }
+
+    status = ucp_ep_rkey_unpack_uncached(ep, rkey_buffer, &rkey);
+    if (status != UCS_OK) {
+        goto err_free_entry;
+    }
+
+    memcpy(entry->buffer, rkey_buffer, key.length);
+    entry->cache    = cache;
+    entry->rkey     = rkey;
+    entry->refcount = 1;
+    entry->length   = key.length;
+
+    key.buffer = entry->buffer;
+    iter       = ucs_shash_put(ucp_rkey_cache, &cache->hash, key, &ret);
+    if (ret < 0) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err_destroy_rkey;
+    }
+
+    ucs_shash_value(&cache->hash, iter) = rkey;
+    rkey->cache_entry                   = entry;
+    *rkey_p                             = rkey;
+    return UCS_OK;
+
+err_destroy_rkey:
+    ucp_rkey_release(rkey);
+err_free_entry:
+    ucs_free(entry);
+err:
+    return status;
+}
+
+ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, const void *rkey_buffer,
+                                ucp_rkey_h *rkey_p)
+{
+    ucp_worker_h worker = ep->worker;
+    ucs_status_t status;
+
+    if (worker->context->config.ext.rkey_unpack_cache == 0) {
+        return ucp_ep_rkey_unpack_uncached(ep, rkey_buffer, rkey_p);
+    }
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    status = ucp_rkey_cache_unpack(ep, rkey_buffer, rkey_p);
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+
+    return status;
+}
+
+static void ucp_rkey_cache_release(ucp_rkey_h rkey)
+{
+    ucp_rkey_cache_entry_t *entry = rkey->cache_entry;
+    ucp_rkey_cache_t *cache       = entry->cache;
+    ucp_worker_h worker;
+
+    if (cache == NULL) {
+        /* The endpoint was destroyed, the key is no longer cached */
+        if (--entry->refcount == 0) {
+            ucp_rkey_cache_entry_free(entry);
+        }
+        return;
+    }
+
+    worker = cache->ep->worker;
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    ucs_assert(entry->refcount > 0);
+    if (--entry->refcount == 0) {
+        ucs_list_add_tail(&cache->released, &entry->list);
+        if (++cache->num_released >
+            worker->context->config.ext.rkey_unpack_cache) {
+            ucp_rkey_cache_evict(cache);
+        }
+    }
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+}
+
+void ucp_rkey_cache_purge(ucp_ep_h ep)
+{
+    ucp_rkey_cache_t *cache = ucp_ep_ext_gen(ep)->rkey_cache;
+    ucp_rkey_h rkey;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    ucs_shash_foreach_value(&cache->hash, rkey, {
+        if (rkey->cache_entry->refcount == 0) {
+            ucp_rkey_cache_entry_free(rkey->cache_entry);
+        } else {
+            rkey->cache_entry->cache = NULL;
+        }
+    });
+
+    ucs_shash_destroy_inplace(ucp_rkey_cache, &cache->hash);
+    ucs_free(cache);
+    ucp_ep_ext_gen(ep)->rkey_cache = NULL;
+}
+
 void ucp_rkey_dump_packed(const void *rkey_buffer, char *buffer, size_t max)
 {
     char *p       = buffer;
@@ -327,24 +589,10 @@ ucs_status_t ucp_rkey_ptr(ucp_rkey_h rkey, uint64_t raddr, void **addr_p)
 
 void ucp_rkey_destroy(ucp_rkey_h rkey)
 {
-    ucp_context_h UCS_V_UNUSED context;
-    unsigned num_rkeys;
-    unsigned i;
-
-    num_rkeys = ucs_popcount(rkey->md_map);
-
-    for (i = 0; i < num_rkeys; ++i) {
-        uct_rkey_release(&rkey->uct[i]);
-    }
-
-    if (ucs_popcount(rkey->md_map) <= UCP_RKEY_MPOOL_MAX_MD) {
-        context = ucs_container_of(ucs_mpool_obj_owner(rkey), ucp_context_t,
-                                   rkey_mp);
-        UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
-        ucs_mpool_put_inline(rkey);
-        UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
+    if (rkey->cache_entry != NULL) {
+        ucp_rkey_cache_release(rkey);
     } else {
-        ucs_free(rkey);
+        ucp_rkey_release(rkey);
     }
 }
 
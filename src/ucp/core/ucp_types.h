@@ -16,6 +16,7 @@
 #define UCP_WORKER_NAME_MAX          32   /* Worker name for debugging */
 #define UCP_MIN_BCOPY                64   /* Minimal size for bcopy */
 #define UCP_FEATURE_AMO              (UCP_FEATURE_AMO32|UCP_FEATURE_AMO64)
+#define UCP_FEATURE_AM               UCP_FEATURE_EXPERIMENTAL /* Active messages */
 
 /* Resources */
 #define UCP_MAX_RESOURCES            64 /* up to 64 only due to tl_bitmap usage */
@@ -45,10 +46,16 @@ typedef struct ucp_recv_desc            ucp_recv_desc_t;
 typedef struct ucp_address_iface_attr   ucp_address_iface_attr_t;
 typedef struct ucp_address_entry        ucp_address_entry_t;
 typedef struct ucp_unpacked_address     ucp_unpacked_address_t;
+typedef struct ucp_address_template     ucp_address_template_t;
+typedef struct ucp_cached_address       ucp_cached_address_t;
+typedef struct ucp_rkey_cache           ucp_rkey_cache_t;
 typedef struct ucp_wireup_ep            ucp_wireup_ep_t;
 typedef struct ucp_proto                ucp_proto_t;
+typedef struct ucp_proto_tune           ucp_proto_tune_t;
+typedef struct ucp_proto_tune_entry     ucp_proto_tune_entry_t;
 typedef struct ucp_worker_iface         ucp_worker_iface_t;
 typedef struct ucp_rma_proto            ucp_rma_proto_t;
+typedef struct ucp_rma_aggr             ucp_rma_aggr_t;
 typedef struct ucp_amo_proto            ucp_amo_proto_t;
 
 
@@ -85,6 +92,20 @@ enum {
     UCP_AM_ID_ATOMIC_REP        =  21, /* Remote memory atomic reply */
     UCP_AM_ID_CMPL              =  22, /* Remote memory operation completion */
 
+    UCP_AM_ID_SINGLE            =  23, /* Single fragment user defined AM */
+    UCP_AM_ID_SINGLE_REPLY      =  24, /* Single fragment user defined AM
+                                          carrying a reply endpoint */
+    UCP_AM_ID_MULTI             =  25, /* Fragment of a multi-fragment user
+                                          defined AM */
+    UCP_AM_ID_AM_RNDV_RTS       =  26, /* Ready-to-Send of a user defined AM
+                                          sent with rendezvous */
+    UCP_AM_ID_STREAM_RNDV_RTS   =  27, /* Ready-to-Send of stream data sent
+                                          with rendezvous */
+    UCP_AM_ID_EAGER_FC          =  28, /* Pause or resume eager protocol of
+                                          tag messages */
+    UCP_AM_ID_ATOMIC_BATCH      =  29, /* Batch of remote memory atomic
+                                          operations without result */
+
     UCP_AM_ID_LAST
 };
 
@@ -5,6 +5,10 @@
 * See file LICENSE for terms.
 */
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include "ucp_worker.h"
 #include "ucp_mm.h"
 #include "ucp_request.inl"
@@ -14,6 +18,8 @@
 #include <ucp/tag/eager.h>
 #include <ucp/tag/offload.h>
 #include <ucp/stream/stream.h>
+#include <ucp/proto/proto_tune.h>
+#include <ucp/rma/rma.h>
 #include <ucs/config/parser.h>
 #include <ucs/datastruct/mpool.inl>
 #include <ucs/datastruct/queue.h>
@@ -21,6 +27,8 @@
 #include <ucs/sys/string.h>
 #include <ucs/arch/atomic.h>
 #include <sys/poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/eventfd.h>
 
 
@@ -269,7 +277,9 @@ static ucs_status_t ucp_worker_wakeup_init(ucp_worker_h worker,
 
     ucp_worker_wakeup_ctl_fd(worker, EPOLL_CTL_ADD, worker->eventfd);
 
-    worker->uct_events = 0;
+    worker->wait.spin_max = ucs_time_from_sec(context->config.ext.wait_spin_time);
+    worker->wait.avg_idle = worker->wait.spin_max;
+    worker->uct_events    = 0;
 
     /* FIXME: any TAG flag initializes all types of completion because of
      *        possible issues in RNDV protocol. The optimization may be
@@ -1325,6 +1335,13 @@ out:
     return status;
 }
 
+static void ucp_worker_cleanup_mpools(ucp_worker_h worker)
+{
+    ucs_mpool_cleanup(&worker->am_mp, 1);
+    ucs_mpool_cleanup(&worker->reg_mp, 1);
+    ucs_mpool_cleanup(&worker->rndv_frag_mp, 1);
+}
+
 /* All the ucp endpoints will share the configurations. No need for every ep to
  * have it's own configuration (to save memory footprint). Same config can be used
  * by different eps.
@@ -1356,11 +1373,195 @@ unsigned ucp_worker_get_ep_config(ucp_worker_h worker,
     memset(config, 0, sizeof(*config));
     config->key = *key;
     ucp_ep_config_init(worker, config);
+    ucp_proto_tune_init(worker, config);
 
 out:
     return config_idx;
 }
 
+static void ucp_worker_progress_thread_set_affinity(ucp_worker_h worker)
+{
+    cpu_set_t cpu_mask;
+    int cpu, ret;
+
+    CPU_ZERO(&cpu_mask);
+    for (cpu = 0; cpu < ucs_min(CPU_SETSIZE, UCS_CPU_SETSIZE); ++cpu) {
+        if (ucs_cpu_is_set(cpu, &worker->cpu_mask)) {
+            CPU_SET(cpu, &cpu_mask);
+        }
+    }
+
+    if (CPU_COUNT(&cpu_mask) == 0) {
+        return;
+    }
+
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_mask), &cpu_mask);
+    if (ret != 0) {
+        ucs_warn("worker %p: failed to set progress thread affinity: %s",
+                 worker, strerror(ret));
+    }
+}
+
+static ucs_status_t ucp_worker_arm_ifaces(ucp_worker_h worker)
+{
+    ucp_worker_iface_t *wiface;
+    ucs_status_t status;
+    uint64_t dummy;
+    int ret;
+
+    /* Read from event pipe. If some events are found, return BUSY,
+     * Otherwise, continue to arm the transport interfaces.
+     */
+    worker->wait.signaled = 0;
+    do {
+        ret = read(worker->eventfd, &dummy, sizeof(dummy));
+        if (ret == sizeof(dummy)) {
+            status = UCS_ERR_BUSY;
+            goto out;
+        } else if (ret == -1) {
+            if (errno == EAGAIN) {
+                break; /* No more events */
+            } else if (errno != EINTR) {
+                ucs_error("Read from internal event fd failed: %m");
+                status = UCS_ERR_IO_ERROR;
+                goto out;
+            }
+        } else {
+            ucs_assert(ret == 0);
+        }
+    } while (ret != 0);
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+
+    /* Go over arm_list of active interfaces which support events and arm them */
+    ucs_list_for_each(wiface, &worker->arm_ifaces, arm_list) {
+        ucs_assert(wiface->activate_count > 0);
+        status = uct_iface_event_arm(wiface->iface, worker->uct_events);
+        ucs_trace("arm iface %p returned %s", wiface->iface,
+                  ucs_status_string(status));
+        if (status != UCS_OK) {
+            goto out_unlock;
+        }
+    }
+
+    status = UCS_OK;
+
+out_unlock:
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+out:
+    ucs_trace("ucp_worker_arm returning %s", ucs_status_string(status));
+    return status;
+}
+
+/* The progress thread owns the worker event fd, so the application must not
+ * arm it or wait on it */
+static ucs_status_t ucp_worker_check_user_wakeup(ucp_worker_h worker,
+                                                 const char *func_name)
+{
+    if (ucs_unlikely(worker->flags & UCP_WORKER_FLAG_PROGRESS_THREAD)) {
+        ucs_error("worker %p: %s() is not supported on a worker with a "
+                  "progress thread", worker, func_name);
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    return UCS_OK;
+}
+
+/*
+ * Sleep until there are events on the worker. ucp_worker_wait() is not used,
+ * since it holds the worker lock while sleeping, which would block the
+ * application threads.
+ */
+static void ucp_worker_progress_thread_sleep(ucp_worker_h worker)
+{
+    struct pollfd pfd;
+    int ret;
+
+    if (ucp_worker_arm_ifaces(worker) != UCS_OK) {
+        return;
+    }
+
+    pfd.fd      = worker->epfd;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+    do {
+        ret = poll(&pfd, 1, -1);
+    } while ((ret < 0) && (errno == EINTR));
+
+    if (ret < 0) {
+        ucs_error("worker %p: poll(fd=%d) failed: %m", worker, worker->epfd);
+    }
+}
+
+static void ucp_worker_ep_configs_cleanup(ucp_worker_h worker)
+{
+    unsigned i;
+
+    for (i = 0; i < worker->ep_config_count; ++i) {
+        ucp_proto_tune_cleanup(&worker->ep_config[i]);
+    }
+}
+
+static void *ucp_worker_progress_thread_func(void *arg)
+{
+    ucp_worker_h worker = arg;
+    int can_sleep;
+
+    can_sleep = worker->context->config.features & UCP_FEATURE_WAKEUP;
+
+    ucp_worker_progress_thread_set_affinity(worker);
+    ucs_debug("worker %p: progress thread started, %s", worker,
+              can_sleep ? "sleeping on events" : "polling");
+
+    while (!worker->progress_thread_stop) {
+        if (ucp_worker_progress(worker) != 0) {
+            continue;
+        }
+
+        if (can_sleep) {
+            ucp_worker_progress_thread_sleep(worker);
+        } else {
+            sched_yield();
+        }
+    }
+
+    ucs_debug("worker %p: progress thread stopped", worker);
+    return NULL;
+}
+
+static ucs_status_t ucp_worker_progress_thread_start(ucp_worker_h worker)
+{
+    int ret;
+
+    worker->progress_thread_stop = 0;
+    worker->flags               |= UCP_WORKER_FLAG_PROGRESS_THREAD;
+    ret = pthread_create(&worker->progress_thread, NULL,
+                         ucp_worker_progress_thread_func, worker);
+    if (ret != 0) {
+        ucs_error("pthread_create() returned %d: %s", ret, strerror(ret));
+        worker->flags &= ~UCP_WORKER_FLAG_PROGRESS_THREAD;
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+}
+
+static void ucp_worker_progress_thread_stop(ucp_worker_h worker)
+{
+    if (!(worker->flags & UCP_WORKER_FLAG_PROGRESS_THREAD)) {
+        return;
+    }
+
+    worker->progress_thread_stop = 1;
+    if (worker->context->config.features & UCP_FEATURE_WAKEUP) {
+        /* wake up the thread if it sleeps on the event fd */
+        ucp_worker_wakeup_signal_fd(worker);
+    }
+
+    pthread_join(worker->progress_thread, NULL);
+    worker->flags &= ~UCP_WORKER_FLAG_PROGRESS_THREAD;
+}
+
 ucs_status_t ucp_worker_create(ucp_context_h context,
                                const ucp_worker_params_t *params,
                                ucp_worker_h *worker_p)
@@ -1369,12 +1570,27 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     ucs_thread_mode_t thread_mode;
     unsigned config_count;
     unsigned name_length;
+    uint64_t flags;
     ucp_worker_h worker;
     ucs_status_t status;
 
+    flags        = UCP_PARAM_VALUE(WORKER, params, flags, FLAGS, 0);
     config_count = ucs_min((context->num_tls + 1) * (context->num_tls + 1) * context->num_tls,
                            UINT8_MAX);
 
+#if !ENABLE_MT
+    if (flags & UCP_WORKER_PARAM_FLAG_PROGRESS_THREAD) {
+        ucs_error("progress thread requires multi-threading support");
+        return UCS_ERR_UNSUPPORTED;
+    }
+#endif
+
+    if ((flags & UCP_WORKER_PARAM_FLAG_PROGRESS_THREAD) &&
+        (params->field_mask & UCP_WORKER_PARAM_FIELD_EVENT_FD)) {
+        ucs_error("progress thread cannot be used with an external event fd");
+        return UCS_ERR_INVALID_PARAM;
+    }
+
     worker = ucs_calloc(1, sizeof(*worker) +
                            sizeof(*worker->ep_config) * config_count,
                         "ucp worker");
@@ -1395,8 +1611,16 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         thread_mode = UCS_THREAD_MODE_SINGLE;
     }
 
+    if (flags & UCP_WORKER_PARAM_FLAG_PROGRESS_THREAD) {
+        /* the worker is shared by the progress thread and the user */
+        thread_mode = UCS_THREAD_MODE_MULTI;
+    }
+
     if (thread_mode == UCS_THREAD_MODE_MULTI) {
         worker->flags = UCP_WORKER_FLAG_MT;
+        if (context->config.ext.progress_trylock) {
+            worker->flags |= UCP_WORKER_FLAG_PROGRESS_TRYLOCK;
+        }
     } else {
         worker->flags = 0;
     }
@@ -1415,13 +1639,19 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     worker->ep_config_max     = config_count;
     worker->ep_config_count   = 0;
     worker->num_active_ifaces = 0;
+    worker->am_cbs            = NULL;
+    worker->am_cb_array_len   = 0;
     ucs_list_head_init(&worker->arm_ifaces);
     ucs_list_head_init(&worker->stream_ready_eps);
     ucs_list_head_init(&worker->all_eps);
+    ucs_list_head_init(&worker->rma_aggr_eps);
+    worker->flush_req_last = NULL;
+    ucs_queue_head_init(&worker->completions);
     ucp_ep_match_init(&worker->ep_match_ctx);
 
     UCS_STATIC_ASSERT(sizeof(ucp_ep_ext_gen_t) <= sizeof(ucp_ep_t));
-    if (context->config.features & UCP_FEATURE_STREAM) {
+    if ((context->config.features & (UCP_FEATURE_STREAM | UCP_FEATURE_AM)) ||
+        ucp_rma_aggr_is_enabled(context)) {
         UCS_STATIC_ASSERT(sizeof(ucp_ep_ext_proto_t) <= sizeof(ucp_ep_t));
         ucs_strided_alloc_init(&worker->ep_alloc, sizeof(ucp_ep_t), 3);
     } else {
@@ -1476,10 +1706,18 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         goto err_destroy_uct_worker;
     }
 
+    /* Create memory pool for completions of requests with a user cookie */
+    status = ucs_mpool_init(&worker->cq_mp, 0, sizeof(ucp_request_cq_entry_t),
+                            0, 1, 128, UINT_MAX, &ucp_request_cq_mpool_ops,
+                            "ucp_cq_entries");
+    if (status != UCS_OK) {
+        goto err_req_mp_cleanup;
+    }
+
     /* Create epoll set which combines events from all transports */
     status = ucp_worker_wakeup_init(worker, params);
     if (status != UCS_OK) {
-        goto err_req_mp_cleanup;
+        goto err_cq_mp_cleanup;
     }
 
     if (params->field_mask & UCP_WORKER_PARAM_FIELD_CPU_MASK) {
@@ -1489,7 +1727,10 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     }
 
     /* Initialize tag matching */
-    status = ucp_tag_match_init(&worker->tm);
+    status = ucp_tag_match_init(&worker->tm, context->config.tag_sender_mask,
+                                context->config.ext.tm_unexp_max,
+                                (worker->flags & UCP_WORKER_FLAG_MT) ?
+                                UCP_MT_TYPE_SPINLOCK : UCP_MT_TYPE_NONE);
     if (status != UCS_OK) {
         goto err_wakeup_cleanup;
     }
@@ -1509,7 +1750,7 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     /* Init AM and registered memory pools */
     status = ucp_worker_init_mpools(worker);
     if (status != UCS_OK) {
-        goto err_close_ifaces;
+        goto err_destroy_mem_type_eps;
     }
 
     /* Select atomic resources */
@@ -1520,14 +1761,28 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
      */
     ucs_config_parser_warn_unused_env_vars();
 
+    if (flags & UCP_WORKER_PARAM_FLAG_PROGRESS_THREAD) {
+        status = ucp_worker_progress_thread_start(worker);
+        if (status != UCS_OK) {
+            goto err_cleanup_mpools;
+        }
+    }
+
     *worker_p = worker;
     return UCS_OK;
 
+err_cleanup_mpools:
+    ucp_worker_cleanup_mpools(worker);
+err_destroy_mem_type_eps:
+    ucp_worker_destroy_mem_type_endpoints(worker);
 err_close_ifaces:
+    ucp_worker_ep_configs_cleanup(worker);
     ucp_worker_close_ifaces(worker);
     ucp_tag_match_cleanup(&worker->tm);
 err_wakeup_cleanup:
     ucp_worker_wakeup_cleanup(worker);
+err_cq_mp_cleanup:
+    ucs_mpool_cleanup(&worker->cq_mp, 1);
 err_req_mp_cleanup:
     ucs_mpool_cleanup(&worker->req_mp, 1);
 err_destroy_uct_worker:
@@ -1544,6 +1799,18 @@ err_free:
     return status;
 }
 
+static void ucp_worker_cq_cleanup(ucp_worker_h worker)
+{
+    ucp_request_cq_entry_t *entry;
+
+    /* release the completions which were not polled */
+    ucs_queue_for_each_extract(entry, &worker->completions, queue, 1) {
+        ucs_mpool_put_inline(entry);
+    }
+
+    ucs_mpool_cleanup(&worker->cq_mp, 1);
+}
+
 static void ucp_worker_destroy_eps(ucp_worker_h worker)
 {
     ucp_ep_ext_gen_t *ep_ext, *tmp;
@@ -1558,17 +1825,21 @@ void ucp_worker_destroy(ucp_worker_h worker)
 {
     ucs_trace_func("worker=%p", worker);
 
+    ucp_worker_progress_thread_stop(worker);
+
     UCS_ASYNC_BLOCK(&worker->async);
     ucp_worker_destroy_eps(worker);
     ucp_worker_remove_am_handlers(worker);
     UCS_ASYNC_UNBLOCK(&worker->async);
 
-    ucs_mpool_cleanup(&worker->am_mp, 1);
-    ucs_mpool_cleanup(&worker->reg_mp, 1);
-    ucs_mpool_cleanup(&worker->rndv_frag_mp, 1);
+    ucp_proto_tune_dump(worker);
+    ucp_worker_ep_configs_cleanup(worker);
+
+    ucp_worker_cleanup_mpools(worker);
     ucp_worker_close_ifaces(worker);
     ucp_tag_match_cleanup(&worker->tm);
     ucp_worker_wakeup_cleanup(worker);
+    ucp_worker_cq_cleanup(worker);
     ucs_mpool_cleanup(&worker->req_mp, 1);
     uct_worker_destroy(worker->uct);
     ucs_async_context_cleanup(&worker->async);
@@ -1576,6 +1847,7 @@ void ucp_worker_destroy(ucp_worker_h worker)
     ucs_strided_alloc_cleanup(&worker->ep_alloc);
     UCS_STATS_NODE_FREE(worker->tm_offload_stats);
     UCS_STATS_NODE_FREE(worker->stats);
+    ucs_free(worker->am_cbs);
     ucs_free(worker);
 }
 
@@ -1622,13 +1894,24 @@ unsigned ucp_worker_progress(ucp_worker_h worker)
 {
     unsigned count;
 
-    /* worker->inprogress is used only for assertion check.
+    if (worker->flags & UCP_WORKER_FLAG_PROGRESS_TRYLOCK) {
+        if (!ucs_async_try_block(&worker->async)) {
+            /* another thread is using the worker, don't wait for it */
+            return 0;
+        }
+    } else {
+        UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    }
+
+    /* check that ucp_worker_progress is not called from within ucp_worker_progress.
+     * worker->inprogress is used only for assertion check.
      * coverity[assert_side_effect]
      */
-    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
-
-    /* check that ucp_worker_progress is not called from within ucp_worker_progress */
     ucs_assert(worker->inprogress++ == 0);
+    if (ucs_unlikely(!ucs_list_is_empty(&worker->rma_aggr_eps))) {
+        /* failed operations remain pending, and are reported by flush */
+        (void)ucp_rma_aggr_flush_all(worker);
+    }
     count = uct_worker_progress(worker->uct);
     ucs_async_check_miss(&worker->async);
 
@@ -1666,6 +1949,37 @@ ssize_t ucp_stream_worker_poll(ucp_worker_h worker,
     return count;
 }
 
+unsigned ucp_worker_poll_completions(ucp_worker_h worker,
+                                     ucp_completion_t *entries,
+                                     unsigned max_entries)
+{
+    unsigned count = 0;
+    ucp_request_cq_entry_t *entry;
+    ucp_request_t *req;
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+
+    while ((count < max_entries) && !ucs_queue_is_empty(&worker->completions)) {
+        entry = ucs_queue_pull_elem_non_empty(&worker->completions,
+                                              ucp_request_cq_entry_t, queue);
+        req   = entry->req;
+        if (req != NULL) {
+            /* otherwise, the request was released before it was polled */
+            ucs_assert(req->flags & UCP_REQUEST_FLAG_COMPLETED);
+            req->flags             &= ~UCP_REQUEST_FLAG_COMPLETION_QUEUE;
+            entries[count].request  = req + 1;
+            entries[count].cookie   = entry->cookie;
+            entries[count].status   = req->status;
+            ++count;
+        }
+        ucs_mpool_put_inline(entry);
+    }
+
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+
+    return count;
+}
+
 ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd)
 {
     ucs_status_t status;
@@ -1673,6 +1987,11 @@ ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd)
     UCP_CONTEXT_CHECK_FEATURE_FLAGS(worker->context, UCP_FEATURE_WAKEUP,
                                     return UCS_ERR_INVALID_PARAM);
 
+    status = ucp_worker_check_user_wakeup(worker, "ucp_worker_get_efd");
+    if (status != UCS_OK) {
+        return status;
+    }
+
     UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
     if (worker->flags & UCP_WORKER_FLAG_EXTERNAL_EVENT_FD) {
         status = UCS_ERR_UNSUPPORTED;
@@ -1686,66 +2005,80 @@ ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd)
 
 ucs_status_t ucp_worker_arm(ucp_worker_h worker)
 {
-    ucp_worker_iface_t *wiface;
     ucs_status_t status;
-    uint64_t dummy;
-    int ret;
 
     ucs_trace_func("worker=%p", worker);
 
     UCP_CONTEXT_CHECK_FEATURE_FLAGS(worker->context, UCP_FEATURE_WAKEUP,
                                     return UCS_ERR_INVALID_PARAM);
 
-    /* Read from event pipe. If some events are found, return BUSY,
-     * Otherwise, continue to arm the transport interfaces.
-     */
+    status = ucp_worker_check_user_wakeup(worker, "ucp_worker_arm");
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    return ucp_worker_arm_ifaces(worker);
+}
+
+void ucp_worker_wait_mem(ucp_worker_h worker, void *address)
+{
+    ucs_arch_wait_mem(address);
+}
+
+static ucs_time_t ucp_worker_wait_spin_time(ucp_worker_h worker)
+{
+    if (!worker->context->config.ext.wait_spin_adaptive) {
+        return worker->wait.spin_max;
+    }
+
+    /* Spin only if the next event is expected before the spin limit */
+    if (worker->wait.avg_idle > worker->wait.spin_max) {
+        return 0;
+    }
+
+    return ucs_min(worker->wait.avg_idle * 2, worker->wait.spin_max);
+}
+
+/* Poll the worker for a while, return nonzero if there was an event */
+static int ucp_worker_wait_spin(ucp_worker_h worker, ucs_time_t start_time)
+{
+    ucs_time_t spin_time = ucp_worker_wait_spin_time(worker);
+    uint64_t dummy;
+
+    if (spin_time == 0) {
+        return 0;
+    }
+
     do {
-        ret = read(worker->eventfd, &dummy, sizeof(dummy));
-        if (ret == sizeof(dummy)) {
-            status = UCS_ERR_BUSY;
-            goto out;
-        } else if (ret == -1) {
-            if (errno == EAGAIN) {
-                break; /* No more events */
-            } else if (errno != EINTR) {
-                ucs_error("Read from internal event fd failed: %m");
-                status = UCS_ERR_IO_ERROR;
-                goto out;
+        if (worker->wait.signaled) {
+            /* consume the signal, so the next wait would not wake up */
+            worker->wait.signaled = 0;
+            if (read(worker->eventfd, &dummy, sizeof(dummy)) < 0) {
+                ucs_assert((errno == EAGAIN) || (errno == EINTR));
             }
-        } else {
-            ucs_assert(ret == 0);
+            return 1;
         }
-    } while (ret != 0);
-
-    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
 
-    /* Go over arm_list of active interfaces which support events and arm them */
-    ucs_list_for_each(wiface, &worker->arm_ifaces, arm_list) {
-        ucs_assert(wiface->activate_count > 0);
-        status = uct_iface_event_arm(wiface->iface, worker->uct_events);
-        ucs_trace("arm iface %p returned %s", wiface->iface,
-                  ucs_status_string(status));
-        if (status != UCS_OK) {
-            goto out_unlock;
+        if (ucp_worker_progress(worker)) {
+            return 1;
         }
-    }
-
-    status = UCS_OK;
+    } while ((ucs_get_time() - start_time) < spin_time);
 
-out_unlock:
-    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
-out:
-    ucs_trace("ucp_worker_arm returning %s", ucs_status_string(status));
-    return status;
+    return 0;
 }
 
-void ucp_worker_wait_mem(ucp_worker_h worker, void *address)
+static void ucp_worker_wait_update_idle(ucp_worker_h worker,
+                                        ucs_time_t start_time)
 {
-    ucs_arch_wait_mem(address);
+    ucs_time_t idle = ucs_get_time() - start_time;
+
+    /* Moving average, giving recent events a weight of 1/4 */
+    worker->wait.avg_idle = (worker->wait.avg_idle * 3 + idle) / 4;
 }
 
 ucs_status_t ucp_worker_wait(ucp_worker_h worker)
 {
+    ucs_time_t start_time;
     ucp_worker_iface_t *wiface;
     struct pollfd *pfd;
     ucs_status_t status;
@@ -1757,10 +2090,22 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
     UCP_CONTEXT_CHECK_FEATURE_FLAGS(worker->context, UCP_FEATURE_WAKEUP,
                                     return UCS_ERR_INVALID_PARAM);
 
+    status = ucp_worker_check_user_wakeup(worker, "ucp_worker_wait");
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    start_time = ucs_get_time();
+    if (ucp_worker_wait_spin(worker, start_time)) {
+        ucp_worker_wait_update_idle(worker, start_time);
+        return UCS_OK;
+    }
+
     UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
 
-    status = ucp_worker_arm(worker);
+    status = ucp_worker_arm_ifaces(worker);
     if (status == UCS_ERR_BUSY) { /* if UCS_ERR_BUSY returned - no poll() must called */
+        ucp_worker_wait_update_idle(worker, start_time);
         status = UCS_OK;
         goto out;
     } else if (status != UCS_OK) {
@@ -1786,6 +2131,7 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
         ret = poll(pfd, nfds, -1);
         if (ret >= 0) {
             ucs_assertv(ret == 1, "ret=%d", ret);
+            ucp_worker_wait_update_idle(worker, start_time);
             status = UCS_OK;
             goto out;
         } else {
@@ -1804,10 +2150,15 @@ out:
 
 ucs_status_t ucp_worker_signal(ucp_worker_h worker)
 {
+    ucs_status_t status;
+
     ucs_trace_func("worker %p", worker);
     UCP_CONTEXT_CHECK_FEATURE_FLAGS(worker->context, UCP_FEATURE_WAKEUP,
                                     return UCS_ERR_INVALID_PARAM);
-    return ucp_worker_wakeup_signal_fd(worker);
+
+    status = ucp_worker_wakeup_signal_fd(worker);
+    worker->wait.signaled = 1;
+    return status;
 }
 
 ucs_status_t ucp_worker_get_address(ucp_worker_h worker, ucp_address_t **address_p,
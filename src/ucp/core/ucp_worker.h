@@ -12,6 +12,7 @@
 #include "ucp_context.h"
 #include "ucp_thread.h"
 
+#include <ucp/api/ucpx.h>
 #include <ucp/proto/proto.h>
 #include <ucp/tag/tag_match.h>
 #include <ucp/wireup/ep_match.h>
@@ -59,7 +60,11 @@
 enum {
     UCP_WORKER_FLAG_EXTERNAL_EVENT_FD = UCS_BIT(0), /**< worker event fd is external */
     UCP_WORKER_FLAG_EDGE_TRIGGERED    = UCS_BIT(1), /**< events are edge-triggered */
-    UCP_WORKER_FLAG_MT                = UCS_BIT(2)  /**< MT locking is required */
+    UCP_WORKER_FLAG_MT                = UCS_BIT(2), /**< MT locking is required */
+    UCP_WORKER_FLAG_PROGRESS_TRYLOCK  = UCS_BIT(3), /**< progress does not wait
+                                                         for the MT lock */
+    UCP_WORKER_FLAG_PROGRESS_THREAD   = UCS_BIT(4)  /**< progress thread is
+                                                         running */
 };
 
 
@@ -180,6 +185,16 @@ struct ucp_worker_iface {
 };
 
 
+/**
+ * UCP worker handler of user defined active messages.
+ */
+typedef struct ucp_worker_am_entry {
+    ucp_am_callback_t             cb;            /* Active message callback */
+    void                          *context;      /* Active message argument */
+    uint32_t                      flags;         /* Active message flags */
+} ucp_worker_am_entry_t;
+
+
 /**
  * UCP worker (thread context).
  */
@@ -190,6 +205,8 @@ typedef struct ucp_worker {
     uint64_t                      uuid;          /* Unique ID for wireup */
     uct_worker_h                  uct;           /* UCT worker handle */
     ucs_mpool_t                   req_mp;        /* Memory pool for requests */
+    ucs_mpool_t                   cq_mp;         /* Memory pool for completion
+                                                    queue entries */
     uint64_t                      atomic_tls;    /* Which resources can be used for atomics */
 
     int                           inprogress;
@@ -202,10 +219,25 @@ typedef struct ucp_worker {
     unsigned                      uct_events;    /* UCT arm events */
     ucs_list_link_t               arm_ifaces;    /* List of interfaces to arm */
 
+    struct {
+        ucs_time_t                spin_max;      /* Maximal polling time in wait */
+        ucs_time_t                avg_idle;      /* Average waiting time for an event */
+        volatile int              signaled;      /* ucp_worker_signal() was called */
+    } wait;
+
     void                          *user_data;    /* User-defined data */
     ucs_strided_alloc_t           ep_alloc;      /* Endpoint allocator */
     ucs_list_link_t               stream_ready_eps; /* List of EPs with received stream data */
-    ucs_list_link_t               all_eps;       /* List of all endpoints */
+    ucs_list_link_t               all_eps;       /* List of all endpoints, the ones
+                                                    with RMA_DIRTY flag first */
+    ucs_list_link_t               rma_aggr_eps;  /* List of endpoints with
+                                                    aggregated puts to send */
+    ucs_queue_head_t              completions;   /* Completed requests with a
+                                                    user cookie */
+    ucp_request_t                 *flush_req_last; /* Last started worker flush */
+    pthread_t                     progress_thread; /* Background progress thread */
+    volatile int                  progress_thread_stop; /* Request the progress
+                                                           thread to exit */
     ucp_ep_match_ctx_t            ep_match_ctx;  /* Endpoint-to-endpoint matching context */
     ucp_worker_iface_t            *ifaces;       /* Array of interfaces, one for each resource */
     unsigned                      num_ifaces;    /* Number of elements in ifaces array  */
@@ -215,6 +247,8 @@ typedef struct ucp_worker {
     ucs_mpool_t                   rndv_frag_mp;  /* Memory pool for RNDV fragments */
     ucp_tag_match_t               tm;            /* Tag-matching queues and offload info */
     ucp_ep_h                      mem_type_ep[UCT_MD_MEM_TYPE_LAST];/* memory type eps */
+    ucp_worker_am_entry_t         *am_cbs;       /* Array of user AM callbacks */
+    unsigned                      am_cb_array_len; /* Length of am_cbs array */
 
     UCS_STATS_NODE_DECLARE(stats);
     UCS_STATS_NODE_DECLARE(tm_offload_stats);
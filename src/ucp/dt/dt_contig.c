@@ -14,6 +14,7 @@ size_t ucp_memcpy_pack(void *dest, void *arg)
 {
     ucp_memcpy_pack_context_t *ctx = arg;
     size_t length = ctx->length;
-    UCS_PROFILE_CALL(memcpy, dest, ctx->src, length);
+    UCS_PROFILE_CALL_VOID(ucp_dt_memcpy_pack, dest, ctx->src, length,
+                          ctx->nontemporal);
     return length;
 }
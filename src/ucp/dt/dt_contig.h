@@ -9,7 +9,9 @@
 #define UCP_DT_CONTIG_H_
 
 #include <ucp/api/ucp.h>
+#include <ucs/arch/cpu.h>
 #include <ucs/debug/assert.h>
+#include <string.h>
 
 
 /**
@@ -18,12 +20,28 @@
 typedef struct {
     const void                    *src;
     size_t                        length;
+    int                           nontemporal; /* Bypass the CPU cache */
 } ucp_memcpy_pack_context_t;
 
 
 size_t ucp_memcpy_pack(void *dest, void *arg);
 
 
+/*
+ * Copy send data to a transport buffer. The caller decides once per request,
+ * by the total message length, if the copy should bypass the CPU cache.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_memcpy_pack(void *dest, const void *src, size_t length, int nontemporal)
+{
+    if (ucs_unlikely(nontemporal)) {
+        ucs_memcpy_nontemporal(dest, src, length);
+    } else {
+        memcpy(dest, src, length);
+    }
+}
+
+
 static inline size_t ucp_contig_dt_elem_size(ucp_datatype_t datatype)
 {
     return datatype >> UCP_DATATYPE_SHIFT;
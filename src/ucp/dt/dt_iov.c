@@ -4,6 +4,7 @@
  * See file LICENSE for terms.
  */
 #include "dt_iov.h"
+#include "dt_contig.h"
 
 #include <ucs/debug/assert.h>
 #include <ucs/sys/math.h>
@@ -13,7 +14,8 @@
 
 
 void ucp_dt_iov_gather(void *dest, const ucp_dt_iov_t *iov, size_t length,
-                       size_t *iov_offset, size_t *iovcnt_offset)
+                       size_t *iov_offset, size_t *iovcnt_offset,
+                       int nontemporal)
 {
     size_t item_len, item_reminder, item_len_to_copy;
     size_t length_it = 0;
@@ -25,8 +27,9 @@ void ucp_dt_iov_gather(void *dest, const ucp_dt_iov_t *iov, size_t length,
 
         item_len_to_copy = item_reminder -
                            ucs_max((ssize_t)((length_it + item_reminder) - length), 0);
-        memcpy(dest + length_it, iov[*iovcnt_offset].buffer + *iov_offset,
-               item_len_to_copy);
+        ucp_dt_memcpy_pack(dest + length_it,
+                           iov[*iovcnt_offset].buffer + *iov_offset,
+                           item_len_to_copy, nontemporal);
         length_it += item_len_to_copy;
 
         ucs_assert(length_it <= length);
@@ -45,9 +45,11 @@ static inline size_t ucp_dt_iov_length(const ucp_dt_iov_t *iov, size_t iovcnt)
  *                                belongs to the @a iov_offset. The point to start
  *                                copying from should be selected as
  *                                iov[iovcnt_offset].buffer + iov_offset
+ * @param [in]     nontemporal    Whether to bypass the CPU cache when copying
  */
 void ucp_dt_iov_gather(void *dest, const ucp_dt_iov_t *iov, size_t length,
-                       size_t *iov_offset, size_t *iovcnt_offset);
+                       size_t *iov_offset, size_t *iovcnt_offset,
+                       int nontemporal);
 
 /**
  * Copy contiguous buffer @a src into @ref ucp_dt_iov_t data buffers in @a iov
@@ -0,0 +1,286 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "dt_strided.h"
+
+#include <ucs/debug/assert.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+
+#include <string.h>
+
+
+/* Position of a contiguous block in the strided buffer */
+typedef struct ucp_dt_strided_iter {
+    size_t  index[UCP_DT_STRIDED_MAX_LEVELS + 1]; /* Item index in every level */
+    size_t  block_offset;                         /* Distance of the current
+                                                     block from buffer start */
+} ucp_dt_strided_iter_t;
+
+
+ucs_status_t ucp_dt_create_strided(size_t blocklength,
+                                   const ucp_dt_strided_level_t *levels,
+                                   unsigned num_levels,
+                                   ucp_datatype_t *datatype_p)
+{
+    ucp_dt_strided_level_t *last;
+    ucp_dt_strided_t *dt;
+    size_t extent;
+    unsigned i;
+
+    if ((blocklength == 0) || (num_levels > UCP_DT_STRIDED_MAX_LEVELS) ||
+        ((num_levels > 0) && (levels == NULL))) {
+        ucs_error("invalid strided datatype: blocklength %zu num_levels %u",
+                  blocklength, num_levels);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    for (i = 0; i < num_levels; ++i) {
+        if (levels[i].count == 0) {
+            ucs_error("invalid strided datatype: level %u has zero count", i);
+            return UCS_ERR_INVALID_PARAM;
+        }
+    }
+
+    dt = ucs_memalign(UCS_BIT(UCP_DATATYPE_SHIFT), sizeof(*dt), "strided_dt");
+    if (dt == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    /* Consecutive elements continue the outermost level */
+    extent = (num_levels > 0) ?
+             (levels[num_levels - 1].count * levels[num_levels - 1].stride) :
+             blocklength;
+
+    dt->blocklength = blocklength;
+    dt->length      = blocklength;
+    dt->span        = blocklength;
+    dt->num_levels  = 0;
+    for (i = 0; i < num_levels; ++i) {
+        dt->length *= levels[i].count;
+        if (levels[i].count == 1) {
+            continue;
+        }
+
+        dt->span += (levels[i].count - 1) * levels[i].stride;
+        if (dt->num_levels == 0) {
+            if (levels[i].stride == dt->blocklength) {
+                /* Items are adjacent, make a larger block */
+                dt->blocklength *= levels[i].count;
+                continue;
+            }
+        } else {
+            last = &dt->levels[dt->num_levels - 1];
+            if (levels[i].stride == (last->count * last->stride)) {
+                /* Items continue the lower level */
+                last->count *= levels[i].count;
+                continue;
+            }
+        }
+
+        dt->levels[dt->num_levels++] = levels[i];
+    }
+
+    dt->levels[dt->num_levels].count  = SIZE_MAX;
+    dt->levels[dt->num_levels].stride = extent;
+
+    ucs_debug("created strided datatype %p blocklength %zu levels %u length "
+              "%zu span %zu extent %zu", dt, dt->blocklength, dt->num_levels,
+              dt->length, dt->span, extent);
+
+    *datatype_p = ((uintptr_t)dt) | UCP_DATATYPE_STRIDED;
+    return UCS_OK;
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_strided_iter_init(ucp_dt_strided_iter_t *iter, const ucp_dt_strided_t *dt,
+                         size_t block)
+{
+    unsigned level;
+
+    iter->block_offset = 0;
+    for (level = 0; level < dt->num_levels; ++level) {
+        iter->index[level]  = block % dt->levels[level].count;
+        iter->block_offset += iter->index[level] * dt->levels[level].stride;
+        block              /= dt->levels[level].count;
+    }
+
+    iter->index[level]  = block;
+    iter->block_offset += block * dt->levels[level].stride;
+}
+
+/* Number of blocks which are left in the innermost level */
+static UCS_F_ALWAYS_INLINE size_t
+ucp_dt_strided_iter_avail(const ucp_dt_strided_iter_t *iter,
+                          const ucp_dt_strided_t *dt)
+{
+    return dt->levels[0].count - iter->index[0];
+}
+
+/* Advance by @a count blocks, which must not exceed the innermost level */
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_strided_iter_advance(ucp_dt_strided_iter_t *iter,
+                            const ucp_dt_strided_t *dt, size_t count)
+{
+    unsigned level;
+
+    iter->index[0]     += count;
+    iter->block_offset += count * dt->levels[0].stride;
+
+    for (level = 0; (level < dt->num_levels) &&
+                    (iter->index[level] == dt->levels[level].count); ++level) {
+        iter->block_offset -= dt->levels[level].count * dt->levels[level].stride;
+        iter->index[level]  = 0;
+        iter->block_offset += dt->levels[level + 1].stride;
+        ++iter->index[level + 1];
+    }
+}
+
+#define UCP_DT_STRIDED_COPY_BLOCKS(_size) \
+    for (i = 0; i < count; ++i) { \
+        memcpy(UCS_PTR_BYTE_OFFSET(dst, i * dst_stride), \
+               UCS_PTR_BYTE_OFFSET(src, i * src_stride), _size); \
+    }
+
+/*
+ * Copy @a count blocks of @a blocklength bytes. Common block sizes are copied
+ * with fixed-size loads and stores, which the compiler turns into single
+ * (vector) instructions instead of calling memcpy for every block.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_strided_copy_blocks(void *dst, size_t dst_stride, const void *src,
+                           size_t src_stride, size_t blocklength, size_t count)
+{
+    size_t i;
+
+    if ((dst_stride == blocklength) && (src_stride == blocklength)) {
+        memcpy(dst, src, count * blocklength);
+        return;
+    }
+
+    switch (blocklength) {
+    case 1:
+        UCP_DT_STRIDED_COPY_BLOCKS(1);
+        break;
+    case 2:
+        UCP_DT_STRIDED_COPY_BLOCKS(2);
+        break;
+    case 4:
+        UCP_DT_STRIDED_COPY_BLOCKS(4);
+        break;
+    case 8:
+        UCP_DT_STRIDED_COPY_BLOCKS(8);
+        break;
+    case 16:
+        UCP_DT_STRIDED_COPY_BLOCKS(16);
+        break;
+    case 32:
+        UCP_DT_STRIDED_COPY_BLOCKS(32);
+        break;
+    default:
+        UCP_DT_STRIDED_COPY_BLOCKS(blocklength);
+        break;
+    }
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_strided_copy(void *buffer, void *packed, ucp_datatype_t datatype,
+                    size_t offset, size_t length, int is_pack)
+{
+    const ucp_dt_strided_t *dt = ucp_dt_strided(datatype);
+    size_t blocklength         = dt->blocklength;
+    size_t stride              = dt->levels[0].stride;
+    ucp_dt_strided_iter_t iter;
+    size_t count, copy_length;
+    void *block;
+
+    ucp_dt_strided_iter_init(&iter, dt, offset / blocklength);
+
+    while (length > 0) {
+        block = UCS_PTR_BYTE_OFFSET(buffer, iter.block_offset);
+        if ((offset % blocklength) || (length < blocklength)) {
+            /* Part of a block */
+            block       = UCS_PTR_BYTE_OFFSET(block, offset % blocklength);
+            copy_length = ucs_min(blocklength - (offset % blocklength), length);
+            if (is_pack) {
+                memcpy(packed, block, copy_length);
+            } else {
+                memcpy(block, packed, copy_length);
+            }
+            count = 1;
+        } else {
+            /* Whole blocks of the innermost level */
+            count       = ucs_min(length / blocklength,
+                                  ucp_dt_strided_iter_avail(&iter, dt));
+            copy_length = count * blocklength;
+            if (is_pack) {
+                ucp_dt_strided_copy_blocks(packed, blocklength, block, stride,
+                                           blocklength, count);
+            } else {
+                ucp_dt_strided_copy_blocks(block, stride, packed, blocklength,
+                                           blocklength, count);
+            }
+        }
+
+        packed  = UCS_PTR_BYTE_OFFSET(packed, copy_length);
+        offset += copy_length;
+        length -= copy_length;
+        if (length > 0) {
+            ucp_dt_strided_iter_advance(&iter, dt, count);
+        }
+    }
+}
+
+void ucp_dt_strided_gather(void *dest, const void *src, ucp_datatype_t datatype,
+                           size_t offset, size_t length)
+{
+    ucp_dt_strided_copy((void*)src, dest, datatype, offset, length, 1);
+}
+
+void ucp_dt_strided_scatter(void *dest, ucp_datatype_t datatype,
+                            const void *src, size_t offset, size_t length)
+{
+    ucp_dt_strided_copy(dest, (void*)src, datatype, offset, length, 0);
+}
+
+size_t ucp_dt_strided_to_uct_iov(uct_iov_t *iov, size_t max_iov, void *buffer,
+                                 ucp_datatype_t datatype, uct_mem_h memh,
+                                 size_t offset, size_t length,
+                                 size_t *iovcnt_p)
+{
+    const ucp_dt_strided_t *dt = ucp_dt_strided(datatype);
+    size_t blocklength         = dt->blocklength;
+    size_t length_it           = 0;
+    size_t iovcnt              = 0;
+    ucp_dt_strided_iter_t iter;
+    size_t block_skip;
+
+    ucs_assert(max_iov > 0);
+
+    ucp_dt_strided_iter_init(&iter, dt, offset / blocklength);
+    block_skip = offset % blocklength;
+
+    while ((length_it < length) && (iovcnt < max_iov)) {
+        iov[iovcnt].buffer = UCS_PTR_BYTE_OFFSET(buffer,
+                                                 iter.block_offset + block_skip);
+        iov[iovcnt].length = ucs_min(blocklength - block_skip,
+                                     length - length_it);
+        iov[iovcnt].memh   = memh;
+        iov[iovcnt].stride = 0;
+        iov[iovcnt].count  = 1;
+        length_it         += iov[iovcnt].length;
+        ++iovcnt;
+
+        block_skip = 0;
+        if (length_it < length) {
+            ucp_dt_strided_iter_advance(&iter, dt, 1);
+        }
+    }
+
+    *iovcnt_p = iovcnt;
+    return length_it;
+}
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+
+#ifndef UCP_DT_STRIDED_H_
+#define UCP_DT_STRIDED_H_
+
+#include <ucp/api/ucp.h>
+#include <uct/api/uct.h>
+
+
+#define UCP_DT_IS_STRIDED(_datatype) \
+    (((_datatype) & UCP_DATATYPE_CLASS_MASK) == UCP_DATATYPE_STRIDED)
+
+
+/**
+ * Strided datatype structure.
+ *
+ * The levels are normalized when the datatype is created: levels with a single
+ * item are removed, and contiguous levels are merged into the block or into
+ * the level above them. An additional outermost level with unlimited count
+ * describes the consecutive elements of the datatype.
+ */
+typedef struct ucp_dt_strided {
+    size_t                  blocklength;  /* Size of a contiguous block */
+    size_t                  length;       /* Packed size of a single element */
+    size_t                  span;         /* Distance between the first and past
+                                             the last byte of an element */
+    unsigned                num_levels;   /* Number of levels, not including
+                                             the elements level */
+    ucp_dt_strided_level_t  levels[UCP_DT_STRIDED_MAX_LEVELS + 1];
+} ucp_dt_strided_t;
+
+
+static inline ucp_dt_strided_t* ucp_dt_strided(ucp_datatype_t datatype)
+{
+    return (ucp_dt_strided_t*)(void*)(datatype & ~UCP_DATATYPE_CLASS_MASK);
+}
+
+
+/**
+ * Get the total packed length of @a count elements of strided datatype
+ */
+static inline size_t ucp_dt_strided_length(ucp_datatype_t datatype,
+                                           size_t count)
+{
+    return count * ucp_dt_strided(datatype)->length;
+}
+
+
+/**
+ * Get the size of the memory area which holds the elements of strided
+ * datatype, which packed length is @a length.
+ */
+static inline size_t ucp_dt_strided_span(ucp_datatype_t datatype, size_t length)
+{
+    const ucp_dt_strided_t *dt = ucp_dt_strided(datatype);
+    size_t count               = length / dt->length;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    return ((count - 1) * dt->levels[dt->num_levels].stride) + dt->span;
+}
+
+
+/**
+ * Get the number of contiguous blocks in the packed range [0, @a length).
+ */
+static inline size_t ucp_dt_strided_num_blocks(ucp_datatype_t datatype,
+                                               size_t length)
+{
+    return (length + ucp_dt_strided(datatype)->blocklength - 1) /
+           ucp_dt_strided(datatype)->blocklength;
+}
+
+
+/**
+ * Copy strided data from @a src buffer to contiguous buffer @a dest
+ *
+ * @param [in]     dest      Destination contiguous buffer
+ *                           (no offset applicable)
+ * @param [in]     src       Source strided buffer
+ * @param [in]     datatype  Strided datatype of @a src
+ * @param [in]     offset    Offset in the packed data to start copying from
+ * @param [in]     length    Total data length to copy in bytes
+ */
+void ucp_dt_strided_gather(void *dest, const void *src, ucp_datatype_t datatype,
+                           size_t offset, size_t length);
+
+
+/**
+ * Copy contiguous buffer @a src into strided buffer @a dest
+ *
+ * @param [in]     dest      Destination strided buffer
+ * @param [in]     datatype  Strided datatype of @a dest
+ * @param [in]     src       Source contiguous buffer (no offset applicable)
+ * @param [in]     offset    Offset in the packed data to start copying to
+ * @param [in]     length    Total data length to copy in bytes
+ */
+void ucp_dt_strided_scatter(void *dest, ucp_datatype_t datatype,
+                            const void *src, size_t offset, size_t length);
+
+
+/**
+ * Describe the strided data of a packed range by a list of UCT iov entries,
+ * each of them points to a single contiguous block, or part of it.
+ *
+ * @param [out]    iov       Filled with the iov entries
+ * @param [in]     max_iov   Maximal number of iov entries to fill
+ * @param [in]     buffer    Strided buffer
+ * @param [in]     datatype  Strided datatype of @a buffer
+ * @param [in]     memh      Memory handle of @a buffer
+ * @param [in]     offset    Offset in the packed data of the first entry
+ * @param [in]     length    Maximal total length of the entries
+ * @param [out]    iovcnt_p  Filled with the number of iov entries
+ *
+ * @return Total length of the iov entries.
+ */
+size_t ucp_dt_strided_to_uct_iov(uct_iov_t *iov, size_t max_iov, void *buffer,
+                                 ucp_datatype_t datatype, uct_mem_h memh,
+                                 size_t offset, size_t length,
+                                 size_t *iovcnt_p);
+
+#endif
@@ -7,6 +7,7 @@
 #include "proto.h"
 #include "proto_am.inl"
 
+#include <ucp/tag/eager.h>
 #include <ucp/tag/offload.h>
 
 
@@ -15,6 +16,7 @@ static size_t ucp_proto_pack(void *dest, void *arg)
     ucp_request_t *req = arg;
     ucp_reply_hdr_t *rep_hdr;
     ucp_offload_ssend_hdr_t *off_rep_hdr;
+    ucp_eager_fc_hdr_t *fc_hdr;
 
     switch (req->send.proto.am_id) {
     case UCP_AM_ID_EAGER_SYNC_ACK:
@@ -29,6 +31,11 @@ static size_t ucp_proto_pack(void *dest, void *arg)
         off_rep_hdr->sender_tag = req->send.proto.sender_tag;
         off_rep_hdr->ep_ptr     = ucp_request_get_dest_ep_ptr(req);
         return sizeof(*off_rep_hdr);
+    case UCP_AM_ID_EAGER_FC:
+        fc_hdr         = dest;
+        fc_hdr->ep_ptr = ucp_request_get_dest_ep_ptr(req);
+        fc_hdr->pause  = req->send.proto.eager_pause;
+        return sizeof(*fc_hdr);
     }
 
     ucs_bug("unexpected am_id");
@@ -0,0 +1,394 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "proto_tune.h"
+
+#include <ucp/core/ucp_context.h>
+#include <ucp/core/ucp_worker.h>
+#include <ucs/arch/bitops.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/string.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/* Minimal number of samples of each protocol before comparing them */
+#define UCP_PROTO_TUNE_MIN_SAMPLES   8
+
+/* Weight of the history in the moving average, once there are enough samples */
+#define UCP_PROTO_TUNE_AVG_WEIGHT    16
+
+/* The other protocol has to be faster by this fraction to move a threshold,
+ * to prevent the thresholds from oscillating because of noise */
+#define UCP_PROTO_TUNE_MARGIN        0.1
+
+/* Thresholds are not moved below this bucket */
+#define UCP_PROTO_TUNE_MIN_BUCKET    8
+
+
+/* The rendezvous threshold which is in effect for contiguous data */
+static size_t *ucp_proto_tune_rndv_thresh(ucp_ep_config_t *config)
+{
+    return (config->tag.rndv.rma_thresh <= config->tag.rndv.am_thresh) ?
+           &config->tag.rndv.rma_thresh : &config->tag.rndv.am_thresh;
+}
+
+static int ucp_proto_tune_thresh_is_valid(size_t thresh)
+{
+    return (thresh > 0) && (thresh < UCS_BIT(UCP_PROTO_TUNE_NUM_BUCKETS - 1));
+}
+
+/* Keep a threshold within UCP_PROTO_TUNE_MAX_SHIFT buckets of its value before
+ * tuning, so a bias of the measurements can't move it arbitrarily far */
+static size_t ucp_proto_tune_clamp(size_t thresh, size_t base)
+{
+    if (!ucp_proto_tune_thresh_is_valid(base)) {
+        return base; /* the threshold is not tuned */
+    }
+
+    return ucs_min(ucs_max(thresh, base >> UCP_PROTO_TUNE_MAX_SHIFT),
+                   base << UCP_PROTO_TUNE_MAX_SHIFT);
+}
+
+static void ucp_proto_tune_config_name(ucp_worker_h worker,
+                                       ucp_ep_config_t *config,
+                                       char *name, size_t max)
+{
+    ucp_context_h context = worker->context;
+    ucp_rsc_index_t rsc_index;
+
+    if (config->key.am_lane == UCP_NULL_LANE) {
+        name[0] = '\0';
+        return;
+    }
+
+    rsc_index = config->key.lanes[config->key.am_lane].rsc_index;
+    if (rsc_index == UCP_NULL_RESOURCE) {
+        name[0] = '\0';
+        return;
+    }
+
+    snprintf(name, max, "%s/%s", context->tl_rscs[rsc_index].tl_rsc.tl_name,
+             context->tl_rscs[rsc_index].tl_rsc.dev_name);
+}
+
+ucs_status_t ucp_proto_tune_load(const char *filename,
+                                 ucp_proto_tune_entry_t **table_p,
+                                 unsigned *count_p)
+{
+    ucp_proto_tune_entry_t *table, *entry;
+    unsigned count, max_count;
+    char line[256];
+    FILE *stream;
+
+    stream = fopen(filename, "r");
+    if (stream == NULL) {
+        if (errno == ENOENT) {
+            /* nothing was learned yet */
+            ucs_debug("protocol tuning file '%s' does not exist", filename);
+            *table_p = NULL;
+            *count_p = 0;
+            return UCS_OK;
+        }
+
+        ucs_error("failed to open protocol tuning file '%s': %m", filename);
+        return UCS_ERR_IO_ERROR;
+    }
+
+    table     = NULL;
+    count     = 0;
+    max_count = 0;
+    while (fgets(line, sizeof(line), stream) != NULL) {
+        if ((line[0] == '#') || (line[0] == '\n')) {
+            continue;
+        }
+
+        if (count == max_count) {
+            max_count = ucs_max(max_count * 2, 8);
+            entry     = ucs_realloc(table, sizeof(*table) * max_count,
+                                    "proto_tune_table");
+            if (entry == NULL) {
+                ucs_free(table);
+                fclose(stream);
+                return UCS_ERR_NO_MEMORY;
+            }
+            table = entry;
+        }
+
+        entry = &table[count];
+        UCS_STATIC_ASSERT(UCP_PROTO_TUNE_NAME_MAX == 64);
+        if (sscanf(line, "%63s %zu %zu",
+                   entry->name, &entry->zcopy_thresh,
+                   &entry->rndv_thresh) != 3) {
+            ucs_warn("%s: invalid protocol tuning line: '%s'", filename,
+                     ucs_strtrim(line));
+            continue;
+        }
+
+        ++count;
+    }
+
+    fclose(stream);
+
+    ucs_debug("loaded %u protocol tuning entries from '%s'", count, filename);
+    *table_p = table;
+    *count_p = count;
+    return UCS_OK;
+}
+
+static void ucp_proto_tune_apply(ucp_context_h context, ucp_ep_config_t *config,
+                                 const char *name, size_t *rndv_thresh_p)
+{
+    const ucp_proto_tune_entry_t *entry;
+
+    for (entry = context->config.proto_tune.table;
+         entry < context->config.proto_tune.table +
+                 context->config.proto_tune.count; ++entry) {
+        if (strcmp(entry->name, name)) {
+            continue;
+        }
+
+        if (config->tag.eager.max_zcopy > 0) {
+            config->tag.eager.zcopy_thresh[0] =
+                    ucp_proto_tune_clamp(entry->zcopy_thresh,
+                                         config->tag.eager.zcopy_thresh[0]);
+        }
+        *rndv_thresh_p = ucp_proto_tune_clamp(entry->rndv_thresh,
+                                              *rndv_thresh_p);
+        ucs_debug("%s: using tuned zcopy threshold %zu rndv threshold %zu",
+                  name, config->tag.eager.zcopy_thresh[0], *rndv_thresh_p);
+        return;
+    }
+}
+
+void ucp_proto_tune_init(ucp_worker_h worker, ucp_ep_config_t *config)
+{
+    ucp_context_h context = worker->context;
+    char name[UCP_PROTO_TUNE_NAME_MAX];
+    size_t zcopy_base, rndv_base;
+    ucp_proto_tune_t *tune;
+    size_t *rndv_thresh_p;
+
+    config->tag.tune = NULL;
+
+    if (!(context->config.features & UCP_FEATURE_TAG)) {
+        return;
+    }
+
+    ucp_proto_tune_config_name(worker, config, name, sizeof(name));
+    if (name[0] == '\0') {
+        return;
+    }
+
+    /* tuned thresholds are kept close to the computed ones */
+    rndv_thresh_p = ucp_proto_tune_rndv_thresh(config);
+    zcopy_base    = config->tag.eager.zcopy_thresh[0];
+    rndv_base     = *rndv_thresh_p;
+    ucp_proto_tune_apply(context, config, name, rndv_thresh_p);
+
+    if (!context->config.ext.proto_tune) {
+        return;
+    }
+
+    tune = ucs_calloc(1, sizeof(*tune), "proto_tune");
+    if (tune == NULL) {
+        ucs_warn("failed to allocate protocol tuning state for %s", name);
+        return;
+    }
+
+    ucs_strncpy_zero(tune->name, name, sizeof(tune->name));
+    tune->explore       = ucs_max(context->config.ext.proto_tune_explore, 2);
+    tune->zcopy_enabled = (config->tag.eager.max_zcopy > 0) &&
+                          ucp_proto_tune_thresh_is_valid(zcopy_base);
+    tune->rndv_thresh   = rndv_thresh_p;
+    tune->rndv_enabled  = ucp_proto_tune_thresh_is_valid(rndv_base);
+    tune->zcopy_base    = zcopy_base;
+    tune->rndv_base     = rndv_base;
+    config->tag.tune    = tune;
+}
+
+void ucp_proto_tune_cleanup(ucp_ep_config_t *config)
+{
+    ucs_free(config->tag.tune);
+    config->tag.tune = NULL;
+}
+
+void ucp_proto_tune_dump(ucp_worker_h worker)
+{
+    const char *filename = worker->context->config.proto_tune.file;
+    ucp_ep_config_t *config;
+    FILE *stream;
+
+    if (!worker->context->config.ext.proto_tune || (filename[0] == '\0')) {
+        return;
+    }
+
+    stream = fopen(filename, "w");
+    if (stream == NULL) {
+        ucs_warn("failed to write protocol tuning file '%s': %m", filename);
+        return;
+    }
+
+    fprintf(stream, "# <transport>/<device> <zcopy threshold> "
+            "<rendezvous threshold>\n");
+    for (config = worker->ep_config;
+         config < worker->ep_config + worker->ep_config_count; ++config) {
+        if (config->tag.tune != NULL) {
+            fprintf(stream, "%s %zu %zu\n", config->tag.tune->name,
+                    config->tag.eager.zcopy_thresh[0],
+                    *config->tag.tune->rndv_thresh);
+        }
+    }
+
+    fclose(stream);
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_proto_tune_is_near(size_t thresh, unsigned bucket)
+{
+    unsigned thresh_bucket = ucs_ilog2(thresh);
+
+    return (bucket == thresh_bucket) || ((bucket + 1) == thresh_bucket);
+}
+
+/*
+ * Every N-th send near a threshold explores the other protocol, and the send
+ * which follows it is measured with the selected protocol.
+ */
+static UCS_F_ALWAYS_INLINE int
+ucp_proto_tune_is_explore(ucp_proto_tune_t *tune, int *sample_p)
+{
+    unsigned phase = ++tune->num_sends % tune->explore;
+
+    *sample_p = (phase <= 1);
+    return phase == 0;
+}
+
+int ucp_proto_tune_select(ucp_proto_tune_t *tune, size_t length,
+                          size_t *zcopy_thresh_p, size_t *rndv_thresh_p)
+{
+    unsigned bucket = ucs_ilog2(length);
+    int sample;
+
+    if (tune->rndv_enabled && ucp_proto_tune_is_near(*rndv_thresh_p, bucket)) {
+        if (!ucp_proto_tune_is_explore(tune, &sample)) {
+            return sample;
+        }
+
+        if (length >= *rndv_thresh_p) {
+            /* try eager, with the protocol which is used below the rendezvous
+             * threshold */
+            if (*zcopy_thresh_p >= *rndv_thresh_p) {
+                *zcopy_thresh_p = length + 1;
+            }
+            *rndv_thresh_p  = length + 1;
+        } else {
+            *rndv_thresh_p  = length;       /* try rendezvous */
+            *zcopy_thresh_p = length;
+        }
+        return 1;
+    } else if (tune->zcopy_enabled && (length < *rndv_thresh_p) &&
+               ucp_proto_tune_is_near(*zcopy_thresh_p, bucket)) {
+        if (!ucp_proto_tune_is_explore(tune, &sample)) {
+            return sample;
+        }
+
+        if (length >= *zcopy_thresh_p) {
+            *zcopy_thresh_p = length + 1;   /* try bcopy */
+        } else {
+            *zcopy_thresh_p = length;       /* try zcopy */
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+static int ucp_proto_tune_is_faster(const ucp_proto_tune_stat_t *stat1,
+                                    const ucp_proto_tune_stat_t *stat2)
+{
+    return (stat1->count >= UCP_PROTO_TUNE_MIN_SAMPLES) &&
+           (stat2->count >= UCP_PROTO_TUNE_MIN_SAMPLES) &&
+           (stat1->avg < (stat2->avg * (1.0 - UCP_PROTO_TUNE_MARGIN)));
+}
+
+/*
+ * Move the threshold between two protocols by one bucket, if the protocol on
+ * the other side of the threshold is faster in the bucket next to it.
+ */
+static void ucp_proto_tune_update_thresh(ucp_proto_tune_t *tune,
+                                         const char *title, size_t *thresh_p,
+                                         size_t base,
+                                         const ucp_proto_tune_stat_t *below,
+                                         const ucp_proto_tune_stat_t *above,
+                                         unsigned bucket)
+{
+    unsigned thresh_bucket = ucs_ilog2(*thresh_p);
+    size_t thresh;
+
+    if (((bucket + 1) == thresh_bucket) && (bucket >= UCP_PROTO_TUNE_MIN_BUCKET) &&
+        ucp_proto_tune_is_faster(above, below)) {
+        thresh = UCS_BIT(bucket);
+    } else if ((bucket == thresh_bucket) &&
+               ((bucket + 2) < UCP_PROTO_TUNE_NUM_BUCKETS) &&
+               ucp_proto_tune_is_faster(below, above)) {
+        thresh = UCS_BIT(bucket + 1);
+    } else {
+        return;
+    }
+
+    if (ucp_proto_tune_clamp(thresh, base) != thresh) {
+        return;
+    }
+
+    ucs_debug("%s: %s threshold %zu -> %zu", tune->name, title, *thresh_p,
+              thresh);
+    *thresh_p = thresh;
+}
+
+void ucp_proto_tune_sample(ucp_ep_config_t *config, size_t length,
+                           ucp_proto_tune_id_t proto, ucs_time_t time)
+{
+    ucp_proto_tune_t *tune = config->tag.tune;
+    unsigned bucket        = ucs_ilog2(length);
+    ucp_proto_tune_stat_t *stats, *stat, eager;
+
+    if (bucket >= UCP_PROTO_TUNE_NUM_BUCKETS) {
+        return;
+    }
+
+    stats = tune->stats[bucket];
+    stat  = &stats[proto];
+    ++stat->count;
+    stat->avg += ((ucs_time_to_sec(time) / length) - stat->avg) /
+                 ucs_min(stat->count, UCP_PROTO_TUNE_AVG_WEIGHT);
+
+    if (tune->zcopy_enabled && (proto != UCP_PROTO_TUNE_RNDV)) {
+        ucp_proto_tune_update_thresh(tune, "zcopy",
+                                     &config->tag.eager.zcopy_thresh[0],
+                                     tune->zcopy_base,
+                                     &stats[UCP_PROTO_TUNE_BCOPY],
+                                     &stats[UCP_PROTO_TUNE_ZCOPY], bucket);
+    }
+
+    if (tune->rndv_enabled) {
+        /* Eager time is of the faster of bcopy and zcopy */
+        eager = stats[UCP_PROTO_TUNE_BCOPY];
+        if ((stats[UCP_PROTO_TUNE_ZCOPY].count >= UCP_PROTO_TUNE_MIN_SAMPLES) &&
+            ((eager.count < UCP_PROTO_TUNE_MIN_SAMPLES) ||
+             (stats[UCP_PROTO_TUNE_ZCOPY].avg < eager.avg))) {
+            eager = stats[UCP_PROTO_TUNE_ZCOPY];
+        }
+
+        ucp_proto_tune_update_thresh(tune, "rndv", tune->rndv_thresh,
+                                     tune->rndv_base, &eager,
+                                     &stats[UCP_PROTO_TUNE_RNDV],
+                                     bucket);
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_PROTO_TUNE_H_
+#define UCP_PROTO_TUNE_H_
+
+#include <ucp/core/ucp_ep.h>
+#include <ucs/time/time.h>
+
+
+/* Number of message size buckets, each bucket holds sizes of the same log2 */
+#define UCP_PROTO_TUNE_NUM_BUCKETS   32
+
+/* Maximal length of the name of a tuned configuration */
+#define UCP_PROTO_TUNE_NAME_MAX      64
+
+/* Maximal number of buckets a threshold is moved from its configured value */
+#define UCP_PROTO_TUNE_MAX_SHIFT     2
+
+
+/**
+ * Protocols which are compared by the tuner
+ */
+typedef enum {
+    UCP_PROTO_TUNE_BCOPY,
+    UCP_PROTO_TUNE_ZCOPY,
+    UCP_PROTO_TUNE_RNDV,
+    UCP_PROTO_TUNE_LAST
+} ucp_proto_tune_id_t;
+
+
+/**
+ * Send time statistics of a protocol in a message size bucket. The send time
+ * lasts until the local completion of the send. For eager protocols it ends
+ * when the buffer can be reused, and for rendezvous when the receiver has
+ * fetched the data.
+ */
+typedef struct ucp_proto_tune_stat {
+    double                 avg;     /* Moving average of send time per byte, sec */
+    unsigned               count;   /* Number of samples */
+} ucp_proto_tune_stat_t;
+
+
+/**
+ * Thresholds of a configuration, as stored in the tuning file
+ */
+struct ucp_proto_tune_entry {
+    char                   name[UCP_PROTO_TUNE_NAME_MAX];
+    size_t                 zcopy_thresh;
+    size_t                 rndv_thresh;
+};
+
+
+/**
+ * Tuning state of an endpoint configuration
+ */
+struct ucp_proto_tune {
+    char                   name[UCP_PROTO_TUNE_NAME_MAX]; /* Transport name */
+    unsigned               num_sends;     /* Counter of sends near switch points */
+    unsigned               explore;       /* Explore every N-th send */
+    int                    zcopy_enabled; /* Whether to tune the zcopy threshold */
+    int                    rndv_enabled;  /* Whether to tune the rndv threshold */
+    size_t                 *rndv_thresh;  /* Rndv threshold in the configuration */
+    size_t                 zcopy_base;    /* Zcopy threshold before tuning */
+    size_t                 rndv_base;     /* Rndv threshold before tuning */
+    ucp_proto_tune_stat_t  stats[UCP_PROTO_TUNE_NUM_BUCKETS][UCP_PROTO_TUNE_LAST];
+};
+
+
+/**
+ * Load the thresholds table from a file written by @ref ucp_proto_tune_dump.
+ */
+ucs_status_t ucp_proto_tune_load(const char *filename,
+                                 ucp_proto_tune_entry_t **table_p,
+                                 unsigned *count_p);
+
+
+/**
+ * Apply the loaded thresholds to an endpoint configuration, and start tuning
+ * it if enabled by the configuration.
+ */
+void ucp_proto_tune_init(ucp_worker_h worker, ucp_ep_config_t *config);
+
+
+void ucp_proto_tune_cleanup(ucp_ep_config_t *config);
+
+
+/**
+ * Write the thresholds of the tuned configurations of the worker to the
+ * tuning file.
+ */
+void ucp_proto_tune_dump(ucp_worker_h worker);
+
+
+/**
+ * Adjust the thresholds of a single send operation, to explore the protocol
+ * which is not currently selected for this message size.
+ *
+ * @return Nonzero if the send time should be measured. Such a send is either
+ *         exploring, or it is the next send, which uses the selected protocol.
+ */
+int ucp_proto_tune_select(ucp_proto_tune_t *tune, size_t length,
+                          size_t *zcopy_thresh_p, size_t *rndv_thresh_p);
+
+
+/**
+ * Account the time it took to complete a send operation, and move the
+ * thresholds of the configuration towards the faster protocol. A threshold is
+ * moved at most UCP_PROTO_TUNE_MAX_SHIFT buckets from its value before tuning.
+ */
+void ucp_proto_tune_sample(ucp_ep_config_t *config, size_t length,
+                           ucp_proto_tune_id_t proto, ucs_time_t time);
+
+#endif
@@ -127,12 +127,27 @@ ucs_status_ptr_t ucp_atomic_fetch_nb(ucp_ep_h ep, ucp_atomic_fetch_op_t opcode,
                   opcode, value, result, op_size, remote_addr, rkey,
                   ucp_ep_peer_name(ep), cb);
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        status_p = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
     status = UCP_RKEY_RESOLVE(rkey, ep, amo);
     if (status != UCS_OK) {
         status_p = UCS_STATUS_PTR(UCS_ERR_UNREACHABLE);
         goto out;
     }
 
+    ucp_ep_rma_set_dirty(ep);
+
+    /* Send the batched operations first, to keep them ordered before this one */
+    status = ucp_rma_aggr_flush(ep);
+    if (UCS_STATUS_IS_ERR(status)) {
+        status_p = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
     req = ucp_request_get(ep->worker);
     if (ucs_unlikely(NULL == req)) {
         status_p = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
@@ -165,11 +180,25 @@ ucs_status_t ucp_atomic_post(ucp_ep_h ep, ucp_atomic_post_op_t opcode, uint64_t
                   opcode, value, op_size, remote_addr, rkey,
                   ucp_ep_peer_name(ep));
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
     status = UCP_RKEY_RESOLVE(rkey, ep, amo);
     if (status != UCS_OK) {
         goto out;
     }
 
+    ucp_ep_rma_set_dirty(ep);
+
+    if ((ep->worker->context->config.ext.amo_sw_batch > 0) &&
+        (rkey->cache.amo_proto == &ucp_amo_sw_proto)) {
+        status = ucp_amo_sw_batch_post(ep, ucp_uct_op_table[opcode], value,
+                                       op_size, remote_addr);
+        goto out;
+    }
+
     req = ucp_request_get(ep->worker);
     if (ucs_unlikely(NULL == req)) {
         status = UCS_ERR_NO_MEMORY;
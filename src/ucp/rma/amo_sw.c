@@ -7,6 +7,7 @@
 #include "rma.h"
 #include "rma.inl"
 
+#include <ucp/dt/dt_contig.h>
 #include <ucs/arch/atomic.h>
 #include <ucs/profile/profile.h>
 
@@ -84,6 +85,213 @@ static ucs_status_t ucp_amo_sw_progress_fetch(uct_pending_req_t *self)
     return ucp_amo_sw_progress(self, ucp_amo_sw_fetch_pack_cb, 1);
 }
 
+static size_t ucp_amo_sw_batch_pack(void *dest, ucp_ep_h ep,
+                                    const ucp_atomic_batch_entry_t *entries,
+                                    size_t entries_length)
+{
+    ucp_atomic_batch_hdr_t *hdr = dest;
+
+    hdr->ep_ptr = ucp_ep_dest_ep_ptr(ep);
+    memcpy(hdr + 1, entries, entries_length);
+    return sizeof(*hdr) + entries_length;
+}
+
+static size_t ucp_amo_sw_batch_pack_cb(void *dest, void *arg)
+{
+    ucp_rma_aggr_t *aggr = arg;
+
+    return ucp_amo_sw_batch_pack(dest, aggr->ep, aggr->amo.entries,
+                                 aggr->amo.count * sizeof(*aggr->amo.entries));
+}
+
+static size_t ucp_amo_sw_batch_req_pack_cb(void *dest, void *arg)
+{
+    ucp_request_t *req = arg;
+
+    return ucp_amo_sw_batch_pack(dest, req->send.ep, req->send.buffer,
+                                 req->send.length);
+}
+
+static void ucp_amo_sw_batch_completion(void *request, ucs_status_t status)
+{
+    ucp_request_t *req = (ucp_request_t*)request - 1;
+
+    if (status != UCS_OK) {
+        /* no user request is waiting for the batch */
+        ucs_error("ep %p: failed to send batch of atomic operations: %s",
+                  req->send.ep, ucs_status_string(status));
+    }
+
+    ucs_free(req->send.buffer);
+}
+
+static ucs_status_t ucp_amo_sw_progress_batch(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_ep_t *ep       = req->send.ep;
+    ucs_status_t status;
+    ssize_t packed_len;
+
+    req->send.lane = ucp_ep_get_am_lane(ep);
+    packed_len = uct_ep_am_bcopy(ep->uct_eps[req->send.lane],
+                                 UCP_AM_ID_ATOMIC_BATCH,
+                                 ucp_amo_sw_batch_req_pack_cb, req, 0);
+    if (packed_len >= 0) {
+        ucp_ep_rma_remote_request_sent(ep);
+        ucp_request_complete_send(req, UCS_OK);
+        return UCS_OK;
+    }
+
+    status = (ucs_status_t)packed_len;
+    if (status != UCS_ERR_NO_RESOURCE) {
+        ucp_request_complete_send(req, status);
+        return UCS_OK;
+    }
+
+    return status;
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_amo_sw_batch_is_overlap(const ucp_atomic_batch_entry_t *entry,
+                            uint64_t address, size_t length)
+{
+    return (entry->address < (address + length)) &&
+           (address < (entry->address + entry->length));
+}
+
+ucs_status_t ucp_amo_sw_batch_post(ucp_ep_h ep, uct_atomic_op_t op,
+                                   uint64_t value, size_t size,
+                                   uint64_t remote_addr)
+{
+    unsigned batch_size = ep->worker->context->config.ext.amo_sw_batch;
+    ucp_atomic_batch_entry_t *entry;
+    ucp_rma_aggr_t *aggr;
+    ucs_status_t status;
+    size_t max_count;
+    unsigned i;
+
+    aggr = ucp_rma_aggr_get(ep);
+    if (aggr == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    /* Combine with the latest operation which overlaps the same memory, if
+     * it is on the same address and has the same type. All post operations
+     * are commutative with themselves. */
+    for (i = aggr->amo.count; i > 0; --i) {
+        entry = &aggr->amo.entries[i - 1];
+        if (!ucp_amo_sw_batch_is_overlap(entry, remote_addr, size)) {
+            continue;
+        }
+
+        if ((entry->address != remote_addr) || (entry->opcode != op) ||
+            (entry->length != size)) {
+            break;
+        }
+
+        switch (op) {
+        case UCT_ATOMIC_OP_ADD:
+            entry->value += value;
+            break;
+        case UCT_ATOMIC_OP_AND:
+            entry->value &= value;
+            break;
+        case UCT_ATOMIC_OP_OR:
+            entry->value |= value;
+            break;
+        case UCT_ATOMIC_OP_XOR:
+            entry->value ^= value;
+            break;
+        default:
+            ucs_fatal("invalid opcode: %d", op);
+        }
+        return UCS_OK;
+    }
+
+    max_count = ucs_min(batch_size, (ucp_ep_config(ep)->am.max_bcopy -
+                                     sizeof(ucp_atomic_batch_hdr_t)) /
+                                    sizeof(*entry));
+    if (aggr->amo.count >= max_count) {
+        /* sending the full batch has failed before */
+        status = ucp_rma_aggr_flush(ep);
+        if (UCS_STATUS_IS_ERR(status)) {
+            return status;
+        }
+    }
+
+    if (aggr->amo.entries == NULL) {
+        aggr->amo.entries = ucs_malloc(batch_size * sizeof(*aggr->amo.entries),
+                                       "ucp_amo_batch");
+        if (aggr->amo.entries == NULL) {
+            return UCS_ERR_NO_MEMORY;
+        }
+    }
+
+    ucp_rma_aggr_set_pending(aggr);
+    entry          = &aggr->amo.entries[aggr->amo.count++];
+    entry->address = remote_addr;
+    entry->value   = value;
+    entry->length  = size;
+    entry->opcode  = op;
+
+    if (aggr->amo.count >= max_count) {
+        /* The operation is queued already. If the batch can't be sent now, it
+         * is sent again by the next flush, which reports the error. */
+        (void)ucp_rma_aggr_flush(ep);
+    }
+
+    return UCS_OK;
+}
+
+ucs_status_t ucp_amo_sw_batch_flush(ucp_ep_h ep, ucp_rma_aggr_t *aggr)
+{
+    unsigned count = aggr->amo.count;
+    ucp_request_t *req;
+    ssize_t packed_len;
+
+    if (count == 0) {
+        return UCS_OK;
+    }
+
+    ucs_trace_req("ep %p: sending batch of %u atomic operations", ep, count);
+
+    packed_len = uct_ep_am_bcopy(ucp_ep_get_am_uct_ep(ep),
+                                 UCP_AM_ID_ATOMIC_BATCH,
+                                 ucp_amo_sw_batch_pack_cb, aggr, 0);
+    if (ucs_likely(packed_len >= 0)) {
+        aggr->amo.count = 0;
+        ucp_ep_rma_remote_request_sent(ep);
+        return UCS_OK;
+    } else if (packed_len != UCS_ERR_NO_RESOURCE) {
+        /* keep the batch, to send it again by the next flush */
+        return (ucs_status_t)packed_len;
+    }
+
+    /* Hand the entries over to a request which is sent when resources are
+     * available, and releases them when completed. The next batch allocates
+     * a new buffer. */
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    req->flags         = UCP_REQUEST_FLAG_RELEASED;
+    req->send.ep       = ep;
+    req->send.buffer   = aggr->amo.entries;
+    req->send.datatype = ucp_dt_make_contig(1);
+    req->send.length   = count * sizeof(*aggr->amo.entries);
+    req->send.uct.func = ucp_amo_sw_progress_batch;
+    ucp_request_send_state_init(req, req->send.datatype, req->send.length);
+    ucp_request_send_state_reset(req, NULL, UCP_REQUEST_SEND_PROTO_BCOPY_AM);
+    ucp_request_set_callback(req, send.cb, ucp_amo_sw_batch_completion);
+
+    aggr->amo.entries = NULL;
+    aggr->amo.count   = 0;
+
+    ucp_request_send(req, 0);
+    return UCS_OK;
+}
+
 ucp_amo_proto_t ucp_amo_sw_proto = {
     .name           = "sw_amo",
     .progress_fetch = ucp_amo_sw_progress_fetch,
@@ -131,26 +339,26 @@ static ucs_status_t ucp_progress_atomic_reply(uct_pending_req_t *self)
 }
 
 #define DEFINE_AMO_SW_OP(_bits) \
-    static void ucp_amo_sw_do_op##_bits(const ucp_atomic_req_hdr_t *atomicreqh) \
+    static void ucp_amo_sw_do_op##_bits(uint8_t opcode, uint64_t address, \
+                                        uint##_bits##_t arg) \
     { \
-        uint##_bits##_t *ptr  = (void*)atomicreqh->address; \
-        uint##_bits##_t *args = (void*)(atomicreqh + 1); \
+        uint##_bits##_t *ptr = (void*)address; \
         \
-       switch (atomicreqh->opcode) { \
+       switch (opcode) { \
         case UCT_ATOMIC_OP_ADD: \
-            ucs_atomic_add##_bits(ptr, args[0]); \
+            ucs_atomic_add##_bits(ptr, arg); \
             break; \
         case UCT_ATOMIC_OP_AND: \
-            ucs_atomic_and##_bits(ptr, args[0]); \
+            ucs_atomic_and##_bits(ptr, arg); \
             break; \
         case UCT_ATOMIC_OP_OR: \
-            ucs_atomic_or##_bits(ptr, args[0]); \
+            ucs_atomic_or##_bits(ptr, arg); \
             break; \
         case UCT_ATOMIC_OP_XOR: \
-            ucs_atomic_xor##_bits(ptr, args[0]); \
+            ucs_atomic_xor##_bits(ptr, arg); \
             break; \
         default: \
-            ucs_fatal("invalid opcode: %d", atomicreqh->opcode); \
+            ucs_fatal("invalid opcode: %d", opcode); \
         } \
     }
 
@@ -203,10 +411,12 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_atomic_req_handler, (arg, data, length, am_fl
         /* atomic operation without result */
         switch (atomicreqh->length) {
         case sizeof(uint32_t):
-            ucp_amo_sw_do_op32(atomicreqh);
+            ucp_amo_sw_do_op32(atomicreqh->opcode, atomicreqh->address,
+                               *(uint32_t*)(atomicreqh + 1));
             break;
         case sizeof(uint64_t):
-            ucp_amo_sw_do_op64(atomicreqh);
+            ucp_amo_sw_do_op64(atomicreqh->opcode, atomicreqh->address,
+                               *(uint64_t*)(atomicreqh + 1));
             break;
         default:
             ucs_fatal("invalid atomic length: %u", atomicreqh->length);
@@ -238,6 +448,32 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_atomic_req_handler, (arg, data, length, am_fl
     return UCS_OK;
 }
 
+UCS_PROFILE_FUNC(ucs_status_t, ucp_atomic_batch_handler, (arg, data, length, am_flags),
+                 void *arg, void *data, size_t length, unsigned am_flags)
+{
+    ucp_atomic_batch_hdr_t *hdr     = data;
+    ucp_atomic_batch_entry_t *entry = (void*)(hdr + 1);
+    ucp_atomic_batch_entry_t *end   = UCS_PTR_BYTE_OFFSET(data, length);
+    ucp_worker_h worker             = arg;
+
+    for (; entry < end; ++entry) {
+        switch (entry->length) {
+        case sizeof(uint32_t):
+            ucp_amo_sw_do_op32(entry->opcode, entry->address, entry->value);
+            break;
+        case sizeof(uint64_t):
+            ucp_amo_sw_do_op64(entry->opcode, entry->address, entry->value);
+            break;
+        default:
+            ucs_fatal("invalid atomic length: %u", entry->length);
+        }
+    }
+
+    /* the whole batch is acknowledged by a single completion */
+    ucp_rma_sw_send_cmpl(ucp_worker_get_ep_by_ptr(worker, hdr->ep_ptr));
+    return UCS_OK;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_atomic_rep_handler, (arg, data, length, am_flags),
                  void *arg, void *data, size_t length, unsigned am_flags)
 {
@@ -257,6 +493,7 @@ static void ucp_amo_sw_dump_packet(ucp_worker_h worker, uct_am_trace_type_t type
                                    char *buffer, size_t max)
 {
     const ucp_atomic_req_hdr_t *atomich;
+    const ucp_atomic_batch_hdr_t *batchh;
     const ucp_rma_rep_hdr_t *reph;
     size_t header_len;
     char *p;
@@ -270,6 +507,13 @@ static void ucp_amo_sw_dump_packet(ucp_worker_h worker, uct_am_trace_type_t type
                  atomich->req.ep_ptr, atomich->opcode);
         header_len = sizeof(*atomich);;
         break;
+    case UCP_AM_ID_ATOMIC_BATCH:
+        batchh = data;
+        snprintf(buffer, max, "ATOMIC_BATCH [ep 0x%lx count %zu]",
+                 batchh->ep_ptr, (length - sizeof(*batchh)) /
+                 sizeof(ucp_atomic_batch_entry_t));
+        header_len = sizeof(*batchh);
+        break;
     case UCP_AM_ID_ATOMIC_REP:
         reph = data;
         snprintf(buffer, max, "ATOMIC_REP [reqptr 0x%lx]", reph->req);
@@ -286,7 +530,10 @@ static void ucp_amo_sw_dump_packet(ucp_worker_h worker, uct_am_trace_type_t type
 
 UCP_DEFINE_AM(UCP_FEATURE_AMO, UCP_AM_ID_ATOMIC_REQ, ucp_atomic_req_handler,
               ucp_amo_sw_dump_packet, 0);
+UCP_DEFINE_AM(UCP_FEATURE_AMO, UCP_AM_ID_ATOMIC_BATCH, ucp_atomic_batch_handler,
+              ucp_amo_sw_dump_packet, 0);
 UCP_DEFINE_AM(UCP_FEATURE_AMO, UCP_AM_ID_ATOMIC_REP, ucp_atomic_rep_handler,
               ucp_amo_sw_dump_packet, 0);
 
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_ATOMIC_REQ);
+UCP_DEFINE_AM_PROXY(UCP_AM_ID_ATOMIC_BATCH);
@@ -241,10 +241,16 @@ ucs_status_ptr_t ucp_ep_flush_internal(ucp_ep_h ep, unsigned uct_flags,
 
     ucs_debug("%s ep %p", debug_name, ep);
 
-    if (ep->flags & UCP_EP_FLAG_FAILED) {
+    if (ep->flags & (UCP_EP_FLAG_FAILED | UCP_EP_FLAG_CONNECT_LAZY)) {
+        /* nothing to flush if the ep was never connected */
         return NULL;
     }
 
+    status = ucp_rma_aggr_flush(ep);
+    if (UCS_STATUS_IS_ERR(status)) {
+        return UCS_STATUS_PTR(status);
+    }
+
     req = ucp_request_get(ep->worker);
     if (req == NULL) {
         return UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
@@ -342,10 +348,23 @@ static ucs_status_t ucp_worker_flush_check(ucp_worker_h worker)
     return UCS_OK;
 }
 
+static unsigned ucp_worker_flush_progress(void *arg);
+
+static void ucp_worker_flush_start(ucp_request_t *req)
+{
+    ucp_worker_h worker = req->flush_worker.worker;
+
+    req->flush_worker.next_ep = ucs_list_head(&worker->all_eps,
+                                              ucp_ep_ext_gen_t, ep_list);
+    uct_worker_progress_register_safe(worker->uct, ucp_worker_flush_progress,
+                                      req, 0, &req->flush_worker.prog_id);
+}
+
 static void ucp_worker_flush_complete_one(ucp_request_t *req, ucs_status_t status,
                                           int force_progress_unreg)
 {
     ucp_worker_h worker = req->flush_worker.worker;
+    ucp_request_t *next_req;
     int complete;
 
     --req->flush_worker.comp_count;
@@ -358,10 +377,28 @@ static void ucp_worker_flush_complete_one(ucp_request_t *req, ucs_status_t statu
 
     if (complete) {
         ucs_assert(status != UCS_INPROGRESS);
+        next_req = req->flush_worker.next_req;
+        if (worker->flush_req_last == req) {
+            worker->flush_req_last = NULL;
+        }
+
         ucp_request_complete(req, flush_worker.cb, status);
+
+        if (next_req != NULL) {
+            ucp_worker_flush_start(next_req);
+        }
     }
 }
 
+static void ucp_worker_flush_ep_clear_dirty(ucp_ep_h ep)
+{
+    ucp_ep_ext_gen_t *ep_ext = ucp_ep_ext_gen(ep);
+
+    ep->flags &= ~UCP_EP_FLAG_RMA_DIRTY;
+    ucs_list_del(&ep_ext->ep_list);
+    ucs_list_add_tail(&ep->worker->all_eps, &ep_ext->ep_list);
+}
+
 static void ucp_worker_flush_ep_flushed_cb(ucp_request_t *req)
 {
     ucp_worker_flush_complete_one(req->send.flush.worker_req, UCS_OK, 0);
@@ -378,10 +415,12 @@ static unsigned ucp_worker_flush_progress(void *arg)
     ucp_ep_h ep;
 
     status = ucp_worker_flush_check(worker);
-    if ((status == UCS_OK) || (&next_ep->ep_list == &worker->all_eps)) {
-        /* If all ifaces are flushed, or we finished going over all endpoints,
-         * no need to progress this request actively any more. Just wait until
-         * all associated endpoint flush requests are completed.
+    if ((status == UCS_OK) || (&next_ep->ep_list == &worker->all_eps) ||
+        !(ucp_ep_from_ext_gen(next_ep)->flags & UCP_EP_FLAG_RMA_DIRTY)) {
+        /* If all ifaces are flushed, or we finished going over all endpoints
+         * with RMA operations, no need to progress this request actively any
+         * more. Just wait until all associated endpoint flush requests are
+         * completed.
          */
         ucp_worker_flush_complete_one(req, UCS_OK, 1);
     } else if (status != UCS_INPROGRESS) {
@@ -395,6 +434,10 @@ static unsigned ucp_worker_flush_progress(void *arg)
         req->flush_worker.next_ep = ucs_list_next(&next_ep->ep_list,
                                                   ucp_ep_ext_gen_t, ep_list);
 
+        /* The endpoint flush covers all operations issued so far, move the
+         * endpoint to the idle part of the list */
+        ucp_worker_flush_ep_clear_dirty(ep);
+
         ep_flush_request = ucp_ep_flush_internal(ep, UCT_FLUSH_FLAG_LOCAL, NULL,
                                                  UCP_REQUEST_FLAG_RELEASED, req,
                                                  ucp_worker_flush_ep_flushed_cb,
@@ -419,6 +462,11 @@ static ucs_status_ptr_t ucp_worker_flush_nb_internal(ucp_worker_h worker,
     ucs_status_t status;
     ucp_request_t *req;
 
+    status = ucp_rma_aggr_flush_all(worker);
+    if (UCS_STATUS_IS_ERR(status)) {
+        return UCS_STATUS_PTR(status);
+    }
+
     status = ucp_worker_flush_check(worker);
     if ((status != UCS_INPROGRESS) && (status != UCS_ERR_NO_RESOURCE)) {
         return UCS_STATUS_PTR(status);
@@ -436,11 +484,18 @@ static ucs_status_ptr_t ucp_worker_flush_nb_internal(ucp_worker_h worker,
     req->flush_worker.comp_count = 1; /* counting starts from 1, and decremented
                                          when finished going over all endpoints */
     req->flush_worker.prog_id    = UCS_CALLBACKQ_ID_NULL;
-    req->flush_worker.next_ep    = ucs_list_head(&worker->all_eps,
-                                                 ucp_ep_ext_gen_t, ep_list);
+    req->flush_worker.next_req   = NULL;
 
-    uct_worker_progress_register_safe(worker->uct, ucp_worker_flush_progress,
-                                      req, 0, &req->flush_worker.prog_id);
+    if (worker->flush_req_last != NULL) {
+        /* Previous worker flush may be flushing endpoints which had operations
+         * issued before this one, and are not marked anymore. Go over the
+         * endpoints only after it is completed. */
+        worker->flush_req_last->flush_worker.next_req = req;
+    } else {
+        ucp_worker_flush_start(req);
+    }
+
+    worker->flush_req_last = req;
     return req + 1;
 }
 
@@ -502,6 +557,11 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_fence, (worker), ucp_worker_h worker)
 
     UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
 
+    status = ucp_rma_aggr_flush_all(worker);
+    if (UCS_STATUS_IS_ERR(status)) {
+        goto out;
+    }
+
     ucs_for_each_bit(rsc_index, worker->context->tl_bitmap) {
         wiface = ucp_worker_iface(worker, rsc_index);
         if (wiface->iface == NULL) {
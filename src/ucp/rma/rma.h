@@ -7,6 +7,7 @@
 #ifndef UCP_RMA_H_
 #define UCP_RMA_H_
 
+#include <ucp/core/ucp_context.h>
 #include <ucp/proto/proto.h>
 
 
@@ -70,6 +71,55 @@ typedef struct {
 } UCS_S_PACKED ucp_atomic_req_hdr_t;
 
 
+typedef struct {
+    uintptr_t                 ep_ptr;
+} UCS_S_PACKED ucp_atomic_batch_hdr_t;
+
+
+typedef struct {
+    uint64_t                  address;
+    uint64_t                  value;
+    uint8_t                   length;
+    uint8_t                   opcode;
+} UCS_S_PACKED ucp_atomic_batch_entry_t;
+
+
+/**
+ * Completion counter of RMA operations
+ */
+struct ucp_rma_counter {
+    ucp_worker_h               worker;
+    uint64_t                   completed; /* Number of completed operations */
+    ucs_status_t               status;    /* Error of the first failed one */
+};
+
+
+/**
+ * Operations of an endpoint which are combined before sending them
+ */
+struct ucp_rma_aggr {
+    ucs_list_link_t               list;        /* Entry in worker's list of
+                                                  endpoints with aggregated
+                                                  operations */
+    ucp_ep_h                      ep;          /* Endpoint to send on */
+
+    struct {
+        ucp_rkey_h                rkey;        /* Remote key of the puts */
+        uint64_t                  remote_addr; /* Remote address of the first put */
+        size_t                    length;      /* Total length of the puts */
+        void                      *buffer;     /* Data of the puts, NULL if it
+                                                  was passed to a send request */
+    } put;
+
+    struct {
+        unsigned                  count;       /* Number of batched posts */
+        ucp_atomic_batch_entry_t  *entries;    /* Batched software atomic posts,
+                                                  NULL if they were passed to a
+                                                  send request */
+    } amo;
+};
+
+
 extern ucp_rma_proto_t ucp_rma_basic_proto;
 extern ucp_rma_proto_t ucp_rma_sw_proto;
 extern ucp_amo_proto_t ucp_amo_basic_proto;
@@ -83,4 +133,52 @@ void ucp_ep_flush_remote_completed(ucp_request_t *req);
 
 void ucp_rma_sw_send_cmpl(ucp_ep_h ep);
 
+void ucp_rma_aggr_ep_init(ucp_ep_h ep);
+
+/**
+ * Get the aggregation state of the endpoint, allocate it on first use.
+ */
+ucp_rma_aggr_t *ucp_rma_aggr_get(ucp_ep_h ep);
+
+/**
+ * Send the puts aggregated on the endpoint.
+ */
+ucs_status_t ucp_rma_aggr_flush(ucp_ep_h ep);
+
+/**
+ * Send the operations aggregated on all endpoints of the worker. Operations
+ * which could not be sent remain pending, and the first error is returned.
+ */
+ucs_status_t ucp_rma_aggr_flush_all(ucp_worker_h worker);
+
+/**
+ * Release the aggregation buffer of the endpoint, discarding unsent puts.
+ */
+void ucp_rma_aggr_cleanup(ucp_ep_h ep);
+
+/**
+ * Add a non-fetching atomic operation to the batch of the endpoint, or combine
+ * it with a batched operation on the same address.
+ */
+ucs_status_t ucp_amo_sw_batch_post(ucp_ep_h ep, uct_atomic_op_t op,
+                                   uint64_t value, size_t size,
+                                   uint64_t remote_addr);
+
+/**
+ * Send the batched atomic operations of the endpoint in one message.
+ */
+ucs_status_t ucp_amo_sw_batch_flush(ucp_ep_h ep, ucp_rma_aggr_t *aggr);
+
+
+static UCS_F_ALWAYS_INLINE int ucp_rma_aggr_is_enabled(ucp_context_h context)
+{
+    return (context->config.ext.rma_aggr_size > 0) ||
+           (context->config.ext.amo_sw_batch > 0);
+}
+
+static UCS_F_ALWAYS_INLINE int ucp_rma_aggr_is_pending(const ucp_rma_aggr_t *aggr)
+{
+    return (aggr->put.length > 0) || (aggr->amo.count > 0);
+}
+
 #endif
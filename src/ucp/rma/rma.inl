@@ -14,6 +14,25 @@
 #include <ucs/debug/log.h>
 
 
+/*
+ * Mark the endpoint as having RMA/AMO operations, so the next worker flush
+ * would flush it. Such endpoints are kept in the head of the worker's list, so
+ * worker flush does not have to go over the idle ones.
+ */
+static UCS_F_ALWAYS_INLINE void ucp_ep_rma_set_dirty(ucp_ep_h ep)
+{
+    ucp_ep_ext_gen_t *ep_ext;
+
+    if (ucs_likely(ep->flags & UCP_EP_FLAG_RMA_DIRTY)) {
+        return;
+    }
+
+    ep_ext     = ucp_ep_ext_gen(ep);
+    ep->flags |= UCP_EP_FLAG_RMA_DIRTY;
+    ucs_list_del(&ep_ext->ep_list);
+    ucs_list_add_head(&ep->worker->all_eps, &ep_ext->ep_list);
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_ptr_t
 ucp_rma_send_request_cb(ucp_request_t *req, ucp_send_callback_t cb)
 {
@@ -56,6 +75,14 @@ static inline ucs_status_t ucp_rma_wait(ucp_worker_h worker, void *user_req,
     }
 }
 
+/* Must be called before adding an operation to the aggregation state */
+static UCS_F_ALWAYS_INLINE void ucp_rma_aggr_set_pending(ucp_rma_aggr_t *aggr)
+{
+    if (!ucp_rma_aggr_is_pending(aggr)) {
+        ucs_list_add_tail(&aggr->ep->worker->rma_aggr_eps, &aggr->list);
+    }
+}
+
 static inline void ucp_ep_rma_remote_request_sent(ucp_ep_t *ep)
 {
     ++ucp_ep_flush_state(ep)->send_sn;
@@ -128,6 +128,7 @@ ucp_rma_request_init(ucp_request_t *req, ucp_ep_h ep, const void *buffer,
     req->send.rma.rkey        = rkey;
     req->send.uct.func        = cb;
     req->send.lane            = rkey->cache.rma_lane;
+    ucp_request_send_nontemporal_init(req);
     ucp_request_send_state_init(req, ucp_dt_make_contig(1), length);
     ucp_request_send_state_reset(req,
                                  (length < zcopy_thresh) ?
@@ -190,9 +191,304 @@ ucp_rma_nonblocking_cb(ucp_ep_h ep, const void *buffer, size_t length,
     return ucp_rma_send_request_cb(req, cb);
 }
 
+static void ucp_rma_aggr_put_completion(void *request, ucs_status_t status)
+{
+    ucp_request_t *req = (ucp_request_t*)request - 1;
+
+    ucs_free(req->send.rma.aggr_buffer);
+}
+
+void ucp_rma_aggr_ep_init(ucp_ep_h ep)
+{
+    if (ucp_rma_aggr_is_enabled(ep->worker->context)) {
+        ucp_ep_ext_proto(ep)->rma_aggr = NULL;
+    }
+}
+
+ucp_rma_aggr_t *ucp_rma_aggr_get(ucp_ep_h ep)
+{
+    ucp_rma_aggr_t *aggr = ucp_ep_ext_proto(ep)->rma_aggr;
+
+    if (ucs_likely(aggr != NULL)) {
+        return aggr;
+    }
+
+    aggr = ucs_malloc(sizeof(*aggr), "ucp_rma_aggr");
+    if (aggr == NULL) {
+        return NULL;
+    }
+
+    aggr->ep                       = ep;
+    aggr->put.length               = 0;
+    aggr->put.buffer               = NULL;
+    aggr->amo.count                = 0;
+    aggr->amo.entries              = NULL;
+    ucp_ep_ext_proto(ep)->rma_aggr = aggr;
+    return aggr;
+}
+
+static ucs_status_t ucp_rma_aggr_flush_put(ucp_ep_h ep, ucp_rma_aggr_t *aggr)
+{
+    size_t length   = aggr->put.length;
+    ucp_rkey_h rkey = aggr->put.rkey;
+    ucp_ep_rma_config_t *rma_config;
+    ucs_status_t status;
+    ucp_request_t *req;
+
+    if (length == 0) {
+        return UCS_OK;
+    }
+
+    ucs_trace_req("ep %p: flushing aggregated put length %zu remote_addr %"
+                  PRIx64" rkey %p", ep, length, aggr->put.remote_addr, rkey);
+
+    status = UCP_RKEY_RESOLVE(rkey, ep, rma);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    if ((ssize_t)length <= (int)rkey->cache.max_put_short) {
+        status = UCS_PROFILE_CALL(uct_ep_put_short,
+                                  ep->uct_eps[rkey->cache.rma_lane],
+                                  aggr->put.buffer, length,
+                                  aggr->put.remote_addr, rkey->cache.rma_rkey);
+        if (ucs_likely(status == UCS_OK)) {
+            aggr->put.length = 0;
+            return UCS_OK;
+        } else if (status != UCS_ERR_NO_RESOURCE) {
+            return status;
+        }
+    }
+
+    /* The request sends the data from the aggregation buffer, and releases it
+     * when completed. If it could not be started, the data is kept in the
+     * buffer and sent by the next flush. */
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
+    status     = ucp_rma_request_init(req, ep, aggr->put.buffer, length,
+                                      aggr->put.remote_addr, rkey,
+                                      rkey->cache.rma_proto->progress_put,
+                                      rma_config->put_zcopy_thresh,
+                                      UCP_REQUEST_FLAG_RELEASED);
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucp_request_put(req);
+        return status;
+    }
+
+    req->send.rma.aggr_buffer = aggr->put.buffer;
+    aggr->put.buffer          = NULL;
+    aggr->put.length          = 0;
+    ucp_request_set_callback(req, send.cb, ucp_rma_aggr_put_completion);
+    return ucp_request_send(req, 0);
+}
+
+ucs_status_t ucp_rma_aggr_flush(ucp_ep_h ep)
+{
+    ucs_status_t put_status, amo_status;
+    ucp_rma_aggr_t *aggr;
+
+    if (ucs_likely(!ucp_rma_aggr_is_enabled(ep->worker->context))) {
+        return UCS_OK;
+    }
+
+    aggr = ucp_ep_ext_proto(ep)->rma_aggr;
+    if ((aggr == NULL) || !ucp_rma_aggr_is_pending(aggr)) {
+        return UCS_OK;
+    }
+
+    put_status = ucp_rma_aggr_flush_put(ep, aggr);
+    amo_status = ucp_amo_sw_batch_flush(ep, aggr);
+
+    /* Operations which failed to be sent remain pending */
+    if (!ucp_rma_aggr_is_pending(aggr)) {
+        ucs_list_del(&aggr->list);
+    }
+
+    return UCS_STATUS_IS_ERR(put_status) ? put_status : amo_status;
+}
+
+ucs_status_t ucp_rma_aggr_flush_all(ucp_worker_h worker)
+{
+    ucs_status_t status = UCS_OK;
+    ucp_rma_aggr_t *aggr, *tmp;
+    ucs_status_t ep_status;
+
+    ucs_list_for_each_safe(aggr, tmp, &worker->rma_aggr_eps, list) {
+        ep_status = ucp_rma_aggr_flush(aggr->ep);
+        if (UCS_STATUS_IS_ERR(ep_status)) {
+            ucs_debug("ep %p: failed to send aggregated operations: %s",
+                      aggr->ep, ucs_status_string(ep_status));
+            if (status == UCS_OK) {
+                status = ep_status;
+            }
+        }
+    }
+
+    return status;
+}
+
+void ucp_rma_aggr_cleanup(ucp_ep_h ep)
+{
+    ucp_rma_aggr_t *aggr;
+
+    if (!ucp_rma_aggr_is_enabled(ep->worker->context)) {
+        return;
+    }
+
+    aggr = ucp_ep_ext_proto(ep)->rma_aggr;
+    if (aggr == NULL) {
+        return;
+    }
+
+    if (ucp_rma_aggr_is_pending(aggr)) {
+        ucs_debug("ep %p: discarding %zu bytes of aggregated puts and %u "
+                  "atomic operations", ep, aggr->put.length, aggr->amo.count);
+        ucs_list_del(&aggr->list);
+    }
+
+    ucs_free(aggr->put.buffer);
+    ucs_free(aggr->amo.entries);
+    ucs_free(aggr);
+    ucp_ep_ext_proto(ep)->rma_aggr = NULL;
+}
+
+static void ucp_rma_counter_completion(void *request, ucs_status_t status)
+{
+    ucp_request_t *req        = (ucp_request_t*)request - 1;
+    ucp_rma_counter_h counter = req->send.rma.counter;
+
+    if (ucs_unlikely(status != UCS_OK) && (counter->status == UCS_OK)) {
+        counter->status = status;
+    }
+    ++counter->completed;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_rma_nonblocking_counter(ucp_ep_h ep, const void *buffer, size_t length,
+                            uint64_t remote_addr, ucp_rkey_h rkey,
+                            uct_pending_callback_t progress_cb,
+                            size_t zcopy_thresh, ucp_rma_counter_h counter)
+{
+    ucs_status_t status;
+    ucp_request_t *req;
+
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    status = ucp_rma_request_init(req, ep, buffer, length, remote_addr, rkey,
+                                  progress_cb, zcopy_thresh,
+                                  UCP_REQUEST_FLAG_RELEASED);
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucp_request_put(req);
+        return status;
+    }
+
+    /* The callback is called also if the request completes immediately, so
+     * any result of the send is reported by the counter */
+    req->send.rma.counter = counter;
+    ucp_request_set_callback(req, send.cb, ucp_rma_counter_completion);
+    ucp_request_send(req, 0);
+    return UCS_OK;
+}
+
+ucs_status_t ucp_rma_counter_create(ucp_worker_h worker,
+                                    ucp_rma_counter_h *counter_p)
+{
+    ucp_rma_counter_h counter;
+
+    counter = ucs_malloc(sizeof(*counter), "ucp_rma_counter");
+    if (counter == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    counter->worker    = worker;
+    counter->completed = 0;
+    counter->status    = UCS_OK;
+    *counter_p         = counter;
+    return UCS_OK;
+}
+
+void ucp_rma_counter_destroy(ucp_rma_counter_h counter)
+{
+    ucs_free(counter);
+}
+
+uint64_t ucp_rma_counter_read(ucp_rma_counter_h counter)
+{
+    return counter->completed;
+}
+
+ucs_status_t ucp_rma_counter_wait(ucp_rma_counter_h counter, uint64_t value)
+{
+    while (counter->completed < value) {
+        ucp_worker_progress(counter->worker);
+    }
+
+    return counter->status;
+}
+
+/*
+ * Add a put to the aggregation buffer of the endpoint, after sending the
+ * previous puts if the new one does not continue them.
+ */
+static ucs_status_t
+ucp_rma_aggr_put(ucp_ep_h ep, const void *buffer, size_t length,
+                 uint64_t remote_addr, ucp_rkey_h rkey, size_t max_length)
+{
+    ucp_rma_aggr_t *aggr;
+    ucs_status_t status;
+
+    aggr = ucp_rma_aggr_get(ep);
+    if (aggr == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    if ((aggr->put.length > 0) &&
+        ((rkey != aggr->put.rkey) ||
+         (remote_addr != (aggr->put.remote_addr + aggr->put.length)) ||
+         ((aggr->put.length + length) > max_length))) {
+        status = ucp_rma_aggr_flush(ep);
+        if (UCS_STATUS_IS_ERR(status)) {
+            return status;
+        }
+    }
+
+    if (aggr->put.buffer == NULL) {
+        aggr->put.buffer = ucs_malloc(max_length, "ucp_rma_aggr_buffer");
+        if (aggr->put.buffer == NULL) {
+            return UCS_ERR_NO_MEMORY;
+        }
+    }
+
+    if (aggr->put.length == 0) {
+        ucp_rma_aggr_set_pending(aggr);
+        aggr->put.rkey        = rkey;
+        aggr->put.remote_addr = remote_addr;
+    }
+
+    memcpy(UCS_PTR_BYTE_OFFSET(aggr->put.buffer, aggr->put.length), buffer,
+           length);
+    aggr->put.length += length;
+
+    if (aggr->put.length == max_length) {
+        /* The data is queued already. If the buffer can't be sent now, it is
+         * sent again by the next flush, which reports the error. */
+        (void)ucp_rma_aggr_flush(ep);
+    }
+
+    return UCS_OK;
+}
+
 ucs_status_t ucp_put_nbi(ucp_ep_h ep, const void *buffer, size_t length,
                          uint64_t remote_addr, ucp_rkey_h rkey)
 {
+    size_t aggr_size = ep->worker->context->config.ext.rma_aggr_size;
     ucp_ep_rma_config_t *rma_config;
     ucs_status_t status;
 
@@ -203,11 +499,32 @@ ucs_status_t ucp_put_nbi(ucp_ep_h ep, const void *buffer, size_t length,
     ucs_trace_req("put_nbi buffer %p length %zu remote_addr %"PRIx64" rkey %p to %s",
                    buffer, length, remote_addr, rkey, ucp_ep_peer_name(ep));
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        goto out_unlock;
+    }
+
     status = UCP_RKEY_RESOLVE(rkey, ep, rma);
     if (status != UCS_OK) {
         goto out_unlock;
     }
 
+    ucp_ep_rma_set_dirty(ep);
+
+    if (ucs_unlikely(aggr_size > 0)) {
+        if (length < aggr_size) {
+            status = ucp_rma_aggr_put(ep, buffer, length, remote_addr, rkey,
+                                      aggr_size);
+            goto out_unlock;
+        }
+
+        /* Keep the order of puts on the endpoint */
+        status = ucp_rma_aggr_flush(ep);
+        if (UCS_STATUS_IS_ERR(status)) {
+            goto out_unlock;
+        }
+    }
+
     /* Fast path for a single short message */
     if (ucs_likely((ssize_t)length <= (int)rkey->cache.max_put_short)) {
         status = UCS_PROFILE_CALL(uct_ep_put_short, ep->uct_eps[rkey->cache.rma_lane],
@@ -226,6 +543,67 @@ out_unlock:
     return status;
 }
 
+ucs_status_t ucp_put_nbc(ucp_ep_h ep, const void *buffer, size_t length,
+                         uint64_t remote_addr, ucp_rkey_h rkey,
+                         ucp_rma_counter_h counter)
+{
+    ucp_ep_rma_config_t *rma_config;
+    ucs_status_t status;
+
+    UCP_CONTEXT_CHECK_FEATURE_FLAGS(ep->worker->context, UCP_FEATURE_RMA,
+                                    return UCS_ERR_INVALID_PARAM);
+    UCP_RMA_CHECK_BUFFER(buffer, return UCS_ERR_INVALID_PARAM);
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(ep->worker);
+
+    ucs_trace_req("put_nbc buffer %p length %zu remote_addr %"PRIx64" rkey %p to %s"
+                  " counter %p", buffer, length, remote_addr, rkey,
+                  ucp_ep_peer_name(ep), counter);
+
+    if (length == 0) {
+        ++counter->completed;
+        status = UCS_OK;
+        goto out_unlock;
+    }
+
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        goto out_unlock;
+    }
+
+    status = UCP_RKEY_RESOLVE(rkey, ep, rma);
+    if (status != UCS_OK) {
+        goto out_unlock;
+    }
+
+    ucp_ep_rma_set_dirty(ep);
+
+    /* Keep the order of puts on the endpoint */
+    status = ucp_rma_aggr_flush(ep);
+    if (UCS_STATUS_IS_ERR(status)) {
+        goto out_unlock;
+    }
+
+    /* Fast path for a single short message */
+    if (ucs_likely((ssize_t)length <= (int)rkey->cache.max_put_short)) {
+        status = UCS_PROFILE_CALL(uct_ep_put_short, ep->uct_eps[rkey->cache.rma_lane],
+                                  buffer, length, remote_addr, rkey->cache.rma_rkey);
+        if (ucs_likely(status == UCS_OK)) {
+            ++counter->completed;
+            goto out_unlock;
+        } else if (status != UCS_ERR_NO_RESOURCE) {
+            goto out_unlock;
+        }
+    }
+
+    rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
+    status = ucp_rma_nonblocking_counter(ep, buffer, length, remote_addr, rkey,
+                                         rkey->cache.rma_proto->progress_put,
+                                         rma_config->put_zcopy_thresh, counter);
+out_unlock:
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(ep->worker);
+    return status;
+}
+
 ucs_status_ptr_t ucp_put_nb(ucp_ep_h ep, const void *buffer, size_t length,
                             uint64_t remote_addr, ucp_rkey_h rkey,
                             ucp_send_callback_t cb)
@@ -240,12 +618,27 @@ ucs_status_ptr_t ucp_put_nb(ucp_ep_h ep, const void *buffer, size_t length,
     ucs_trace_req("put_nb buffer %p length %zu remote_addr %"PRIx64" rkey %p to %s cb %p",
                    buffer, length, remote_addr, rkey, ucp_ep_peer_name(ep), cb);
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        ptr_status = UCS_STATUS_PTR(status);
+        goto out_unlock;
+    }
+
     status = UCP_RKEY_RESOLVE(rkey, ep, rma);
     if (status != UCS_OK) {
         ptr_status = UCS_STATUS_PTR(status);
         goto out_unlock;
     }
 
+    ucp_ep_rma_set_dirty(ep);
+
+    /* Keep the order of puts on the endpoint */
+    status = ucp_rma_aggr_flush(ep);
+    if (UCS_STATUS_IS_ERR(status)) {
+        ptr_status = UCS_STATUS_PTR(status);
+        goto out_unlock;
+    }
+
     /* Fast path for a single short message */
     if (ucs_likely((ssize_t)length <= (int)rkey->cache.max_put_short)) {
         status = UCS_PROFILE_CALL(uct_ep_put_short, ep->uct_eps[rkey->cache.rma_lane],
@@ -277,11 +670,18 @@ ucs_status_t ucp_get_nbi(ucp_ep_h ep, void *buffer, size_t length,
     ucs_trace_req("get_nbi buffer %p length %zu remote_addr %"PRIx64" rkey %p from %s",
                    buffer, length, remote_addr, rkey, ucp_ep_peer_name(ep));
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        goto out_unlock;
+    }
+
     status = UCP_RKEY_RESOLVE(rkey, ep, rma);
     if (status != UCS_OK) {
         goto out_unlock;
     }
 
+    ucp_ep_rma_set_dirty(ep);
+
     rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
     status = ucp_rma_nonblocking(ep, buffer, length, remote_addr, rkey,
                                  rkey->cache.rma_proto->progress_get,
@@ -291,6 +691,49 @@ out_unlock:
     return status;
 }
 
+ucs_status_t ucp_get_nbc(ucp_ep_h ep, void *buffer, size_t length,
+                         uint64_t remote_addr, ucp_rkey_h rkey,
+                         ucp_rma_counter_h counter)
+{
+    ucp_ep_rma_config_t *rma_config;
+    ucs_status_t status;
+
+    UCP_CONTEXT_CHECK_FEATURE_FLAGS(ep->worker->context, UCP_FEATURE_RMA,
+                                    return UCS_ERR_INVALID_PARAM);
+    UCP_RMA_CHECK_BUFFER(buffer, return UCS_ERR_INVALID_PARAM);
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(ep->worker);
+
+    ucs_trace_req("get_nbc buffer %p length %zu remote_addr %"PRIx64" rkey %p from %s"
+                  " counter %p", buffer, length, remote_addr, rkey,
+                  ucp_ep_peer_name(ep), counter);
+
+    if (length == 0) {
+        ++counter->completed;
+        status = UCS_OK;
+        goto out_unlock;
+    }
+
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        goto out_unlock;
+    }
+
+    status = UCP_RKEY_RESOLVE(rkey, ep, rma);
+    if (status != UCS_OK) {
+        goto out_unlock;
+    }
+
+    ucp_ep_rma_set_dirty(ep);
+
+    rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
+    status = ucp_rma_nonblocking_counter(ep, buffer, length, remote_addr, rkey,
+                                         rkey->cache.rma_proto->progress_get,
+                                         rma_config->get_zcopy_thresh, counter);
+out_unlock:
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(ep->worker);
+    return status;
+}
+
 ucs_status_ptr_t ucp_get_nb(ucp_ep_h ep, void *buffer, size_t length,
                             uint64_t remote_addr, ucp_rkey_h rkey,
                             ucp_send_callback_t cb)
@@ -305,12 +748,20 @@ ucs_status_ptr_t ucp_get_nb(ucp_ep_h ep, void *buffer, size_t length,
     ucs_trace_req("get_nb buffer %p length %zu remote_addr %"PRIx64" rkey %p from %s cb %p",
                    buffer, length, remote_addr, rkey, ucp_ep_peer_name(ep), cb);
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        ptr_status = UCS_STATUS_PTR(status);
+        goto out_unlock;
+    }
+
     status = UCP_RKEY_RESOLVE(rkey, ep, rma);
     if (status != UCS_OK) {
         ptr_status = UCS_STATUS_PTR(status);
         goto out_unlock;
     }
 
+    ucp_ep_rma_set_dirty(ep);
+
     rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
     ptr_status = ucp_rma_nonblocking_cb(ep, buffer, length, remote_addr, rkey,
                                         rkey->cache.rma_proto->progress_get,
@@ -10,6 +10,7 @@
 #include <ucp/core/ucp_request.h>
 #include <ucp/core/ucp_request.inl>
 #include <ucp/stream/stream.h>
+#include <ucp/tag/rndv.h>
 
 #include <ucs/datastruct/mpool.inl>
 #include <ucs/profile/profile.h>
@@ -343,74 +344,218 @@ out:
     return req;
 }
 
-static UCS_F_ALWAYS_INLINE ucs_status_t
-ucp_stream_am_data_process(ucp_worker_t *worker, ucp_ep_ext_proto_t *ep_ext,
-                           ucp_stream_am_data_t *am_data, size_t length,
-                           unsigned am_flags)
+/*
+ * Unpack the data of @a rdesc to the requests posted on the endpoint.
+ * The payload of @a rdesc is at 'payload_offset' bytes from @a base.
+ *
+ * @return Nonzero if all data was consumed by the posted requests.
+ */
+static UCS_F_ALWAYS_INLINE int
+ucp_stream_rdesc_unpack_expected(ucp_ep_ext_proto_t *ep_ext,
+                                 ucp_recv_desc_t *rdesc, void *base)
 {
-    ucp_recv_desc_t  rdesc_tmp;
-    void            *payload;
-    ucp_recv_desc_t *rdesc;
-    ucp_request_t   *req;
-    ssize_t          unpacked;
-
-    rdesc_tmp.length         = length;
-    rdesc_tmp.payload_offset = sizeof(*am_data); /* add sizeof(*rdesc) only if
-                                                    am_data wont be handled in
-                                                    place */
-
-    /* First, process expected requests */
-    if (!ucp_stream_ep_has_data(ep_ext)) {
-        while (!ucs_queue_is_empty(&ep_ext->stream.match_q)) {
-            req      = ucs_queue_head_elem_non_empty(&ep_ext->stream.match_q,
-                                                     ucp_request_t, recv.queue);
-            payload  = UCS_PTR_BYTE_OFFSET(am_data, rdesc_tmp.payload_offset);
-            unpacked = ucp_stream_rdata_unpack(payload, rdesc_tmp.length, req);
-            if (ucs_unlikely(unpacked < 0)) {
-                ucs_fatal("failed to unpack from am_data %p with offset %u to request %p",
-                          am_data, rdesc_tmp.payload_offset, req);
-            } else if (unpacked == rdesc_tmp.length) {
-                if (ucp_request_can_complete_stream_recv(req)) {
-                    ucp_request_complete_stream_recv(req, ep_ext, UCS_OK);
-                }
-                return UCS_OK;
+    void          *payload;
+    ucp_request_t *req;
+    ssize_t        unpacked;
+
+    ucs_assert(!ucp_stream_ep_has_data(ep_ext));
+
+    while (!ucs_queue_is_empty(&ep_ext->stream.match_q)) {
+        req      = ucs_queue_head_elem_non_empty(&ep_ext->stream.match_q,
+                                                 ucp_request_t, recv.queue);
+        payload  = UCS_PTR_BYTE_OFFSET(base, rdesc->payload_offset);
+        unpacked = ucp_stream_rdata_unpack(payload, rdesc->length, req);
+        if (ucs_unlikely(unpacked < 0)) {
+            ucs_fatal("failed to unpack from am_data %p with offset %u to request %p",
+                      base, rdesc->payload_offset, req);
+        } else if (unpacked == rdesc->length) {
+            if (ucp_request_can_complete_stream_recv(req)) {
+                ucp_request_complete_stream_recv(req, ep_ext, UCS_OK);
             }
-            ucp_stream_rdesc_advance(&rdesc_tmp, unpacked, ep_ext);
-            /* This request is full, try next one */
-            ucs_assert(ucp_request_can_complete_stream_recv(req));
-            ucp_request_complete_stream_recv(req, ep_ext, UCS_OK);
+            return 1;
         }
+        ucp_stream_rdesc_advance(rdesc, unpacked, ep_ext);
+        /* This request is full, try next one */
+        ucs_assert(ucp_request_can_complete_stream_recv(req));
+        ucp_request_complete_stream_recv(req, ep_ext, UCS_OK);
     }
 
-    ucs_assert(rdesc_tmp.length > 0);
+    return 0;
+}
+
+static UCS_F_ALWAYS_INLINE ucp_recv_desc_t *
+ucp_stream_rdesc_init(ucp_worker_t *worker, ucp_stream_am_data_t *am_data,
+                      const ucp_recv_desc_t *rdesc_tmp, unsigned am_flags)
+{
+    ucp_recv_desc_t *rdesc;
 
-    /* Now, enqueue the rest of data */
     if (ucs_likely(!(am_flags & UCT_CB_PARAM_FLAG_DESC))) {
         rdesc = (ucp_recv_desc_t*)ucs_mpool_get_inline(&worker->am_mp);
         ucs_assertv_always(rdesc != NULL,
                            "ucp recv descriptor is not allocated");
-        rdesc->length         = rdesc_tmp.length;
+        rdesc->length         = rdesc_tmp->length;
         /* reset offset to improve locality */
         rdesc->payload_offset = sizeof(*rdesc) + sizeof(*am_data);
         rdesc->flags          = 0;
         memcpy(ucp_stream_rdesc_payload(rdesc),
-               UCS_PTR_BYTE_OFFSET(am_data, rdesc_tmp.payload_offset),
-               rdesc_tmp.length);
+               UCS_PTR_BYTE_OFFSET(am_data, rdesc_tmp->payload_offset),
+               rdesc_tmp->length);
     } else {
         /* slowpath */
         rdesc                 = (ucp_recv_desc_t *)am_data - 1;
-        rdesc->length         = rdesc_tmp.length;
-        rdesc->payload_offset = rdesc_tmp.payload_offset + sizeof(*rdesc);
+        rdesc->length         = rdesc_tmp->length;
+        rdesc->payload_offset = rdesc_tmp->payload_offset + sizeof(*rdesc);
         rdesc->priv_length    = 0;
         rdesc->flags          = UCP_RECV_DESC_FLAG_UCT_DESC;
     }
 
+    return rdesc;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_stream_am_data_process(ucp_worker_t *worker, ucp_ep_ext_proto_t *ep_ext,
+                           ucp_stream_am_data_t *am_data, size_t length,
+                           unsigned am_flags)
+{
+    ucp_recv_desc_t  rdesc_tmp;
+    ucp_recv_desc_t *rdesc;
+
+    rdesc_tmp.length         = length;
+    rdesc_tmp.payload_offset = sizeof(*am_data); /* add sizeof(*rdesc) only if
+                                                    am_data wont be handled in
+                                                    place */
+
+    /* First, process expected requests */
+    if (!ucp_stream_ep_has_data(ep_ext) &&
+        ucp_stream_rdesc_unpack_expected(ep_ext, &rdesc_tmp, am_data)) {
+        return UCS_OK;
+    }
+
+    ucs_assert(rdesc_tmp.length > 0);
+
+    /* Now, enqueue the rest of data */
+    rdesc = ucp_stream_rdesc_init(worker, am_data, &rdesc_tmp, am_flags);
     ucp_ep_from_ext_proto(ep_ext)->flags |= UCP_EP_FLAG_STREAM_HAS_DATA;
     ucs_queue_push(&ep_ext->stream.match_q, &rdesc->stream_queue);
 
     return UCS_INPROGRESS;
 }
 
+/*
+ * Get the posted receive request which the data of rendezvous descriptor
+ * @a rdesc is fetched to, or NULL if the data is fetched to the descriptor or
+ * @a rdesc is not a rendezvous descriptor.
+ */
+static UCS_F_ALWAYS_INLINE ucp_request_t *
+ucp_stream_rdesc_rndv_req(const ucp_recv_desc_t *rdesc)
+{
+    /* Only rendezvous descriptors are allocated by malloc */
+    return (rdesc->flags & UCP_RECV_DESC_FLAG_MALLOC) ?
+           rdesc->stream_rndv.rreq : NULL;
+}
+
+/*
+ * Get the posted receive request which the next data of the endpoint can be
+ * placed to, while rendezvous is in progress. This is possible only if all
+ * data in the rendezvous queue is fetched directly to the head posted request.
+ * Since any such data is ordered before the rest of rendezvous queue, it's
+ * enough to check the tail.
+ */
+static UCS_F_ALWAYS_INLINE ucp_request_t *
+ucp_stream_rndv_q_posted_req(ucp_ep_ext_proto_t *ep_ext)
+{
+    ucp_recv_desc_t *rdesc;
+
+    rdesc = ucs_queue_tail_elem_non_empty(&ep_ext->stream.rndv_q,
+                                          ucp_recv_desc_t, stream_queue);
+    return ucp_stream_rdesc_rndv_req(rdesc);
+}
+
+/*
+ * Deliver the data from the head of rendezvous queue, until reaching data
+ * which is still being fetched.
+ */
+static void ucp_stream_rndv_q_progress(ucp_ep_ext_proto_t *ep_ext)
+{
+    ucp_ep_h        ep = ucp_ep_from_ext_proto(ep_ext);
+    ucp_recv_desc_t *rdesc;
+    ucp_request_t   *req;
+
+    while (!ucs_queue_is_empty(&ep_ext->stream.rndv_q)) {
+        rdesc = ucs_queue_head_elem_non_empty(&ep_ext->stream.rndv_q,
+                                              ucp_recv_desc_t, stream_queue);
+        if (rdesc->flags & UCP_RECV_DESC_FLAG_RNDV) {
+            break;
+        }
+
+        ucs_queue_pull_non_empty(&ep_ext->stream.rndv_q);
+
+        req = ucp_stream_rdesc_rndv_req(rdesc);
+        if (req != NULL) {
+            /* The data was fetched to the receive request. It may complete
+             * when no more data is being fetched to it. */
+            ucp_recv_desc_release(rdesc);
+            if ((ucs_queue_is_empty(&ep_ext->stream.rndv_q) ||
+                 (ucp_stream_rdesc_rndv_req(
+                      ucs_queue_head_elem_non_empty(&ep_ext->stream.rndv_q,
+                                                    ucp_recv_desc_t,
+                                                    stream_queue)) != req)) &&
+                ucp_request_can_complete_stream_recv(req)) {
+                ucp_request_complete_stream_recv(req, ep_ext, UCS_OK);
+            }
+            continue;
+        }
+
+        if ((rdesc->length == 0) ||
+            (!ucp_stream_ep_has_data(ep_ext) &&
+             ucp_stream_rdesc_unpack_expected(ep_ext, rdesc, rdesc))) {
+            ucp_recv_desc_release(rdesc);
+            continue;
+        }
+
+        ep->flags |= UCP_EP_FLAG_STREAM_HAS_DATA;
+        ucs_queue_push(&ep_ext->stream.match_q, &rdesc->stream_queue);
+    }
+
+    if (ucp_stream_ep_has_data(ep_ext) && !ucp_stream_ep_is_queued(ep_ext) &&
+        (ep->flags & UCP_EP_FLAG_USED)) {
+        ucp_stream_ep_enqueue(ep_ext, ep->worker);
+    }
+}
+
+/*
+ * Handle stream data which arrived while earlier data is being fetched with
+ * rendezvous.
+ */
+static ucs_status_t
+ucp_stream_rndv_q_data_process(ucp_worker_t *worker, ucp_ep_ext_proto_t *ep_ext,
+                               ucp_stream_am_data_t *am_data, size_t length,
+                               unsigned am_flags)
+{
+    ucp_recv_desc_t rdesc_tmp;
+    ucp_recv_desc_t *rdesc;
+    ucp_request_t   *req;
+    ssize_t         unpacked UCS_V_UNUSED;
+
+    /* The data can be placed to the request which earlier data is fetched to,
+     * behind the space which was reserved for it. The request is completed
+     * after the fetch is done. */
+    req = ucp_stream_rndv_q_posted_req(ep_ext);
+    if ((req != NULL) &&
+        (length <= (req->recv.length - req->recv.stream.offset))) {
+        unpacked = ucp_stream_rdata_unpack(am_data + 1, length, req);
+        ucs_assert(unpacked == length);
+        return UCS_OK;
+    }
+
+    /* Deliver the data after the earlier data */
+    rdesc_tmp.length         = length;
+    rdesc_tmp.payload_offset = sizeof(*am_data);
+    rdesc = ucp_stream_rdesc_init(worker, am_data, &rdesc_tmp, am_flags);
+    ucs_queue_push(&ep_ext->stream.rndv_q, &rdesc->stream_queue);
+    return (am_flags & UCT_CB_PARAM_FLAG_DESC) ? UCS_INPROGRESS : UCS_OK;
+}
+
 void ucp_stream_ep_init(ucp_ep_h ep)
 {
     ucp_ep_ext_proto_t *ep_ext = ucp_ep_ext_proto(ep);
@@ -419,15 +564,28 @@ void ucp_stream_ep_init(ucp_ep_h ep)
         ep_ext->stream.ready_list.prev = NULL;
         ep_ext->stream.ready_list.next = NULL;
         ucs_queue_head_init(&ep_ext->stream.match_q);
+        ucs_queue_head_init(&ep_ext->stream.rndv_q);
     }
 }
 
 void ucp_stream_ep_cleanup(ucp_ep_h ep)
 {
-    size_t length;
-    void *data;
+    ucp_ep_ext_proto_t *ep_ext = ucp_ep_ext_proto(ep);
+    ucp_recv_desc_t    *rdesc;
+    size_t             length;
+    void               *data;
 
     if (ep->worker->context->config.features & UCP_FEATURE_STREAM) {
+        ucs_queue_for_each_extract(rdesc, &ep_ext->stream.rndv_q, stream_queue,
+                                   1) {
+            if (rdesc->flags & UCP_RECV_DESC_FLAG_RNDV) {
+                /* released when the rendezvous completes */
+                rdesc->stream_rndv.ep = NULL;
+            } else {
+                ucp_recv_desc_release(rdesc);
+            }
+        }
+
         while ((data = ucp_stream_recv_data_nb_nolock(ep, &length)) != NULL) {
             ucs_assert_always(!UCS_PTR_IS_ERR(data));
             ucp_stream_data_release(ep, data);
@@ -470,6 +628,12 @@ ucp_stream_am_handler(void *am_arg, void *am_data, size_t am_length,
         return UCS_OK;
     }
 
+    if (ucs_unlikely(!ucs_queue_is_empty(&ep_ext->stream.rndv_q))) {
+        return ucp_stream_rndv_q_data_process(worker, ep_ext, data,
+                                              am_length - sizeof(data->hdr),
+                                              am_flags);
+    }
+
     status = ucp_stream_am_data_process(worker, ep_ext, data,
                                         am_length - sizeof(data->hdr),
                                         am_flags);
@@ -487,23 +651,194 @@ ucp_stream_am_handler(void *am_arg, void *am_data, size_t am_length,
     return (am_flags & UCT_CB_PARAM_FLAG_DESC) ? UCS_INPROGRESS : UCS_OK;
 }
 
+static void ucp_stream_rndv_recv_completed(void *request, ucs_status_t status,
+                                           ucp_tag_recv_info_t *info)
+{
+    ucp_request_t      *rreq  = (ucp_request_t*)request - 1;
+    ucp_recv_desc_t    *rdesc = rreq->recv.tag.stream_rdesc;
+    ucp_ep_ext_proto_t *ep_ext;
+
+    if (rdesc == NULL) {
+        /* The data was dropped when rendezvous started */
+        return;
+    }
+
+    if (rdesc->stream_rndv.ep == NULL) {
+        /* The endpoint was closed */
+        ucs_free(rdesc);
+        return;
+    }
+
+    ep_ext        = ucp_ep_ext_proto(rdesc->stream_rndv.ep);
+    rdesc->flags &= ~UCP_RECV_DESC_FLAG_RNDV;
+
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_error("ep %p: failed to receive %u bytes of stream data: %s",
+                  rdesc->stream_rndv.ep, rdesc->length,
+                  ucs_status_string(status));
+        rdesc->length = 0;
+    }
+
+    /* If the data was fetched to the receive request, it remained at the
+     * head of match queue since the rendezvous was started, because any later
+     * data went either to the same request or to the rendezvous queue */
+    ucs_assert((rdesc->stream_rndv.rreq == NULL) ||
+               (rdesc->stream_rndv.rreq ==
+                ucs_queue_head_elem_non_empty(&ep_ext->stream.match_q,
+                                              ucp_request_t, recv.queue)));
+    ucp_stream_rndv_q_progress(ep_ext);
+}
+
+/*
+ * Get the posted receive request which the rendezvous data of @a length bytes
+ * can be fetched to directly.
+ */
+static UCS_F_ALWAYS_INLINE ucp_request_t *
+ucp_stream_rndv_get_posted_req(ucp_ep_ext_proto_t *ep_ext, size_t length)
+{
+    ucp_request_t *req;
+
+    /* The request must be the next one to get data */
+    if (ucp_stream_ep_has_data(ep_ext)) {
+        return NULL;
+    } else if (!ucs_queue_is_empty(&ep_ext->stream.rndv_q)) {
+        req = ucp_stream_rndv_q_posted_req(ep_ext);
+        if (req == NULL) {
+            return NULL;
+        }
+    } else if (!ucs_queue_is_empty(&ep_ext->stream.match_q)) {
+        req = ucs_queue_head_elem_non_empty(&ep_ext->stream.match_q,
+                                            ucp_request_t, recv.queue);
+        if (!UCP_DT_IS_CONTIG(req->recv.datatype)) {
+            return NULL;
+        }
+    } else {
+        return NULL;
+    }
+
+    if ((req->recv.length - req->recv.stream.offset) < length) {
+        return NULL;
+    }
+
+    return req;
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_stream_rndv_rts_handler,
+                 (am_arg, am_data, am_length, am_flags),
+                 void *am_arg, void *am_data, size_t am_length,
+                 unsigned am_flags)
+{
+    ucp_worker_h       worker       = am_arg;
+    ucp_rndv_rts_hdr_t *rndv_rts_hdr = am_data;
+    ucp_ep_h           ep;
+    ucp_ep_ext_proto_t *ep_ext;
+    ucp_recv_desc_t    *rdesc;
+    ucp_request_t      *rreq, *req;
+
+    ep     = ucp_worker_get_ep_by_ptr(worker, rndv_rts_hdr->sreq.ep_ptr);
+    ep_ext = ucp_ep_ext_proto(ep);
+
+    rreq = ucp_request_get(worker);
+    if (rreq == NULL) {
+        ucs_fatal("failed to allocate receive request for stream data");
+    }
+
+    rreq->flags         = UCP_REQUEST_FLAG_CALLBACK | UCP_REQUEST_FLAG_RELEASED;
+    rreq->recv.worker   = worker;
+    rreq->recv.datatype = ucp_dt_make_contig(1);
+    rreq->recv.tag.cb   = ucp_stream_rndv_recv_completed;
+
+    if (ucs_unlikely(ep->flags & UCP_EP_FLAG_CLOSED)) {
+        ucs_trace_data("ep %p: stream is invalid", ep);
+        /* Drop the data, rendezvous completes as truncated and releases the
+         * sender */
+        rdesc               = NULL;
+        rreq->recv.buffer   = NULL;
+        rreq->recv.length   = 0;
+        rreq->recv.mem_type = UCT_MD_MEM_TYPE_HOST;
+    } else {
+        ucs_assert(rndv_rts_hdr->size <= UINT32_MAX);
+
+        /* Fetch the data directly to the posted receive buffer if possible,
+         * otherwise to a descriptor which is queued as any other data */
+        req   = ucp_stream_rndv_get_posted_req(ep_ext, rndv_rts_hdr->size);
+        rdesc = ucs_malloc(sizeof(*rdesc) + sizeof(ucp_stream_am_data_t) +
+                           ((req == NULL) ? rndv_rts_hdr->size : 0),
+                           "ucp_stream_rndv_rdesc");
+        if (rdesc == NULL) {
+            ucs_fatal("failed to allocate %zu bytes for stream data",
+                      rndv_rts_hdr->size);
+        }
+
+        rdesc->flags             = UCP_RECV_DESC_FLAG_MALLOC |
+                                   UCP_RECV_DESC_FLAG_RNDV;
+        rdesc->length            = rndv_rts_hdr->size;
+        rdesc->payload_offset    = sizeof(*rdesc) + sizeof(ucp_stream_am_data_t);
+        rdesc->priv_length       = 0;
+        rdesc->stream_rndv.ep    = ep;
+        rdesc->stream_rndv.rreq  = req;
+        ucs_queue_push(&ep_ext->stream.rndv_q, &rdesc->stream_queue);
+
+        if (req != NULL) {
+            /* Reserve the space in the receive buffer, so later data could be
+             * placed behind it */
+            rreq->recv.buffer        = UCS_PTR_BYTE_OFFSET(req->recv.buffer,
+                                                           req->recv.stream.offset);
+            rreq->recv.mem_type      = req->recv.mem_type;
+            req->recv.stream.offset += rndv_rts_hdr->size;
+        } else {
+            rreq->recv.buffer   = ucp_stream_rdesc_payload(rdesc);
+            rreq->recv.mem_type = UCT_MD_MEM_TYPE_HOST;
+        }
+        rreq->recv.length = rndv_rts_hdr->size;
+    }
+
+    rreq->recv.tag.stream_rdesc = rdesc;
+    ucp_dt_recv_state_init(&rreq->recv.state, rreq->recv.buffer,
+                           rreq->recv.datatype, rreq->recv.length);
+
+    ucs_trace_data("ep %p: stream rendezvous of %zu bytes to %s %p", ep,
+                   rndv_rts_hdr->size,
+                   ((rdesc != NULL) && (rdesc->stream_rndv.rreq != NULL)) ?
+                   "request" : "descriptor", rreq->recv.buffer);
+
+    ucp_rndv_matched(worker, rreq, rndv_rts_hdr);
+    return UCS_OK;
+}
+
 static void ucp_stream_am_dump(ucp_worker_h worker, uct_am_trace_type_t type,
                                uint8_t id, const void *data, size_t length,
                                char *buffer, size_t max)
 {
-    const ucp_stream_am_hdr_t *hdr    = data;
-    size_t                    hdr_len = sizeof(*hdr);
+    const ucp_stream_am_hdr_t *hdr          = data;
+    const ucp_rndv_rts_hdr_t  *rndv_rts_hdr = data;
+    size_t                    hdr_len       = sizeof(*hdr);
     char                      *p;
 
-    snprintf(buffer, max, "STREAM ep_ptr 0x%lx", hdr->ep_ptr);
-    p = buffer + strlen(buffer);
-
-    ucs_assert(hdr->ep_ptr != 0);
-    ucp_dump_payload(worker->context, p, buffer + max - p, data + hdr_len,
-                     length - hdr_len);
+    switch (id) {
+    case UCP_AM_ID_STREAM_DATA:
+        snprintf(buffer, max, "STREAM ep_ptr 0x%lx", hdr->ep_ptr);
+        p = buffer + strlen(buffer);
+
+        ucs_assert(hdr->ep_ptr != 0);
+        ucp_dump_payload(worker->context, p, buffer + max - p, data + hdr_len,
+                         length - hdr_len);
+        break;
+    case UCP_AM_ID_STREAM_RNDV_RTS:
+        snprintf(buffer, max, "STREAM_RNDV_RTS ep_ptr 0x%lx sreq 0x%lx "
+                 "address 0x%"PRIx64" size %zu", rndv_rts_hdr->sreq.ep_ptr,
+                 rndv_rts_hdr->sreq.reqptr, rndv_rts_hdr->address,
+                 rndv_rts_hdr->size);
+        break;
+    default:
+        break;
+    }
 }
 
 UCP_DEFINE_AM(UCP_FEATURE_STREAM, UCP_AM_ID_STREAM_DATA, ucp_stream_am_handler,
               ucp_stream_am_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_STREAM, UCP_AM_ID_STREAM_RNDV_RTS,
+              ucp_stream_rndv_rts_handler, ucp_stream_am_dump, 0);
 
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_STREAM_DATA);
+UCP_DEFINE_AM_PROXY(UCP_AM_ID_STREAM_RNDV_RTS);
@@ -11,6 +11,7 @@
 #include <ucp/proto/proto.h>
 #include <ucp/proto/proto_am.inl>
 #include <ucp/stream/stream.h>
+#include <ucp/tag/rndv.h>
 #include <ucp/dt/dt.h>
 #include <ucp/dt/dt.inl>
 
@@ -37,25 +38,53 @@ static void ucp_stream_send_req_init(ucp_request_t* req, ucp_ep_h ep,
     req->send.length       = ucp_dt_length(req->send.datatype, count,
                                            req->send.buffer,
                                            &req->send.state.dt);
+    ucp_request_send_nontemporal_init(req);
     ucp_memory_type_detect_mds(ep->worker->context, (void *)buffer,
                                req->send.length, &req->send.mem_type);
     VALGRIND_MAKE_MEM_UNDEFINED(&req->send.tag, sizeof(req->send.tag));
 }
 
+static UCS_F_ALWAYS_INLINE size_t
+ucp_stream_get_rndv_threshold(const ucp_request_t *req)
+{
+    const ucp_ep_config_t *config = ucp_ep_config(req->send.ep);
+
+    if (ucs_unlikely(req->send.length > UINT32_MAX)) {
+        /* Stream receive descriptor holds a 32-bit length */
+        return SIZE_MAX;
+    }
+
+    if (UCP_DT_IS_GENERIC(req->send.datatype)) {
+        return config->tag.rndv.am_thresh;
+    }
+
+    return ucs_min(config->tag.rndv.rma_thresh, config->tag.rndv.am_thresh);
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_ptr_t
 ucp_stream_send_req(ucp_request_t *req, size_t count,
                     const ucp_ep_msg_config_t* msg_config,
                     ucp_send_callback_t cb, const ucp_proto_t *proto)
 {
+    size_t rndv_thresh  = ucp_stream_get_rndv_threshold(req);
     size_t zcopy_thresh = ucp_proto_get_zcopy_threshold(req, msg_config,
-                                                        count, SIZE_MAX);
+                                                        count, rndv_thresh);
     ssize_t max_short   = ucp_proto_get_short_max(req, msg_config);
 
     ucs_status_t status = ucp_request_send_start(req, max_short, zcopy_thresh,
-                                                 SIZE_MAX, count, msg_config,
+                                                 rndv_thresh, count, msg_config,
                                                  proto);
-    if (status != UCS_OK) {
-        return UCS_STATUS_PTR(status);
+    if (ucs_unlikely(status != UCS_OK)) {
+        if (status == UCS_ERR_NO_PROGRESS) {
+            /* RMA/AM rendezvous */
+            ucs_assert(req->send.length >= rndv_thresh);
+            status = ucp_stream_send_start_rndv(req);
+        }
+
+        if (status != UCS_OK) {
+            ucp_request_put(req);
+            return UCS_STATUS_PTR(status);
+        }
     }
 
     /*
@@ -98,6 +127,12 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_stream_send_nb,
         goto out;
     }
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        ret = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
     status = ucp_ep_resolve_dest_ep_ptr(ep, ep->am_lane);
     if (status != UCS_OK) {
         ret = UCS_STATUS_PTR(status);
@@ -157,7 +192,8 @@ static size_t ucp_stream_pack_am_single_dt(void *dest, void *arg)
 
     length = ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                          req->send.mem_type, hdr + 1, req->send.buffer,
-                         &req->send.state.dt, req->send.length);
+                         &req->send.state.dt, req->send.length,
+                         ucp_request_pack_nontemporal(req));
     ucs_assert(length == req->send.length);
     return sizeof(*hdr) + length;
 }
@@ -189,7 +225,8 @@ static size_t ucp_stream_pack_am_first_dt(void *dest, void *arg)
     ucs_assert(req->send.length > length);
     return sizeof(*hdr) + ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                                       req->send.mem_type, hdr + 1, req->send.buffer,
-                                      &req->send.state.dt, length);
+                                      &req->send.state.dt, length,
+                                      ucp_request_pack_nontemporal(req));
 }
 
 static size_t ucp_stream_pack_am_middle_dt(void *dest, void *arg)
@@ -203,7 +240,8 @@ static size_t ucp_stream_pack_am_middle_dt(void *dest, void *arg)
                           req->send.length - req->send.state.dt.offset);
     return sizeof(*hdr) + ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                                       req->send.mem_type, hdr + 1, req->send.buffer,
-                                      &req->send.state.dt, length);
+                                      &req->send.state.dt, length,
+                                      ucp_request_pack_nontemporal(req));
 }
 
 static ucs_status_t ucp_stream_bcopy_multi(uct_pending_req_t *self)
@@ -65,8 +65,20 @@ typedef struct {
 extern const ucp_proto_t ucp_tag_eager_proto;
 extern const ucp_proto_t ucp_tag_eager_sync_proto;
 
+/*
+ * Eager flow control message, sent by a receiver which holds too many
+ * unexpected messages, to pause and later resume eager protocol
+ */
+typedef struct {
+    uintptr_t                 ep_ptr;
+    uint8_t                   pause;
+} UCS_S_PACKED ucp_eager_fc_hdr_t;
+
+
 void ucp_tag_eager_sync_send_ack(ucp_worker_h worker, void *hdr, uint16_t recv_flags);
 
+void ucp_tag_eager_fc_send(ucp_ep_h ep, int pause);
+
 void ucp_tag_eager_sync_completion(ucp_request_t *req, uint16_t flag,
                                    ucs_status_t status);
 
@@ -46,6 +46,8 @@ ucp_eager_offload_handler(void *arg, void *data, size_t length,
     ucp_tag_t *rdesc_hdr;
     ucs_status_t status;
 
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
+
     req = ucp_tag_exp_search(&worker->tm, recv_tag);
     if (req != NULL) {
         ucp_eager_expected_handler(worker, req, data, length, recv_tag, flags);
@@ -64,6 +66,7 @@ ucp_eager_offload_handler(void *arg, void *data, size_t length,
         }
     }
 
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
     return status;
 }
 
@@ -86,6 +89,8 @@ ucp_eager_tagged_handler(void *arg, void *data, size_t length, unsigned am_flags
     recv_tag = eager_hdr->super.tag;
     recv_len = length - hdr_len;
 
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
+
     req = ucp_tag_exp_search(&worker->tm, recv_tag);
     if (req != NULL) {
         ucp_eager_expected_handler(worker, req, data, recv_len, recv_tag, flags);
@@ -121,6 +126,7 @@ ucp_eager_tagged_handler(void *arg, void *data, size_t length, unsigned am_flags
         }
     }
 
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
     return status;
 }
 
@@ -154,11 +160,14 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_eager_middle_handler,
     ucp_request_t *req;
     ucs_status_t status;
     size_t recv_len;
-    khiter_t iter;
+    ucs_shash_iter_t iter;
     int ret;
 
-    iter   = kh_put(ucp_tag_frag_hash, &worker->tm.frag_hash, hdr->msg_id, &ret);
-    matchq = &kh_value(&worker->tm.frag_hash, iter);
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
+
+    iter   = ucs_shash_put(ucp_tag_frag_hash, &worker->tm.frag_hash,
+                           hdr->msg_id, &ret);
+    matchq = &ucs_shash_value(&worker->tm.frag_hash, iter);
     if (ret != 0) {
         /* initialize a previously empty hash entry */
         ucp_tag_frag_match_init_unexp(matchq);
@@ -171,6 +180,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_eager_middle_handler,
                                     &rdesc);
         if (!UCS_STATUS_IS_ERR(status)) {
             ucp_tag_frag_match_add_unexp(matchq, rdesc, hdr->offset);
+            ucp_tag_unexp_mem_add(&worker->tm, rdesc);
         }
     } else {
         /* hash entry contains a request, copy data to user buffer */
@@ -182,12 +192,13 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_eager_middle_handler,
                                                    recv_len, hdr->offset, 0);
         if (status != UCS_INPROGRESS) {
             /* request completed, delete hash entry */
-            kh_del(ucp_tag_frag_hash, &worker->tm.frag_hash, iter);
+            ucs_shash_del(ucp_tag_frag_hash, &worker->tm.frag_hash, iter);
         }
 
         status = UCS_OK;
     }
 
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
     return status;
 }
 
@@ -248,6 +259,26 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_eager_sync_ack_handler,
     return UCS_OK;
 }
 
+UCS_PROFILE_FUNC(ucs_status_t, ucp_eager_fc_handler,
+                 (arg, data, length, am_flags),
+                 void *arg, void *data, size_t length, unsigned am_flags)
+{
+    ucp_eager_fc_hdr_t *fc_hdr = data;
+    ucp_worker_h worker        = arg;
+    ucp_ep_h ep;
+
+    ep = ucp_worker_get_ep_by_ptr(worker, fc_hdr->ep_ptr);
+    if (fc_hdr->pause) {
+        ep->flags |= UCP_EP_FLAG_TAG_EAGER_PAUSED;
+    } else {
+        ep->flags &= ~UCP_EP_FLAG_TAG_EAGER_PAUSED;
+    }
+
+    ucs_debug("ep %p: %s eager protocol of tag messages", ep,
+              fc_hdr->pause ? "paused" : "resumed");
+    return UCS_OK;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_tag_offload_unexp_eager,
                  (arg, data, length, tl_flags, stag, imm),
                  void *arg, void *data, size_t length, unsigned tl_flags,
@@ -301,6 +332,7 @@ static void ucp_eager_dump(ucp_worker_h worker, uct_am_trace_type_t type,
     const ucp_eager_sync_hdr_t *eagers_hdr       = data;
     const ucp_reply_hdr_t *rep_hdr               = data;
     const ucp_offload_ssend_hdr_t *off_rep_hdr   = data;
+    const ucp_eager_fc_hdr_t *fc_hdr             = data;
     size_t header_len;
     char *p;
 
@@ -347,6 +379,11 @@ static void ucp_eager_dump(ucp_worker_h worker, uct_am_trace_type_t type,
                  off_rep_hdr->sender_tag, off_rep_hdr->ep_ptr);
         header_len = sizeof(*rep_hdr);
         break;
+    case UCP_AM_ID_EAGER_FC:
+        snprintf(buffer, max, "EGR_FC ep_ptr 0x%lx %s", fc_hdr->ep_ptr,
+                 fc_hdr->pause ? "pause" : "resume");
+        header_len = sizeof(*fc_hdr);
+        break;
     default:
         return;
     }
@@ -370,6 +407,8 @@ UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_SYNC_ACK,
               ucp_eager_sync_ack_handler, ucp_eager_dump, 0);
 UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_OFFLOAD_SYNC_ACK,
               ucp_eager_offload_sync_ack_handler, ucp_eager_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_FC,
+              ucp_eager_fc_handler, ucp_eager_dump, 0);
 
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_EAGER_ONLY);
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_EAGER_FIRST);
@@ -378,3 +417,4 @@ UCP_DEFINE_AM_PROXY(UCP_AM_ID_EAGER_SYNC_ONLY);
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_EAGER_SYNC_FIRST);
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_EAGER_SYNC_ACK);
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_OFFLOAD_SYNC_ACK);
+UCP_DEFINE_AM_PROXY(UCP_AM_ID_EAGER_FC);
@@ -25,7 +25,8 @@ static size_t ucp_tag_pack_eager_only_dt(void *dest, void *arg)
     ucs_assert(req->send.state.dt.offset == 0);
     length = ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                          req->send.mem_type, hdr + 1, req->send.buffer,
-                         &req->send.state.dt, req->send.length);
+                         &req->send.state.dt, req->send.length,
+                         ucp_request_pack_nontemporal(req));
     ucs_assert(length == req->send.length);
     return sizeof(*hdr) + length;
 }
@@ -43,7 +44,8 @@ static size_t ucp_tag_pack_eager_sync_only_dt(void *dest, void *arg)
     ucs_assert(req->send.state.dt.offset == 0);
     length = ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                          req->send.mem_type, hdr + 1, req->send.buffer,
-                         &req->send.state.dt, req->send.length);
+                         &req->send.state.dt, req->send.length,
+                         ucp_request_pack_nontemporal(req));
     ucs_assert(length == req->send.length);
     return sizeof(*hdr) + length;
 }
@@ -66,7 +68,8 @@ static size_t ucp_tag_pack_eager_first_dt(void *dest, void *arg)
     ucs_assert(req->send.length > length);
     return sizeof(*hdr) + ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                                       req->send.mem_type, hdr + 1, req->send.buffer,
-                                      &req->send.state.dt, length);
+                                      &req->send.state.dt, length,
+                                      ucp_request_pack_nontemporal(req));
 }
 
 static size_t ucp_tag_pack_eager_sync_first_dt(void *dest, void *arg)
@@ -89,7 +92,8 @@ static size_t ucp_tag_pack_eager_sync_first_dt(void *dest, void *arg)
     ucs_assert(req->send.length > length);
     return sizeof(*hdr) + ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                                       req->send.mem_type, hdr + 1, req->send.buffer,
-                                      &req->send.state.dt, length);
+                                      &req->send.state.dt, length,
+                                      ucp_request_pack_nontemporal(req));
 }
 
 static size_t ucp_tag_pack_eager_middle_dt(void *dest, void *arg)
@@ -105,7 +109,8 @@ static size_t ucp_tag_pack_eager_middle_dt(void *dest, void *arg)
     hdr->offset     = req->send.state.dt.offset;
     return sizeof(*hdr) + ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                                       req->send.mem_type, hdr + 1, req->send.buffer,
-                                      &req->send.state.dt, length);
+                                      &req->send.state.dt, length,
+                                      ucp_request_pack_nontemporal(req));
 }
 
 /* eager */
@@ -355,3 +360,33 @@ void ucp_tag_eager_sync_send_ack(ucp_worker_h worker, void *hdr, uint16_t recv_f
 
     ucp_request_send(req, 0);
 }
+
+void ucp_tag_eager_fc_send(ucp_ep_h ep, int pause)
+{
+    ucp_request_t *req;
+    ucs_status_t status;
+
+    /* The peer finds its endpoint by the pointer in the header */
+    status = ucp_ep_resolve_dest_ep_ptr(ep, ep->am_lane);
+    if (status != UCS_OK) {
+        ucs_error("ep %p: failed to connect for eager flow control: %s", ep,
+                  ucs_status_string(status));
+        return;
+    }
+
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        ucs_fatal("could not allocate request");
+    }
+
+    req->flags                   = 0;
+    req->send.ep                 = ep;
+    req->send.uct.func           = ucp_proto_progress_am_bcopy_single;
+    req->send.proto.comp_cb      = ucp_request_put;
+    req->send.proto.status       = UCS_OK;
+    req->send.proto.am_id        = UCP_AM_ID_EAGER_FC;
+    req->send.proto.eager_pause  = pause;
+
+    ucs_trace_req("send_eager_fc req %p ep %p pause %d", req, ep, pause);
+    ucp_request_send(req, 0);
+}
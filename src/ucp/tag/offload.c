@@ -48,7 +48,7 @@ int ucp_tag_offload_iface_activate(ucp_worker_iface_t *iface)
 static UCS_F_ALWAYS_INLINE ucp_worker_iface_t*
 ucp_tag_offload_iface(ucp_worker_t *worker, ucp_tag_t tag)
 {
-    khiter_t hash_it;
+    ucs_shash_iter_t hash_it;
     ucp_tag_t key_tag;
 
     if (worker->num_active_ifaces == 1) {
@@ -57,11 +57,11 @@ ucp_tag_offload_iface(ucp_worker_t *worker, ucp_tag_t tag)
     }
 
     key_tag = worker->context->config.tag_sender_mask & tag;
-    hash_it = kh_get(ucp_tag_offload_hash, &worker->tm.offload.tag_hash,
-                     key_tag);
+    hash_it = ucs_shash_get(ucp_tag_offload_hash, &worker->tm.offload.tag_hash,
+                            key_tag);
 
-    return (hash_it == kh_end(&worker->tm.offload.tag_hash)) ?
-           NULL : kh_value(&worker->tm.offload.tag_hash, hash_it);
+    return (hash_it == ucs_shash_end(&worker->tm.offload.tag_hash)) ?
+           NULL : ucs_shash_value(&worker->tm.offload.tag_hash, hash_it);
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -78,11 +78,15 @@ ucp_tag_offload_release_buf(ucp_request_t *req, int dereg)
 UCS_PROFILE_FUNC_VOID(ucp_tag_offload_tag_consumed, (self),
                       uct_tag_context_t *self)
 {
-    ucp_request_t *req = ucs_container_of(self, ucp_request_t, recv.uct_ctx);
+    ucp_request_t *req  = ucs_container_of(self, ucp_request_t, recv.uct_ctx);
+    ucp_tag_match_t *tm = &req->recv.worker->tm;
     ucs_queue_head_t *queue;
 
-    queue = &ucp_tag_exp_get_req_queue(&req->recv.worker->tm, req)->queue;
+    UCP_TAG_MATCH_CS_ENTER(tm);
+    queue = &ucp_tag_exp_get_req_queue(tm, req)->queue;
     ucs_queue_remove(queue, &req->recv.queue);
+    ucp_tag_exp_hash_update_count(tm, req, -1);
+    UCP_TAG_MATCH_CS_EXIT(tm);
 }
 
 /* Message is scattered to user buffer by the transport, complete the request */
@@ -405,7 +409,7 @@ UCS_PROFILE_FUNC(int, ucp_tag_offload_post, (req, req_queue),
             UCP_WORKER_STAT_TAG_OFFLOAD(worker, BLOCK_SW_PEND);
             return 0;
         }
-    } else if (worker->tm.expected.wildcard.sw_count ||
+    } else if (worker->tm.expected.sw_wild_count ||
                (req_queue->sw_count && !ucp_tag_offload_post_sw_reqs(req, req_queue))) {
         /* There are some requests which must be completed in SW */
         UCP_WORKER_STAT_TAG_OFFLOAD(worker, BLOCK_SW_PEND);
@@ -426,7 +430,8 @@ static size_t ucp_tag_offload_pack_eager(void *dest, void *arg)
 
     length = ucp_dt_pack(req->send.ep->worker, req->send.datatype,
                          req->send.mem_type, dest, req->send.buffer,
-                         &req->send.state.dt, req->send.length);
+                         &req->send.state.dt, req->send.length,
+                         ucp_request_pack_nontemporal(req));
     ucs_assert(length == req->send.length);
     return length;
 }
@@ -83,6 +83,8 @@ ucp_tag_offload_try_post(ucp_worker_t *worker, ucp_request_t *req,
     }
 
     ++worker->tm.expected.sw_all_count;
+    worker->tm.expected.sw_wild_count +=
+            (req->recv.tag.tag_mask != UCP_TAG_MASK_FULL);
     ++req_queue->sw_count;
     req_queue->block_count += !!(req->flags & UCP_REQUEST_FLAG_BLOCK_OFFLOAD);
 }
@@ -120,28 +122,35 @@ ucp_tag_offload_unexp(ucp_worker_iface_t *wiface, ucp_tag_t tag, size_t length)
 {
     ucp_worker_t *worker = wiface->worker;
     ucp_tag_t tag_key;
-    khiter_t hash_it;
+    ucs_shash_iter_t hash_it;
     int ret;
 
     ++wiface->proxy_recv_count;
 
+    /* Activation sets the offload threshold, which the receive path checks
+     * under the tag matching lock */
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
+
     if (ucs_unlikely(!(wiface->flags & UCP_WORKER_IFACE_FLAG_OFFLOAD_ACTIVATED))) {
         if (!ucp_tag_offload_iface_activate(wiface)) {
-            return;
+            goto out;
         }
     }
 
     if (ucs_unlikely((length >= worker->tm.offload.thresh) &&
                      (worker->num_active_ifaces > 1))) {
         tag_key = worker->context->config.tag_sender_mask & tag;
-        hash_it = kh_put(ucp_tag_offload_hash, &worker->tm.offload.tag_hash,
-                         tag_key, &ret);
+        hash_it = ucs_shash_put(ucp_tag_offload_hash,
+                                &worker->tm.offload.tag_hash, tag_key, &ret);
 
-        /* khash returns 1 or 2 if key is not present and value can be set */
+        /* returns 1 or 2 if key is not present and value can be set */
         if (ret > 0) {
-            kh_value(&worker->tm.offload.tag_hash, hash_it) = wiface;
+            ucs_shash_value(&worker->tm.offload.tag_hash, hash_it) = wiface;
         }
     }
+
+out:
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
 }
 
 
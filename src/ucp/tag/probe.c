@@ -23,7 +23,10 @@ ucp_tag_message_h ucp_tag_probe_nb(ucp_worker_h worker, ucp_tag_t tag,
 
     UCP_CONTEXT_CHECK_FEATURE_FLAGS(worker->context, UCP_FEATURE_TAG,
                                     return NULL);
-    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+
+    /* Probing accesses only the unexpected queue, so it does not have to wait
+     * for the worker lock */
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
 
     ucs_trace_req("probe_nb tag %"PRIx64"/%"PRIx64" remove=%d", tag, tag_mask,
                   remove);
@@ -43,7 +46,7 @@ ucp_tag_message_h ucp_tag_probe_nb(ucp_worker_h worker, ucp_tag_t tag,
         }
     }
 
-    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
 
     return rdesc;
 }
@@ -124,10 +124,39 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_rtr, (self),
     return status;
 }
 
-ucs_status_t ucp_tag_send_start_rndv(ucp_request_t *sreq)
+UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_am_rndv_rts, (self),
+                 uct_pending_req_t *self)
+{
+    /* the header of the active message is passed instead of tag */
+    return ucp_do_am_bcopy_single(self, UCP_AM_ID_AM_RNDV_RTS,
+                                  ucp_tag_rndv_rts_pack);
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_stream_rndv_rts, (self),
+                 uct_pending_req_t *self)
+{
+    return ucp_do_am_bcopy_single(self, UCP_AM_ID_STREAM_RNDV_RTS,
+                                  ucp_tag_rndv_rts_pack);
+}
+
+static ucs_status_t ucp_rndv_reg_send_buffer(ucp_request_t *sreq)
 {
     ucp_ep_h ep = sreq->send.ep;
     ucp_md_map_t md_map;
+
+    if (UCP_DT_IS_CONTIG(sreq->send.datatype) &&
+        ucp_rndv_is_get_zcopy(sreq, ep->worker->context->config.ext.rndv_mode)) {
+        /* register a contiguous buffer for rma_get */
+        md_map = ucp_ep_config(ep)->key.rma_bw_md_map;
+        return ucp_request_send_buffer_reg(sreq, md_map);
+    }
+
+    return UCS_OK;
+}
+
+ucs_status_t ucp_tag_send_start_rndv(ucp_request_t *sreq)
+{
+    ucp_ep_h ep = sreq->send.ep;
     ucs_status_t status;
 
     ucp_trace_req(sreq, "start_rndv to %s buffer %p length %zu",
@@ -146,14 +175,9 @@ ucs_status_t ucp_tag_send_start_rndv(ucp_request_t *sreq)
             return status;
         }
     } else {
-        if (UCP_DT_IS_CONTIG(sreq->send.datatype) &&
-            ucp_rndv_is_get_zcopy(sreq, ep->worker->context->config.ext.rndv_mode)) {
-            /* register a contiguous buffer for rma_get */
-            md_map = ucp_ep_config(ep)->key.rma_bw_md_map;
-            status = ucp_request_send_buffer_reg(sreq, md_map);
-            if (status != UCS_OK) {
-                return status;
-            }
+        status = ucp_rndv_reg_send_buffer(sreq);
+        if (status != UCS_OK) {
+            return status;
         }
 
         ucs_assert(sreq->send.lane == ucp_ep_get_am_lane(ep));
@@ -163,6 +187,52 @@ ucs_status_t ucp_tag_send_start_rndv(ucp_request_t *sreq)
     return UCS_OK;
 }
 
+/* Start rendezvous which is not offloaded, and sends the RTS with active
+ * message on the AM lane */
+static ucs_status_t ucp_rndv_send_start_am_rts(ucp_request_t *sreq,
+                                               uct_pending_callback_t rts_func)
+{
+    ucp_ep_h ep = sreq->send.ep;
+    ucs_status_t status;
+
+    status = ucp_ep_resolve_dest_ep_ptr(ep, sreq->send.lane);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = ucp_rndv_reg_send_buffer(sreq);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucs_assert(sreq->send.lane == ucp_ep_get_am_lane(ep));
+    sreq->send.uct.func = rts_func;
+    return UCS_OK;
+}
+
+ucs_status_t ucp_am_send_start_rndv(ucp_request_t *sreq)
+{
+    ucp_trace_req(sreq, "start_am_rndv to %s buffer %p length %zu",
+                  ucp_ep_peer_name(sreq->send.ep), sreq->send.buffer,
+                  sreq->send.length);
+    UCS_PROFILE_REQUEST_EVENT(sreq, "start_am_rndv", sreq->send.length);
+
+    /* Tag offload is never used for active messages */
+    return ucp_rndv_send_start_am_rts(sreq, ucp_proto_progress_am_rndv_rts);
+}
+
+ucs_status_t ucp_stream_send_start_rndv(ucp_request_t *sreq)
+{
+    ucp_trace_req(sreq, "start_stream_rndv to %s buffer %p length %zu",
+                  ucp_ep_peer_name(sreq->send.ep), sreq->send.buffer,
+                  sreq->send.length);
+    UCS_PROFILE_REQUEST_EVENT(sreq, "start_stream_rndv", sreq->send.length);
+
+    /* Stream data is not tagged, the tag field of the RTS is unused */
+    sreq->send.tag.tag = 0;
+    return ucp_rndv_send_start_am_rts(sreq, ucp_proto_progress_stream_rndv_rts);
+}
+
 static void ucp_rndv_complete_send(ucp_request_t *sreq)
 {
     ucp_request_send_generic_dt_finish(sreq);
@@ -264,8 +334,10 @@ static void ucp_rndv_req_send_rtr(ucp_request_t *rndv_req, ucp_request_t *rreq,
 
 static void ucp_rndv_get_lanes_count(ucp_request_t *req)
 {
-    ucp_ep_h ep        = req->send.ep;
-    ucp_lane_map_t map = 0;
+    ucp_ep_h ep             = req->send.ep;
+    ucp_ep_config_t *config = ucp_ep_config(ep);
+    size_t max_lanes        = ep->worker->context->config.ext.max_rndv_lanes;
+    ucp_lane_map_t map      = 0;
     uct_rkey_t uct_rkey;
     ucp_lane_index_t lane;
 
@@ -273,14 +345,17 @@ static void ucp_rndv_get_lanes_count(ucp_request_t *req)
         return; /* already resolved */
     }
 
-    while ((lane = ucp_rkey_get_rma_bw_lane(req->send.rndv_get.rkey, ep, req->send.mem_type,
-                                            &uct_rkey, map)) != UCP_NULL_LANE) {
+    /* Lanes are used in the same order as ucp_rndv_get_next_lane() selects
+     * them, so the first max_lanes lanes take part in the transfer */
+    req->send.rndv_get.lanes_scale = 0;
+    while ((req->send.rndv_get.lane_count < max_lanes) &&
+           ((lane = ucp_rkey_get_rma_bw_lane(req->send.rndv_get.rkey, ep,
+                                             req->send.mem_type, &uct_rkey,
+                                             map)) != UCP_NULL_LANE)) {
         req->send.rndv_get.lane_count++;
+        req->send.rndv_get.lanes_scale += config->tag.rndv.scale[lane];
         map |= UCS_BIT(lane);
     }
-
-    req->send.rndv_get.lane_count = ucs_min(req->send.rndv_get.lane_count,
-                                            ep->worker->context->config.ext.max_rndv_lanes);
 }
 
 static ucp_lane_index_t ucp_rndv_get_next_lane(ucp_request_t *rndv_req, uct_rkey_t *uct_rkey)
@@ -376,10 +451,14 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_progress_rma_get_zcopy, (self),
     if ((offset == 0) && (remainder > 0) && (rndv_req->send.length > ucp_mtu)) {
         length = ucp_mtu - remainder;
     } else {
+        /* Split the data between the lanes in proportion to their bandwidth,
+         * so all of them complete their part at the same time */
         chunk = ucs_align_up((size_t)(ucs_min(rndv_req->send.length /
-                                              rndv_req->send.rndv_get.lane_count,
+                                              rndv_req->send.rndv_get.lanes_scale,
                                               max_zcopy) * config->tag.rndv.scale[lane]),
                              align);
+        /* a lane with a small scale still has to make progress */
+        chunk  = ucs_max(chunk, ucs_max(min_zcopy, align));
         length = ucs_min(chunk, rndv_req->send.length - offset);
     }
 
@@ -495,8 +574,8 @@ static void ucp_rndv_req_send_rma_get(ucp_request_t *rndv_req, ucp_request_t *rr
     rndv_req->send.rndv_get.lane_count     = 0;
     rndv_req->send.datatype                = rreq->recv.datatype;
 
-    status = ucp_ep_rkey_unpack(rndv_req->send.ep, rndv_rts_hdr + 1,
-                                &rndv_req->send.rndv_get.rkey);
+    status = ucp_ep_rkey_unpack_uncached(rndv_req->send.ep, rndv_rts_hdr + 1,
+                                         &rndv_req->send.rndv_get.rkey);
     if (status != UCS_OK) {
         ucs_fatal("failed to unpack rendezvous remote key received from %s: %s",
                   ucp_ep_peer_name(rndv_req->send.ep), ucs_status_string(status));
@@ -590,6 +669,8 @@ ucs_status_t ucp_rndv_process_rts(void *arg, void *data, size_t length,
     ucp_request_t *rreq;
     ucs_status_t status;
 
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
+
     rreq = ucp_tag_exp_search(&worker->tm, rndv_rts_hdr->super.tag);
     if (rreq != NULL) {
         ucp_rndv_matched(worker, rreq, rndv_rts_hdr);
@@ -609,6 +690,7 @@ ucs_status_t ucp_rndv_process_rts(void *arg, void *data, size_t length,
         }
     }
 
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
     return status;
 }
 
@@ -662,7 +744,8 @@ static size_t ucp_rndv_pack_data(void *dest, void *arg)
 
     return sizeof(*hdr) + ucp_dt_pack(sreq->send.ep->worker, sreq->send.datatype,
                                       sreq->send.mem_type, hdr + 1, sreq->send.buffer,
-                                      &sreq->send.state.dt, length);
+                                      &sreq->send.state.dt, length,
+                                      ucp_request_pack_nontemporal(sreq));
 }
 
 UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_progress_am_bcopy, (self),
@@ -920,8 +1003,8 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_rtr_handler,
     }
 
     if (UCP_DT_IS_CONTIG(sreq->send.datatype) && rndv_rtr_hdr->address) {
-        status = ucp_ep_rkey_unpack(ep, rndv_rtr_hdr + 1,
-                                    &sreq->send.rndv_put.rkey);
+        status = ucp_ep_rkey_unpack_uncached(ep, rndv_rtr_hdr + 1,
+                                             &sreq->send.rndv_put.rkey);
         if (status != UCS_OK) {
             ucs_fatal("failed to unpack rendezvous remote key received from %s: %s",
                       ucp_ep_peer_name(ep), ucs_status_string(status));
@@ -1055,14 +1138,14 @@ static void ucp_rndv_dump(ucp_worker_h worker, uct_am_trace_type_t type,
 
 UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_RTS, ucp_rndv_rts_handler,
               ucp_rndv_dump, 0);
-UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_ATS, ucp_rndv_ats_handler,
-              ucp_rndv_dump, 0);
-UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_ATP, ucp_rndv_atp_handler,
-              ucp_rndv_dump, 0);
-UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_RTR, ucp_rndv_rtr_handler,
-              ucp_rndv_dump, 0);
-UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_DATA, ucp_rndv_data_handler,
-              ucp_rndv_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_TAG | UCP_FEATURE_STREAM | UCP_FEATURE_AM,
+              UCP_AM_ID_RNDV_ATS, ucp_rndv_ats_handler, ucp_rndv_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_TAG | UCP_FEATURE_STREAM | UCP_FEATURE_AM,
+              UCP_AM_ID_RNDV_ATP, ucp_rndv_atp_handler, ucp_rndv_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_TAG | UCP_FEATURE_STREAM | UCP_FEATURE_AM,
+              UCP_AM_ID_RNDV_RTR, ucp_rndv_rtr_handler, ucp_rndv_dump, 0);
+UCP_DEFINE_AM(UCP_FEATURE_TAG | UCP_FEATURE_STREAM | UCP_FEATURE_AM,
+              UCP_AM_ID_RNDV_DATA, ucp_rndv_data_handler, ucp_rndv_dump, 0);
 
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_RNDV_RTS);
 UCP_DEFINE_AM_PROXY(UCP_AM_ID_RNDV_ATS);
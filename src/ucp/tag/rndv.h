@@ -47,6 +47,10 @@ typedef struct {
 
 ucs_status_t ucp_tag_send_start_rndv(ucp_request_t *req);
 
+ucs_status_t ucp_am_send_start_rndv(ucp_request_t *req);
+
+ucs_status_t ucp_stream_send_start_rndv(ucp_request_t *req);
+
 void ucp_rndv_matched(ucp_worker_h worker, ucp_request_t *req,
                       const ucp_rndv_rts_hdr_t *rndv_rts_hdr);
 
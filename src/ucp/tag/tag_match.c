@@ -8,53 +8,332 @@
 #include <ucp/tag/offload.h>
 
 
-ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm)
+static void ucp_tag_exp_buckets_init(ucp_request_queue_t *buckets,
+                                     size_t hash_size)
 {
-    size_t hash_size, bucket;
+    size_t bucket;
 
-    hash_size = ucs_roundup_pow2(UCP_TAG_MATCH_HASH_SIZE);
+    for (bucket = 0; bucket < hash_size; ++bucket) {
+        buckets[bucket].sw_count    = 0;
+        buckets[bucket].block_count = 0;
+        ucs_queue_head_init(&buckets[bucket].queue);
+    }
+}
+
+static ucs_status_t ucp_tag_exp_hash_init(ucp_tag_exp_hash_t *hash,
+                                          ucp_tag_t tag_mask, size_t hash_size)
+{
+    hash->buckets = ucs_malloc(sizeof(*hash->buckets) * hash_size,
+                               "ucp_tm_exp_hash");
+    if (hash->buckets == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    ucp_tag_exp_buckets_init(hash->buckets, hash_size);
+    hash->tag_mask  = tag_mask;
+    hash->count     = 0;
+    hash->size_mask = hash_size - 1;
+    return UCS_OK;
+}
+
+static ucs_list_link_t *ucp_tag_unexp_hash_alloc(size_t hash_size)
+{
+    ucs_list_link_t *hash;
+    size_t bucket;
+
+    hash = ucs_malloc(sizeof(*hash) * hash_size, "ucp_tm_unexp_hash");
+    if (hash == NULL) {
+        return NULL;
+    }
 
-    tm->expected.sn           = 0;
-    tm->expected.sw_all_count = 0;
+    for (bucket = 0; bucket < hash_size; ++bucket) {
+        ucs_list_head_init(&hash[bucket]);
+    }
+    return hash;
+}
+
+ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm, ucp_tag_t sender_mask,
+                                size_t unexp_max, ucp_mt_type_t mt_type)
+{
+    ucs_status_t status;
+
+    tm->lock.mt_type           = mt_type;
+    UCP_THREAD_LOCK_INIT(&tm->lock);
+
+    tm->expected.sn            = 0;
+    tm->expected.sw_all_count  = 0;
+    tm->expected.sw_wild_count = 0;
+    tm->expected.num_masks     = 0;
+    tm->expected.mask_count    = 0;
+    tm->expected.wildcard.sw_count    = 0;
+    tm->expected.wildcard.block_count = 0;
     ucs_queue_head_init(&tm->expected.wildcard.queue);
     ucs_list_head_init(&tm->unexpected.all);
 
-    tm->expected.hash = ucs_malloc(sizeof(*tm->expected.hash) * hash_size,
-                                   "ucp_tm_exp_hash");
-    if (tm->expected.hash == NULL) {
-        return UCS_ERR_NO_MEMORY;
+    status = ucp_tag_exp_hash_init(&tm->expected.hash, UCP_TAG_MASK_FULL,
+                                   UCP_TAG_MATCH_HASH_SIZE);
+    if (status != UCS_OK) {
+        goto err;
     }
 
-    tm->unexpected.hash = ucs_malloc(sizeof(*tm->unexpected.hash) * hash_size,
-                                     "ucp_tm_unexp_hash");
+    tm->unexpected.count        = 0;
+    tm->unexpected.size_mask    = UCP_TAG_MATCH_HASH_SIZE - 1;
+    tm->unexpected.mem          = 0;
+    tm->unexpected.mem_max      = unexp_max;
+    tm->unexpected.eager_paused = 0;
+    tm->unexpected.eager_fc_cb_id = UCS_CALLBACKQ_ID_NULL;
+    tm->unexpected.hash      = ucp_tag_unexp_hash_alloc(UCP_TAG_MATCH_HASH_SIZE);
     if (tm->unexpected.hash == NULL) {
-        ucs_free(tm->expected.hash);
-        return UCS_ERR_NO_MEMORY;
+        status = UCS_ERR_NO_MEMORY;
+        goto err_free_exp_hash;
     }
 
-    for (bucket = 0; bucket < hash_size; ++bucket) {
-        tm->expected.hash[bucket].sw_count    = 0;
-        tm->expected.hash[bucket].block_count = 0;
-        ucs_queue_head_init(&tm->expected.hash[bucket].queue);
-        ucs_list_head_init(&tm->unexpected.hash[bucket]);
+    /* Index the unexpected tags without the sender bits as well, to search
+     * them quickly for receives from any sender */
+    if ((sender_mask != 0) && (sender_mask != UCP_TAG_MASK_FULL)) {
+        tm->unexpected.any_src_mask = ~sender_mask;
+        tm->unexpected.any_src_hash =
+                ucp_tag_unexp_hash_alloc(UCP_TAG_MATCH_HASH_SIZE);
+        if (tm->unexpected.any_src_hash == NULL) {
+            status = UCS_ERR_NO_MEMORY;
+            goto err_free_unexp_hash;
+        }
+    } else {
+        tm->unexpected.any_src_mask = 0;
+        tm->unexpected.any_src_hash = NULL;
     }
 
-    kh_init_inplace(ucp_tag_frag_hash, &tm->frag_hash);
+    ucs_shash_init_inplace(ucp_tag_frag_hash, &tm->frag_hash);
     ucs_queue_head_init(&tm->offload.sync_reqs);
-    kh_init_inplace(ucp_tag_offload_hash, &tm->offload.tag_hash);
+    ucs_shash_init_inplace(ucp_tag_offload_hash, &tm->offload.tag_hash);
     tm->offload.thresh       = SIZE_MAX;
     tm->offload.zcopy_thresh = SIZE_MAX;
     tm->offload.iface        = NULL;
     tm->am.message_id        = ucs_generate_uuid(0);
     return UCS_OK;
+
+err_free_unexp_hash:
+    ucs_free(tm->unexpected.hash);
+err_free_exp_hash:
+    ucs_free(tm->expected.hash.buckets);
+err:
+    UCP_THREAD_LOCK_FINALIZE(&tm->lock);
+    return status;
 }
 
 void ucp_tag_match_cleanup(ucp_tag_match_t *tm)
 {
-    kh_destroy_inplace(ucp_tag_offload_hash, &tm->offload.tag_hash);
-    kh_destroy_inplace(ucp_tag_frag_hash, &tm->frag_hash);
+    ucp_worker_h worker = ucs_container_of(tm, ucp_worker_t, tm);
+    unsigned i;
+
+    uct_worker_progress_unregister_safe(worker->uct,
+                                        &tm->unexpected.eager_fc_cb_id);
+    ucs_shash_destroy_inplace(ucp_tag_offload_hash, &tm->offload.tag_hash);
+    ucs_shash_destroy_inplace(ucp_tag_frag_hash, &tm->frag_hash);
+    ucs_free(tm->unexpected.any_src_hash);
     ucs_free(tm->unexpected.hash);
-    ucs_free(tm->expected.hash);
+    for (i = 0; i < tm->expected.num_masks; ++i) {
+        ucs_free(tm->expected.mask_hash[i].buckets);
+    }
+    ucs_free(tm->expected.hash.buckets);
+    UCP_THREAD_LOCK_FINALIZE(&tm->lock);
+}
+
+static unsigned ucp_tag_unexp_eager_fc_progress(void *arg)
+{
+    ucp_worker_h worker = arg;
+    ucp_ep_ext_gen_t *ep_ext;
+    ucp_ep_h ep;
+    int pause;
+
+    uct_worker_progress_unregister_safe(worker->uct,
+                                        &worker->tm.unexpected.eager_fc_cb_id);
+
+    /* Endpoints which are not connected yet are skipped, since connecting
+     * them here would create transport endpoints the user never asked for */
+    UCS_ASYNC_BLOCK(&worker->async);
+
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
+    pause = worker->tm.unexpected.eager_paused;
+    ucs_debug("worker %p: %s eager protocol of the peers, unexpected size %zu",
+              worker, pause ? "pausing" : "resuming",
+              worker->tm.unexpected.mem);
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
+
+    ucs_list_for_each(ep_ext, &worker->all_eps, ep_list) {
+        ep = ucp_ep_from_ext_gen(ep_ext);
+        if (!(ep->flags & (UCP_EP_FLAG_FAILED | UCP_EP_FLAG_CLOSED |
+                           UCP_EP_FLAG_CONNECT_LAZY))) {
+            ucp_tag_eager_fc_send(ep, pause);
+        }
+    }
+    UCS_ASYNC_UNBLOCK(&worker->async);
+
+    return 1;
+}
+
+void ucp_tag_unexp_eager_pause(ucp_tag_match_t *tm, int pause)
+{
+    ucp_worker_h worker = ucs_container_of(tm, ucp_worker_t, tm);
+
+    /* Called from the receive path, possibly from an active message handler,
+     * so the messages are sent later from progress. If the state changes
+     * again before that, only the latest one is sent. */
+    tm->unexpected.eager_paused = pause;
+    uct_worker_progress_register_safe(worker->uct,
+                                      ucp_tag_unexp_eager_fc_progress, worker,
+                                      0, &tm->unexpected.eager_fc_cb_id);
+}
+
+void ucp_tag_exp_hash_grow(ucp_tag_exp_hash_t *hash)
+{
+    size_t old_size = hash->size_mask + 1;
+    size_t new_size = old_size * 2;
+    ucp_request_queue_t *old_buckets, *req_queue;
+    ucp_request_t *req;
+    size_t bucket;
+
+    old_buckets   = hash->buckets;
+    hash->buckets = ucs_malloc(sizeof(*hash->buckets) * new_size,
+                               "ucp_tm_exp_hash");
+    if (hash->buckets == NULL) {
+        /* Keep using the current buckets */
+        ucs_debug("failed to grow expected hash to %zu buckets", new_size);
+        hash->buckets = old_buckets;
+        return;
+    }
+
+    ucp_tag_exp_buckets_init(hash->buckets, new_size);
+    hash->size_mask = new_size - 1;
+
+    /* Requests with same tag are moved in order, so they remain sorted by
+     * their sequence numbers */
+    for (bucket = 0; bucket < old_size; ++bucket) {
+        ucs_queue_for_each_extract(req, &old_buckets[bucket].queue, recv.queue,
+                                   1) {
+            req_queue = ucp_tag_exp_hash_bucket(hash, req->recv.tag.tag);
+            ucs_queue_push(&req_queue->queue, &req->recv.queue);
+            if (!(req->flags & UCP_REQUEST_FLAG_OFFLOADED)) {
+                ++req_queue->sw_count;
+                req_queue->block_count +=
+                        !!(req->flags & UCP_REQUEST_FLAG_BLOCK_OFFLOAD);
+            }
+        }
+    }
+
+    ucs_free(old_buckets);
+    ucs_debug("grown expected hash with tag mask 0x%"PRIx64" to %zu buckets",
+              hash->tag_mask, new_size);
+}
+
+void ucp_tag_unexp_hash_grow(ucp_tag_match_t *tm)
+{
+    size_t new_size = (tm->unexpected.size_mask + 1) * 2;
+    ucs_list_link_t *hash, *any_src_hash;
+    ucp_recv_desc_t *rdesc;
+
+    hash = ucp_tag_unexp_hash_alloc(new_size);
+    if (hash == NULL) {
+        goto err;
+    }
+
+    if (tm->unexpected.any_src_hash != NULL) {
+        any_src_hash = ucp_tag_unexp_hash_alloc(new_size);
+        if (any_src_hash == NULL) {
+            goto err_free_hash;
+        }
+        ucs_free(tm->unexpected.any_src_hash);
+        tm->unexpected.any_src_hash = any_src_hash;
+    }
+
+    ucs_free(tm->unexpected.hash);
+    tm->unexpected.hash      = hash;
+    tm->unexpected.size_mask = new_size - 1;
+
+    /* Re-add the descriptors in arrival order, so the hash lists remain
+     * sorted by arrival */
+    ucs_list_for_each(rdesc, &tm->unexpected.all, tag_list[UCP_RDESC_ALL_LIST]) {
+        ucs_list_add_tail(ucp_tag_unexp_get_list_for_tag(tm,
+                                                         ucp_rdesc_get_tag(rdesc)),
+                          &rdesc->tag_list[UCP_RDESC_HASH_LIST]);
+        if (tm->unexpected.any_src_hash != NULL) {
+            ucs_list_add_tail(ucp_tag_unexp_get_any_src_list(tm,
+                                                    ucp_rdesc_get_tag(rdesc)),
+                              &rdesc->tag_list[UCP_RDESC_ANY_SRC_LIST]);
+        }
+    }
+
+    ucs_debug("grown unexpected hash to %zu buckets", new_size);
+    return;
+
+err_free_hash:
+    ucs_free(hash);
+err:
+    /* Keep using the current buckets */
+    ucs_debug("failed to grow unexpected hash to %zu buckets", new_size);
+}
+
+static int ucp_tag_exp_wildcard_has_mask(ucp_tag_match_t *tm, ucp_tag_t tag_mask)
+{
+    ucp_request_t *req;
+
+    ucs_queue_for_each(req, &tm->expected.wildcard.queue, recv.queue) {
+        if (req->recv.tag.tag_mask == tag_mask) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+ucp_request_queue_t*
+ucp_tag_exp_get_wild_queue(ucp_tag_match_t *tm, ucp_tag_t tag,
+                           ucp_tag_t tag_mask)
+{
+    ucp_tag_exp_hash_t *hash;
+    unsigned i;
+
+    hash = ucp_tag_exp_get_hash(tm, tag_mask);
+    if (hash != NULL) {
+        goto out;
+    }
+
+    /* Hashing by an empty mask would put all requests in the same bucket.
+     * Requests which were already put on the wildcard queue must stay there
+     * to be found by ucp_tag_exp_get_req_queue(). */
+    if ((tag_mask == 0) || ucp_tag_exp_wildcard_has_mask(tm, tag_mask)) {
+        return &tm->expected.wildcard;
+    }
+
+    if (tm->expected.num_masks < UCP_TAG_MATCH_MAX_MASKS) {
+        hash = &tm->expected.mask_hash[tm->expected.num_masks];
+        if (ucp_tag_exp_hash_init(hash, tag_mask,
+                                  UCP_TAG_MATCH_MASK_HASH_SIZE) != UCS_OK) {
+            return &tm->expected.wildcard;
+        }
+        ++tm->expected.num_masks;
+    } else {
+        /* Reuse the hash table of a mask which has no posted requests */
+        for (i = 0; i < tm->expected.num_masks; ++i) {
+            if (tm->expected.mask_hash[i].count == 0) {
+                hash = &tm->expected.mask_hash[i];
+                break;
+            }
+        }
+
+        if (hash == NULL) {
+            return &tm->expected.wildcard;
+        }
+
+        hash->tag_mask = tag_mask;
+    }
+
+    ucs_debug("created expected hash for tag mask 0x%"PRIx64, tag_mask);
+
+out:
+    if (ucs_unlikely(hash->count > hash->size_mask)) {
+        ucp_tag_exp_hash_grow(hash);
+    }
+    return ucp_tag_exp_hash_bucket(hash, tag);
 }
 
 int ucp_tag_unexp_is_empty(ucp_tag_match_t *tm)
@@ -79,58 +358,56 @@ void ucp_tag_exp_remove(ucp_tag_match_t *tm, ucp_request_t *req)
     ucs_bug("expected request not found");
 }
 
-static inline uint64_t ucp_tag_exp_req_seq(ucs_queue_iter_t iter)
-{
-    return (*iter == NULL) ? ULONG_MAX :
-           ucs_container_of(*iter, ucp_request_t, recv.queue)->recv.tag.sn;
-}
-
 ucp_request_t*
 ucp_tag_exp_search_all(ucp_tag_match_t *tm, ucp_request_queue_t *req_queue,
                        ucp_tag_t tag)
 {
-    ucs_queue_head_t *hash_queue = &req_queue->queue;
-    ucp_request_queue_t *queue;
-    ucs_queue_iter_t hash_iter, wild_iter, *iter;
-    uint64_t hash_sn, wild_sn, *sn_p;
-    ucp_request_t *req;
+    ucp_request_queue_t *queues[UCP_TAG_MATCH_MAX_MASKS + 2];
+    ucp_request_queue_t *match_queue = NULL;
+    ucs_queue_iter_t iter, match_iter = NULL;
+    ucp_request_t *req, *match_req = NULL;
+    ucp_tag_exp_hash_t *hash;
+    unsigned i, num_queues;
 
-    *hash_queue->ptail                 = NULL;
-    *tm->expected.wildcard.queue.ptail = NULL;
-
-    hash_iter = ucs_queue_iter_begin(hash_queue);
-    wild_iter = ucs_queue_iter_begin(&tm->expected.wildcard.queue);
-
-    hash_sn = ucp_tag_exp_req_seq(hash_iter);
-    wild_sn = ucp_tag_exp_req_seq(wild_iter);
-
-    while (hash_sn != wild_sn) {
-        if (hash_sn < wild_sn) {
-            iter  = &hash_iter;
-            sn_p  = &hash_sn;
-            queue = req_queue;
-        } else {
-            iter  = &wild_iter;
-            sn_p  = &wild_sn;
-            queue = &tm->expected.wildcard;
+    /* All requests which can match the tag are in the bucket of the tag in
+     * every hash table, or on the wildcard queue */
+    num_queues           = 0;
+    queues[num_queues++] = req_queue;
+    queues[num_queues++] = &tm->expected.wildcard;
+    for (i = 0; i < tm->expected.num_masks; ++i) {
+        hash = &tm->expected.mask_hash[i];
+        if (hash->count > 0) {
+            queues[num_queues++] = ucp_tag_exp_hash_bucket(hash, tag);
         }
+    }
+
+    /* Find the first posted request which matches the tag. Every queue is
+     * sorted by sequence number, so stop searching a queue when reaching
+     * requests posted after the best match so far. */
+    for (i = 0; i < num_queues; ++i) {
+        ucs_queue_for_each_safe(req, iter, &queues[i]->queue, recv.queue) {
+            if ((match_req != NULL) &&
+                (req->recv.tag.sn > match_req->recv.tag.sn)) {
+                break;
+            }
 
-        req = ucs_container_of(**iter, ucp_request_t, recv.queue);
-        if (ucp_tag_is_match(tag, req->recv.tag.tag, req->recv.tag.tag_mask)) {
-            ucs_trace_req("matched received tag %"PRIx64" to req %p", tag, req);
-            ucp_tag_exp_delete(req, tm, queue, *iter);
-            return req;
+            if (ucp_tag_is_match(tag, req->recv.tag.tag,
+                                 req->recv.tag.tag_mask)) {
+                match_req   = req;
+                match_queue = queues[i];
+                match_iter  = iter;
+                break;
+            }
         }
+    }
 
-        *iter = ucs_queue_iter_next(*iter);
-        *sn_p = ucp_tag_exp_req_seq(*iter);
+    if (match_req == NULL) {
+        return NULL;
     }
 
-    ucs_assertv((hash_sn == ULONG_MAX) && (wild_sn == ULONG_MAX),
-                "hash_seq=%lu wild_seq=%lu", hash_sn, wild_sn);
-    ucs_assert(ucs_queue_iter_end(hash_queue, hash_iter));
-    ucs_assert(ucs_queue_iter_end(&tm->expected.wildcard.queue, wild_iter));
-    return NULL;
+    ucs_trace_req("matched received tag %"PRIx64" to req %p", tag, match_req);
+    ucp_tag_exp_delete(match_req, tm, match_queue, match_iter);
+    return match_req;
 }
 
 void ucp_tag_frag_list_process_queue(ucp_tag_match_t *tm, ucp_request_t *req,
@@ -140,17 +417,18 @@ void ucp_tag_frag_list_process_queue(ucp_tag_match_t *tm, ucp_request_t *req,
     ucp_tag_frag_match_t *matchq;
     ucp_recv_desc_t *rdesc;
     ucs_status_t status;
-    khiter_t iter;
+    ucs_shash_iter_t iter;
     int ret;
 
-    iter   = kh_put(ucp_tag_frag_hash, &tm->frag_hash, msg_id, &ret);
-    matchq = &kh_value(&tm->frag_hash, iter);
+    iter   = ucs_shash_put(ucp_tag_frag_hash, &tm->frag_hash, msg_id, &ret);
+    matchq = &ucs_shash_value(&tm->frag_hash, iter);
     if (ret == 0) {
         status = UCS_INPROGRESS;
         ucs_assert(ucp_tag_frag_match_is_unexp(matchq));
         ucs_queue_for_each_extract(rdesc, &matchq->unexp_q, tag_frag_queue,
                                    status == UCS_INPROGRESS) {
             UCS_STATS_UPDATE_COUNTER(req->recv.worker->stats, counter_idx, 1);
+            ucp_tag_unexp_mem_remove(tm, rdesc);
             hdr    = (void*)(rdesc + 1);
             status = ucp_tag_recv_request_process_rdesc(req, rdesc, hdr->offset);
         }
@@ -158,7 +436,7 @@ void ucp_tag_frag_list_process_queue(ucp_tag_match_t *tm, ucp_request_t *req,
 
         /* if we completed the request, delete hash entry */
         if (status != UCS_INPROGRESS) {
-            kh_del(ucp_tag_frag_hash, &tm->frag_hash, iter);
+            ucs_shash_del(ucp_tag_frag_hash, &tm->frag_hash, iter);
         }
     }
 
@@ -9,17 +9,30 @@
 
 #include <ucp/api/ucp_def.h>
 #include <ucp/core/ucp_types.h>
+#include <ucp/core/ucp_thread.h>
 #include <ucs/datastruct/queue_types.h>
-#include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/shash.h>
 #include <ucs/sys/compiler_def.h>
 #include <ucs/stats/stats.h>
 
 
 #define UCP_TAG_MASK_FULL     0xffffffffffffffffUL  /* All 1-s */
+#define UCP_TAG_MATCH_MAX_MASKS 4  /* Maximal number of partial tag masks which
+                                      expected requests are hashed by */
 
 
-KHASH_INIT(ucp_tag_offload_hash, ucp_tag_t, ucp_worker_iface_t *, 1,
-           kh_int64_hash_func, kh_int64_hash_equal);
+/*
+ * Tag matching lock. It protects the expected and unexpected queues, and may be
+ * taken either alone, or after the worker lock, but never before it.
+ */
+#define UCP_TAG_MATCH_CS_ENTER(_tm) \
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&(_tm)->lock)
+#define UCP_TAG_MATCH_CS_EXIT(_tm) \
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&(_tm)->lock)
+
+
+UCS_SHASH_INIT(ucp_tag_offload_hash, ucp_tag_t, ucp_worker_iface_t *, 1,
+               ucs_shash_int64_hash_func, ucs_shash_equal);
 
 
 /**
@@ -42,6 +55,19 @@ typedef struct {
 } ucp_request_queue_t;
 
 
+/**
+ * Growable hash table of expected requests, which were posted with the same
+ * tag mask. The key is the tag masked by the table's mask, so all requests
+ * which can match an incoming tag are in the same bucket.
+ */
+typedef struct {
+    ucp_tag_t             tag_mask;    /* Tag mask of all requests in the table */
+    unsigned              count;       /* Number of requests in the table */
+    unsigned              size_mask;   /* Number of buckets minus 1 */
+    ucp_request_queue_t   *buckets;    /* Array of request queues */
+} ucp_tag_exp_hash_t;
+
+
 /**
  * Hash table entry for tag message fragments
  */
@@ -51,8 +77,8 @@ typedef union {
 } ucp_tag_frag_match_t;
 
 
-KHASH_INIT(ucp_tag_frag_hash, uint64_t, ucp_tag_frag_match_t, 1,
-           kh_int64_hash_func, kh_int64_hash_equal);
+UCS_SHASH_INIT(ucp_tag_frag_hash, uint64_t, ucp_tag_frag_match_t, 1,
+               ucs_shash_int64_hash_func, ucs_shash_equal);
 
 
 /**
@@ -60,28 +86,58 @@ KHASH_INIT(ucp_tag_frag_hash, uint64_t, ucp_tag_frag_match_t, 1,
  */
 typedef struct ucp_tag_match {
 
+    ucp_mt_lock_t             lock;       /* Tag matching lock, see
+                                             UCP_TAG_MATCH_CS_ENTER */
+
     /* Expected queue */
     struct {
-        ucp_request_queue_t   wildcard;   /* Expected wildcard requests */
-        ucp_request_queue_t   *hash;      /* Hash table of expected non-wild tags */
+        ucp_request_queue_t   wildcard;   /* Expected wildcard requests, which
+                                             tag mask has no hash table */
+        ucp_tag_exp_hash_t    hash;       /* Hash table of expected non-wild tags */
+        ucp_tag_exp_hash_t    mask_hash[UCP_TAG_MATCH_MAX_MASKS];
+                                          /* Hash tables of expected requests
+                                             with partial tag masks, e.g
+                                             requests from any sender */
+        unsigned              num_masks;  /* Number of initialized mask hash
+                                             tables */
+        unsigned              mask_count; /* Number of requests in mask hash
+                                             tables */
         uint64_t              sn;
         unsigned              sw_all_count; /* Number of all expected requests which
                                                are not posted to offload */
+        unsigned              sw_wild_count; /* Number of expected requests with
+                                                partial tag mask, which are not
+                                                posted to offload */
     } expected;
 
     /* Unexpected queue */
     struct {
         ucs_list_link_t       all;        /* Linked list of all tags */
         ucs_list_link_t       *hash;      /* Hash table of unexpected tags */
+        ucs_list_link_t       *any_src_hash; /* Hash table of unexpected tags
+                                                without the sender bits, or
+                                                NULL if sender mask is not
+                                                defined */
+        ucp_tag_t             any_src_mask; /* Tag mask of 'any_src_hash' keys */
+        unsigned              count;      /* Number of unexpected descriptors */
+        unsigned              size_mask;  /* Number of hash buckets minus 1 */
+        size_t                mem;        /* Total size of unexpected
+                                             descriptors */
+        size_t                mem_max;    /* Pause eager protocol of the peers
+                                             when 'mem' exceeds this value */
+        int                   eager_paused; /* Whether the peers were asked to
+                                               pause eager protocol */
+        uct_worker_cb_id_t    eager_fc_cb_id; /* Progress callback which sends
+                                                 the pause/resume messages */
     } unexpected;
 
     /* Hash for fragment assembly, the key is a globally unique tag message id */
-    khash_t(ucp_tag_frag_hash) frag_hash;
+    ucs_shash_t(ucp_tag_frag_hash) frag_hash;
 
     /* Tag offload fields */
     struct {
         ucs_queue_head_t      sync_reqs;        /* Outgoing sync send requests */
-        khash_t(ucp_tag_offload_hash) tag_hash; /* Hash table of offload ifaces */
+        ucs_shash_t(ucp_tag_offload_hash) tag_hash; /* Hash table of offload ifaces */
         ucp_worker_iface_t    *iface;           /* Active offload iface (relevant if just
                                                    one iface is activated on the worker,
                                                    otherwise hash should be used) */
@@ -105,18 +161,29 @@ typedef struct ucp_tag_match {
 } ucp_tag_match_t;
 
 
-ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm);
+ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm, ucp_tag_t sender_mask,
+                                size_t unexp_max, ucp_mt_type_t mt_type);
 
 void ucp_tag_match_cleanup(ucp_tag_match_t *tm);
 
 void ucp_tag_exp_remove(ucp_tag_match_t *tm, ucp_request_t *req);
 
+void ucp_tag_unexp_eager_pause(ucp_tag_match_t *tm, int pause);
+
 int ucp_tag_unexp_is_empty(ucp_tag_match_t *tm);
 
 ucp_request_t*
 ucp_tag_exp_search_all(ucp_tag_match_t *tm, ucp_request_queue_t *req_queue,
                        ucp_tag_t tag);
 
+ucp_request_queue_t*
+ucp_tag_exp_get_wild_queue(ucp_tag_match_t *tm, ucp_tag_t tag,
+                           ucp_tag_t tag_mask);
+
+void ucp_tag_exp_hash_grow(ucp_tag_exp_hash_t *hash);
+
+void ucp_tag_unexp_hash_grow(ucp_tag_match_t *tm);
+
 void ucp_tag_frag_list_process_queue(ucp_tag_match_t *tm, ucp_request_t *req,
                                      uint64_t msg_id
                                      UCS_STATS_ARG(int counter_idx));
@@ -19,9 +19,10 @@
 #include <inttypes.h>
 
 
-/* Hash size is a prime number just below 1024. Prime number for even distribution,
- * and small enough to fit L1 cache. */
-#define UCP_TAG_MATCH_HASH_SIZE     1021
+/* Initial hash sizes. The hash tables grow when they contain more entries than
+ * buckets, to keep the buckets short with many posted receives. */
+#define UCP_TAG_MATCH_HASH_SIZE       1024
+#define UCP_TAG_MATCH_MASK_HASH_SIZE  64
 
 
 static UCS_F_ALWAYS_INLINE
@@ -43,22 +44,56 @@ int ucp_tag_is_match(ucp_tag_t tag, ucp_tag_t exp_tag, ucp_tag_t tag_mask)
 static UCS_F_ALWAYS_INLINE size_t
 ucp_tag_match_calc_hash(ucp_tag_t tag)
 {
-    /* Compute two 32-bit modulo and combine their result */
-    return ((uint32_t)tag % UCP_TAG_MATCH_HASH_SIZE) ^
-           ((uint32_t)(tag >> 32) % UCP_TAG_MATCH_HASH_SIZE);
+    /* The hash size is a power of 2, so mix the tag bits into the lower bits */
+    return ucs_shash_mix(tag);
+}
+
+static UCS_F_ALWAYS_INLINE ucp_request_queue_t*
+ucp_tag_exp_hash_bucket(const ucp_tag_exp_hash_t *hash, ucp_tag_t tag)
+{
+    return &hash->buckets[ucp_tag_match_calc_hash(tag & hash->tag_mask) &
+                          hash->size_mask];
 }
 
 static UCS_F_ALWAYS_INLINE ucp_request_queue_t*
 ucp_tag_exp_get_queue_for_tag(ucp_tag_match_t *tm, ucp_tag_t tag)
 {
-    return &tm->expected.hash[ucp_tag_match_calc_hash(tag)];
+    return &tm->expected.hash.buckets[ucp_tag_match_calc_hash(tag) &
+                                      tm->expected.hash.size_mask];
+}
+
+/* Get the hash table of expected requests with the given tag mask, or NULL if
+ * such requests are on the wildcard queue */
+static UCS_F_ALWAYS_INLINE ucp_tag_exp_hash_t*
+ucp_tag_exp_get_hash(ucp_tag_match_t *tm, ucp_tag_t tag_mask)
+{
+    unsigned i;
+
+    if (ucs_likely(tag_mask == UCP_TAG_MASK_FULL)) {
+        return &tm->expected.hash;
+    }
+
+    for (i = 0; i < tm->expected.num_masks; ++i) {
+        if (tm->expected.mask_hash[i].tag_mask == tag_mask) {
+            return &tm->expected.mask_hash[i];
+        }
+    }
+
+    return NULL;
 }
 
 static UCS_F_ALWAYS_INLINE ucp_request_queue_t*
 ucp_tag_exp_get_queue(ucp_tag_match_t *tm, ucp_tag_t tag, ucp_tag_t tag_mask)
 {
+    ucp_tag_exp_hash_t *hash;
+
     if (tag_mask == UCP_TAG_MASK_FULL) {
         return ucp_tag_exp_get_queue_for_tag(tm, tag);
+    }
+
+    hash = ucp_tag_exp_get_hash(tm, tag_mask);
+    if (hash != NULL) {
+        return ucp_tag_exp_hash_bucket(hash, tag);
     } else {
         return &tm->expected.wildcard;
     }
@@ -70,18 +105,48 @@ ucp_tag_exp_get_req_queue(ucp_tag_match_t *tm, ucp_request_t *req)
     return ucp_tag_exp_get_queue(tm, req->recv.tag.tag, req->recv.tag.tag_mask);
 }
 
+/* Get the queue to post a new expected request to. This may create a hash
+ * table for the tag mask, or grow the hash table, so must be called before
+ * updating the counters of the queue. */
+static UCS_F_ALWAYS_INLINE ucp_request_queue_t*
+ucp_tag_exp_get_post_queue(ucp_tag_match_t *tm, ucp_tag_t tag,
+                           ucp_tag_t tag_mask)
+{
+    if (ucs_likely(tag_mask == UCP_TAG_MASK_FULL)) {
+        if (ucs_unlikely(tm->expected.hash.count > tm->expected.hash.size_mask)) {
+            ucp_tag_exp_hash_grow(&tm->expected.hash);
+        }
+        return ucp_tag_exp_get_queue_for_tag(tm, tag);
+    }
+
+    return ucp_tag_exp_get_wild_queue(tm, tag, tag_mask);
+}
+
+/* Update the number of requests in the hash table which holds @a req */
 static UCS_F_ALWAYS_INLINE void
-ucp_tag_exp_push(ucp_tag_match_t *tm, ucp_request_queue_t *req_queue,
-                 ucp_request_t *req)
+ucp_tag_exp_hash_update_count(ucp_tag_match_t *tm, ucp_request_t *req, int diff)
 {
-    req->recv.tag.sn = tm->expected.sn++;
-    ucs_queue_push(&req_queue->queue, &req->recv.queue);
+    ucp_tag_exp_hash_t *hash;
+
+    if (ucs_likely(req->recv.tag.tag_mask == UCP_TAG_MASK_FULL)) {
+        tm->expected.hash.count += diff;
+        return;
+    }
+
+    hash = ucp_tag_exp_get_hash(tm, req->recv.tag.tag_mask);
+    if (hash != NULL) {
+        hash->count              += diff;
+        tm->expected.mask_count  += diff;
+    }
 }
 
 static UCS_F_ALWAYS_INLINE void
-ucp_tag_exp_add(ucp_tag_match_t *tm, ucp_request_t *req)
+ucp_tag_exp_push(ucp_tag_match_t *tm, ucp_request_queue_t *req_queue,
+                 ucp_request_t *req)
 {
-    ucp_tag_exp_push(tm, ucp_tag_exp_get_req_queue(tm, req), req);
+    req->recv.tag.sn = tm->expected.sn++;
+    ucs_queue_push(&req_queue->queue, &req->recv.queue);
+    ucp_tag_exp_hash_update_count(tm, req, 1);
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -94,8 +159,12 @@ ucp_tag_exp_delete(ucp_request_t *req, ucp_tag_match_t *tm,
         if (req->flags & UCP_REQUEST_FLAG_BLOCK_OFFLOAD) {
             --req_queue->block_count;
         }
+        if (req->recv.tag.tag_mask != UCP_TAG_MASK_FULL) {
+            --tm->expected.sw_wild_count;
+        }
     }
     ucs_queue_del_iter(&req_queue->queue, iter);
+    ucp_tag_exp_hash_update_count(tm, req, -1);
 }
 
 static UCS_F_ALWAYS_INLINE ucp_request_t *
@@ -105,7 +174,8 @@ ucp_tag_exp_search(ucp_tag_match_t *tm, ucp_tag_t tag)
     ucs_queue_iter_t iter;
     ucp_request_t *req;
 
-    if (ucs_unlikely(!ucs_queue_is_empty(&tm->expected.wildcard.queue))) {
+    if (ucs_unlikely(!ucs_queue_is_empty(&tm->expected.wildcard.queue) ||
+                     (tm->expected.mask_count > 0))) {
         req_queue = ucp_tag_exp_get_queue_for_tag(tm, tag);
         return ucp_tag_exp_search_all(tm, req_queue, tag);
     }
@@ -133,14 +203,50 @@ static UCS_F_ALWAYS_INLINE ucp_tag_t ucp_rdesc_get_tag(ucp_recv_desc_t *rdesc)
 static UCS_F_ALWAYS_INLINE ucs_list_link_t*
 ucp_tag_unexp_get_list_for_tag(ucp_tag_match_t *tm, ucp_tag_t tag)
 {
-    return &tm->unexpected.hash[ucp_tag_match_calc_hash(tag)];
+    return &tm->unexpected.hash[ucp_tag_match_calc_hash(tag) &
+                                tm->unexpected.size_mask];
+}
+
+static UCS_F_ALWAYS_INLINE ucs_list_link_t*
+ucp_tag_unexp_get_any_src_list(ucp_tag_match_t *tm, ucp_tag_t tag)
+{
+    return &tm->unexpected.any_src_hash[
+                    ucp_tag_match_calc_hash(tag & tm->unexpected.any_src_mask) &
+                    tm->unexpected.size_mask];
 }
 
 static UCS_F_ALWAYS_INLINE void
-ucp_tag_unexp_remove(ucp_recv_desc_t *rdesc)
+ucp_tag_unexp_mem_add(ucp_tag_match_t *tm, ucp_recv_desc_t *rdesc)
+{
+    tm->unexpected.mem += rdesc->length;
+    if (ucs_unlikely(tm->unexpected.mem > tm->unexpected.mem_max) &&
+        !tm->unexpected.eager_paused) {
+        ucp_tag_unexp_eager_pause(tm, 1);
+    }
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_tag_unexp_mem_remove(ucp_tag_match_t *tm, ucp_recv_desc_t *rdesc)
+{
+    ucs_assert(tm->unexpected.mem >= rdesc->length);
+    tm->unexpected.mem -= rdesc->length;
+    /* Resume with hysteresis, to avoid sending pause/resume on every message */
+    if (ucs_unlikely(tm->unexpected.eager_paused) &&
+        (tm->unexpected.mem <= (tm->unexpected.mem_max / 2))) {
+        ucp_tag_unexp_eager_pause(tm, 0);
+    }
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_tag_unexp_remove(ucp_tag_match_t *tm, ucp_recv_desc_t *rdesc)
 {
     ucs_list_del(&rdesc->tag_list[UCP_RDESC_HASH_LIST]);
     ucs_list_del(&rdesc->tag_list[UCP_RDESC_ALL_LIST] );
+    if (tm->unexpected.any_src_hash != NULL) {
+        ucs_list_del(&rdesc->tag_list[UCP_RDESC_ANY_SRC_LIST]);
+    }
+    --tm->unexpected.count;
+    ucp_tag_unexp_mem_remove(tm, rdesc);
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -148,9 +254,19 @@ ucp_tag_unexp_recv(ucp_tag_match_t *tm, ucp_recv_desc_t *rdesc, ucp_tag_t tag)
 {
     ucs_list_link_t *hash_list;
 
+    if (ucs_unlikely(tm->unexpected.count > tm->unexpected.size_mask)) {
+        ucp_tag_unexp_hash_grow(tm);
+    }
+
     hash_list = ucp_tag_unexp_get_list_for_tag(tm, tag);
     ucs_list_add_tail(hash_list,           &rdesc->tag_list[UCP_RDESC_HASH_LIST]);
     ucs_list_add_tail(&tm->unexpected.all, &rdesc->tag_list[UCP_RDESC_ALL_LIST]);
+    if (tm->unexpected.any_src_hash != NULL) {
+        ucs_list_add_tail(ucp_tag_unexp_get_any_src_list(tm, tag),
+                          &rdesc->tag_list[UCP_RDESC_ANY_SRC_LIST]);
+    }
+    ++tm->unexpected.count;
+    ucp_tag_unexp_mem_add(tm, rdesc);
 
     ucs_trace_req("unexp "UCP_RECV_DESC_FMT" tag %"PRIx64,
                   UCP_RECV_DESC_ARG(rdesc), tag);
@@ -185,6 +301,16 @@ ucp_tag_unexp_search(ucp_tag_match_t *tm, ucp_tag_t tag, uint64_t tag_mask,
             return NULL;
         }
         i_list = UCP_RDESC_HASH_LIST;
+    } else if ((tm->unexpected.any_src_hash != NULL) &&
+               ((tag_mask & tm->unexpected.any_src_mask) ==
+                tm->unexpected.any_src_mask)) {
+        /* Only the sender bits are masked out, so all matching descriptors
+         * have the same tag without the sender bits */
+        list = ucp_tag_unexp_get_any_src_list(tm, tag);
+        if (ucs_list_is_empty(list)) {
+            return NULL;
+        }
+        i_list = UCP_RDESC_ANY_SRC_LIST;
     } else {
         list   = &tm->unexpected.all;
         i_list = UCP_RDESC_ALL_LIST;
@@ -201,7 +327,7 @@ ucp_tag_unexp_search(ucp_tag_match_t *tm, ucp_tag_t tag, uint64_t tag_mask,
                           "%s tag %"PRIx64"/%"PRIx64, UCP_RECV_DESC_ARG(rdesc),
                           title, tag, tag_mask);
             if (remove) {
-                ucp_tag_unexp_remove(rdesc);
+                ucp_tag_unexp_remove(tm, rdesc);
             }
             return rdesc;
         }
@@ -108,7 +108,7 @@ ucp_tag_recv_common(ucp_worker_h worker, void *buffer, size_t count,
     if (ucs_unlikely(rdesc == NULL)) {
         /* If not found on unexpected, wait until it arrives.
          * If was found but need this receive request for later completion, save it */
-        req_queue = ucp_tag_exp_get_queue(&worker->tm, tag, tag_mask);
+        req_queue = ucp_tag_exp_get_post_queue(&worker->tm, tag, tag_mask);
 
         /* If offload supported, post this tag to transport as well.
          * TODO: need to distinguish the cases when posting is not needed. */
@@ -162,13 +162,37 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_tag_recv_nbr,
 
     UCP_CONTEXT_CHECK_FEATURE_FLAGS(worker->context, UCP_FEATURE_TAG,
                                     return UCS_ERR_INVALID_PARAM);
-    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
 
+    /* Posting an expected receive accesses only the tag matching queues, so
+     * it does not wait for the worker lock, which may be held by a thread in
+     * progress. Consuming an unexpected message, or posting the receive to
+     * tag offload, uses the worker resources and requires the worker lock. */
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
     rdesc = ucp_tag_unexp_search(&worker->tm, tag, tag_mask, 1, "recv_nbr");
+    if (ucs_likely((rdesc == NULL) &&
+                   (worker->tm.offload.thresh == SIZE_MAX))) {
+        ucp_tag_recv_common(worker, buffer, count, datatype, tag, tag_mask,
+                            req, UCP_REQUEST_DEBUG_FLAG_EXTERNAL, NULL, NULL,
+                            "recv_nbr");
+        UCP_TAG_MATCH_CS_EXIT(&worker->tm);
+        return UCS_OK;
+    }
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
+
+    /* The descriptor, if found, was already removed from the unexpected queue,
+     * so it cannot be matched by another receive after releasing the lock */
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    UCP_TAG_MATCH_CS_ENTER(&worker->tm);
+
+    if (rdesc == NULL) {
+        rdesc = ucp_tag_unexp_search(&worker->tm, tag, tag_mask, 1,
+                                     "recv_nbr");
+    }
     ucp_tag_recv_common(worker, buffer, count, datatype, tag, tag_mask,
                         req, UCP_REQUEST_DEBUG_FLAG_EXTERNAL, NULL, rdesc,
                         "recv_nbr");
 
+    UCP_TAG_MATCH_CS_EXIT(&worker->tm);
     UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
     return UCS_OK;
 }
@@ -189,9 +213,11 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_recv_nb,
 
     req = ucp_request_get(worker);
     if (ucs_likely(req != NULL)) {
+        UCP_TAG_MATCH_CS_ENTER(&worker->tm);
         rdesc = ucp_tag_unexp_search(&worker->tm, tag, tag_mask, 1, "recv_nb");
         ucp_tag_recv_common(worker, buffer, count, datatype, tag, tag_mask, req,
                             UCP_REQUEST_FLAG_CALLBACK, cb, rdesc,"recv_nb");
+        UCP_TAG_MATCH_CS_EXIT(&worker->tm);
         ret = req + 1;
     } else {
         ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
@@ -217,9 +243,11 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_msg_recv_nb,
 
     req = ucp_request_get(worker);
     if (ucs_likely(req != NULL)) {
+        UCP_TAG_MATCH_CS_ENTER(&worker->tm);
         ucp_tag_recv_common(worker, buffer, count, datatype,
                             ucp_rdesc_get_tag(rdesc), UCP_TAG_MASK_FULL, req,
                             UCP_REQUEST_FLAG_CALLBACK, cb, rdesc, "msg_recv_nb");
+        UCP_TAG_MATCH_CS_EXIT(&worker->tm);
         ret = req + 1;
     } else {
         ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
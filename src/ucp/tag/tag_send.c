@@ -12,6 +12,7 @@
 #include <ucp/core/ucp_worker.h>
 #include <ucp/core/ucp_context.h>
 #include <ucp/proto/proto_am.inl>
+#include <ucp/proto/proto_tune.h>
 #include <ucs/datastruct/mpool.inl>
 #include <string.h>
 
@@ -32,6 +33,14 @@ ucp_tag_get_rndv_threshold(const ucp_request_t *req, size_t count,
         /* Fall through */
     case UCP_DATATYPE_CONTIG:
         return ucs_min(rndv_rma_thresh, rndv_am_thresh);
+    case UCP_DATATYPE_STRIDED:
+        if ((ucp_dt_strided_num_blocks(req->send.datatype,
+                                       req->send.length) > max_iov) &&
+            ucp_ep_is_tag_offload_enabled(ucp_ep_config(req->send.ep))) {
+            /* Same as IOV, multi-packet eager is not supported by offload */
+            return 1;
+        }
+        return ucs_min(rndv_rma_thresh, rndv_am_thresh);
     case UCP_DATATYPE_GENERIC:
         return rndv_am_thresh;
     default:
@@ -41,6 +50,26 @@ ucp_tag_get_rndv_threshold(const ucp_request_t *req, size_t count,
     return SIZE_MAX;
 }
 
+/*
+ * Only contiguous host memory sends of ucp_tag_send_nb() are tuned. Measured
+ * sends are sent as synchronous, so the endpoint has to support it.
+ */
+static UCS_F_ALWAYS_INLINE int
+ucp_tag_send_is_tuned(const ucp_request_t *req, int enable_zcopy,
+                      ssize_t max_short)
+{
+    ucp_ep_h ep = req->send.ep;
+
+    return (ucp_ep_config(ep)->tag.tune != NULL) && enable_zcopy &&
+           ((ssize_t)req->send.length > max_short) &&
+           UCP_DT_IS_CONTIG(req->send.datatype) &&
+           UCP_MEM_IS_HOST(req->send.mem_type) &&
+           !(req->flags & UCP_REQUEST_FLAG_SYNC) &&
+           !(ep->flags & UCP_EP_FLAG_TAG_EAGER_PAUSED) &&
+           (ep->flags & UCP_EP_FLAG_DEST_EP) &&
+           (ucp_ep_config(ep)->key.err_mode != UCP_ERR_HANDLING_MODE_PEER);
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_ptr_t
 ucp_tag_send_req(ucp_request_t *req, size_t dt_count,
                  const ucp_ep_msg_config_t* msg_config,
@@ -53,9 +82,17 @@ ucp_tag_send_req(ucp_request_t *req, size_t dt_count,
                                                      rndv_rma_thresh,
                                                      rndv_am_thresh);
     ssize_t max_short   = ucp_proto_get_short_max(req, msg_config);
+    int tuned           = ucp_tag_send_is_tuned(req, enable_zcopy, max_short);
     ucs_status_t status;
     size_t zcopy_thresh;
 
+    if (ucs_unlikely(req->send.ep->flags & UCP_EP_FLAG_TAG_EAGER_PAUSED)) {
+        /* The peer holds too much unexpected data, so send the payload only
+         * when the receive is matched */
+        rndv_thresh = 1;
+        max_short   = -1;
+    }
+
     if (enable_zcopy || ucs_unlikely(!UCP_MEM_IS_HOST(req->send.mem_type))) {
         zcopy_thresh = ucp_proto_get_zcopy_threshold(req, msg_config, dt_count,
                                                      rndv_thresh);
@@ -63,6 +100,17 @@ ucp_tag_send_req(ucp_request_t *req, size_t dt_count,
         zcopy_thresh = rndv_thresh;
     }
 
+    if (ucs_unlikely(tuned)) {
+        tuned = ucp_proto_tune_select(ucp_ep_config(req->send.ep)->tag.tune,
+                                      req->send.length, &zcopy_thresh,
+                                      &rndv_thresh);
+        if (tuned) {
+            /* Measure the send until its local completion, which is what the
+             * application waits for. The send semantics are not changed. */
+            req->send.tune_start = ucs_get_time();
+        }
+    }
+
     ucs_trace_req("select tag request(%p) progress algorithm datatype=%lx "
                   "buffer=%p length=%zu max_short=%zd rndv_thresh=%zu "
                   "zcopy_thresh=%zu zcopy_enabled=%d",
@@ -81,9 +129,17 @@ ucp_tag_send_req(ucp_request_t *req, size_t dt_count,
             }
 
             UCP_EP_STAT_TAG_OP(req->send.ep, RNDV);
+            if (ucs_unlikely(tuned)) {
+                req->send.tune_proto = UCP_PROTO_TUNE_RNDV;
+                req->flags          |= UCP_REQUEST_FLAG_PROTO_TUNE;
+            }
         } else {
             return UCS_STATUS_PTR(status);
         }
+    } else if (ucs_unlikely(tuned)) {
+        req->send.tune_proto = (req->send.length < zcopy_thresh) ?
+                               UCP_PROTO_TUNE_BCOPY : UCP_PROTO_TUNE_ZCOPY;
+        req->flags          |= UCP_REQUEST_FLAG_PROTO_TUNE;
     }
 
     if (req->flags & UCP_REQUEST_FLAG_SYNC) {
@@ -129,6 +185,7 @@ ucp_tag_send_req_init(ucp_request_t* req, ucp_ep_h ep, const void* buffer,
     req->send.length       = ucp_dt_length(req->send.datatype, count,
                                            req->send.buffer,
                                            &req->send.state.dt);
+    ucp_request_send_nontemporal_init(req);
     ucp_memory_type_detect_mds(ep->worker->context, (void *)buffer,
                                req->send.length, &req->send.mem_type);
     req->send.lane         = ucp_ep_config(ep)->tag.lane;
@@ -142,7 +199,8 @@ ucp_tag_send_inline(ucp_ep_h ep, const void *buffer, size_t count,
     ucs_status_t status;
     size_t length;
 
-    if (ucs_unlikely(!UCP_DT_IS_CONTIG(datatype))) {
+    if (ucs_unlikely(!UCP_DT_IS_CONTIG(datatype) ||
+                     (ep->flags & UCP_EP_FLAG_TAG_EAGER_PAUSED))) {
         return UCS_ERR_NO_RESOURCE;
     }
 
@@ -185,6 +243,12 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_nb,
     ucs_trace_req("send_nb buffer %p count %zu tag %"PRIx64" to %s cb %p",
                   buffer, count, tag, ucp_ep_peer_name(ep), cb);
 
+    status = ucp_ep_connect_on_use(ep);
+    if (ucs_unlikely(status != UCS_OK)) {
+        ret = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
     status = UCS_PROFILE_CALL(ucp_tag_send_inline, ep, buffer, count,
                               datatype, tag);
     if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
@@ -225,6 +289,12 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_tag_send_nbr,
     ucs_trace_req("send_nbr buffer %p count %zu tag %"PRIx64" to %s req %p",
                   buffer, count, tag, ucp_ep_peer_name(ep), request);
 
+    status = ucp_ep_connect_on_use(ep);
+    if (ucs_unlikely(status != UCS_OK)) {
+        UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(ep->worker);
+        return status;
+    }
+
     status = UCS_PROFILE_CALL(ucp_tag_send_inline, ep, buffer, count,
                               datatype, tag);
     if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
@@ -263,6 +333,12 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_sync_nb,
     ucs_trace_req("send_sync_nb buffer %p count %zu tag %"PRIx64" to %s cb %p",
                   buffer, count, tag, ucp_ep_peer_name(ep), cb);
 
+    status = ucp_ep_connect_on_use(ep);
+    if (status != UCS_OK) {
+        ret = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
     if (ucp_ep_config(ep)->key.err_mode == UCP_ERR_HANDLING_MODE_PEER) {
         ret = UCS_STATUS_PTR(UCS_ERR_UNSUPPORTED);
         goto out;
@@ -9,6 +9,7 @@
 
 #include <ucp/core/ucp_worker.h>
 #include <ucp/core/ucp_ep.inl>
+#include <ucs/algorithm/crc.h>
 #include <ucs/arch/bitops.h>
 #include <ucs/debug/log.h>
 #include <inttypes.h>
@@ -38,6 +39,28 @@
  */
 
 
+typedef void (*ucp_address_tl_addr_cb_t)(const void *tl_addr, size_t length,
+                                         void *arg);
+
+
+/* Copy a packed address to an address template, and its transport addresses
+ * to a cached address */
+typedef struct {
+    const void       *src;
+    void             *tmpl_ptr;
+    void             *tl_addrs_ptr;
+} ucp_address_split_t;
+
+
+/* Copy an address template to a packed address, and insert the transport
+ * addresses from a cached address */
+typedef struct {
+    const void       *src;
+    void             *dst;
+    const void       *tl_addrs_ptr;
+} ucp_address_merge_t;
+
+
 typedef struct {
     const char       *dev_name;
     size_t           dev_addr_len;
@@ -774,3 +797,272 @@ ucs_status_t ucp_address_unpack(ucp_worker_t *worker, const void *buffer,
     return UCS_OK;
 }
 
+static UCS_F_ALWAYS_INLINE uint64_t
+ucp_address_template_hash(const ucp_address_template_t *tmpl)
+{
+    return tmpl->hash;
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_address_template_equal(const ucp_address_template_t *tmpl1,
+                           const ucp_address_template_t *tmpl2)
+{
+    return (tmpl1->length == tmpl2->length) &&
+           !memcmp(tmpl1->data, tmpl2->data, tmpl1->length);
+}
+
+UCS_SHASH_IMPL(ucp_address_templates, static UCS_F_MAYBE_UNUSED inline,
+               ucp_address_template_t*, char, 0, ucp_address_template_hash,
+               ucp_address_template_equal);
+
+/*
+ * Go over the device and transport entries of a packed address, starting after
+ * the header, and call the callback for every interface and endpoint address.
+ * If with_tl_addrs is 0, the buffer is an address template which does not
+ * contain these addresses, and the callback gets the location they were taken
+ * from.
+ * Returns a pointer to the end of the packed address.
+ */
+static const void*
+ucp_address_walk(ucp_worker_h worker, const void *ptr, int with_tl_addrs,
+                 ucp_address_tl_addr_cb_t cb, void *arg)
+{
+    int last_dev, last_tl, empty_dev;
+    size_t dev_addr_len;
+    size_t attr_len;
+    size_t addr_len;
+    const void *flags_ptr;
+
+    do {
+        if (*(uint8_t*)ptr == UCP_NULL_RESOURCE) {
+            return ptr + 1;
+        }
+
+        /* md_index */
+        empty_dev    = (*(uint8_t*)ptr) & UCP_ADDRESS_FLAG_EMPTY;
+        ++ptr;
+
+        /* device address length */
+        dev_addr_len = (*(uint8_t*)ptr) & ~UCP_ADDRESS_FLAG_LAST;
+        last_dev     = (*(uint8_t*)ptr) & UCP_ADDRESS_FLAG_LAST;
+        ++ptr;
+
+        ptr += dev_addr_len;
+
+        last_tl = empty_dev;
+        while (!last_tl) {
+            ptr      += sizeof(uint16_t);  /* tl_name_csum */
+            attr_len  = ucp_address_iface_attr_size(worker);
+            flags_ptr = ucp_address_iface_flags_ptr(worker, ptr, attr_len);
+            ptr      += attr_len;
+
+            /* iface address */
+            ptr       = ucp_address_unpack_length(worker, flags_ptr, ptr,
+                                                  &addr_len, 0);
+            cb(ptr, addr_len, arg);
+            ptr      += with_tl_addrs ? addr_len : 0;
+
+            /* ep address */
+            ptr       = ucp_address_unpack_length(worker, flags_ptr, ptr,
+                                                  &addr_len, 1);
+            cb(ptr, addr_len, arg);
+            ptr      += with_tl_addrs ? addr_len : 0;
+
+            last_tl   = (*(uint8_t*)flags_ptr) & UCP_ADDRESS_FLAG_LAST;
+        }
+    } while (!last_dev);
+
+    return ptr;
+}
+
+static void ucp_address_count_tl_addr_cb(const void *tl_addr, size_t length,
+                                         void *arg)
+{
+    *(size_t*)arg += length;
+}
+
+static void ucp_address_split_tl_addr_cb(const void *tl_addr, size_t length,
+                                         void *arg)
+{
+    ucp_address_split_t *split = arg;
+    size_t shared_length       = tl_addr - split->src;
+
+    memcpy(split->tmpl_ptr, split->src, shared_length);
+    split->tmpl_ptr += shared_length;
+
+    memcpy(split->tl_addrs_ptr, tl_addr, length);
+    split->tl_addrs_ptr += length;
+    split->src           = tl_addr + length;
+}
+
+static void ucp_address_merge_tl_addr_cb(const void *tl_addr, size_t length,
+                                         void *arg)
+{
+    ucp_address_merge_t *merge = arg;
+    size_t shared_length       = tl_addr - merge->src;
+
+    memcpy(merge->dst, merge->src, shared_length);
+    merge->dst += shared_length;
+    merge->src  = tl_addr;
+
+    memcpy(merge->dst, merge->tl_addrs_ptr, length);
+    merge->dst          += length;
+    merge->tl_addrs_ptr += length;
+}
+
+void ucp_address_cache_init(ucp_context_h context)
+{
+    ucs_shash_init_inplace(ucp_address_templates, &context->address_templates);
+}
+
+void ucp_address_cache_cleanup(ucp_context_h context)
+{
+    ucp_address_template_t *tmpl;
+
+    ucs_shash_foreach_key(&context->address_templates, tmpl, {
+        ucs_warn("address template %p was not released, refcount %u", tmpl,
+                 tmpl->refcount);
+        ucs_free(tmpl);
+    });
+    ucs_shash_destroy_inplace(ucp_address_templates,
+                              &context->address_templates);
+}
+
+ucs_status_t ucp_address_cache_insert(ucp_worker_h worker, const void *buffer,
+                                      ucp_cached_address_t **cached_p)
+{
+    ucp_context_h context  = worker->context;
+    size_t tl_addrs_length = 0;
+    char name[UCP_WORKER_NAME_MAX];
+    ucp_address_template_t *tmpl;
+    ucp_cached_address_t *cached;
+    ucp_address_split_t split;
+    const void *header_end;
+    const void *end;
+    ucs_status_t status;
+    ucs_shash_iter_t iter;
+    size_t header_length;
+    size_t tmpl_length;
+    int ret;
+
+    header_end    = ucp_address_unpack_worker_name(buffer + sizeof(uint64_t),
+                                                   name, sizeof(name));
+    header_length = header_end - buffer;
+    end           = ucp_address_walk(worker, header_end, 1,
+                                     ucp_address_count_tl_addr_cb,
+                                     &tl_addrs_length);
+    tmpl_length   = (end - header_end) - tl_addrs_length;
+
+    tmpl = ucs_malloc(sizeof(*tmpl) + tmpl_length, "ucp_address_template");
+    if (tmpl == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err;
+    }
+
+    cached = ucs_malloc(sizeof(*cached) + header_length + tl_addrs_length,
+                        "ucp_cached_address");
+    if (cached == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err_free_tmpl;
+    }
+
+    memcpy(cached->data, buffer, header_length);
+    split.src          = header_end;
+    split.tmpl_ptr     = tmpl->data;
+    split.tl_addrs_ptr = cached->data + header_length;
+    ucp_address_walk(worker, header_end, 1, ucp_address_split_tl_addr_cb,
+                     &split);
+    memcpy(split.tmpl_ptr, split.src, end - split.src);
+
+    tmpl->length          = tmpl_length;
+    tmpl->hash            = ucs_crc16(tmpl->data, tmpl_length);
+    cached->header_length = header_length;
+    cached->length        = header_length + tl_addrs_length;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
+    iter = ucs_shash_put(ucp_address_templates, &context->address_templates,
+                         tmpl, &ret);
+    if (ret < 0) {
+        UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
+        status = UCS_ERR_NO_MEMORY;
+        goto err_free_cached;
+    } else if (ret == 0) {
+        /* same template is already used by another address */
+        ucs_free(tmpl);
+        tmpl = ucs_shash_key(&context->address_templates, iter);
+        ++tmpl->refcount;
+    } else {
+        tmpl->refcount = 1;
+    }
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
+
+    ucs_trace("worker %p: cached address %p template %p refcount %u, "
+              "%zu bytes instead of %zu", worker, cached, tmpl, tmpl->refcount,
+              cached->length, end - buffer);
+
+    cached->tmpl = tmpl;
+    *cached_p    = cached;
+    return UCS_OK;
+
+err_free_cached:
+    ucs_free(cached);
+err_free_tmpl:
+    ucs_free(tmpl);
+err:
+    return status;
+}
+
+ucs_status_t ucp_address_cache_restore(ucp_worker_h worker,
+                                       const ucp_cached_address_t *cached,
+                                       void **buffer_p)
+{
+    const ucp_address_template_t *tmpl = cached->tmpl;
+    ucp_address_merge_t merge;
+    const void *end;
+    void *buffer;
+
+    buffer = ucs_malloc(cached->length + tmpl->length, "ucp_address");
+    if (buffer == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    memcpy(buffer, cached->data, cached->header_length);
+    merge.src          = tmpl->data;
+    merge.dst          = buffer + cached->header_length;
+    merge.tl_addrs_ptr = cached->data + cached->header_length;
+    end                = ucp_address_walk(worker, tmpl->data, 0,
+                                          ucp_address_merge_tl_addr_cb, &merge);
+    memcpy(merge.dst, merge.src, end - merge.src);
+
+    ucs_assert(merge.dst + (end - merge.src) ==
+               buffer + cached->length + tmpl->length);
+
+    *buffer_p = buffer;
+    return UCS_OK;
+}
+
+void ucp_address_cache_release(ucp_worker_h worker, ucp_cached_address_t *cached)
+{
+    ucp_context_h context = worker->context;
+    ucp_address_template_t *tmpl;
+    ucs_shash_iter_t iter;
+
+    if (cached == NULL) {
+        return;
+    }
+
+    tmpl = cached->tmpl;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
+    if (--tmpl->refcount == 0) {
+        iter = ucs_shash_get(ucp_address_templates,
+                             &context->address_templates, tmpl);
+        ucs_assert(iter != ucs_shash_end(&context->address_templates));
+        ucs_shash_del(ucp_address_templates, &context->address_templates,
+                      iter);
+        ucs_free(tmpl);
+    }
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
+
+    ucs_free(cached);
+}
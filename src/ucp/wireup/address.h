@@ -73,6 +73,33 @@ struct ucp_unpacked_address {
 };
 
 
+/**
+ * Part of a packed worker address which is usually the same for many remote
+ * workers, e.g all processes on the same host: device addresses, memory domain
+ * indices and interface attributes. Interface and endpoint addresses are left
+ * out, only their lengths are kept.
+ */
+struct ucp_address_template {
+    uint64_t                   hash;            /* Hash of the data */
+    unsigned                   refcount;        /* Number of cached addresses */
+    size_t                     length;          /* Size of the data */
+    uint8_t                    data[0];
+};
+
+
+/**
+ * Packed worker address which is stored as a reference to a shared template,
+ * and only the parts which are specific to the remote worker.
+ */
+struct ucp_cached_address {
+    ucp_address_template_t     *tmpl;           /* Shared part of the address */
+    size_t                     header_length;   /* Size of UUID and worker name */
+    size_t                     length;          /* Size of the data */
+    uint8_t                    data[0];         /* Header, followed by interface
+                                                   and endpoint addresses */
+};
+
+
 /**
  * Pack multiple addresses into a buffer, of resources specified in rsc_bitmap.
  * For every resource in rcs_bitmap:
@@ -115,4 +142,50 @@ ucs_status_t ucp_address_unpack(ucp_worker_h worker, const void *buffer,
                                 ucp_unpacked_address_t *unpacked_address);
 
 
+/**
+ * Initialize the table of address templates of a context.
+ */
+void ucp_address_cache_init(ucp_context_h context);
+
+
+/**
+ * Release the table of address templates of a context.
+ */
+void ucp_address_cache_cleanup(ucp_context_h context);
+
+
+/**
+ * Store a packed worker address in a compact form. The parts of the address
+ * which are identical to an address stored before, by any worker of the same
+ * context, are stored only once.
+ *
+ * @param [in]  worker      Worker object.
+ * @param [in]  buffer      Packed worker address.
+ * @param [out] cached_p    Filled with the stored address. It should be
+ *                           released by @ref ucp_address_cache_release.
+ */
+ucs_status_t ucp_address_cache_insert(ucp_worker_h worker, const void *buffer,
+                                      ucp_cached_address_t **cached_p);
+
+
+/**
+ * Restore the packed worker address from its compact form.
+ *
+ * @param [in]  worker      Worker object.
+ * @param [in]  cached      Address stored by @ref ucp_address_cache_insert.
+ * @param [out] buffer_p    Filled with pointer to packed address. It should be
+ *                           released by ucs_free().
+ */
+ucs_status_t ucp_address_cache_restore(ucp_worker_h worker,
+                                       const ucp_cached_address_t *cached,
+                                       void **buffer_p);
+
+
+/**
+ * Release an address stored by @ref ucp_address_cache_insert. Does nothing if
+ * the address is NULL.
+ */
+void ucp_address_cache_release(ucp_worker_h worker, ucp_cached_address_t *cached);
+
+
 #endif
@@ -10,8 +10,9 @@
 #include <inttypes.h>
 
 
-__KHASH_IMPL(ucp_ep_match, static UCS_F_MAYBE_UNUSED inline, uint64_t,
-             ucp_ep_match_entry_t, 1, kh_int64_hash_func, kh_int64_hash_equal);
+UCS_SHASH_IMPL(ucp_ep_match, static UCS_F_MAYBE_UNUSED inline, uint64_t,
+               ucp_ep_match_entry_t, 1, ucs_shash_int64_hash_func,
+               ucs_shash_equal);
 
 
 #define ucp_ep_match_list_for_each(_elem, _head, _member) \
@@ -46,7 +47,7 @@ static inline void ucp_ep_match_list_del(ucs_list_link_t *head,
 
 void ucp_ep_match_init(ucp_ep_match_ctx_t *match_ctx)
 {
-    kh_init_inplace(ucp_ep_match, &match_ctx->hash);
+    ucs_shash_init_inplace(ucp_ep_match, &match_ctx->hash);
 }
 
 void ucp_ep_match_cleanup(ucp_ep_match_ctx_t *match_ctx)
@@ -54,7 +55,7 @@ void ucp_ep_match_cleanup(ucp_ep_match_ctx_t *match_ctx)
     ucp_ep_match_entry_t entry;
     uint64_t dest_uuid;
 
-    kh_foreach(&match_ctx->hash, dest_uuid, entry, {
+    ucs_shash_foreach(&match_ctx->hash, dest_uuid, entry, {
         if (entry.exp_ep_q.next != NULL) {
             ucs_warn("match_ctx %p: uuid 0x%"PRIx64" expected queue is not empty",
                      match_ctx, dest_uuid);
@@ -64,18 +65,18 @@ void ucp_ep_match_cleanup(ucp_ep_match_ctx_t *match_ctx)
                      match_ctx, dest_uuid);
         }
     })
-    kh_destroy_inplace(ucp_ep_match, &match_ctx->hash);
+    ucs_shash_destroy_inplace(ucp_ep_match, &match_ctx->hash);
 }
 
 static ucp_ep_match_entry_t*
 ucp_ep_match_entry_get(ucp_ep_match_ctx_t *match_ctx, uint64_t dest_uuid)
 {
     ucp_ep_match_entry_t *entry;
-    khiter_t iter;
+    ucs_shash_iter_t iter;
     int ret;
 
-    iter  = kh_put(ucp_ep_match, &match_ctx->hash, dest_uuid, &ret);
-    entry = &kh_value(&match_ctx->hash, iter);
+    iter  = ucs_shash_put(ucp_ep_match, &match_ctx->hash, dest_uuid, &ret);
+    entry = &ucs_shash_value(&match_ctx->hash, iter);
 
     if (ret != 0) {
         /* initialize match list on first use */
@@ -139,15 +140,15 @@ ucp_ep_match_retrieve_common(ucp_ep_match_ctx_t *match_ctx, uint64_t dest_uuid,
     ucp_ep_match_entry_t *entry;
     ucs_list_link_t *list;
     ucp_ep_ext_gen_t *ep_ext;
-    khiter_t iter;
+    ucs_shash_iter_t iter;
     ucp_ep_h ep;
 
-    iter = kh_get(ucp_ep_match, &match_ctx->hash, dest_uuid);
-    if (iter == kh_end(&match_ctx->hash)) {
+    iter = ucs_shash_get(ucp_ep_match, &match_ctx->hash, dest_uuid);
+    if (iter == ucs_shash_end(&match_ctx->hash)) {
         goto notfound; /* no hash entry */
     }
 
-    entry = &kh_value(&match_ctx->hash, iter);
+    entry = &ucs_shash_value(&match_ctx->hash, iter);
     list  = is_exp ? &entry->exp_ep_q : &entry->unexp_ep_q;
     ucp_ep_match_list_for_each(ep_ext, list, ep_match.list) {
         ep = ucp_ep_from_ext_gen(ep_ext);
@@ -188,15 +189,17 @@ void ucp_ep_match_remove_ep(ucp_ep_match_ctx_t *match_ctx, ucp_ep_h ep)
 {
     ucp_ep_ext_gen_t *ep_ext = ucp_ep_ext_gen(ep);
     ucp_ep_match_entry_t *entry;
-    khiter_t iter;
+    ucs_shash_iter_t iter;
 
     if (!(ep->flags & UCP_EP_FLAG_ON_MATCH_CTX)) {
         return;
     }
 
-    iter = kh_get(ucp_ep_match, &match_ctx->hash, ep_ext->ep_match.dest_uuid);
-    ucs_assertv(iter != kh_end(&match_ctx->hash), "ep %p not found in hash", ep);
-    entry = &kh_value(&match_ctx->hash, iter);
+    iter = ucs_shash_get(ucp_ep_match, &match_ctx->hash,
+                         ep_ext->ep_match.dest_uuid);
+    ucs_assertv(iter != ucs_shash_end(&match_ctx->hash),
+                "ep %p not found in hash", ep);
+    entry = &ucs_shash_value(&match_ctx->hash, iter);
 
     if (ep->flags & UCP_EP_FLAG_DEST_EP) {
         ucs_trace("match_ctx %p: remove unexpected ep %p", match_ctx, ep);
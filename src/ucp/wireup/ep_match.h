@@ -8,7 +8,7 @@
 #define UCP_EP_MATCH_H_
 
 #include <ucp/core/ucp_types.h>
-#include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/shash.h>
 #include <ucs/datastruct/list.h>
 
 
@@ -40,12 +40,12 @@ typedef struct ucp_ep_match_entry {
 } ucp_ep_match_entry_t;
 
 
-__KHASH_TYPE(ucp_ep_match, uint64_t, ucp_ep_match_entry_t)
+UCS_SHASH_TYPE(ucp_ep_match, uint64_t, ucp_ep_match_entry_t)
 
 
 /* Context for matching endpoints */
 typedef struct {
-    khash_t(ucp_ep_match)    hash;
+    ucs_shash_t(ucp_ep_match) hash;
 } ucp_ep_match_ctx_t;
 
 
@@ -883,7 +883,9 @@ static inline int ucp_wireup_is_am_required(ucp_ep_h ep,
     }
 
     if (!(ep_init_flags & UCP_EP_INIT_FLAG_MEM_TYPE) &&
-        (ucp_ep_get_context_features(ep) & (UCP_FEATURE_TAG | UCP_FEATURE_STREAM))) {
+        (ucp_ep_get_context_features(ep) & (UCP_FEATURE_TAG |
+                                            UCP_FEATURE_STREAM |
+                                            UCP_FEATURE_AM))) {
         return 1;
     }
 
@@ -1046,8 +1048,8 @@ static ucs_status_t ucp_wireup_add_am_bw_lanes(ucp_ep_h ep, const ucp_ep_params_
     unsigned addr_index;
 
     /* Check if we need active messages, for wireup */
-    if (!(ucp_ep_get_context_features(ep) & UCP_FEATURE_TAG) ||
-        (ep_init_flags & UCP_EP_INIT_FLAG_MEM_TYPE)          ||
+    if (!(ucp_ep_get_context_features(ep) & (UCP_FEATURE_TAG | UCP_FEATURE_AM)) ||
+        (ep_init_flags & UCP_EP_INIT_FLAG_MEM_TYPE)                          ||
         (ep->worker->context->config.ext.max_eager_lanes < 2)) {
         return UCS_OK;
     }
@@ -1110,7 +1112,9 @@ static ucs_status_t ucp_wireup_add_rma_bw_lanes(ucp_ep_h ep,
     if (ep_init_flags & UCP_EP_INIT_FLAG_MEM_TYPE) {
         bw_info.criteria.remote_md_flags = 0;
         bw_info.criteria.local_md_flags  = 0;
-    } else if (ucp_ep_get_context_features(ep) & UCP_FEATURE_TAG) {
+    } else if (ucp_ep_get_context_features(ep) & (UCP_FEATURE_TAG    |
+                                                  UCP_FEATURE_STREAM |
+                                                  UCP_FEATURE_AM)) {
         /* if needed for RNDV, need only access for remote registered memory */
         bw_info.criteria.remote_md_flags = UCT_MD_FLAG_REG;
         bw_info.criteria.local_md_flags  = UCT_MD_FLAG_REG;
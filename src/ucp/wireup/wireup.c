@@ -769,7 +769,8 @@ ucs_status_t ucp_wireup_init_lanes(ucp_ep_h ep, const ucp_ep_params_t *params,
         return UCS_OK; /* No change */
     }
 
-    if ((ep->cfg_index != 0) && !ucp_ep_is_sockaddr_stub(ep)) {
+    if ((ep->cfg_index != 0) && !ucp_ep_is_sockaddr_stub(ep) &&
+        !(ep->flags & UCP_EP_FLAG_CONNECT_LAZY)) {
         /*
          * TODO handle a case where we have to change lanes and reconfigure the ep:
          *
@@ -788,6 +789,16 @@ ucs_status_t ucp_wireup_init_lanes(ucp_ep_h ep, const ucp_ep_params_t *params,
         ucs_fatal("endpoint reconfiguration not supported yet");
     }
 
+    if (ep->flags & UCP_EP_FLAG_CONNECT_LAZY) {
+        /* the lanes replace the stub of an ep which was not connected yet */
+        ep->flags &= ~UCP_EP_FLAG_CONNECT_LAZY;
+        if (ep->uct_eps[0] != NULL) {
+            /* remote peer connects an ep which was not used yet */
+            ucp_address_cache_release(worker,
+                                      ucp_wireup_ep_extract_lazy_address(ep->uct_eps[0]));
+        }
+    }
+
     ep->cfg_index = new_cfg_index;
     ep->am_lane   = key.am_lane;
 
@@ -6,6 +6,7 @@
 
 #include "wireup_ep.h"
 #include "wireup.h"
+#include "address.h"
 
 #include <ucp/core/ucp_request.h>
 #include <ucp/core/ucp_worker.h>
@@ -349,6 +350,7 @@ UCS_CLASS_INIT_FUNC(ucp_wireup_ep_t, ucp_ep_h ucp_ep)
     self->pending_count      = 0;
     self->flags              = 0;
     self->progress_id        = UCS_CALLBACKQ_ID_NULL;
+    self->lazy_address       = NULL;
     ucs_queue_head_init(&self->pending_q);
 
     UCS_ASYNC_BLOCK(&ucp_ep->worker->async);
@@ -380,6 +382,10 @@ static UCS_CLASS_CLEANUP_FUNC(ucp_wireup_ep_t)
         uct_ep_destroy(self->sockaddr_ep);
     }
 
+    /* Release the address if the endpoint was never used */
+    ucp_address_cache_release(worker,
+                              ucp_wireup_ep_extract_lazy_address(&self->super.super));
+
     UCS_ASYNC_BLOCK(&worker->async);
     --worker->flush_ops_count;
     UCS_ASYNC_UNBLOCK(&worker->async);
@@ -689,3 +695,45 @@ void ucp_wireup_ep_disown(uct_ep_h uct_ep, uct_ep_h owned_ep)
         ucp_proxy_ep_extract(uct_ep);
     }
 }
+
+ucs_status_t ucp_wireup_ep_set_lazy_address(uct_ep_h uct_ep, const void *address)
+{
+    ucp_wireup_ep_t *wireup_ep = ucs_derived_of(uct_ep, ucp_wireup_ep_t);
+    ucp_worker_h worker        = wireup_ep->super.ucp_ep->worker;
+    ucs_status_t status;
+
+    ucs_assert(ucp_wireup_ep_test(uct_ep));
+    ucs_assert(wireup_ep->lazy_address == NULL);
+
+    status = ucp_address_cache_insert(worker, address, &wireup_ep->lazy_address);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    /* Connection establishment is not in progress until the endpoint is used,
+     * so it should not hold off worker flush */
+    UCS_ASYNC_BLOCK(&worker->async);
+    --worker->flush_ops_count;
+    UCS_ASYNC_UNBLOCK(&worker->async);
+    return UCS_OK;
+}
+
+ucp_cached_address_t *ucp_wireup_ep_extract_lazy_address(uct_ep_h uct_ep)
+{
+    ucp_wireup_ep_t *wireup_ep = ucs_derived_of(uct_ep, ucp_wireup_ep_t);
+    ucp_cached_address_t *address;
+    ucp_worker_h worker;
+
+    if (!ucp_wireup_ep_test(uct_ep) || (wireup_ep->lazy_address == NULL)) {
+        return NULL;
+    }
+
+    worker                  = wireup_ep->super.ucp_ep->worker;
+    address                 = wireup_ep->lazy_address;
+    wireup_ep->lazy_address = NULL;
+
+    UCS_ASYNC_BLOCK(&worker->async);
+    ++worker->flush_ops_count;
+    UCS_ASYNC_UNBLOCK(&worker->async);
+    return address;
+}
@@ -39,6 +39,8 @@ struct ucp_wireup_ep {
     volatile uint32_t         pending_count; /**< Number of pending wireup operations */
     volatile uint32_t         flags;         /**< Connection state flags */
     uct_worker_cb_id_t        progress_id;   /**< ID of progress function */
+    ucp_cached_address_t      *lazy_address; /**< Remote worker address, to
+                                                  connect to on first use */
 };
 
 
@@ -92,4 +94,18 @@ void ucp_wireup_ep_disown(uct_ep_h uct_ep, uct_ep_h owned_ep);
 
 ucs_status_t ucp_wireup_ep_progress_pending(uct_pending_req_t *self);
 
+
+/**
+ * Keep a copy of the remote worker address on a stub endpoint, which is
+ * connected only when it's used for the first time.
+ */
+ucs_status_t ucp_wireup_ep_set_lazy_address(uct_ep_h uct_ep, const void *address);
+
+
+/**
+ * @return The address saved by @ref ucp_wireup_ep_set_lazy_address, or NULL if
+ *         there is none. It should be released by @ref ucp_address_cache_release.
+ */
+ucp_cached_address_t *ucp_wireup_ep_extract_lazy_address(uct_ep_h uct_ep);
+
 #endif
@@ -7,7 +7,9 @@
 #if defined(__aarch64__)
 
 #include <ucs/arch/cpu.h>
+#include <ucs/sys/math.h>
 #include <stdio.h>
+#include <string.h>
 
 
 static void ucs_aarch64_cpuid_from_proc(ucs_aarch64_cpuid_t *cpuid)
@@ -64,4 +66,36 @@ void ucs_aarch64_cpuid(ucs_aarch64_cpuid_t *cpuid)
     *cpuid = cached_cpuid;
 }
 
+void ucs_arch_memcpy_nontemporal(void *dst, const void *src, size_t len)
+{
+    size_t head = ucs_padding((uintptr_t)dst, UCS_ARCH_CACHE_LINE_SIZE);
+    char *d     = dst;
+    const char *s;
+
+    if (len < head + UCS_ARCH_CACHE_LINE_SIZE) {
+        memcpy(dst, src, len);
+        return;
+    }
+
+    memcpy(d, src, head);
+    d   += head;
+    s    = (const char*)src + head;
+    len -= head;
+
+    /* STNP provides a hint that the data should not be kept in the cache */
+    for (; len >= UCS_ARCH_CACHE_LINE_SIZE; len -= UCS_ARCH_CACHE_LINE_SIZE) {
+        asm volatile ("ldp  q0, q1, [%1]\n\t"
+                      "ldp  q2, q3, [%1, #32]\n\t"
+                      "stnp q0, q1, [%0]\n\t"
+                      "stnp q2, q3, [%0, #32]\n\t"
+                      :
+                      : "r" (d), "r" (s)
+                      : "v0", "v1", "v2", "v3", "memory");
+        d += UCS_ARCH_CACHE_LINE_SIZE;
+        s += UCS_ARCH_CACHE_LINE_SIZE;
+    }
+
+    memcpy(d, s, len);
+}
+
 #endif
@@ -54,6 +54,9 @@ typedef struct ucs_aarch64_cpuid {
 void ucs_aarch64_cpuid(ucs_aarch64_cpuid_t *cpuid);
 
 
+void ucs_arch_memcpy_nontemporal(void *dst, const void *src, size_t len);
+
+
 #if HAVE_HW_TIMER
 static inline uint64_t ucs_arch_read_hres_clock(void)
 {
@@ -13,6 +13,7 @@
 #endif
 
 #include <ucs/sys/compiler_def.h>
+#include <string.h>
 
 
 /* CPU models */
@@ -69,6 +70,19 @@ typedef enum ucs_cpu_flag {
 #define UCS_SYS_CACHE_LINE_SIZE    UCS_ARCH_CACHE_LINE_SIZE
 #endif
 
+/**
+ * Copy memory using non-temporal stores where the architecture supports it,
+ * so the destination would not be brought to the CPU cache.
+ *
+ * @param dst   Destination buffer.
+ * @param src   Source buffer.
+ * @param len   Number of bytes to copy.
+ */
+static inline void ucs_memcpy_nontemporal(void *dst, const void *src, size_t len)
+{
+    ucs_arch_memcpy_nontemporal(dst, src, len);
+}
+
 /**
  * Clear processor data and instruction caches, intended for
  * self-modifying code.
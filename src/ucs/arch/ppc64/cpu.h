@@ -16,6 +16,7 @@
 #include <ucs/sys/compiler_def.h>
 #include <ucs/arch/generic/cpu.h>
 #include <stdint.h>
+#include <string.h>
 
 BEGIN_C_DECLS
 
@@ -60,6 +61,13 @@ double ucs_arch_get_clocks_per_sec();
 
 #define ucs_arch_wait_mem ucs_arch_generic_wait_mem
 
+static inline void ucs_arch_memcpy_nontemporal(void *dst, const void *src,
+                                               size_t len)
+{
+    /* No non-temporal stores, rely on the hardware streaming detection */
+    memcpy(dst, src, len);
+}
+
 #if !HAVE___CLEAR_CACHE
 static inline void ucs_arch_clear_cache(void *start, void *end)
 {
@@ -10,6 +10,8 @@
 #include <ucs/debug/log.h>
 #include <ucs/sys/math.h>
 #include <ucs/sys/sys.h>
+#include <immintrin.h>
+#include <string.h>
 
 #define X86_CPUID_GET_MODEL       0x00000001u
 #define X86_CPUID_GET_BASE_VALUE  0x00000000u
@@ -266,4 +268,50 @@ int ucs_arch_get_cpu_flag()
     return cpu_flag;
 }
 
+void ucs_arch_memcpy_nontemporal(void *dst, const void *src, size_t len)
+{
+    size_t head = ucs_padding((uintptr_t)dst, UCS_ARCH_CACHE_LINE_SIZE);
+    char *d     = dst;
+    const char *s;
+
+    if (len < head + UCS_ARCH_CACHE_LINE_SIZE) {
+        memcpy(dst, src, len);
+        return;
+    }
+
+    /* Copy the head with regular stores, so streaming stores would write full
+     * aligned cache lines */
+    memcpy(d, src, head);
+    d   += head;
+    s    = (const char*)src + head;
+    len -= head;
+
+    for (; len >= UCS_ARCH_CACHE_LINE_SIZE; len -= UCS_ARCH_CACHE_LINE_SIZE) {
+#if defined(__AVX512F__)
+        _mm512_stream_si512((__m512i*)d, _mm512_loadu_si512((const void*)s));
+#elif defined(__AVX__)
+        __m256i ymm0 = _mm256_loadu_si256((const __m256i*)s);
+        __m256i ymm1 = _mm256_loadu_si256((const __m256i*)(s + 32));
+        _mm256_stream_si256((__m256i*)d,        ymm0);
+        _mm256_stream_si256((__m256i*)(d + 32), ymm1);
+#else
+        __m128i xmm0 = _mm_loadu_si128((const __m128i*)s);
+        __m128i xmm1 = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i xmm2 = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i xmm3 = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_stream_si128((__m128i*)d,        xmm0);
+        _mm_stream_si128((__m128i*)(d + 16), xmm1);
+        _mm_stream_si128((__m128i*)(d + 32), xmm2);
+        _mm_stream_si128((__m128i*)(d + 48), xmm3);
+#endif
+        d += UCS_ARCH_CACHE_LINE_SIZE;
+        s += UCS_ARCH_CACHE_LINE_SIZE;
+    }
+
+    /* Streaming stores are weakly ordered, make them visible before any
+     * following store */
+    _mm_sfence();
+    memcpy(d, s, len);
+}
+
 #endif
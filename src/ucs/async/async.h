@@ -125,6 +125,29 @@ static inline int ucs_async_check_miss(ucs_async_context_t *async)
     } while (0)
 
 
+/**
+ * Try to block the async handler without waiting for a currently running
+ * callback, or for another thread which has blocked the async context.
+ *
+ * @param async  Event context to block events for.
+ *
+ * @return Nonzero if the async context was blocked, and then it should be
+ *         unblocked by @ref UCS_ASYNC_UNBLOCK. Zero if it is held by another
+ *         thread.
+ */
+static inline int ucs_async_try_block(ucs_async_context_t *async)
+{
+    if (async->mode == UCS_ASYNC_MODE_THREAD_SPINLOCK) {
+        return ucs_spin_trylock(&async->thread.spinlock);
+    } else if (async->mode == UCS_ASYNC_MODE_THREAD_MUTEX) {
+        return pthread_mutex_trylock(&async->thread.mutex) == 0;
+    }
+
+    UCS_ASYNC_BLOCK(async);
+    return 1;
+}
+
+
 #define UCS_ASYNC_THREAD_LOCK_TYPE (RUNNING_ON_VALGRIND ? \
     UCS_ASYNC_MODE_THREAD_MUTEX : UCS_ASYNC_MODE_THREAD_SPINLOCK)
 
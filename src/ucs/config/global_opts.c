@@ -11,6 +11,7 @@
 #include <ucs/debug/assert.h>
 #include <ucs/debug/log.h>
 #include <ucs/sys/compiler.h>
+#include <ucs/sys/sys.h>
 #include <sys/signal.h>
 
 
@@ -40,6 +41,7 @@ ucs_global_opts_t ucs_global_opts = {
     .stats_filter          = { NULL, 0 },
     .stats_format          = UCS_STATS_FULL,
     .rcache_check_pfn      = 0,
+    .memcpy_nt_thresh      = UCS_CONFIG_MEMUNITS_INF,
     .module_dir            = UCX_MODULE_DIR /* defined in Makefile.am */
 };
 
@@ -206,6 +208,15 @@ static ucs_config_field_t ucs_global_opts_table[] = {
    "memory region was not changed since the time the region was registered.\n",
    ucs_offsetof(ucs_global_opts_t, rcache_check_pfn), UCS_CONFIG_TYPE_BOOL},
 
+  {"MEMCPY_NT_THRESH", "auto",
+   "Minimal total size of a sent message for its data to be copied to transport\n"
+   "buffers (for example, shared memory) with non-temporal stores, which bypass\n"
+   "the CPU cache, so large messages would not evict the application's working\n"
+   "set. The decision is made once per message, and applies to all its fragments.\n"
+   "\"auto\" selects half of the last-level cache size, and \"inf\" disables\n"
+   "non-temporal copies. \"ucx_info -s\" can be used to calibrate this value.",
+   ucs_offsetof(ucs_global_opts_t, memcpy_nt_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+
   {"MODULE_DIR", UCX_MODULE_DIR,
    "Directory to search for loadable modules",
    ucs_offsetof(ucs_global_opts_t, module_dir), UCS_CONFIG_TYPE_STRING},
@@ -225,6 +236,12 @@ void ucs_global_opts_init()
     if (status != UCS_OK) {
         ucs_fatal("failed to parse global configuration - aborting");
     }
+
+    if (ucs_global_opts.memcpy_nt_thresh == UCS_CONFIG_MEMUNITS_AUTO) {
+        ucs_global_opts.memcpy_nt_thresh = (ucs_get_llc_size() > 0) ?
+                                           (ucs_get_llc_size() / 2) :
+                                           UCS_CONFIG_MEMUNITS_INF;
+    }
 }
 
 ucs_status_t ucs_global_opts_set_value(const char *name, const char *value)
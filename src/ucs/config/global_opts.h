@@ -109,6 +109,9 @@ typedef struct {
     /* registration cache checks if physical page is not moved */
     int                      rcache_check_pfn;
 
+    /* Minimal size of a data path memory copy to bypass the CPU cache */
+    size_t                   memcpy_nt_thresh;
+
     /* directory for loadable modules */
     char                     *module_dir;
 } ucs_global_opts_t;
@@ -83,6 +83,7 @@ typedef enum {
 #define UCS_CONFIG_MEMUNITS_INF    SIZE_MAX
 #define UCS_CONFIG_MEMUNITS_AUTO   (SIZE_MAX - 1)
 
+#define UCS_CONFIG_ULUNITS_INF     SIZE_MAX
 #define UCS_CONFIG_ULUNITS_AUTO    (SIZE_MAX - 1)
 
 
@@ -0,0 +1,428 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCS_SHASH_H_
+#define UCS_SHASH_H_
+
+#include <ucs/sys/compiler_def.h>
+#include <ucs/arch/bitops.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#endif
+
+
+/*
+ * Open-addressing hash table, in the spirit of "Swiss tables".
+ *
+ * The slots are divided to groups of UCS_SHASH_GROUP_SIZE, and every slot has
+ * a 1-byte control entry, which holds either a special value (empty/deleted),
+ * or 7 bits of the key's hash value. Lookup compares all control bytes of a
+ * group to the hash bits in parallel (using SSE2/NEON where available), and
+ * compares the keys only for the matching slots. The probing is done group by
+ * group, so a lookup typically touches one control group and one key.
+ *
+ * The API follows khash.h:
+ *
+ *   UCS_SHASH_INIT(name, key_t, val_t, is_map, hash_func, hash_equal)
+ *
+ *   ucs_shash_t(name)                - hash table type
+ *   ucs_shash_init_inplace(name, h)  - initialize a hash table
+ *   ucs_shash_destroy_inplace(name, h)
+ *                                    - release hash table memory
+ *   ucs_shash_get(name, h, key)      - find a key, returns ucs_shash_end(h)
+ *                                      if not found
+ *   ucs_shash_put(name, h, key, &ret)
+ *                                    - insert a key. ret is set to 0 if the key
+ *                                      is already present, 1 or 2 if the key
+ *                                      was added, and -1 on allocation failure
+ *                                      (in which case ucs_shash_end(h) is
+ *                                      returned)
+ *   ucs_shash_del(name, h, iter)     - remove an element
+ *   ucs_shash_key/value(h, iter)     - access an element
+ *
+ * Iterators are invalidated by ucs_shash_put(). Elements may be removed while
+ * iterating over the hash table with ucs_shash_foreach().
+ */
+
+
+#define UCS_SHASH_GROUP_SIZE       16
+#define UCS_SHASH_H2_BITS          7
+#define UCS_SHASH_H2_MASK          ((1 << UCS_SHASH_H2_BITS) - 1)
+
+/* Control byte values. Full slots hold the 7-bit hash value (0..127). */
+#define UCS_SHASH_CTRL_EMPTY       ((int8_t)-128)
+#define UCS_SHASH_CTRL_DELETED     ((int8_t)-2)
+
+/* Maximal load factor, including deleted slots, is 7/8 */
+#define UCS_SHASH_MAX_LOAD(_cap)   ((_cap) - ((_cap) / 8))
+
+#ifndef ucs_shash_malloc
+#  define ucs_shash_malloc(_size)  malloc(_size)
+#endif
+#ifndef ucs_shash_free
+#  define ucs_shash_free(_ptr)     free(_ptr)
+#endif
+
+
+typedef uint32_t ucs_shash_iter_t;
+
+
+/* Mix the user hash value, so both the group index and the 7-bit control
+ * value would be well-distributed even for simple (e.g identity) hashes */
+static UCS_F_ALWAYS_INLINE uint64_t ucs_shash_mix(uint64_t hash)
+{
+    hash *= 0x9e3779b97f4a7c15ull;
+    return hash ^ (hash >> 32);
+}
+
+#if defined(__SSE2__)
+
+/* Bitmap of slots in the group whose control byte equals to 'value' */
+static UCS_F_ALWAYS_INLINE unsigned
+ucs_shash_group_match(const int8_t *ctrl, int8_t value)
+{
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+}
+
+/* Bitmap of slots in the group which are empty or deleted */
+static UCS_F_ALWAYS_INLINE unsigned
+ucs_shash_group_match_free(const int8_t *ctrl)
+{
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+static UCS_F_ALWAYS_INLINE unsigned ucs_shash_neon_movemask(uint8x16_t mask)
+{
+    static const uint8_t bits[] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                   1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t masked           = vandq_u8(mask, vld1q_u8(bits));
+
+    return vaddv_u8(vget_low_u8(masked)) |
+           (vaddv_u8(vget_high_u8(masked)) << 8);
+}
+
+static UCS_F_ALWAYS_INLINE unsigned
+ucs_shash_group_match(const int8_t *ctrl, int8_t value)
+{
+    return ucs_shash_neon_movemask(vceqq_s8(vld1q_s8(ctrl), vdupq_n_s8(value)));
+}
+
+static UCS_F_ALWAYS_INLINE unsigned
+ucs_shash_group_match_free(const int8_t *ctrl)
+{
+    return ucs_shash_neon_movemask(vcltzq_s8(vld1q_s8(ctrl)));
+}
+
+#else
+
+static UCS_F_ALWAYS_INLINE unsigned
+ucs_shash_group_match(const int8_t *ctrl, int8_t value)
+{
+    unsigned i, mask = 0;
+
+    for (i = 0; i < UCS_SHASH_GROUP_SIZE; ++i) {
+        mask |= (ctrl[i] == value) << i;
+    }
+    return mask;
+}
+
+static UCS_F_ALWAYS_INLINE unsigned
+ucs_shash_group_match_free(const int8_t *ctrl)
+{
+    unsigned i, mask = 0;
+
+    for (i = 0; i < UCS_SHASH_GROUP_SIZE; ++i) {
+        mask |= (ctrl[i] < 0) << i;
+    }
+    return mask;
+}
+
+#endif
+
+static UCS_F_ALWAYS_INLINE unsigned
+ucs_shash_group_match_empty(const int8_t *ctrl)
+{
+    return ucs_shash_group_match(ctrl, UCS_SHASH_CTRL_EMPTY);
+}
+
+
+#define UCS_SHASH_TYPE(name, key_t, val_t) \
+    typedef struct ucs_shash_##name##_s { \
+        ucs_shash_iter_t capacity;    /* Number of slots, 0 or power of 2 */ \
+        ucs_shash_iter_t size;        /* Number of elements */ \
+        ucs_shash_iter_t growth_left; /* How many empty slots can be used \
+                                         before the table is rehashed */ \
+        int8_t           *ctrl;       /* Control byte per slot */ \
+        key_t            *keys; \
+        val_t            *vals; \
+    } ucs_shash_##name##_t;
+
+
+#define UCS_SHASH_IMPL(name, SCOPE, key_t, val_t, is_map, hash_func, hash_equal) \
+    \
+    SCOPE void ucs_shash_init_##name(ucs_shash_##name##_t *h) \
+    { \
+        memset(h, 0, sizeof(*h)); \
+    } \
+    \
+    SCOPE void ucs_shash_destroy_##name(ucs_shash_##name##_t *h) \
+    { \
+        ucs_shash_free(h->ctrl); \
+        ucs_shash_free(h->keys); \
+        ucs_shash_free(h->vals); \
+        memset(h, 0, sizeof(*h)); \
+    } \
+    \
+    /* Returns the slot of the key, or h->capacity if not found */ \
+    static UCS_F_ALWAYS_INLINE ucs_shash_iter_t \
+    ucs_shash_find_##name(const ucs_shash_##name##_t *h, key_t key, \
+                          uint64_t hash) \
+    { \
+        ucs_shash_iter_t mask = (h->capacity / UCS_SHASH_GROUP_SIZE) - 1; \
+        ucs_shash_iter_t group, step, slot; \
+        const int8_t *ctrl; \
+        unsigned match; \
+        \
+        group = (hash >> UCS_SHASH_H2_BITS) & mask; \
+        for (step = 1; step <= mask + 1; ++step) { \
+            ctrl  = h->ctrl + (group * UCS_SHASH_GROUP_SIZE); \
+            match = ucs_shash_group_match(ctrl, hash & UCS_SHASH_H2_MASK); \
+            while (match != 0) { \
+                slot = (group * UCS_SHASH_GROUP_SIZE) + ucs_ffs64(match); \
+                if (ucs_likely(hash_equal(h->keys[slot], key))) { \
+                    return slot; \
+                } \
+                match &= match - 1; \
+            } \
+            if (ucs_likely(ucs_shash_group_match_empty(ctrl) != 0)) { \
+                break; \
+            } \
+            group = (group + step) & mask; \
+        } \
+        return h->capacity; \
+    } \
+    \
+    /* Returns the first empty or deleted slot on the probe sequence */ \
+    static UCS_F_ALWAYS_INLINE ucs_shash_iter_t \
+    ucs_shash_find_free_##name(const ucs_shash_##name##_t *h, uint64_t hash) \
+    { \
+        ucs_shash_iter_t mask = (h->capacity / UCS_SHASH_GROUP_SIZE) - 1; \
+        ucs_shash_iter_t group, step; \
+        unsigned match; \
+        \
+        group = (hash >> UCS_SHASH_H2_BITS) & mask; \
+        for (step = 1; ; ++step) { \
+            match = ucs_shash_group_match_free(h->ctrl + \
+                                               (group * UCS_SHASH_GROUP_SIZE)); \
+            if (match != 0) { \
+                return (group * UCS_SHASH_GROUP_SIZE) + ucs_ffs64(match); \
+            } \
+            group = (group + step) & mask; \
+        } \
+    } \
+    \
+    /* Rehash all elements to a new table, dropping the deleted slots */ \
+    static UCS_F_MAYBE_UNUSED int \
+    ucs_shash_resize_##name(ucs_shash_##name##_t *h) \
+    { \
+        ucs_shash_##name##_t new_h; \
+        ucs_shash_iter_t i, slot; \
+        uint64_t hash; \
+        \
+        /* Grow the table only if it's filled with elements, rather than \
+         * with deleted slots */ \
+        if (h->capacity == 0) { \
+            new_h.capacity = UCS_SHASH_GROUP_SIZE; \
+        } else if (h->size >= (UCS_SHASH_MAX_LOAD(h->capacity) / 2)) { \
+            new_h.capacity = h->capacity * 2; \
+        } else { \
+            new_h.capacity = h->capacity; \
+        } \
+        \
+        new_h.size        = h->size; \
+        new_h.growth_left = UCS_SHASH_MAX_LOAD(new_h.capacity) - h->size; \
+        new_h.ctrl        = (int8_t*)ucs_shash_malloc(new_h.capacity); \
+        new_h.keys        = (key_t*)ucs_shash_malloc(new_h.capacity * \
+                                                     sizeof(key_t)); \
+        new_h.vals        = is_map ? \
+                            (val_t*)ucs_shash_malloc(new_h.capacity * \
+                                                     sizeof(val_t)) : \
+                            NULL; \
+        if ((new_h.ctrl == NULL) || (new_h.keys == NULL) || \
+            (is_map && (new_h.vals == NULL))) { \
+            ucs_shash_free(new_h.ctrl); \
+            ucs_shash_free(new_h.keys); \
+            ucs_shash_free(new_h.vals); \
+            return -1; \
+        } \
+        \
+        memset(new_h.ctrl, UCS_SHASH_CTRL_EMPTY, new_h.capacity); \
+        for (i = 0; i < h->capacity; ++i) { \
+            if (h->ctrl[i] < 0) { \
+                continue; \
+            } \
+            hash             = ucs_shash_mix(hash_func(h->keys[i])); \
+            slot             = ucs_shash_find_free_##name(&new_h, hash); \
+            new_h.ctrl[slot] = h->ctrl[i]; \
+            new_h.keys[slot] = h->keys[i]; \
+            if (is_map) { \
+                new_h.vals[slot] = h->vals[i]; \
+            } \
+        } \
+        \
+        ucs_shash_free(h->ctrl); \
+        ucs_shash_free(h->keys); \
+        ucs_shash_free(h->vals); \
+        *h = new_h; \
+        return 0; \
+    } \
+    \
+    SCOPE ucs_shash_iter_t ucs_shash_get_##name(const ucs_shash_##name##_t *h, \
+                                                key_t key) \
+    { \
+        if (ucs_unlikely(h->capacity == 0)) { \
+            return 0; \
+        } \
+        return ucs_shash_find_##name(h, key, ucs_shash_mix(hash_func(key))); \
+    } \
+    \
+    SCOPE ucs_shash_iter_t ucs_shash_put_##name(ucs_shash_##name##_t *h, \
+                                                key_t key, int *ret) \
+    { \
+        uint64_t hash = ucs_shash_mix(hash_func(key)); \
+        ucs_shash_iter_t slot; \
+        \
+        if (ucs_likely(h->capacity != 0)) { \
+            slot = ucs_shash_find_##name(h, key, hash); \
+            if (slot != h->capacity) { \
+                *ret = 0; \
+                return slot; \
+            } \
+            slot = ucs_shash_find_free_##name(h, hash); \
+        } else { \
+            slot = 0; \
+        } \
+        \
+        /* A deleted slot can always be reused, but an empty slot can be used \
+         * only if it does not exceed the maximal load factor */ \
+        if ((h->capacity == 0) || \
+            ((h->ctrl[slot] == UCS_SHASH_CTRL_EMPTY) && \
+             (h->growth_left == 0))) { \
+            if (ucs_shash_resize_##name(h) < 0) { \
+                *ret = -1; \
+                return h->capacity; \
+            } \
+            slot = ucs_shash_find_free_##name(h, hash); \
+        } \
+        \
+        if (h->ctrl[slot] == UCS_SHASH_CTRL_EMPTY) { \
+            --h->growth_left; \
+            *ret = 1; \
+        } else { \
+            *ret = 2; \
+        } \
+        \
+        h->ctrl[slot] = hash & UCS_SHASH_H2_MASK; \
+        h->keys[slot] = key; \
+        ++h->size; \
+        return slot; \
+    } \
+    \
+    SCOPE void ucs_shash_del_##name(ucs_shash_##name##_t *h, \
+                                    ucs_shash_iter_t iter) \
+    { \
+        const int8_t *group = h->ctrl + (iter & ~(UCS_SHASH_GROUP_SIZE - 1)); \
+        \
+        /* If the group has an empty slot, no probe sequence has continued \
+         * past it, so the slot can become empty rather than deleted */ \
+        if (ucs_shash_group_match_empty(group) != 0) { \
+            h->ctrl[iter] = UCS_SHASH_CTRL_EMPTY; \
+            ++h->growth_left; \
+        } else { \
+            h->ctrl[iter] = UCS_SHASH_CTRL_DELETED; \
+        } \
+        --h->size; \
+    }
+
+
+#define UCS_SHASH_INIT(name, key_t, val_t, is_map, hash_func, hash_equal) \
+    UCS_SHASH_TYPE(name, key_t, val_t) \
+    UCS_SHASH_IMPL(name, static UCS_F_MAYBE_UNUSED inline, key_t, val_t, \
+                   is_map, hash_func, hash_equal)
+
+
+/* Hash functions for common key types */
+#define ucs_shash_int64_hash_func(_key)  ((uint64_t)(_key))
+#define ucs_shash_int_hash_func(_key)    ((uint64_t)(uint32_t)(_key))
+#define ucs_shash_ptr_hash_func(_key)    ((uint64_t)(uintptr_t)(_key))
+#define ucs_shash_equal(_a, _b)          ((_a) == (_b))
+
+
+#define ucs_shash_t(name)                     ucs_shash_##name##_t
+#define ucs_shash_init_inplace(name, h)       ucs_shash_init_##name(h)
+#define ucs_shash_destroy_inplace(name, h)    ucs_shash_destroy_##name(h)
+#define ucs_shash_get(name, h, key)           ucs_shash_get_##name(h, key)
+#define ucs_shash_put(name, h, key, r)        ucs_shash_put_##name(h, key, r)
+#define ucs_shash_del(name, h, iter)          ucs_shash_del_##name(h, iter)
+
+#define ucs_shash_exist(h, iter)              ((h)->ctrl[iter] >= 0)
+#define ucs_shash_key(h, iter)                ((h)->keys[iter])
+#define ucs_shash_value(h, iter)              ((h)->vals[iter])
+#define ucs_shash_begin(h)                    ((ucs_shash_iter_t)0)
+#define ucs_shash_end(h)                      ((h)->capacity)
+#define ucs_shash_size(h)                     ((h)->size)
+
+
+/**
+ * Iterate over all elements of the hash table.
+ */
+#define ucs_shash_foreach(h, kvar, vvar, code) \
+    { \
+        ucs_shash_iter_t __i; \
+        for (__i = ucs_shash_begin(h); __i != ucs_shash_end(h); ++__i) { \
+            if (!ucs_shash_exist(h, __i)) { \
+                continue; \
+            } \
+            (kvar) = ucs_shash_key(h, __i); \
+            (vvar) = ucs_shash_value(h, __i); \
+            code; \
+        } \
+    }
+
+#define ucs_shash_foreach_key(h, kvar, code) \
+    { \
+        ucs_shash_iter_t __i; \
+        for (__i = ucs_shash_begin(h); __i != ucs_shash_end(h); ++__i) { \
+            if (!ucs_shash_exist(h, __i)) { \
+                continue; \
+            } \
+            (kvar) = ucs_shash_key(h, __i); \
+            code; \
+        } \
+    }
+
+#define ucs_shash_foreach_value(h, vvar, code) \
+    { \
+        ucs_shash_iter_t __i; \
+        for (__i = ucs_shash_begin(h); __i != ucs_shash_end(h); ++__i) { \
+            if (!ucs_shash_exist(h, __i)) { \
+                continue; \
+            } \
+            (vvar) = ucs_shash_value(h, __i); \
+            code; \
+        } \
+    }
+
+#endif
@@ -0,0 +1,470 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "memprot_cache.h"
+
+#include <ucs/type/class.h>
+#include <ucs/debug/log.h>
+#include <ucs/profile/profile.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/sys.h>
+#include <ucs/sys/math.h>
+#include <ucm/api/ucm.h>
+#include <ucm/util/sys.h>
+#include <sys/mman.h>
+
+
+/* Protection of a range which was unmapped, or whose protection is unknown */
+#define UCS_MEMPROT_CACHE_PROT_UNKNOWN  (-1)
+
+/* Protection of a range which was not mapped when /proc/self/maps was read */
+#define UCS_MEMPROT_CACHE_PROT_UNMAPPED (-2)
+
+#define UCS_MEMPROT_CACHE_EVENTS \
+    (UCM_EVENT_MMAP | UCM_EVENT_MPROTECT | UCM_EVENT_MREMAP | UCM_EVENT_SBRK | \
+     UCM_EVENT_VM_UNMAPPED)
+
+
+/* Memory protection cache which is shared by all users in the process */
+static struct {
+    pthread_mutex_t     lock;
+    ucs_memprot_cache_t *memprot_cache;
+    unsigned            refcount;
+} ucs_memprot_cache_shared = {
+    .lock          = PTHREAD_MUTEX_INITIALIZER,
+    .memprot_cache = NULL,
+    .refcount      = 0
+};
+
+
+static ucs_pgt_dir_t *ucs_memprot_cache_pgt_dir_alloc(const ucs_pgtable_t *pgtable)
+{
+    return ucs_memalign(UCS_PGT_ENTRY_MIN_ALIGN, sizeof(ucs_pgt_dir_t),
+                        "memprot_cache_pgdir");
+}
+
+static void ucs_memprot_cache_pgt_dir_release(const ucs_pgtable_t *pgtable,
+                                              ucs_pgt_dir_t *dir)
+{
+    ucs_free(dir);
+}
+
+static void ucs_memprot_cache_region_collect_callback(const ucs_pgtable_t *pgtable,
+                                                      ucs_pgt_region_t *pgt_region,
+                                                      void *arg)
+{
+    ucs_memprot_cache_region_t *region = ucs_derived_of(pgt_region,
+                                                        ucs_memprot_cache_region_t);
+    ucs_list_link_t *list = arg;
+    ucs_list_add_tail(list, &region->list);
+}
+
+static void ucs_memprot_cache_push_op(ucs_memprot_cache_t *memprot_cache,
+                                      void *address, size_t length, int prot)
+{
+    ucs_memprot_cache_op_t *op;
+
+    ucs_trace("memprot_cache: event address %p length %zu prot %d", address,
+              length, prot);
+
+    pthread_spin_lock(&memprot_cache->ops_lock);
+    if ((memprot_cache->ops_pi - memprot_cache->ops_ci) <
+        UCS_MEMPROT_CACHE_MAX_OPS) {
+        op        = &memprot_cache->ops[memprot_cache->ops_pi %
+                                        UCS_MEMPROT_CACHE_MAX_OPS];
+        op->start = (uintptr_t)address;
+        op->end   = (uintptr_t)address + length;
+        op->prot  = prot;
+        ++memprot_cache->ops_pi;
+    } else {
+        /* Too many events, rebuild everything on next lookup */
+        memprot_cache->reload = 1;
+    }
+    pthread_spin_unlock(&memprot_cache->ops_lock);
+}
+
+static void ucs_memprot_cache_event_callback(ucm_event_type_t event_type,
+                                             ucm_event_t *event, void *arg)
+{
+    ucs_memprot_cache_t *memprot_cache = arg;
+
+    switch (event_type) {
+    case UCM_EVENT_MMAP:
+        if (event->mmap.result != MAP_FAILED) {
+            ucs_memprot_cache_push_op(memprot_cache, event->mmap.result,
+                                      event->mmap.size, event->mmap.prot);
+        }
+        break;
+    case UCM_EVENT_MPROTECT:
+        if (event->mprotect.result == 0) {
+            ucs_memprot_cache_push_op(memprot_cache, event->mprotect.addr,
+                                      event->mprotect.length,
+                                      event->mprotect.prot);
+        }
+        break;
+    case UCM_EVENT_MREMAP:
+        /* The new mapping may replace existing mappings, and its protection
+         * is not known */
+        if (event->mremap.result != MAP_FAILED) {
+            ucs_memprot_cache_push_op(memprot_cache, event->mremap.result,
+                                      event->mremap.new_size,
+                                      UCS_MEMPROT_CACHE_PROT_UNKNOWN);
+        }
+        break;
+    case UCM_EVENT_SBRK:
+        if ((event->sbrk.increment > 0) && (event->sbrk.result != MAP_FAILED)) {
+            ucs_memprot_cache_push_op(memprot_cache, event->sbrk.result,
+                                      event->sbrk.increment,
+                                      PROT_READ | PROT_WRITE);
+        }
+        break;
+    case UCM_EVENT_VM_UNMAPPED:
+        ucs_memprot_cache_push_op(memprot_cache, event->vm_unmapped.address,
+                                  event->vm_unmapped.size,
+                                  UCS_MEMPROT_CACHE_PROT_UNKNOWN);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Lock must be held in write mode */
+static void ucs_memprot_cache_insert(ucs_memprot_cache_t *memprot_cache,
+                                     ucs_pgt_addr_t start, ucs_pgt_addr_t end,
+                                     int prot)
+{
+    ucs_memprot_cache_region_t *region;
+    ucs_status_t status;
+
+    region = ucs_memalign(UCS_PGT_ENTRY_MIN_ALIGN,
+                          sizeof(ucs_memprot_cache_region_t),
+                          "memprot_cache_region");
+    if (region == NULL) {
+        ucs_debug("failed to allocate memprot_cache region");
+        memprot_cache->reload = 1;
+        return;
+    }
+
+    region->super.start = start;
+    region->super.end   = end;
+    region->prot        = prot;
+    status = ucs_pgtable_insert(&memprot_cache->pgtable, &region->super);
+    if (status != UCS_OK) {
+        /* The range will be looked up in /proc/self/maps */
+        ucs_debug("failed to insert region " UCS_PGT_REGION_FMT ": %s",
+                  UCS_PGT_REGION_ARG(&region->super), ucs_status_string(status));
+        ucs_free(region);
+    }
+}
+
+/* Lock must be held in write mode */
+static void ucs_memprot_cache_set_range(ucs_memprot_cache_t *memprot_cache,
+                                        ucs_pgt_addr_t start, ucs_pgt_addr_t end,
+                                        int prot)
+{
+    ucs_memprot_cache_region_t *region, *tmp;
+    ucs_list_link_t region_list;
+    ucs_status_t status;
+
+    start = ucs_align_down_pow2(start, ucs_get_page_size());
+    end   = ucs_align_up_pow2  (end,   ucs_get_page_size());
+    if (start >= end) {
+        return;
+    }
+
+    /* Remove the overlapping regions, and put back the parts of them which are
+     * outside of the range */
+    ucs_list_head_init(&region_list);
+    ucs_pgtable_search_range(&memprot_cache->pgtable, start, end - 1,
+                             ucs_memprot_cache_region_collect_callback,
+                             &region_list);
+    ucs_list_for_each_safe(region, tmp, &region_list, list) {
+        status = ucs_pgtable_remove(&memprot_cache->pgtable, &region->super);
+        if (status != UCS_OK) {
+            ucs_warn("failed to remove region " UCS_PGT_REGION_FMT ": %s",
+                     UCS_PGT_REGION_ARG(&region->super),
+                     ucs_status_string(status));
+        }
+
+        if (region->super.start < start) {
+            ucs_memprot_cache_insert(memprot_cache, region->super.start, start,
+                                     region->prot);
+        }
+        if (region->super.end > end) {
+            ucs_memprot_cache_insert(memprot_cache, end, region->super.end,
+                                     region->prot);
+        }
+        ucs_free(region);
+    }
+
+    if (prot != UCS_MEMPROT_CACHE_PROT_UNKNOWN) {
+        ucs_memprot_cache_insert(memprot_cache, start, end, prot);
+    }
+}
+
+static void ucs_memprot_cache_purge(ucs_memprot_cache_t *memprot_cache)
+{
+    ucs_memprot_cache_region_t *region, *tmp;
+    ucs_list_link_t region_list;
+
+    ucs_list_head_init(&region_list);
+    ucs_pgtable_purge(&memprot_cache->pgtable,
+                      ucs_memprot_cache_region_collect_callback, &region_list);
+    ucs_list_for_each_safe(region, tmp, &region_list, list) {
+        ucs_free(region);
+    }
+}
+
+static int ucs_memprot_cache_maps_callback(void *arg, void *addr, size_t length,
+                                           int prot)
+{
+    ucs_memprot_cache_t *memprot_cache = arg;
+
+    ucs_memprot_cache_insert(memprot_cache, (uintptr_t)addr,
+                             (uintptr_t)addr + length, prot);
+    return 0;
+}
+
+/* Lock must be held in write mode */
+static void ucs_memprot_cache_reload(ucs_memprot_cache_t *memprot_cache)
+{
+    ucs_trace_func("memprot_cache=%p", memprot_cache);
+
+    /* /proc/self/maps already reflects all pending events */
+    pthread_spin_lock(&memprot_cache->ops_lock);
+    memprot_cache->ops_ci = memprot_cache->ops_pi;
+    memprot_cache->reload = 0;
+    pthread_spin_unlock(&memprot_cache->ops_lock);
+
+    ucs_memprot_cache_purge(memprot_cache);
+    UCS_PROFILE_CALL_VOID(ucm_parse_proc_self_maps,
+                          ucs_memprot_cache_maps_callback, memprot_cache);
+    ++memprot_cache->num_reloads;
+}
+
+/* Lock must be held in write mode */
+static void ucs_memprot_cache_apply_ops(ucs_memprot_cache_t *memprot_cache)
+{
+    ucs_memprot_cache_op_t op;
+
+    pthread_spin_lock(&memprot_cache->ops_lock);
+    while (!memprot_cache->reload &&
+           (memprot_cache->ops_ci != memprot_cache->ops_pi)) {
+        op = memprot_cache->ops[memprot_cache->ops_ci % UCS_MEMPROT_CACHE_MAX_OPS];
+        ++memprot_cache->ops_ci;
+
+        /* Updating the page table may allocate memory and generate more
+         * events, so release the lock */
+        pthread_spin_unlock(&memprot_cache->ops_lock);
+        ucs_memprot_cache_set_range(memprot_cache, op.start, op.end, op.prot);
+        pthread_spin_lock(&memprot_cache->ops_lock);
+    }
+    pthread_spin_unlock(&memprot_cache->ops_lock);
+
+    if (memprot_cache->reload) {
+        ucs_memprot_cache_reload(memprot_cache);
+    }
+}
+
+/*
+ * Lock must be held.
+ * Returns 0 if some part of the range is not in the cache, and sets *hole_p to
+ * the start of that part. Otherwise, returns 1. In both cases, the protection
+ * of the part before the first hole (or unmapped range) is returned, same as
+ * ucs_get_mem_prot() does.
+ */
+static int ucs_memprot_cache_find(ucs_memprot_cache_t *memprot_cache,
+                                  ucs_pgt_addr_t start, ucs_pgt_addr_t end,
+                                  int *prot_p, ucs_pgt_addr_t *hole_p)
+{
+    ucs_memprot_cache_region_t *region;
+    ucs_pgt_region_t *pgt_region;
+    ucs_pgt_addr_t address;
+    int prot;
+
+    prot    = PROT_READ | PROT_WRITE | PROT_EXEC;
+    address = start;
+    while (address < end) {
+        pgt_region = ucs_pgtable_lookup(&memprot_cache->pgtable, address);
+        if (pgt_region == NULL) {
+            *prot_p = (address == start) ? PROT_NONE : prot;
+            *hole_p = address;
+            return 0;
+        }
+
+        region = ucs_derived_of(pgt_region, ucs_memprot_cache_region_t);
+        if (region->prot == UCS_MEMPROT_CACHE_PROT_UNMAPPED) {
+            *prot_p = (address == start) ? PROT_NONE : prot;
+            return 1;
+        }
+
+        prot    &= region->prot;
+        address  = region->super.end;
+    }
+
+    *prot_p = prot;
+    return 1;
+}
+
+/*
+ * Lock must be held in write mode.
+ * Remember that a range which was not found in /proc/self/maps is unmapped,
+ * so querying it again would not read /proc/self/maps again. A mapping which
+ * is created there later without a memory event is reported as unmapped until
+ * the next reload, so the caller would only miss an optimization.
+ */
+static void ucs_memprot_cache_add_hole(ucs_memprot_cache_t *memprot_cache,
+                                       ucs_pgt_addr_t hole, ucs_pgt_addr_t end)
+{
+    ucs_memprot_cache_region_t *region;
+    ucs_list_link_t region_list;
+
+    hole = ucs_align_down_pow2(hole, ucs_get_page_size());
+    end  = ucs_align_up_pow2  (end,  ucs_get_page_size());
+
+    /* The hole ends where the next mapping starts */
+    ucs_list_head_init(&region_list);
+    ucs_pgtable_search_range(&memprot_cache->pgtable, hole, end - 1,
+                             ucs_memprot_cache_region_collect_callback,
+                             &region_list);
+    ucs_list_for_each(region, &region_list, list) {
+        if (region->super.start > hole) {
+            end = ucs_min(end, region->super.start);
+        }
+    }
+
+    if (hole < end) {
+        ucs_memprot_cache_insert(memprot_cache, hole, end,
+                                 UCS_MEMPROT_CACHE_PROT_UNMAPPED);
+    }
+}
+
+int ucs_memprot_cache_get(ucs_memprot_cache_t *memprot_cache,
+                          unsigned long start, unsigned long end)
+{
+    ucs_pgt_addr_t hole;
+    int prot;
+
+    pthread_rwlock_rdlock(&memprot_cache->lock);
+    if (!memprot_cache->reload &&
+        (memprot_cache->ops_ci == memprot_cache->ops_pi) &&
+        ucs_memprot_cache_find(memprot_cache, start, end, &prot, &hole)) {
+        pthread_rwlock_unlock(&memprot_cache->lock);
+        return prot;
+    }
+    pthread_rwlock_unlock(&memprot_cache->lock);
+
+    pthread_rwlock_wrlock(&memprot_cache->lock);
+    ucs_memprot_cache_apply_ops(memprot_cache);
+    if (!ucs_memprot_cache_find(memprot_cache, start, end, &prot, &hole)) {
+        /* The range could have been mapped without generating a memory event,
+         * for example by the dynamic loader */
+        ucs_memprot_cache_reload(memprot_cache);
+        if (!ucs_memprot_cache_find(memprot_cache, start, end, &prot, &hole)) {
+            ucs_memprot_cache_add_hole(memprot_cache, hole, end);
+        }
+    }
+    pthread_rwlock_unlock(&memprot_cache->lock);
+
+    ucs_trace("memprot_cache: range 0x%lx..0x%lx prot 0x%x", start, end, prot);
+    return prot;
+}
+
+ucs_status_t ucs_memprot_cache_get_shared(ucs_memprot_cache_t **memprot_cache_p)
+{
+    ucs_status_t status;
+
+    pthread_mutex_lock(&ucs_memprot_cache_shared.lock);
+    if (ucs_memprot_cache_shared.refcount == 0) {
+        status = ucs_memprot_cache_create(&ucs_memprot_cache_shared.memprot_cache);
+        if (status != UCS_OK) {
+            goto out;
+        }
+    }
+
+    ++ucs_memprot_cache_shared.refcount;
+    *memprot_cache_p = ucs_memprot_cache_shared.memprot_cache;
+    status           = UCS_OK;
+out:
+    pthread_mutex_unlock(&ucs_memprot_cache_shared.lock);
+    return status;
+}
+
+void ucs_memprot_cache_put_shared(ucs_memprot_cache_t *memprot_cache)
+{
+    pthread_mutex_lock(&ucs_memprot_cache_shared.lock);
+    ucs_assert(memprot_cache == ucs_memprot_cache_shared.memprot_cache);
+    ucs_assert(ucs_memprot_cache_shared.refcount > 0);
+    if (--ucs_memprot_cache_shared.refcount == 0) {
+        ucs_memprot_cache_destroy(memprot_cache);
+        ucs_memprot_cache_shared.memprot_cache = NULL;
+    }
+    pthread_mutex_unlock(&ucs_memprot_cache_shared.lock);
+}
+
+static UCS_CLASS_INIT_FUNC(ucs_memprot_cache_t)
+{
+    ucs_status_t status;
+    int ret;
+
+    ret = pthread_rwlock_init(&self->lock, NULL);
+    if (ret) {
+        ucs_error("pthread_rwlock_init() failed: %m");
+        status = UCS_ERR_INVALID_PARAM;
+        goto err;
+    }
+
+    ret = pthread_spin_init(&self->ops_lock, 0);
+    if (ret) {
+        ucs_error("pthread_spin_init() failed: %m");
+        status = UCS_ERR_INVALID_PARAM;
+        goto err_destroy_rwlock;
+    }
+
+    status = ucs_pgtable_init(&self->pgtable, ucs_memprot_cache_pgt_dir_alloc,
+                              ucs_memprot_cache_pgt_dir_release);
+    if (status != UCS_OK) {
+        goto err_destroy_ops_lock;
+    }
+
+    self->ops_pi      = 0;
+    self->ops_ci      = 0;
+    self->reload      = 1;
+    self->num_reloads = 0;
+
+    status = ucm_set_event_handler(UCS_MEMPROT_CACHE_EVENTS, 1000,
+                                   ucs_memprot_cache_event_callback, self);
+    if (status != UCS_OK) {
+        goto err_cleanup_pgtable;
+    }
+
+    return UCS_OK;
+
+err_cleanup_pgtable:
+    ucs_pgtable_cleanup(&self->pgtable);
+err_destroy_ops_lock:
+    pthread_spin_destroy(&self->ops_lock);
+err_destroy_rwlock:
+    pthread_rwlock_destroy(&self->lock);
+err:
+    return status;
+}
+
+static UCS_CLASS_CLEANUP_FUNC(ucs_memprot_cache_t)
+{
+    ucm_unset_event_handler(UCS_MEMPROT_CACHE_EVENTS,
+                            ucs_memprot_cache_event_callback, self);
+    ucs_memprot_cache_purge(self);
+    ucs_pgtable_cleanup(&self->pgtable);
+    pthread_spin_destroy(&self->ops_lock);
+    pthread_rwlock_destroy(&self->lock);
+}
+
+UCS_CLASS_DEFINE(ucs_memprot_cache_t, void);
+UCS_CLASS_DEFINE_NAMED_NEW_FUNC(ucs_memprot_cache_create, ucs_memprot_cache_t,
+                                ucs_memprot_cache_t)
+UCS_CLASS_DEFINE_NAMED_DELETE_FUNC(ucs_memprot_cache_destroy, ucs_memprot_cache_t,
+                                   ucs_memprot_cache_t)
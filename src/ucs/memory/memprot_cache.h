@@ -0,0 +1,117 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCS_MEMPROT_CACHE_H_
+#define UCS_MEMPROT_CACHE_H_
+
+/*
+ * Memory protection cache - holds the protection flags of the process address
+ * space, as read from /proc/self/maps, and keeps them up-to-date according to
+ * memory events (mmap, munmap, mprotect, etc.), so protection queries do not
+ * have to parse /proc/self/maps every time.
+ * This data structure is thread safe.
+ */
+#include <ucs/datastruct/pgtable.h>
+#include <ucs/datastruct/list.h>
+#include <pthread.h>
+
+
+/* Maximal number of pending memory events */
+#define UCS_MEMPROT_CACHE_MAX_OPS   64
+
+
+typedef struct ucs_memprot_cache         ucs_memprot_cache_t;
+typedef struct ucs_memprot_cache_region  ucs_memprot_cache_region_t;
+
+
+struct ucs_memprot_cache_region {
+    ucs_pgt_region_t    super;    /**< Base class - page table region */
+    ucs_list_link_t     list;     /**< List element */
+    int                 prot;     /**< Protection flags of the mapping */
+};
+
+
+/*
+ * Memory event which was not applied to the page table yet.
+ */
+typedef struct ucs_memprot_cache_op {
+    ucs_pgt_addr_t      start;    /**< Start of the affected range */
+    ucs_pgt_addr_t      end;      /**< End of the affected range */
+    int                 prot;     /**< New protection of the range, or -1 if
+                                       it's unmapped or unknown */
+} ucs_memprot_cache_op_t;
+
+
+struct ucs_memprot_cache {
+    pthread_rwlock_t       lock;      /**< Protects the page table */
+    ucs_pgtable_t          pgtable;   /**< Page table to hold the regions */
+
+    pthread_spinlock_t     ops_lock;  /**< Protects the pending events. Memory
+                                           events may be generated while the
+                                           page table lock is held, so they are
+                                           queued and applied on next lookup */
+    ucs_memprot_cache_op_t ops[UCS_MEMPROT_CACHE_MAX_OPS]; /**< Pending events */
+    unsigned               ops_pi;    /**< Producer index of pending events */
+    unsigned               ops_ci;    /**< Consumer index of pending events */
+    volatile int           reload;    /**< The page table should be rebuilt from
+                                           /proc/self/maps, set initially and
+                                           when pending events overflow */
+    unsigned long          num_reloads; /**< How many times /proc/self/maps
+                                             was read */
+};
+
+
+/**
+ * Create a memory protection cache.
+ *
+ * @param [out] memprot_cache_p  Filled with a pointer to the memory protection
+ *                               cache.
+ */
+ucs_status_t ucs_memprot_cache_create(ucs_memprot_cache_t **memprot_cache_p);
+
+
+/**
+ * Destroy a memory protection cache.
+ *
+ * @param [in]  memprot_cache    Memory protection cache to destroy.
+ */
+void ucs_memprot_cache_destroy(ucs_memprot_cache_t *memprot_cache);
+
+
+/**
+ * Get a reference to the memory protection cache which is shared by all users
+ * in the process, and create it if it does not exist.
+ *
+ * @param [out] memprot_cache_p  Filled with a pointer to the shared memory
+ *                               protection cache.
+ */
+ucs_status_t ucs_memprot_cache_get_shared(ucs_memprot_cache_t **memprot_cache_p);
+
+
+/**
+ * Release a reference to the shared memory protection cache, and destroy it
+ * when the last reference is released.
+ *
+ * @param [in]  memprot_cache    Shared memory protection cache.
+ */
+void ucs_memprot_cache_put_shared(ucs_memprot_cache_t *memprot_cache);
+
+
+/**
+ * Get the memory protection of an address range. Has the same semantics as
+ * @ref ucs_get_mem_prot.
+ *
+ * @param [in]  memprot_cache    Memory protection cache.
+ * @param [in]  start            Start of the address range.
+ * @param [in]  end              End of the address range.
+ *
+ * @return PROT_xx flags which are set for the whole range.
+ */
+int ucs_memprot_cache_get(ucs_memprot_cache_t *memprot_cache,
+                          unsigned long start, unsigned long end);
+
+
+#endif
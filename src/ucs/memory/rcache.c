@@ -62,6 +62,7 @@ static ucs_stats_class_t ucs_rcache_stats_class = {
         [UCS_RCACHE_PUTS]               = "puts",
         [UCS_RCACHE_REGS]               = "mem_regs",
         [UCS_RCACHE_DEREGS]             = "mem_deregs",
+        [UCS_RCACHE_EVICTS]             = "regions_evicted",
     }
 };
 #endif
@@ -173,6 +174,48 @@ static void ucs_rcache_region_validate_pfn(ucs_rcache_t *rcache,
     }
 }
 
+static inline int ucs_rcache_lru_is_enabled(ucs_rcache_t *rcache)
+{
+    return (rcache->params.max_regions != ULONG_MAX) ||
+           (rcache->params.max_size    != SIZE_MAX);
+}
+
+/* LRU lock must be held */
+static inline void ucs_rcache_region_lru_remove(ucs_rcache_t *rcache,
+                                                ucs_rcache_region_t *region)
+{
+    ucs_list_del(&region->lru_list);
+    region->lru_flags &= ~UCS_RCACHE_LRU_FLAG_IN_LRU;
+}
+
+/* Move the region to the tail of LRU list, the caller must hold a reference */
+static void ucs_rcache_region_lru_add(ucs_rcache_t *rcache,
+                                      ucs_rcache_region_t *region)
+{
+    pthread_spin_lock(&rcache->lru.lock);
+    if (region->lru_flags & UCS_RCACHE_LRU_FLAG_IN_LRU) {
+        ucs_list_del(&region->lru_list);
+    }
+    ucs_list_add_tail(&rcache->lru.list, &region->lru_list);
+    region->lru_flags |= UCS_RCACHE_LRU_FLAG_IN_LRU;
+    pthread_spin_unlock(&rcache->lru.lock);
+}
+
+/* A region which is being used cannot be evicted */
+static UCS_F_ALWAYS_INLINE void
+ucs_rcache_region_lru_get(ucs_rcache_t *rcache, ucs_rcache_region_t *region)
+{
+    if (ucs_likely(!(region->lru_flags & UCS_RCACHE_LRU_FLAG_IN_LRU))) {
+        return;
+    }
+
+    pthread_spin_lock(&rcache->lru.lock);
+    if (region->lru_flags & UCS_RCACHE_LRU_FLAG_IN_LRU) {
+        ucs_rcache_region_lru_remove(rcache, region);
+    }
+    pthread_spin_unlock(&rcache->lru.lock);
+}
+
 /* Lock must be held */
 static void ucs_rcache_region_collect_callback(const ucs_pgtable_t *pgtable,
                                                ucs_pgt_region_t *pgt_region, void *arg)
@@ -191,6 +234,69 @@ static void ucs_rcache_find_regions(ucs_rcache_t *rcache, ucs_pgt_addr_t from,
                              ucs_rcache_region_collect_callback, list);
 }
 
+/* Returns nonzero if the region was registered */
+static int ucs_rcache_region_dereg(ucs_rcache_t *rcache,
+                                   ucs_rcache_region_t *region)
+{
+    int registered = region->flags & UCS_RCACHE_REGION_FLAG_REGISTERED;
+
+    if (registered) {
+        UCS_PROFILE_CODE("mem_dereg") {
+            rcache->params.ops->mem_dereg(rcache->params.context, rcache, region);
+        }
+    }
+
+    ucs_free(region);
+    return registered;
+}
+
+static void *ucs_rcache_dereg_thread_func(void *arg)
+{
+    ucs_rcache_t *rcache = arg;
+    ucs_rcache_region_t *region, *tmp;
+    ucs_list_link_t batch;
+    unsigned count, dereg_count;
+
+    pthread_mutex_lock(&rcache->dereg.lock);
+    for (;;) {
+        while (ucs_list_is_empty(&rcache->dereg.list) && !rcache->dereg.stop) {
+            pthread_cond_wait(&rcache->dereg.cond, &rcache->dereg.lock);
+        }
+
+        if (ucs_list_is_empty(&rcache->dereg.list)) {
+            break;
+        }
+
+        /* Take all pending regions, and deregister them without the lock */
+        ucs_list_head_init(&batch);
+        ucs_list_splice_tail(&batch, &rcache->dereg.list);
+        ucs_list_head_init(&rcache->dereg.list);
+        pthread_mutex_unlock(&rcache->dereg.lock);
+
+        count       = 0;
+        dereg_count = 0;
+        ucs_list_for_each_safe(region, tmp, &batch, lru_list) {
+            if (ucs_rcache_region_dereg(rcache, region)) {
+                ++dereg_count;
+            }
+            ++count;
+        }
+        ucs_trace("%s: released %u regions, deregistered %u", rcache->name,
+                  count, dereg_count);
+
+        /* Synchronous deregistration updates the counter under the rcache
+         * lock, so publish the batch count under the same lock */
+        pthread_rwlock_wrlock(&rcache->lock);
+        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_DEREGS, dereg_count);
+        pthread_rwlock_unlock(&rcache->lock);
+
+        pthread_mutex_lock(&rcache->dereg.lock);
+    }
+    pthread_mutex_unlock(&rcache->dereg.lock);
+
+    return NULL;
+}
+
 /* Lock must be held in write mode */
 static void ucs_mem_region_destroy_internal(ucs_rcache_t *rcache,
                                             ucs_rcache_region_t *region)
@@ -200,14 +306,22 @@ static void ucs_mem_region_destroy_internal(ucs_rcache_t *rcache,
     ucs_assert(region->refcount == 0);
     ucs_assert(!(region->flags & UCS_RCACHE_REGION_FLAG_PGTABLE));
 
-    if (region->flags & UCS_RCACHE_REGION_FLAG_REGISTERED) {
-        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_DEREGS, 1);
-        UCS_PROFILE_CODE("mem_dereg") {
-            rcache->params.ops->mem_dereg(rcache->params.context, rcache, region);
-        }
+    /* Region could be added to LRU by put() after it was invalidated */
+    ucs_rcache_region_lru_get(rcache, region);
+
+    if (rcache->params.flags & UCS_RCACHE_FLAG_ASYNC_DEREG) {
+        /* The region is not on LRU list anymore, so reuse its list element
+         * to pass it to the deregistration thread */
+        pthread_mutex_lock(&rcache->dereg.lock);
+        ucs_list_add_tail(&rcache->dereg.list, &region->lru_list);
+        pthread_cond_signal(&rcache->dereg.cond);
+        pthread_mutex_unlock(&rcache->dereg.lock);
+        return;
     }
 
-    ucs_free(region);
+    if (ucs_rcache_region_dereg(rcache, region)) {
+        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_DEREGS, 1);
+    }
 }
 
 static inline void ucs_rcache_region_put_internal(ucs_rcache_t *rcache,
@@ -249,6 +363,8 @@ static void ucs_rcache_region_invalidate(ucs_rcache_t *rcache,
                                    ucs_status_string(status));
         }
         region->flags &= ~UCS_RCACHE_REGION_FLAG_PGTABLE;
+        --rcache->num_regions;
+        rcache->total_size -= region->super.end - region->super.start;
     } else {
         ucs_assert(!must_be_in_pgt);
     }
@@ -256,6 +372,48 @@ static void ucs_rcache_region_invalidate(ucs_rcache_t *rcache,
      ucs_rcache_region_put_internal(rcache, region, 0, must_be_destroyed);
 }
 
+/* Lock must be held in write mode */
+static void ucs_rcache_lru_evict(ucs_rcache_t *rcache)
+{
+    unsigned num_evicted, num_skipped;
+    ucs_rcache_region_t *region;
+
+    num_evicted = 0;
+    num_skipped = 0;
+
+    pthread_spin_lock(&rcache->lru.lock);
+    while (!ucs_list_is_empty(&rcache->lru.list) &&
+           ((rcache->num_regions > rcache->params.max_regions) ||
+            (rcache->total_size  > rcache->params.max_size))) {
+        region = ucs_list_head(&rcache->lru.list, ucs_rcache_region_t, lru_list);
+        ucs_rcache_region_lru_remove(rcache, region);
+
+        if (!(region->flags & UCS_RCACHE_REGION_FLAG_PGTABLE) ||
+            (region->refcount > 1)) {
+            /* The region is in use, it will be added back to LRU by put() */
+            ++num_skipped;
+            continue;
+        }
+
+        /* Nobody else can take a reference on the region while page table lock
+         * is held for write, so invalidation must destroy it.
+         */
+        pthread_spin_unlock(&rcache->lru.lock);
+        ucs_rcache_region_trace(rcache, region, "evict");
+        ucs_rcache_region_invalidate(rcache, region, 1, 1);
+        ++num_evicted;
+        pthread_spin_lock(&rcache->lru.lock);
+    }
+    pthread_spin_unlock(&rcache->lru.lock);
+
+    if (num_evicted > 0) {
+        ucs_debug("%s: evicted %u regions, skipped %u, now %lu regions "
+                  "total size %zu", rcache->name, num_evicted, num_skipped,
+                  rcache->num_regions, rcache->total_size);
+    }
+    UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_EVICTS, num_evicted);
+}
+
 /* Lock must be held in write mode */
 static void ucs_rcache_invalidate_range(ucs_rcache_t *rcache, ucs_pgt_addr_t start,
                                         ucs_pgt_addr_t end)
@@ -355,6 +513,8 @@ static void ucs_rcache_purge(ucs_rcache_t *rcache)
         if (region->flags & UCS_RCACHE_REGION_FLAG_PGTABLE) {
             region->flags &= ~UCS_RCACHE_REGION_FLAG_PGTABLE;
             ucs_atomic_add32(&region->refcount, -1);
+            --rcache->num_regions;
+            rcache->total_size -= region->super.end - region->super.start;
         }
         if (region->refcount > 0) {
             ucs_rcache_region_warn(rcache, region, "destroying inuse");
@@ -369,6 +529,16 @@ static inline int ucs_rcache_region_test(ucs_rcache_region_t *region, int prot)
            ucs_test_all_flags(region->prot, prot);
 }
 
+static int ucs_rcache_get_mem_prot(ucs_rcache_t *rcache, ucs_pgt_addr_t start,
+                                   ucs_pgt_addr_t end)
+{
+    if (rcache->memprot_cache != NULL) {
+        return ucs_memprot_cache_get(rcache->memprot_cache, start, end);
+    }
+
+    return ucs_get_mem_prot(start, end);
+}
+
 /* Lock must be held */
 static ucs_status_t
 ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
@@ -377,6 +547,7 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
 {
     ucs_rcache_region_t *region, *tmp;
     ucs_list_link_t region_list;
+    ucs_pgt_addr_t from, to;
     int mem_prot;
 
     ucs_trace_func("rcache=%s, *start=0x%lx, *end=0x%lx", rcache->name, *start,
@@ -384,7 +555,16 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
 
     ucs_rcache_check_inv_queue(rcache);
 
-    ucs_rcache_find_regions(rcache, *start, *end - 1, &region_list);
+    if (rcache->params.flags & UCS_RCACHE_FLAG_MERGE_ADJACENT) {
+        /* Also find the regions which end at 'start' or begin at 'end' */
+        from = (*start > 0) ? (*start - 1) : 0;
+        to   = *end;
+    } else {
+        from = *start;
+        to   = *end - 1;
+    }
+
+    ucs_rcache_find_regions(rcache, from, to, &region_list);
 
     /* TODO check if any of the regions is locked */
 
@@ -395,6 +575,7 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
         {
             /* Found a region which contains the given address range */
             ucs_rcache_region_hold(rcache, region);
+            ucs_rcache_region_lru_get(rcache, region);
             *region_p = region;
             return UCS_ERR_ALREADY_EXISTS;
         }
@@ -408,13 +589,14 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
          * the next time.
          */
         if (!ucs_test_all_flags(*prot, region->prot)) {
-            /* A slow path because searching /proc/maps in order to
-             * check memory protection is very expensive.
+            /* A slow path because checking memory protection may require
+             * searching /proc/maps, which is very expensive.
              *
              * TODO: currently rcache is optimized for the case where most of
              * the regions have same protection.
              */
-            mem_prot = UCS_PROFILE_CALL(ucs_get_mem_prot, *start, *end);
+            mem_prot = UCS_PROFILE_CALL(ucs_rcache_get_mem_prot, rcache,
+                                        *start, *end);
             if (!ucs_test_all_flags(mem_prot, *prot)) {
                 ucs_rcache_region_trace(rcache, region,
                                         "do not merge "UCS_RCACHE_PROT_FMT
@@ -516,6 +698,9 @@ retry:
         goto out_unlock;
     }
 
+    ++rcache->num_regions;
+    rcache->total_size += end - start;
+
     /* If memory registration failed, keep the region and mark it as invalid,
      * to avoid numerous retries of registering the region.
      */
@@ -543,6 +728,11 @@ retry:
         } else {
             ucs_debug("failed to register region " UCS_PGT_REGION_FMT ": %s",
                       UCS_PGT_REGION_ARG(&region->super), ucs_status_string(status));
+            if (ucs_rcache_lru_is_enabled(rcache)) {
+                /* Nobody uses the invalid region, so it may be evicted */
+                ucs_rcache_region_lru_add(rcache, region);
+                ucs_rcache_lru_evict(rcache);
+            }
             goto out_unlock;
         }
     }
@@ -560,6 +750,9 @@ retry:
 
     ucs_rcache_region_trace(rcache, region, "created");
 
+    /* The new region is held by the user, so it will not be evicted */
+    ucs_rcache_lru_evict(rcache);
+
 out_set_region:
     *region_p = region;
 out_unlock:
@@ -594,6 +787,7 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
                 ucs_rcache_region_test(region, prot))
             {
                 ucs_rcache_region_hold(rcache, region);
+                ucs_rcache_region_lru_get(rcache, region);
                 ucs_rcache_region_validate_pfn(rcache, region);
                 *region_p = region;
                 UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_HITS_FAST, 1);
@@ -615,10 +809,31 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
 
 void ucs_rcache_region_put(ucs_rcache_t *rcache, ucs_rcache_region_t *region)
 {
+    /* Must be done before releasing the reference, since afterwards the region
+     * could be destroyed by another thread */
+    if (ucs_rcache_lru_is_enabled(rcache) &&
+        (region->flags & UCS_RCACHE_REGION_FLAG_PGTABLE)) {
+        ucs_rcache_region_lru_add(rcache, region);
+    }
+
     ucs_rcache_region_put_internal(rcache, region, 1, 0);
     UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_PUTS, 1);
 }
 
+static void ucs_rcache_dereg_thread_stop(ucs_rcache_t *rcache)
+{
+    if (!(rcache->params.flags & UCS_RCACHE_FLAG_ASYNC_DEREG)) {
+        return;
+    }
+
+    /* The thread deregisters all pending regions before exiting */
+    pthread_mutex_lock(&rcache->dereg.lock);
+    rcache->dereg.stop = 1;
+    pthread_cond_signal(&rcache->dereg.cond);
+    pthread_mutex_unlock(&rcache->dereg.lock);
+    pthread_join(rcache->dereg.thread, NULL);
+}
+
 static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
                            const char *name, ucs_stats_node_t *stats_parent)
 {
@@ -669,10 +884,17 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
         goto err_destroy_rwlock;
     }
 
+    ret = pthread_spin_init(&self->lru.lock, 0);
+    if (ret) {
+        ucs_error("pthread_spin_init() failed: %m");
+        status = UCS_ERR_INVALID_PARAM;
+        goto err_destroy_inv_q_lock;
+    }
+
     status = ucs_pgtable_init(&self->pgtable, ucs_rcache_pgt_dir_alloc,
                               ucs_rcache_pgt_dir_release);
     if (status != UCS_OK) {
-        goto err_destroy_inv_q_lock;
+        goto err_destroy_lru_lock;
     }
 
     status = ucs_mpool_init(&self->inv_mp, 0, sizeof(ucs_rcache_inv_entry_t), 0,
@@ -682,19 +904,54 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
     }
 
     ucs_queue_head_init(&self->inv_q);
+    ucs_list_head_init(&self->lru.list);
+    self->num_regions = 0;
+    self->total_size  = 0;
+
+    ucs_list_head_init(&self->dereg.list);
+    self->dereg.stop = 0;
+    pthread_mutex_init(&self->dereg.lock, NULL);
+    pthread_cond_init(&self->dereg.cond, NULL);
+
+    if (params->flags & UCS_RCACHE_FLAG_ASYNC_DEREG) {
+        ret = pthread_create(&self->dereg.thread, NULL,
+                             ucs_rcache_dereg_thread_func, self);
+        if (ret) {
+            ucs_error("pthread_create() returned %d: %m", ret);
+            status = UCS_ERR_IO_ERROR;
+            goto err_destroy_dereg_lock;
+        }
+    }
 
     status = ucm_set_event_handler(params->ucm_events, params->ucm_event_priority,
                                    ucs_rcache_unmapped_callback, self);
     if (status != UCS_OK) {
-        goto err_destroy_mp;
+        goto err_stop_dereg_thread;
+    }
+
+    self->memprot_cache = NULL;
+    if (params->flags & UCS_RCACHE_FLAG_MEMPROT_CACHE) {
+        status = ucs_memprot_cache_get_shared(&self->memprot_cache);
+        if (status != UCS_OK) {
+            ucs_warn("%s: failed to create memory protection cache (%s), "
+                     "will read /proc/self/maps instead", self->name,
+                     ucs_status_string(status));
+            self->memprot_cache = NULL;
+        }
     }
 
     return UCS_OK;
 
-err_destroy_mp:
+err_stop_dereg_thread:
+    ucs_rcache_dereg_thread_stop(self);
+err_destroy_dereg_lock:
+    pthread_cond_destroy(&self->dereg.cond);
+    pthread_mutex_destroy(&self->dereg.lock);
     ucs_mpool_cleanup(&self->inv_mp, 1);
 err_cleanup_pgtable:
     ucs_pgtable_cleanup(&self->pgtable);
+err_destroy_lru_lock:
+    pthread_spin_destroy(&self->lru.lock);
 err_destroy_inv_q_lock:
     pthread_spin_destroy(&self->inv_lock);
 err_destroy_rwlock:
@@ -711,11 +968,18 @@ static UCS_CLASS_CLEANUP_FUNC(ucs_rcache_t)
 {
     ucm_unset_event_handler(self->params.ucm_events, ucs_rcache_unmapped_callback,
                             self);
+    if (self->memprot_cache != NULL) {
+        ucs_memprot_cache_put_shared(self->memprot_cache);
+    }
     ucs_rcache_check_inv_queue(self);
     ucs_rcache_purge(self);
+    ucs_rcache_dereg_thread_stop(self);
 
     ucs_mpool_cleanup(&self->inv_mp, 1);
     ucs_pgtable_cleanup(&self->pgtable);
+    pthread_cond_destroy(&self->dereg.cond);
+    pthread_mutex_destroy(&self->dereg.lock);
+    pthread_spin_destroy(&self->lru.lock);
     pthread_spin_destroy(&self->inv_lock);
     pthread_rwlock_destroy(&self->lock);
     UCS_STATS_NODE_FREE(self->stats);
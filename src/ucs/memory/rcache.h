@@ -39,6 +39,30 @@ enum {
     UCS_RCACHE_REGION_FLAG_PGTABLE    = UCS_BIT(1)  /**< In the page table */
 };
 
+/*
+ * Registration cache flags.
+ */
+enum {
+    UCS_RCACHE_FLAG_ASYNC_DEREG       = UCS_BIT(0), /**< Deregister invalidated
+                                                         regions in batches by a
+                                                         background thread */
+    UCS_RCACHE_FLAG_MERGE_ADJACENT    = UCS_BIT(1), /**< Merge a new region with
+                                                         adjacent regions, not only
+                                                         with overlapping ones */
+    UCS_RCACHE_FLAG_MEMPROT_CACHE     = UCS_BIT(2)  /**< Check memory protection
+                                                         with the process-wide
+                                                         memory protection cache,
+                                                         instead of reading
+                                                         /proc/self/maps */
+};
+
+/*
+ * LRU flags of a memory region.
+ */
+enum {
+    UCS_RCACHE_LRU_FLAG_IN_LRU        = UCS_BIT(0)  /**< Region is on the LRU list */
+};
+
 /*
  * Memory registration flags.
  */
@@ -78,6 +102,9 @@ struct ucs_rcache_ops {
     * @param [in]  context    User context, as passed to @ref ucs_rcache_create
     * @param [in]  rcache     Pointer to the registration cache.
     * @param [in]  region     Memory region to deregister.
+    *
+    * @note If @ref UCS_RCACHE_FLAG_ASYNC_DEREG is set, this function is called
+    *       from a background thread, without holding the registration cache lock.
     */
     void                   (*mem_dereg)(void *context, ucs_rcache_t *rcache,
                                         ucs_rcache_region_t *region);
@@ -113,17 +140,28 @@ struct ucs_rcache_params {
     const ucs_rcache_ops_t *ops;                /**< Memory operations functions */
     void                   *context;            /**< User-defined context that will
                                                      be passed to mem_reg/mem_dereg */
+    unsigned long          max_regions;         /**< Maximal number of regions in the
+                                                     cache. Unused regions are evicted
+                                                     in LRU order when it's exceeded */
+    size_t                 max_size;            /**< Maximal total size of regions in
+                                                     the cache, in bytes. Unused regions
+                                                     are evicted in LRU order when it's
+                                                     exceeded */
+    unsigned               flags;               /**< Registration cache flags,
+                                                     UCS_RCACHE_FLAG_xx */
 };
 
 
 struct ucs_rcache_region {
     ucs_pgt_region_t       super;    /**< Base class - page table region */
     ucs_list_link_t        list;     /**< List element */
+    ucs_list_link_t        lru_list; /**< LRU list element */
     volatile uint32_t      refcount; /**< Reference count, including +1 if it's
                                           in the page table */
     ucs_status_t           status;   /**< Current status code */
     uint8_t                prot;     /**< Protection bits */
     uint16_t               flags;    /**< Status flags. Protected by page table lock. */
+    uint8_t                lru_flags;/**< LRU flags. Protected by LRU lock. */
     uint64_t               priv;     /**< Used internally */
 };
 
@@ -7,6 +7,8 @@
 #ifndef UCS_REG_CACHE_INT_H_
 #define UCS_REG_CACHE_INT_H_
 
+#include "memprot_cache.h"
+
 /* Names of rcache stats counters */
 enum {
     UCS_RCACHE_GETS,                /* number of get operations */
@@ -20,6 +22,8 @@ enum {
     UCS_RCACHE_PUTS,                /* number of put operations */
     UCS_RCACHE_REGS,                /* number of memory registrations */
     UCS_RCACHE_DEREGS,              /* number of memory deregistrations */
+    UCS_RCACHE_EVICTS,              /* number of regions evicted because of
+                                       cache limits */
     UCS_RCACHE_STAT_LAST
 };
 
@@ -40,6 +44,29 @@ struct ucs_rcache {
                                           since we cannot use regulat malloc().
                                           The backing storage is original mmap()
                                           which does not generate memory events */
+    struct {
+        pthread_spinlock_t lock;     /**< Lock for LRU list. This is a separate
+                                          lock because the fast path of get()
+                                          holds the page table lock for read */
+        ucs_list_link_t    list;     /**< List of regions, sorted by usage:
+                                          the least recently used is first */
+    } lru;
+
+    struct {
+        pthread_t          thread;   /**< Background deregistration thread */
+        pthread_mutex_t    lock;     /**< Protects the list and stop flag */
+        pthread_cond_t     cond;     /**< Signaled when regions are added */
+        ucs_list_link_t    list;     /**< Regions pending deregistration */
+        int                stop;     /**< Thread should exit when list is empty */
+    } dereg;
+
+    ucs_memprot_cache_t    *memprot_cache; /**< Memory protection cache, or
+                                                NULL if /proc/self/maps should
+                                                be used */
+
+    unsigned long          num_regions; /**< Number of regions in the page table */
+    size_t                 total_size;  /**< Total size of regions in the page
+                                             table */
     char                   *name;
     UCS_STATS_NODE_DECLARE(stats);
 };
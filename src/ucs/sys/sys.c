@@ -478,6 +478,27 @@ size_t ucs_get_phys_mem_size()
     return phys_mem_size;
 }
 
+size_t ucs_get_llc_size()
+{
+    static const int names[] = {_SC_LEVEL3_CACHE_SIZE, _SC_LEVEL2_CACHE_SIZE};
+    static ssize_t llc_size  = -1;
+    unsigned i;
+    long value;
+
+    if (llc_size < 0) {
+        llc_size = 0;
+        for (i = 0; i < ucs_static_array_size(names); ++i) {
+            value = ucs_sysconf(names[i]);
+            if (value > 0) {
+                llc_size = value;
+                break;
+            }
+        }
+        ucs_debug("last-level cache size: %zd", llc_size);
+    }
+    return llc_size;
+}
+
 #define UCS_SYS_THP_ENABLED_FILE "/sys/kernel/mm/transparent_hugepage/enabled"
 int ucs_is_thp_enabled()
 {
@@ -181,6 +181,12 @@ size_t ucs_get_memfree_size();
 size_t ucs_get_phys_mem_size();
 
 
+/**
+ * @return Size of the last-level CPU cache, or 0 if unknown.
+ */
+size_t ucs_get_llc_size();
+
+
 /**
  * Allocate shared memory using SystemV API.
  *
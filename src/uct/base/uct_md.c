@@ -12,6 +12,7 @@
 #include <uct/api/uct.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
+#include <ucs/memory/rcache.h>
 #include <ucs/type/class.h>
 #include <ucs/sys/module.h>
 #include <ucs/sys/string.h>
@@ -38,6 +39,32 @@ ucs_config_field_t uct_md_config_rcache_table[] = {
          "between "UCS_PP_MAKE_STRING(UCS_PGT_ADDR_ALIGN)"and system page size",
      ucs_offsetof(uct_md_rcache_config_t, alignment), UCS_CONFIG_TYPE_UINT},
 
+    {"RCACHE_MAX_REGIONS", "inf",
+     "Maximal number of regions in the registration cache. When exceeded,\n"
+     "least recently used regions which are not in use are deregistered.",
+     ucs_offsetof(uct_md_rcache_config_t, max_regions), UCS_CONFIG_TYPE_ULUNITS},
+
+    {"RCACHE_MAX_SIZE", "inf",
+     "Maximal total size of registration cache regions. When exceeded,\n"
+     "least recently used regions which are not in use are deregistered.",
+     ucs_offsetof(uct_md_rcache_config_t, max_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+    {"RCACHE_ASYNC_DEREG", "n",
+     "Deregister invalidated regions in batches by a background thread, instead\n"
+     "of deregistering them during the next registration cache access.",
+     ucs_offsetof(uct_md_rcache_config_t, async_dereg), UCS_CONFIG_TYPE_BOOL},
+
+    {"RCACHE_MERGE_ADJACENT", "n",
+     "Merge a new registration cache region with adjacent regions, so fewer and\n"
+     "larger memory registrations are used.",
+     ucs_offsetof(uct_md_rcache_config_t, merge_adjacent), UCS_CONFIG_TYPE_BOOL},
+
+    {"RCACHE_MEMPROT_CACHE", "n",
+     "Keep the memory protection of the process address space up to date by\n"
+     "memory events, instead of reading /proc/self/maps when the registration\n"
+     "cache checks it. This installs a process-wide mprotect() hook.",
+     ucs_offsetof(uct_md_rcache_config_t, memprot_cache), UCS_CONFIG_TYPE_BOOL},
+
     {NULL}
 };
 
@@ -226,6 +253,13 @@ ucs_status_t uct_single_md_resource(uct_md_component_t *mdc,
     return UCS_OK;
 }
 
+unsigned uct_md_rcache_config_flags(const uct_md_rcache_config_t *config)
+{
+    return (config->async_dereg    ? UCS_RCACHE_FLAG_ASYNC_DEREG    : 0) |
+           (config->merge_adjacent ? UCS_RCACHE_FLAG_MERGE_ADJACENT : 0) |
+           (config->memprot_cache  ? UCS_RCACHE_FLAG_MEMPROT_CACHE  : 0);
+}
+
 ucs_status_t uct_md_stub_rkey_unpack(uct_md_component_t *mdc,
                                      const void *rkey_buffer, uct_rkey_t *rkey_p,
                                      void **handle_p)
@@ -44,6 +44,11 @@ typedef struct uct_md_rcache_config {
     size_t               alignment;    /**< Force address alignment */
     unsigned             event_prio;   /**< Memory events priority */
     double               overhead;     /**< Lookup overhead estimation */
+    unsigned long        max_regions;  /**< Maximal number of cached regions */
+    size_t               max_size;     /**< Maximal total size of cached regions */
+    int                  async_dereg;  /**< Deregister in a background thread */
+    int                  merge_adjacent; /**< Merge adjacent regions */
+    int                  memprot_cache;  /**< Use the memory protection cache */
 } uct_md_rcache_config_t;
 
 extern ucs_config_field_t uct_md_config_rcache_table[];
@@ -171,6 +176,11 @@ ucs_status_t uct_single_md_resource(uct_md_component_t *mdc,
                                     uct_md_resource_desc_t **resources_p,
                                     unsigned *num_resources_p);
 
+/**
+ * Get registration cache flags from registration cache configuration.
+ */
+unsigned uct_md_rcache_config_flags(const uct_md_rcache_config_t *config);
+
 /**
  * @brief Dummy function
  * Dummy function to emulate unpacking a remote key buffer to handle.
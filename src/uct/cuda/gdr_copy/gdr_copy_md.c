@@ -394,6 +394,9 @@ static ucs_status_t uct_gdr_copy_md_open(const char *md_name,
         rcache_params.ucm_event_priority = md_config->rcache.event_prio;
         rcache_params.context            = md;
         rcache_params.ops                = &uct_gdr_copy_rcache_ops;
+        rcache_params.max_regions        = md_config->rcache.max_regions;
+        rcache_params.max_size           = md_config->rcache.max_size;
+        rcache_params.flags              = uct_md_rcache_config_flags(&md_config->rcache);
         status = ucs_rcache_create(&rcache_params, "gdr_copy", NULL, &md->rcache);
         if (status == UCS_OK) {
             md->super.ops         = &md_rcache_ops;
@@ -0,0 +1,196 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include <vector>
+
+#include "ucp_test.h"
+
+extern "C" {
+#include <ucp/api/ucpx.h>
+}
+
+
+class test_ucp_am : public ucp_test {
+public:
+    static ucp_params_t get_ctx_params() {
+        ucp_params_t params = ucp_test::get_ctx_params();
+        params.field_mask  |= UCP_PARAM_FIELD_FEATURES;
+        params.features     = UCP_FEATURE_EXPERIMENTAL;
+        return params;
+    }
+
+    virtual void init() {
+        ucp_test::init();
+        sender().connect(&receiver(), get_ep_params());
+        if (!is_loopback()) {
+            receiver().connect(&sender(), get_ep_params());
+        }
+
+        m_recv_count = 0;
+        m_keep_data  = false;
+        m_reply_ep   = NULL;
+    }
+
+    static void send_cb(void *request, ucs_status_t status) {}
+
+    static ucs_status_t am_cb(void *arg, void *data, size_t length,
+                              ucp_ep_h reply_ep, unsigned flags) {
+        test_ucp_am *self = reinterpret_cast<test_ucp_am*>(arg);
+        const char  *p    = reinterpret_cast<const char*>(data);
+
+        self->m_recv_data.assign(p, p + length);
+        self->m_reply_ep = reply_ep;
+        ++self->m_recv_count;
+
+        if (self->m_keep_data && (flags & UCP_CB_PARAM_FLAG_DATA)) {
+            self->m_kept_data.push_back(data);
+            return UCS_INPROGRESS;
+        }
+
+        return UCS_OK;
+    }
+
+protected:
+    static const uint16_t AM_ID = 5;
+
+    void set_handler(entity &e, uint32_t flags = UCP_AM_FLAG_WHOLE_MSG) {
+        ucs_status_t status = ucp_worker_set_am_handler(e.worker(), AM_ID,
+                                                        am_cb, this, flags);
+        ASSERT_UCS_OK(status);
+    }
+
+    void send_am(ucp_ep_h ep, const std::vector<char> &buf, unsigned flags) {
+        void *sreq = ucp_am_send_nb(ep, AM_ID, &buf[0], buf.size(),
+                                    ucp_dt_make_contig(1), send_cb, flags);
+        ASSERT_UCS_PTR_OK(sreq);
+        wait(sreq);
+    }
+
+    void wait_recv(unsigned count) {
+        ucs_time_t deadline = ucs_get_time() +
+                              ucs_time_from_sec(10.0) *
+                              ucs::test_time_multiplier();
+        while ((m_recv_count < count) && (ucs_get_time() < deadline)) {
+            progress();
+        }
+        ASSERT_EQ(count, m_recv_count);
+    }
+
+    void do_send_recv(size_t size, unsigned flags) {
+        std::vector<char> sbuf(size);
+        ucs::fill_random(sbuf);
+
+        set_handler(receiver());
+        send_am(sender().ep(), sbuf, flags);
+        wait_recv(1);
+
+        EXPECT_EQ(sbuf, m_recv_data);
+        if (flags & UCP_AM_SEND_REPLY) {
+            EXPECT_TRUE(m_reply_ep != NULL);
+        } else {
+            EXPECT_TRUE(m_reply_ep == NULL);
+        }
+    }
+
+    void test_sizes(unsigned flags) {
+        /* short, bcopy, multi-fragment and rendezvous sizes */
+        const size_t max_size = 1024 * 1024 + 7;
+
+        for (size_t size = 0; size <= max_size;
+             size = (size == 0) ? 1 : (size * 8 + 7)) {
+            m_recv_count = 0;
+            do_send_recv(size, flags);
+        }
+    }
+
+    unsigned             m_recv_count;
+    std::vector<char>    m_recv_data;
+    bool                 m_keep_data;
+    std::vector<void*>   m_kept_data;
+    ucp_ep_h             m_reply_ep;
+};
+
+UCS_TEST_P(test_ucp_am, send_recv) {
+    test_sizes(0);
+}
+
+UCS_TEST_P(test_ucp_am, send_recv_reply) {
+    test_sizes(UCP_AM_SEND_REPLY);
+
+    /* Reply back on the endpoint which was passed to the callback */
+    std::vector<char> sbuf(100);
+    ucs::fill_random(sbuf);
+
+    ucp_ep_h reply_ep = m_reply_ep;
+    m_recv_count      = 0;
+    set_handler(sender());
+    send_am(reply_ep, sbuf, 0);
+    wait_recv(1);
+    EXPECT_EQ(sbuf, m_recv_data);
+}
+
+UCS_TEST_P(test_ucp_am, keep_data) {
+    m_keep_data = true;
+    test_sizes(0);
+
+    /* Data which was kept by the callback must remain valid until released */
+    EXPECT_FALSE(m_kept_data.empty());
+    for (size_t i = 0; i < m_kept_data.size(); ++i) {
+        ucp_am_data_release(receiver().worker(), m_kept_data[i]);
+    }
+}
+
+UCS_TEST_P(test_ucp_am, no_handler) {
+    std::vector<char> sbuf(1000);
+
+    {
+        scoped_log_handler slh(hide_warns_logger);
+        send_am(sender().ep(), sbuf, 0);
+        short_progress_loop();
+    }
+
+    EXPECT_EQ(0u, m_recv_count);
+}
+
+UCS_TEST_P(test_ucp_am, no_whole_msg) {
+    std::vector<char> small_buf(100), large_buf(256 * 1024);
+    ucs::fill_random(small_buf);
+    ucs::fill_random(large_buf);
+
+    /* Without UCP_AM_FLAG_WHOLE_MSG only single fragment messages arrive */
+    set_handler(receiver(), 0);
+    {
+        scoped_log_handler slh(hide_warns_logger);
+        send_am(sender().ep(), large_buf, 0);
+        short_progress_loop();
+    }
+    EXPECT_EQ(0u, m_recv_count);
+
+    send_am(sender().ep(), small_buf, 0);
+    wait_recv(1);
+    EXPECT_EQ(small_buf, m_recv_data);
+
+    /* Dropped fragments must not be mixed with the next message */
+    set_handler(receiver());
+    send_am(sender().ep(), large_buf, 0);
+    wait_recv(2);
+    EXPECT_EQ(large_buf, m_recv_data);
+}
+
+UCS_TEST_P(test_ucp_am, invalid_flags) {
+    char buf[8];
+
+    scoped_log_handler slh(hide_errors_logger);
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED,
+              ucp_worker_set_am_handler(receiver().worker(), AM_ID, am_cb,
+                                        this, UCS_BIT(7)));
+    EXPECT_EQ(UCS_ERR_INVALID_PARAM,
+              UCS_PTR_STATUS(ucp_am_send_nb(sender().ep(), AM_ID, buf,
+                                            sizeof(buf), ucp_dt_make_contig(1),
+                                            send_cb, UCS_BIT(7))));
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_am)
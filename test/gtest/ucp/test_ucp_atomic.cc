@@ -102,6 +102,43 @@ void test_ucp_atomic::nb_post(entity *e,  size_t max_size, void *memheap_addr,
     *(T*)&expected_data[0] = atomic_op_val<T, OP>(val, prev);
 }
 
+template <typename T, ucp_atomic_post_op_t OP>
+void test_ucp_atomic::nb_post_multi(entity *e,  size_t max_size,
+                                    void *memheap_addr, ucp_rkey_h rkey,
+                                    std::string& expected_data)
+{
+    const size_t count = ucs_min(max_size / sizeof(T), 16ul);
+    T *remote          = (T*)memheap_addr;
+    std::vector<T> expected(remote, remote + count);
+    ucs_status_t status;
+    void *amo_req;
+    size_t index;
+    T val, result;
+
+    /* Many posts on a few addresses, followed by a fetch which must observe
+     * all of them */
+    for (int i = 0; i < 100; ++i) {
+        index  = ucs::rand() % count;
+        val    = (T)ucs::rand() * (T)ucs::rand();
+        status = test_ucp_atomic::ucp_atomic_post_nbi<T>(e->ep(), OP, val,
+                                                          &remote[index], rkey);
+        ASSERT_UCS_OK(status);
+        expected[index] = atomic_op_val<T, OP>(val, expected[index]);
+    }
+
+    index   = ucs::rand() % count;
+    amo_req = test_ucp_atomic::ucp_atomic_fetch<T>(e->ep(),
+                                                   UCP_ATOMIC_FETCH_OP_FADD,
+                                                   0, &result, &remote[index],
+                                                   rkey);
+    if (UCS_PTR_IS_PTR(amo_req)) {
+        wait(amo_req);
+    }
+    EXPECT_EQ(expected[index], result);
+
+    expected_data.assign((const char*)&expected[0], count * sizeof(T));
+}
+
 template <ucp_atomic_post_op_t OP>
 void test_ucp_atomic::unaligned_nb_post(entity *e,  size_t max_size,
                                         void *memheap_addr, ucp_rkey_h rkey,
@@ -350,3 +387,77 @@ UCS_TEST_P(test_ucp_atomic64, unaligned_atomic_xor_nb) {
 #endif
 
 UCP_INSTANTIATE_TEST_CASE(test_ucp_atomic64)
+
+
+class test_ucp_atomic_sw_batch : public test_ucp_atomic {
+public:
+    static ucp_params_t get_ctx_params() {
+        ucp_params_t params = ucp_test::get_ctx_params();
+        params.features |= UCP_FEATURE_AMO32 | UCP_FEATURE_AMO64;
+        return params;
+    }
+
+    virtual void init() {
+        modify_config("AMO_SW_BATCH", "8");
+        test_ucp_atomic::init();
+    }
+
+    void nb_post_overlap(entity *e,  size_t max_size, void *memheap_addr,
+                         ucp_rkey_h rkey, std::string& expected_data)
+    {
+        uint64_t add        = UCS_BIT(32) + ucs::rand() % 1000 + 1;
+        uint64_t expected   = *(uint64_t*)memheap_addr;
+        uintptr_t remote    = (uintptr_t)memheap_addr;
+        uint32_t *expected_half;
+        ucs_status_t status;
+
+        /* the second add must not be combined with the first one, since
+         * the and on a half of the value was posted between them */
+        status = ucp_atomic_post(e->ep(), UCP_ATOMIC_POST_OP_ADD, add,
+                                 sizeof(uint64_t), remote, rkey);
+        ASSERT_UCS_OK(status);
+        expected += add;
+
+        status = ucp_atomic_post(e->ep(), UCP_ATOMIC_POST_OP_AND, 0,
+                                 sizeof(uint32_t), remote + sizeof(uint32_t),
+                                 rkey);
+        ASSERT_UCS_OK(status);
+        expected_half  = (uint32_t*)&expected + 1;
+        *expected_half = 0;
+
+        status = ucp_atomic_post(e->ep(), UCP_ATOMIC_POST_OP_ADD, add,
+                                 sizeof(uint64_t), remote, rkey);
+        ASSERT_UCS_OK(status);
+        expected += add;
+
+        expected_data.assign((const char*)&expected, sizeof(expected));
+    }
+};
+
+UCS_TEST_P(test_ucp_atomic_sw_batch, atomic_add32_multi) {
+    test<uint32_t>(&test_ucp_atomic::nb_post_multi<uint32_t, UCP_ATOMIC_POST_OP_ADD>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic_sw_batch, atomic_xor32_multi) {
+    test<uint32_t>(&test_ucp_atomic::nb_post_multi<uint32_t, UCP_ATOMIC_POST_OP_XOR>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic_sw_batch, atomic_add64_multi) {
+    test<uint64_t>(&test_ucp_atomic::nb_post_multi<uint64_t, UCP_ATOMIC_POST_OP_ADD>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic_sw_batch, atomic_or64_multi) {
+    test<uint64_t>(&test_ucp_atomic::nb_post_multi<uint64_t, UCP_ATOMIC_POST_OP_OR>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic_sw_batch, atomic_add64_flush_ep) {
+    test_blocking_xfer(static_cast<blocking_send_func_t>(&test_ucp_atomic::nb_post<uint64_t, UCP_ATOMIC_POST_OP_ADD>),
+                       DEFAULT_SIZE, DEFAULT_ITERS, sizeof(uint64_t), false,
+                       true);
+}
+
+UCS_TEST_P(test_ucp_atomic_sw_batch, atomic_post_overlap) {
+    test<uint64_t>(&test_ucp_atomic_sw_batch::nb_post_overlap, false);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_atomic_sw_batch)
@@ -45,6 +45,10 @@ public:
     void nb_post(entity *e,  size_t max_size, void *memheap_addr,
                  ucp_rkey_h rkey, std::string& expected_data);
 
+    template <typename T, ucp_atomic_post_op_t OP>
+    void nb_post_multi(entity *e,  size_t max_size, void *memheap_addr,
+                       ucp_rkey_h rkey, std::string& expected_data);
+
     template <typename T, ucp_atomic_fetch_op_t FOP>
     void nb_fetch(entity *e,  size_t max_size, void *memheap_addr,
                   ucp_rkey_h rkey, std::string& expected_data);
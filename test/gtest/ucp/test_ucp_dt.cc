@@ -46,3 +46,130 @@ UCS_TEST_F(test_ucp_dt_iov, seek)
         }
     }
 }
+
+class test_ucp_dt_strided : public ucs::test {
+protected:
+    /* Offsets of the blocks in the buffer, in packed order */
+    static std::vector<size_t>
+    block_offsets(size_t blocklength, const ucp_dt_strided_level_t *levels,
+                  unsigned num_levels, size_t count) {
+        std::vector<size_t> offsets(1, 0);
+        size_t extent = blocklength;
+
+        for (unsigned l = 0; l < num_levels; ++l) {
+            std::vector<size_t> level_offsets;
+            for (size_t i = 0; i < levels[l].count; ++i) {
+                for (size_t j = 0; j < offsets.size(); ++j) {
+                    level_offsets.push_back(offsets[j] + i * levels[l].stride);
+                }
+            }
+            offsets.swap(level_offsets);
+            extent = levels[l].count * levels[l].stride;
+        }
+
+        std::vector<size_t> result;
+        for (size_t elem = 0; elem < count; ++elem) {
+            for (size_t j = 0; j < offsets.size(); ++j) {
+                result.push_back(elem * extent + offsets[j]);
+            }
+        }
+        return result;
+    }
+
+    /* Random non-overlapping layout */
+    static unsigned random_layout(size_t *blocklength,
+                                  ucp_dt_strided_level_t *levels) {
+        unsigned num_levels = ucs::rand() % (UCP_DT_STRIDED_MAX_LEVELS + 1);
+        size_t span         = *blocklength = (ucs::rand() % 40) + 1;
+
+        for (unsigned l = 0; l < num_levels; ++l) {
+            levels[l].count  = (ucs::rand() % 4) + 1;
+            levels[l].stride = span + (ucs::rand() % 3) * (ucs::rand() % 16);
+            span             = levels[l].count * levels[l].stride;
+        }
+        return num_levels;
+    }
+};
+
+UCS_TEST_F(test_ucp_dt_strided, pack_unpack) {
+    for (int iter = 0; iter < 200; ++iter) {
+        ucp_dt_strided_level_t levels[UCP_DT_STRIDED_MAX_LEVELS];
+        size_t blocklength;
+        unsigned num_levels = random_layout(&blocklength, levels);
+        size_t count        = (ucs::rand() % 3) + 1;
+        ucp_datatype_t dt;
+
+        ASSERT_UCS_OK(ucp_dt_create_strided(blocklength, levels, num_levels,
+                                            &dt));
+
+        std::vector<size_t> offsets = block_offsets(blocklength, levels,
+                                                    num_levels, count);
+        size_t length = offsets.size() * blocklength;
+        ASSERT_EQ(length, ucp_dt_strided_length(dt, count));
+        ASSERT_EQ(offsets.back() + blocklength, ucp_dt_strided_span(dt, length));
+
+        std::vector<char> buffer(offsets.back() + blocklength);
+        std::vector<char> packed(length), expected;
+        ucs::fill_random(buffer);
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            expected.insert(expected.end(), &buffer[offsets[i]],
+                            &buffer[offsets[i]] + blocklength);
+        }
+
+        /* pack in random fragments */
+        size_t offset = 0;
+        while (offset < length) {
+            size_t frag = ucs_min((size_t)(ucs::rand() % 100) + 1, length - offset);
+            ucp_dt_strided_gather(&packed[offset], &buffer[0], dt, offset, frag);
+            offset += frag;
+        }
+        EXPECT_EQ(expected, packed);
+
+        /* unpack in random fragments */
+        std::vector<char> unpacked(buffer.size(), 0);
+        offset = 0;
+        while (offset < length) {
+            size_t frag = ucs_min((size_t)(ucs::rand() % 100) + 1, length - offset);
+            ucp_dt_strided_scatter(&unpacked[0], dt, &packed[offset], offset,
+                                   frag);
+            offset += frag;
+        }
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            EXPECT_EQ(0, memcmp(&buffer[offsets[i]], &unpacked[offsets[i]],
+                                blocklength)) << "block " << i;
+        }
+
+        /* describe by iov */
+        const size_t max_iov = 4;
+        uct_iov_t iov[max_iov];
+        size_t iovcnt;
+        offset = ucs::rand() % length;
+        size_t iov_length = ucp_dt_strided_to_uct_iov(iov, max_iov, &buffer[0],
+                                                      dt, NULL, offset,
+                                                      length - offset, &iovcnt);
+        ASSERT_GT(iovcnt, 0u);
+        ASSERT_LE(iovcnt, max_iov);
+        std::vector<char> iov_data;
+        for (size_t i = 0; i < iovcnt; ++i) {
+            iov_data.insert(iov_data.end(), (char*)iov[i].buffer,
+                            (char*)iov[i].buffer + iov[i].length);
+        }
+        ASSERT_EQ(iov_length, iov_data.size());
+        EXPECT_TRUE(std::equal(iov_data.begin(), iov_data.end(),
+                               expected.begin() + offset));
+
+        ucp_dt_destroy(dt);
+    }
+}
+
+UCS_TEST_F(test_ucp_dt_strided, invalid_params) {
+    ucp_dt_strided_level_t levels[UCP_DT_STRIDED_MAX_LEVELS + 1] = {};
+    ucp_datatype_t dt;
+
+    scoped_log_handler slh(hide_errors_logger);
+    EXPECT_EQ(UCS_ERR_INVALID_PARAM, ucp_dt_create_strided(0, NULL, 0, &dt));
+    EXPECT_EQ(UCS_ERR_INVALID_PARAM, ucp_dt_create_strided(8, levels, 1, &dt));
+    EXPECT_EQ(UCS_ERR_INVALID_PARAM,
+              ucp_dt_create_strided(8, levels, UCP_DT_STRIDED_MAX_LEVELS + 1,
+                                    &dt));
+}
@@ -381,3 +381,103 @@ UCS_TEST_P(test_ucp_mmap, fixed) {
 }
 
 UCP_INSTANTIATE_TEST_CASE(test_ucp_mmap)
+
+
+class test_ucp_mmap_rkey_cache : public test_ucp_mmap {
+public:
+    virtual void init() {
+        modify_config("RKEY_UNPACK_CACHE", "2");
+        test_ucp_mmap::init();
+    }
+
+protected:
+    void mem_map(size_t size, ucp_mem_h *memh_p, void **rkey_buffer_p) {
+        ucp_mem_map_params_t params;
+        ucs_status_t status;
+        size_t rkey_size;
+
+        params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS |
+                            UCP_MEM_MAP_PARAM_FIELD_LENGTH |
+                            UCP_MEM_MAP_PARAM_FIELD_FLAGS;
+        params.address    = NULL;
+        params.length     = size;
+        params.flags      = UCP_MEM_MAP_ALLOCATE;
+
+        status = ucp_mem_map(sender().ucph(), &params, memh_p);
+        ASSERT_UCS_OK(status);
+
+        status = ucp_rkey_pack(sender().ucph(), *memh_p, rkey_buffer_p,
+                               &rkey_size);
+        ASSERT_UCS_OK(status);
+    }
+
+    bool is_same_packed_key(ucp_mem_h memh1, const void *rkey_buffer1,
+                            ucp_mem_h memh2, const void *rkey_buffer2) {
+        return (memh1->md_map == memh2->md_map) &&
+               !memcmp(rkey_buffer1, rkey_buffer2,
+                       ucp_rkey_packed_size(sender().ucph(), memh1->md_map));
+    }
+
+    void mem_unmap(ucp_mem_h memh, void *rkey_buffer) {
+        ucp_rkey_buffer_release(rkey_buffer);
+        ASSERT_UCS_OK(ucp_mem_unmap(sender().ucph(), memh));
+    }
+};
+
+UCS_TEST_P(test_ucp_mmap_rkey_cache, reuse) {
+    static const int num_regions = 4;
+    ucp_mem_h memh[num_regions];
+    void *rkey_buffer[num_regions];
+    ucp_rkey_h rkey1, rkey2, rkey3;
+    ucs_status_t status;
+
+    sender().connect(&sender(), get_ep_params());
+
+    for (int i = 0; i < num_regions; ++i) {
+        mem_map(4096 * (i + 1), &memh[i], &rkey_buffer[i]);
+    }
+
+    status = ucp_ep_rkey_unpack(sender().ep(), rkey_buffer[0], &rkey1);
+    if (status == UCS_ERR_UNREACHABLE) {
+        for (int i = 0; i < num_regions; ++i) {
+            mem_unmap(memh[i], rkey_buffer[i]);
+        }
+        UCS_TEST_SKIP_R("remote keys are unreachable");
+    }
+    ASSERT_UCS_OK(status);
+
+    /* Same packed key returns the same handle while it's in use */
+    ASSERT_UCS_OK(ucp_ep_rkey_unpack(sender().ep(), rkey_buffer[0], &rkey2));
+    EXPECT_EQ(rkey1, rkey2);
+    ucp_rkey_destroy(rkey1);
+    ucp_rkey_destroy(rkey2);
+
+    /* Released key is reused */
+    ASSERT_UCS_OK(ucp_ep_rkey_unpack(sender().ep(), rkey_buffer[0], &rkey2));
+    EXPECT_EQ(rkey1, rkey2);
+    EXPECT_TRUE(rkey2->cache_entry != NULL);
+
+    /* Different keys are not mixed, and released keys are evicted beyond
+     * the cache size. Transports without remote keys pack equal keys. */
+    for (int i = 1; i < num_regions; ++i) {
+        ASSERT_UCS_OK(ucp_ep_rkey_unpack(sender().ep(), rkey_buffer[i],
+                                         &rkey3));
+        if (is_same_packed_key(memh[0], rkey_buffer[0], memh[i],
+                               rkey_buffer[i])) {
+            EXPECT_EQ(rkey2, rkey3);
+        } else {
+            EXPECT_NE(rkey2, rkey3);
+        }
+        ucp_rkey_destroy(rkey3);
+    }
+
+    /* A key which is still in use is released after the endpoint is closed */
+    disconnect(sender());
+    ucp_rkey_destroy(rkey2);
+
+    for (int i = 0; i < num_regions; ++i) {
+        mem_unmap(memh[i], rkey_buffer[i]);
+    }
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_mmap_rkey_cache)
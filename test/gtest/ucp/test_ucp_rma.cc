@@ -88,6 +88,96 @@ public:
         }
     }
 
+    void nonblocking_put_nbi_multi_flush(entity *e, size_t max_size,
+                                         void *memheap_addr,
+                                         ucp_rkey_h rkey,
+                                         std::string& expected_data)
+    {
+        size_t half = expected_data.length() / 2;
+        ucs_status_t status;
+        void *req1, *req2;
+
+        /* the second of two overlapping worker flushes completes the puts
+         * issued before the first one as well */
+        status = ucp_put_nbi(e->ep(), &expected_data[0], half,
+                             (uintptr_t)memheap_addr, rkey);
+        ASSERT_UCS_OK_OR_INPROGRESS(status);
+        req1 = ucp_worker_flush_nb(e->worker(), 0, send_completion);
+        ASSERT_UCS_PTR_OK(req1);
+
+        status = ucp_put_nbi(e->ep(), &expected_data[half],
+                             expected_data.length() - half,
+                             (uintptr_t)memheap_addr + half, rkey);
+        ASSERT_UCS_OK_OR_INPROGRESS(status);
+        req2 = ucp_worker_flush_nb(e->worker(), 0, send_completion);
+        ASSERT_UCS_PTR_OK(req2);
+
+        wait(req2);
+        EXPECT_EQ(expected_data, std::string((char*)memheap_addr,
+                                             expected_data.length()));
+        wait(req1);
+    }
+
+    void wait_counter(ucp_rma_counter_h counter, uint64_t value)
+    {
+        /* progress also the receiver, to handle software RMA */
+        while (ucp_rma_counter_read(counter) < value) {
+            progress();
+        }
+        ASSERT_UCS_OK(ucp_rma_counter_wait(counter, value));
+    }
+
+    void nonblocking_put_nbc(entity *e, size_t max_size,
+                             void *memheap_addr,
+                             ucp_rkey_h rkey,
+                             std::string& expected_data)
+    {
+        ucp_rma_counter_h counter;
+        ucs_status_t status;
+
+        status = ucp_rma_counter_create(e->worker(), &counter);
+        ASSERT_UCS_OK(status);
+
+        status = ucp_put_nbc(e->ep(), &expected_data[0], expected_data.length(),
+                             (uintptr_t)memheap_addr, rkey, counter);
+        ASSERT_UCS_OK(status);
+
+        wait_counter(counter, 1);
+        ucp_rma_counter_destroy(counter);
+    }
+
+    void nonblocking_get_nbc(entity *e, size_t max_size,
+                             void *memheap_addr,
+                             ucp_rkey_h rkey,
+                             std::string& expected_data)
+    {
+        static const size_t num_frags = 4;
+        size_t length                 = expected_data.length();
+        ucp_rma_counter_h counter;
+        ucs_status_t status;
+        size_t offset, frag_length;
+
+        ucs::fill_random(memheap_addr, ucs_min(max_size, 16384U));
+
+        status = ucp_rma_counter_create(e->worker(), &counter);
+        ASSERT_UCS_OK(status);
+
+        /* the data is loaded once all fragments are counted, without a flush */
+        for (size_t i = 0; i < num_frags; ++i) {
+            offset      = (length * i) / num_frags;
+            frag_length = (length * (i + 1)) / num_frags - offset;
+            status      = ucp_get_nbc(e->ep(), &expected_data[offset],
+                                      frag_length,
+                                      (uintptr_t)memheap_addr + offset, rkey,
+                                      counter);
+            ASSERT_UCS_OK(status);
+        }
+
+        wait_counter(counter, num_frags);
+        EXPECT_EQ(std::string((char*)memheap_addr, length), expected_data);
+        ucp_rma_counter_destroy(counter);
+    }
+
     void test_message_sizes(blocking_send_func_t func, size_t *msizes, int iters, int is_nbi);
 };
 
@@ -313,4 +403,68 @@ UCS_TEST_P(test_ucp_rma, nonblocking_stream_get_nb_flush_ep) {
                        1, true, true);
 }
 
+UCS_TEST_P(test_ucp_rma, nonblocking_put_nbc) {
+    test_blocking_xfer(static_cast<blocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbc),
+                       DEFAULT_SIZE, DEFAULT_ITERS, 1, false, false);
+}
+
+UCS_TEST_P(test_ucp_rma, nonblocking_get_nbc) {
+    test_blocking_xfer(static_cast<blocking_send_func_t>(&test_ucp_rma::nonblocking_get_nbc),
+                       DEFAULT_SIZE, DEFAULT_ITERS, 1, false, false);
+}
+
+UCS_TEST_P(test_ucp_rma, nbc_large) {
+    size_t sizes[] = { 1 * MEG, 3 * MEG, 9 * MEG, 0};
+
+    test_message_sizes(static_cast<blocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbc),
+                       sizes, 3, 0);
+    test_message_sizes(static_cast<blocking_send_func_t>(&test_ucp_rma::nonblocking_get_nbc),
+                       sizes, 3, 0);
+}
+
+UCS_TEST_P(test_ucp_rma, nonblocking_put_nbi_multi_flush_worker) {
+    test_blocking_xfer(static_cast<blocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbi_multi_flush),
+                       DEFAULT_SIZE, DEFAULT_ITERS, 1, false, false);
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_rma)
+
+
+class test_ucp_rma_aggr : public test_ucp_rma {
+public:
+    virtual void init() {
+        modify_config("RMA_AGGREGATE_SIZE", "1k");
+        test_ucp_rma::init();
+    }
+};
+
+UCS_TEST_P(test_ucp_rma_aggr, stream_put_nbi_small) {
+    /* Contiguous puts are combined, and flushed when the buffer is full */
+    for (size_t size = 8; size <= 1024; size *= 4) {
+        test_nonblocking_implicit_stream_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbi),
+                                              size, DEFAULT_ITERS, 1, false,
+                                              false);
+        test_nonblocking_implicit_stream_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbi),
+                                              size, DEFAULT_ITERS, 1, false,
+                                              true);
+    }
+}
+
+UCS_TEST_P(test_ucp_rma_aggr, nbi_small) {
+    size_t sizes[] = { 8, 24, 96, 120, 250, 0};
+
+    test_message_sizes(static_cast<blocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbi),
+                       sizes, 1000, 1);
+}
+
+UCS_TEST_P(test_ucp_rma_aggr, put_nbi_flush_worker) {
+    test_blocking_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbi),
+                       DEFAULT_SIZE, DEFAULT_ITERS, 1, false, false);
+}
+
+UCS_TEST_P(test_ucp_rma_aggr, put_nbi_flush_ep) {
+    test_blocking_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_put_nbi),
+                       DEFAULT_SIZE, DEFAULT_ITERS, 1, false, true);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_rma_aggr)
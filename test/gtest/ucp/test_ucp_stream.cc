@@ -132,6 +132,7 @@ protected:
     template <typename T, unsigned recv_flags>
     void do_send_exp_recv_test(ucp_datatype_t datatype);
     void do_send_recv_data_recv_test(ucp_datatype_t datatype);
+    void do_send_rndv_interleaved_test(unsigned recv_flags, size_t post_size);
 
     /* for self-validation of generic datatype
      * NOTE: it's tested only with byte array data since it's recv completion
@@ -400,6 +401,73 @@ void test_ucp_stream::do_send_recv_data_recv_test(ucp_datatype_t datatype)
     EXPECT_EQ(check_pattern, rbuf);
 }
 
+/* Receives of @a post_size bytes are posted before sending, if it's nonzero,
+ * SIZE_MAX posts a single receive for all data */
+void test_ucp_stream::do_send_rndv_interleaved_test(unsigned recv_flags,
+                                                    size_t post_size)
+{
+    /* eager and rendezvous sizes, sent without waiting for each other */
+    const size_t        sizes_arr[] = { 10, 100000, 100, 300000, 7, 2000000,
+                                        1000 };
+    std::vector<size_t> sizes(sizes_arr, sizes_arr + 7);
+    size_t              total = std::accumulate(sizes.begin(), sizes.end(),
+                                                size_t(0));
+
+    std::vector<char> sbuf(total);
+    std::vector<char> rbuf(total, 'r');
+    ucs::fill_random(sbuf);
+
+    std::vector<void*> rreqs;
+    void               *rreq;
+    size_t             roffset = 0;
+    size_t             length;
+    if (post_size > 0) {
+        /* partial completion would break the layout of next receives */
+        ASSERT_TRUE((recv_flags & UCP_STREAM_RECV_FLAG_WAITALL) ||
+                    (post_size >= total));
+        for (size_t offset = 0; offset < total; offset += post_size) {
+            rreq = ucp_stream_recv_nb(receiver().ep(), &rbuf[offset],
+                                      std::min(post_size, total - offset),
+                                      ucp_dt_make_contig(1), ucp_recv_cb,
+                                      &length, recv_flags);
+            ASSERT_TRUE(UCS_PTR_IS_PTR(rreq));
+            rreqs.push_back(rreq);
+        }
+    }
+
+    std::vector<void*> sreqs;
+    size_t             soffset = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        void *sreq = ucp_stream_send_nb(sender().ep(), &sbuf[soffset], sizes[i],
+                                        ucp_dt_make_contig(1), ucp_send_cb, 0);
+        ASSERT_FALSE(UCS_PTR_IS_ERR(sreq));
+        sreqs.push_back(sreq);
+        soffset += sizes[i];
+    }
+
+    for (size_t i = 0; i < rreqs.size(); ++i) {
+        roffset += wait_stream_recv(rreqs[i]);
+    }
+
+    while (roffset < total) {
+        rreq = ucp_stream_recv_nb(receiver().ep(), &rbuf[roffset],
+                                  total - roffset, ucp_dt_make_contig(1),
+                                  ucp_recv_cb, &length, recv_flags);
+        ASSERT_FALSE(UCS_PTR_IS_ERR(rreq));
+        if (UCS_PTR_IS_PTR(rreq)) {
+            length = wait_stream_recv(rreq);
+        }
+        roffset += length;
+    }
+
+    for (size_t i = 0; i < sreqs.size(); ++i) {
+        wait(sreqs[i]);
+    }
+
+    EXPECT_EQ(total, roffset);
+    EXPECT_EQ(sbuf, rbuf);
+}
+
 UCS_TEST_P(test_ucp_stream, send_recv_data) {
     do_send_recv_data_test(DATATYPE);
 }
@@ -515,6 +583,40 @@ UCS_TEST_P(test_ucp_stream, send_recv_data_recv_iov) {
     do_send_recv_data_recv_test(DATATYPE_IOV);
 }
 
+UCS_TEST_P(test_ucp_stream, send_recv_data_rndv, "RNDV_THRESH=1k") {
+    do_send_recv_data_test(DATATYPE);
+}
+
+UCS_TEST_P(test_ucp_stream, send_recv_rndv, "RNDV_THRESH=1k") {
+    ucp_datatype_t datatype = ucp_dt_make_contig(sizeof(uint32_t));
+
+    do_send_recv_test<uint32_t, 0>(datatype);
+    do_send_recv_test<uint32_t, UCP_STREAM_RECV_FLAG_WAITALL>(datatype);
+}
+
+UCS_TEST_P(test_ucp_stream, send_exp_recv_rndv, "RNDV_THRESH=1k") {
+    ucp_datatype_t datatype = ucp_dt_make_contig(sizeof(uint32_t));
+
+    do_send_exp_recv_test<uint32_t, 0>(datatype);
+    do_send_exp_recv_test<uint32_t, UCP_STREAM_RECV_FLAG_WAITALL>(datatype);
+}
+
+UCS_TEST_P(test_ucp_stream, send_exp_recv_iov_rndv, "RNDV_THRESH=1k") {
+    do_send_exp_recv_test<uint8_t, 0>(DATATYPE_IOV);
+    do_send_exp_recv_test<uint8_t, UCP_STREAM_RECV_FLAG_WAITALL>(DATATYPE_IOV);
+}
+
+UCS_TEST_P(test_ucp_stream, send_recv_data_recv_rndv, "RNDV_THRESH=1k") {
+    do_send_recv_data_recv_test(ucp_dt_make_contig(sizeof(uint8_t)));
+}
+
+UCS_TEST_P(test_ucp_stream, send_rndv_interleaved, "RNDV_THRESH=1k") {
+    do_send_rndv_interleaved_test(0, 0);
+    do_send_rndv_interleaved_test(0, SIZE_MAX);
+    do_send_rndv_interleaved_test(UCP_STREAM_RECV_FLAG_WAITALL, SIZE_MAX);
+    do_send_rndv_interleaved_test(UCP_STREAM_RECV_FLAG_WAITALL, 150000);
+}
+
 UCS_TEST_P(test_ucp_stream, send_zero_ending_iov_recv_data) {
     const size_t min_size         = 1024;
     const size_t max_size         = min_size * 64;
@@ -9,6 +9,12 @@
 
 #include <common/test_helpers.h>
 
+extern "C" {
+#include <ucp/core/ucp_ep.h>
+#include <ucp/core/ucp_worker.h>
+#include <ucp/proto/proto_tune.h>
+}
+
 using namespace ucs; /* For vector<char> serialization */
 
 
@@ -414,6 +420,108 @@ UCS_TEST_P(test_ucp_tag_match, send_nb_multiple_recv_unexp) {
     }
 }
 
+UCS_TEST_P(test_ucp_tag_match, send_recv_completion_queue) {
+    const unsigned        num_requests = 16;
+    std::vector<uint64_t> send_data(num_requests);
+    std::vector<uint64_t> recv_data(num_requests + 1, 0);
+    std::map<void*, request*> reqs;
+    const unsigned        max_entries  = 4;
+    ucp_completion_t      entries[max_entries];
+    unsigned              i, count;
+
+    for (i = 0; i < num_requests; ++i) {
+        request *rreq = recv_nb(&recv_data[i], sizeof(recv_data[i]), DATATYPE,
+                                i, (ucp_tag_t)-1);
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(rreq));
+        ASSERT_UCS_OK(ucp_request_set_cookie(receiver().worker(), rreq,
+                                             &recv_data[i]));
+        reqs[&recv_data[i]] = rreq;
+    }
+
+    for (i = 0; i < num_requests; ++i) {
+        send_data[i] = i + 1;
+        request *sreq = send_nb(&send_data[i], sizeof(send_data[i]), DATATYPE,
+                                i);
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(sreq));
+        if (sreq != NULL) {
+            ASSERT_UCS_OK(ucp_request_set_cookie(sender().worker(), sreq,
+                                                 &send_data[i]));
+            reqs[&send_data[i]] = sreq;
+        }
+    }
+
+    /* unexpected message, so the receive completes before the cookie is set */
+    send_data[0] = 0xdeadbeef;
+    send_b(&send_data[0], sizeof(send_data[0]), DATATYPE, num_requests);
+    short_progress_loop();
+    request *rreq = recv_nb(&recv_data[num_requests], sizeof(uint64_t),
+                            DATATYPE, num_requests, (ucp_tag_t)-1);
+    ASSERT_TRUE(!UCS_PTR_IS_ERR(rreq));
+    EXPECT_EQ(UCS_OK, ucp_request_check_status(rreq));
+    ASSERT_UCS_OK(ucp_request_set_cookie(receiver().worker(), rreq,
+                                         &recv_data[num_requests]));
+    reqs[&recv_data[num_requests]] = rreq;
+
+    ucp_worker_h workers[] = { sender().worker(), receiver().worker() };
+    ucs_time_t deadline    = ucs::get_deadline();
+    while (!reqs.empty() && (ucs_get_time() < deadline)) {
+        progress();
+        for (unsigned w = 0; w < 2; ++w) {
+            count = ucp_worker_poll_completions(workers[w], entries,
+                                                max_entries);
+            EXPECT_LE(count, max_entries);
+            for (i = 0; i < count; ++i) {
+                ASSERT_EQ(1ul, reqs.count(entries[i].cookie));
+                EXPECT_EQ((void*)reqs[entries[i].cookie], entries[i].request);
+                EXPECT_EQ(UCS_OK, entries[i].status);
+                request_release(reqs[entries[i].cookie]);
+                reqs.erase(entries[i].cookie);
+            }
+        }
+    }
+
+    EXPECT_TRUE(reqs.empty());
+    for (i = 0; i < num_requests; ++i) {
+        EXPECT_EQ(i + 1, recv_data[i]);
+    }
+    EXPECT_EQ(0xdeadbeefu, recv_data[num_requests]);
+}
+
+UCS_TEST_P(test_ucp_tag_match, send_recv_completion_queue_release) {
+    if (GetParam().variant == RECV_REQ_EXTERNAL) {
+        UCS_TEST_SKIP_R("request release cannot be used for external requests");
+    }
+
+    uint64_t         send_data = 0x0102030405060708;
+    uint64_t         recv_data[2];
+    ucp_completion_t entry;
+
+    /* released before it completes */
+    request *rreq = recv_nb(&recv_data[0], sizeof(recv_data[0]), DATATYPE, 0,
+                            (ucp_tag_t)-1);
+    ASSERT_TRUE(!UCS_PTR_IS_ERR(rreq));
+    ASSERT_UCS_OK(ucp_request_set_cookie(receiver().worker(), rreq,
+                                         &recv_data[0]));
+    request_release(rreq);
+
+    /* released after it completes, before it is polled */
+    rreq = recv_nb(&recv_data[1], sizeof(recv_data[1]), DATATYPE, 1,
+                   (ucp_tag_t)-1);
+    ASSERT_TRUE(!UCS_PTR_IS_ERR(rreq));
+    ASSERT_UCS_OK(ucp_request_set_cookie(receiver().worker(), rreq,
+                                         &recv_data[1]));
+
+    send_b(&send_data, sizeof(send_data), DATATYPE, 0);
+    send_b(&send_data, sizeof(send_data), DATATYPE, 1);
+    wait(rreq);
+    request_release(rreq);
+
+    short_progress_loop();
+    EXPECT_EQ(0u, ucp_worker_poll_completions(receiver().worker(), &entry, 1));
+    EXPECT_EQ(send_data, recv_data[0]);
+    EXPECT_EQ(send_data, recv_data[1]);
+}
+
 UCS_TEST_P(test_ucp_tag_match, sync_send_unexp) {
     ucp_tag_recv_info_t info;
     ucs_status_t        status;
@@ -608,6 +716,114 @@ UCS_TEST_P(test_ucp_tag_match, rndv_req_exp_auto_thresh, "RNDV_THRESH=auto") {
     request_release(my_recv_req);
 }
 
+UCS_TEST_P(test_ucp_tag_match, rndv_req_exp_multi_rail, "RNDV_THRESH=1048576",
+           "MAX_RNDV_RAILS=auto") {
+    static const size_t size = 1148577;
+    request *my_send_req, *my_recv_req;
+    ucp_ep_config_t *config;
+    ucp_lane_index_t lane;
+
+    std::vector<char> sendbuf(size, 0);
+    std::vector<char> recvbuf(size, 0);
+
+    skip_loopback();
+
+    /* every rendezvous lane gets a share of the data by its bandwidth */
+    config = &sender().worker()->ep_config[sender().ep()->cfg_index];
+    for (int i = 0; (i < UCP_MAX_LANES) &&
+                    (config->key.rma_bw_lanes[i] != UCP_NULL_LANE); ++i) {
+        lane = config->key.rma_bw_lanes[i];
+        EXPECT_GT(config->tag.rndv.scale[lane], 0.0) << "lane " << (int)lane;
+        EXPECT_LE(config->tag.rndv.scale[lane], 1.0) << "lane " << (int)lane;
+        EXPECT_LT(i, (int)sender().ucph()->config.ext.max_rndv_lanes);
+    }
+
+    ucs::fill_random(sendbuf);
+
+    my_recv_req = recv_nb(&recvbuf[0], recvbuf.size(), DATATYPE, 0x1337, 0xffff);
+    ASSERT_TRUE(!UCS_PTR_IS_ERR(my_recv_req));
+
+    my_send_req = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, 0x111337);
+    ASSERT_TRUE(!UCS_PTR_IS_ERR(my_send_req));
+
+    wait(my_recv_req);
+
+    EXPECT_EQ(sendbuf.size(),      my_recv_req->info.length);
+    EXPECT_EQ((ucp_tag_t)0x111337, my_recv_req->info.sender_tag);
+    EXPECT_EQ(sendbuf, recvbuf);
+
+    wait_and_validate(my_send_req);
+    request_release(my_recv_req);
+}
+
+UCS_TEST_P(test_ucp_tag_match, eager_exp_multi_rail, "RNDV_THRESH=inf",
+           "MAX_EAGER_RAILS=auto") {
+    static const size_t size = 200000;
+    request *my_send_req, *my_recv_req;
+    ucp_ep_config_t *config;
+    int i;
+
+    std::vector<char> sendbuf(size, 0);
+    std::vector<char> recvbuf(size, 0);
+
+    skip_loopback();
+
+    /* the first lane is the AM lane, the rest are on other devices */
+    config = &sender().worker()->ep_config[sender().ep()->cfg_index];
+    EXPECT_EQ(config->key.am_lane, config->key.am_bw_lanes[0]);
+    for (i = 0; (i < UCP_MAX_LANES) &&
+                (config->key.am_bw_lanes[i] != UCP_NULL_LANE); ++i) {
+        EXPECT_LT(i, (int)sender().ucph()->config.ext.max_eager_lanes);
+    }
+
+    ucs::fill_random(sendbuf);
+
+    /* middle fragments may arrive on other lanes before the first one */
+    my_send_req = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, 0x111337);
+    ASSERT_TRUE(!UCS_PTR_IS_ERR(my_send_req));
+
+    my_recv_req = recv_nb(&recvbuf[0], recvbuf.size(), DATATYPE, 0x1337, 0xffff);
+    ASSERT_TRUE(!UCS_PTR_IS_ERR(my_recv_req));
+
+    wait(my_recv_req);
+
+    EXPECT_EQ(sendbuf.size(),      my_recv_req->info.length);
+    EXPECT_EQ((ucp_tag_t)0x111337, my_recv_req->info.sender_tag);
+    EXPECT_EQ(sendbuf, recvbuf);
+
+    wait_and_validate(my_send_req);
+    request_release(my_recv_req);
+}
+
+UCS_TEST_P(test_ucp_tag_match, eager_nontemporal_pack, "RNDV_THRESH=inf",
+           "MEMCPY_NT_THRESH=64k") {
+    /* below and above the threshold, so fragments of the same size are
+     * copied in both ways */
+    const size_t sizes[] = { 60000, 200000 };
+    request *my_send_req, *my_recv_req;
+
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        std::vector<char> sendbuf(sizes[i], 0);
+        std::vector<char> recvbuf(sizes[i], 0);
+
+        ucs::fill_random(sendbuf);
+
+        my_send_req = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, 0x111337);
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(my_send_req));
+
+        my_recv_req = recv_nb(&recvbuf[0], recvbuf.size(), DATATYPE, 0x1337,
+                              0xffff);
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(my_recv_req));
+        wait(my_recv_req);
+
+        EXPECT_EQ(sendbuf.size(), my_recv_req->info.length);
+        EXPECT_EQ(sendbuf, recvbuf);
+
+        wait_and_validate(my_send_req);
+        request_release(my_recv_req);
+    }
+}
+
 UCS_TEST_P(test_ucp_tag_match, rndv_exp_huge_mix) {
     const size_t sizes[] = { 1000, 2000, 2500ul * 1024 * 1024 };
 
@@ -640,4 +856,360 @@ UCS_TEST_P(test_ucp_tag_match, rndv_exp_huge_mix) {
     }
 }
 
+UCS_TEST_P(test_ucp_tag_match, unexp_eager_pause, "TM_UNEXP_MAX=16k") {
+    const unsigned        num_requests = 32;
+    const size_t          size         = 4096;
+    std::vector<request*> sreqs;
+    ucp_tag_recv_info_t   info;
+    ucs_status_t          status;
+
+    skip_loopback();
+
+    /* The receiver pauses only the peers it has an endpoint to */
+    receiver().connect(&sender(), get_ep_params());
+
+    std::vector<std::vector<char> > sendbufs(num_requests);
+    for (unsigned i = 0; i < num_requests; ++i) {
+        sendbufs[i].resize(size);
+        ucs::fill_random(sendbufs[i]);
+        request *sreq = send_nb(&sendbufs[i][0], size, DATATYPE, i);
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(sreq));
+        sreqs.push_back(sreq);
+        /* Let the pause message reach the sender */
+        short_progress_loop();
+    }
+
+    /* The receiver should have asked the sender to stop sending eager data */
+    EXPECT_TRUE(sender().ep()->flags & UCP_EP_FLAG_TAG_EAGER_PAUSED);
+    EXPECT_LT(receiver().worker()->tm.unexpected.mem, num_requests * size);
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        std::vector<char> recvbuf(size, 0);
+        status = recv_b(&recvbuf[0], size, DATATYPE, i, (ucp_tag_t)-1, &info);
+        ASSERT_UCS_OK(status);
+        EXPECT_EQ(size, info.length);
+        EXPECT_EQ(sendbufs[i], recvbuf);
+    }
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        wait_and_validate(sreqs[i]);
+    }
+
+    short_progress_loop();
+
+    EXPECT_FALSE(sender().ep()->flags & UCP_EP_FLAG_TAG_EAGER_PAUSED);
+    EXPECT_EQ(0ul, receiver().worker()->tm.unexpected.mem);
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_match)
+
+
+class test_ucp_tag_match_masks : public test_ucp_tag_match {
+public:
+    static ucp_params_t get_ctx_params() {
+        ucp_params_t params     = test_ucp_tag_match::get_ctx_params();
+        params.field_mask      |= UCP_PARAM_FIELD_TAG_SENDER_MASK;
+        params.tag_sender_mask = SENDER_MASK;
+        return params;
+    }
+
+protected:
+    static const ucp_tag_t SENDER_MASK = 0xffffffff00000000ul;
+
+    /* Tag of message number @a i, sent from one of several sources */
+    static ucp_tag_t msg_tag(unsigned i) {
+        return ((ucp_tag_t)(i % 7) << 32) | i;
+    }
+
+    /* Mask of the receive for message number @a i. There are more distinct
+     * masks than hash tables for them, including any sender and any tag. */
+    static ucp_tag_t recv_mask(unsigned i) {
+        static const ucp_tag_t masks[] = { (ucp_tag_t)-1,
+                                           ~SENDER_MASK,
+                                           0xffffffffffff0000ul,
+                                           0x0000ffffffffffff,
+                                           ~SENDER_MASK | 0xff00000000ul,
+                                           0x00000000ffff00fful,
+                                           0 };
+        return masks[(i / 3) % (sizeof(masks) / sizeof(masks[0]))];
+    }
+
+    void check_recv(unsigned i, uint64_t recv_data, ucp_tag_recv_info_t *info) {
+        EXPECT_EQ(sizeof(recv_data), info->length);
+        EXPECT_EQ(msg_tag(i), info->sender_tag) << "i=" << i;
+        EXPECT_EQ(i, recv_data);
+    }
+
+    unsigned num_msgs() const {
+        /* more than the initial hash size, to grow the tables */
+        return 3000 / ucs::test_time_multiplier();
+    }
+};
+
+UCS_TEST_P(test_ucp_tag_match_masks, exp_many_masks) {
+    const unsigned        num_requests = num_msgs();
+    std::vector<uint64_t> recv_data(num_requests, 0);
+    std::vector<request*> rreqs;
+
+    /* Every message matches its receive, and the receives of all previous
+     * messages, which were already completed */
+    for (uint64_t i = 0; i < num_requests; ++i) {
+        request *rreq = recv_nb(&recv_data[i], sizeof(recv_data[i]), DATATYPE,
+                                msg_tag(i), recv_mask(i));
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(rreq));
+        ASSERT_TRUE(rreq != NULL);
+        rreqs.push_back(rreq);
+    }
+
+    for (uint64_t i = 0; i < num_requests; ++i) {
+        send_b(&i, sizeof(i), DATATYPE, msg_tag(i));
+    }
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        wait(rreqs[i]);
+        EXPECT_EQ(UCS_OK, rreqs[i]->status);
+        check_recv(i, recv_data[i], &rreqs[i]->info);
+        request_release(rreqs[i]);
+    }
+}
+
+UCS_TEST_P(test_ucp_tag_match_masks, exp_order) {
+    uint64_t send_data = 1;
+    uint64_t recv_data[3];
+    request  *rreqs[3];
+
+    /* Requests posted earlier must match first, regardless of their mask */
+    rreqs[0] = recv_nb(&recv_data[0], sizeof(recv_data[0]), DATATYPE,
+                       0x1337, ~SENDER_MASK);
+    rreqs[1] = recv_nb(&recv_data[1], sizeof(recv_data[1]), DATATYPE,
+                       0x500001337ul, (ucp_tag_t)-1);
+    rreqs[2] = recv_nb(&recv_data[2], sizeof(recv_data[2]), DATATYPE, 0, 0);
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(rreqs[i]));
+        ASSERT_TRUE(rreqs[i] != NULL);
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        send_b(&send_data, sizeof(send_data), DATATYPE, 0x500001337ul);
+        ++send_data;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        wait(rreqs[i]);
+        EXPECT_EQ(UCS_OK, rreqs[i]->status);
+        EXPECT_EQ((ucp_tag_t)0x500001337ul, rreqs[i]->info.sender_tag);
+        EXPECT_EQ(i + 1u, recv_data[i]);
+        request_release(rreqs[i]);
+    }
+}
+
+UCS_TEST_P(test_ucp_tag_match_masks, unexp_many_masks) {
+    const unsigned        num_requests = num_msgs();
+    std::vector<request*> sreqs;
+    ucp_tag_recv_info_t   info;
+    ucs_status_t          status;
+    uint64_t              recv_data;
+
+    skip_loopback();
+
+    std::vector<uint64_t> send_data(num_requests);
+    for (uint64_t i = 0; i < num_requests; ++i) {
+        send_data[i] = i;
+        request *sreq = send_nb(&send_data[i], sizeof(send_data[i]), DATATYPE,
+                                msg_tag(i));
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(sreq));
+        sreqs.push_back(sreq);
+    }
+
+    short_progress_loop();
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        status = recv_b(&recv_data, sizeof(recv_data), DATATYPE, msg_tag(i),
+                        recv_mask(i), &info);
+        ASSERT_UCS_OK(status);
+        check_recv(i, recv_data, &info);
+    }
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        if (sreqs[i] != NULL) {
+            wait(sreqs[i]);
+            request_release(sreqs[i]);
+        }
+    }
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_match_masks)
+
+
+class test_ucp_tag_proto_tune : public test_ucp_tag {
+public:
+    virtual void init()
+    {
+        m_filename = "/tmp/gtest_ucp_proto_tune." + ucs::to_string(getpid());
+        modify_config("PROTO_TUNE",         "y");
+        modify_config("PROTO_TUNE_EXPLORE", "2");
+        modify_config("PROTO_TUNE_FILE",    m_filename);
+        modify_config("ZCOPY_THRESH",       "4096");
+        modify_config("RNDV_THRESH",        "32768");
+
+        test_ucp_tag::init();
+    }
+
+    virtual void cleanup()
+    {
+        test_ucp_tag::cleanup();
+        unlink(m_filename.c_str());
+    }
+
+protected:
+    /* Sample a protocol in the bucket of the given length, to be as fast as
+     * the given time per byte */
+    void sample(ucp_ep_config_t *config, size_t length,
+                ucp_proto_tune_id_t proto, double nsec_per_byte)
+    {
+        for (int i = 0; i < 16; ++i) {
+            ucp_proto_tune_sample(config, length, proto,
+                                  ucs_time_from_usec(length * nsec_per_byte /
+                                                     1000.0));
+        }
+    }
+
+    /* Make the protocol above the threshold faster, then slower, and check
+     * the threshold moves towards it, and not further than allowed */
+    void check_direction(ucp_ep_config_t *config, size_t *thresh_p, size_t base,
+                         ucp_proto_tune_id_t below, ucp_proto_tune_id_t above)
+    {
+        const size_t min_thresh = base >> UCP_PROTO_TUNE_MAX_SHIFT;
+        const size_t max_thresh = base << UCP_PROTO_TUNE_MAX_SHIFT;
+        ucp_proto_tune_t *tune  = config->tag.tune;
+        size_t length;
+
+        memset(tune->stats, 0, sizeof(tune->stats));
+        for (int i = 0; i < UCP_PROTO_TUNE_NUM_BUCKETS; ++i) {
+            length = UCS_BIT(ucs_ilog2(*thresh_p) - 1);
+            sample(config, length, below, 10.0);
+            sample(config, length, above, 1.0);
+        }
+        EXPECT_LT(*thresh_p, base);
+        EXPECT_GE(*thresh_p, min_thresh);
+        EXPECT_LT(*thresh_p, min_thresh * 2);
+
+        memset(tune->stats, 0, sizeof(tune->stats));
+        for (int i = 0; i < UCP_PROTO_TUNE_NUM_BUCKETS; ++i) {
+            length = UCS_BIT(ucs_ilog2(*thresh_p));
+            sample(config, length, below, 1.0);
+            sample(config, length, above, 10.0);
+        }
+        EXPECT_GT(*thresh_p, base);
+        EXPECT_LE(*thresh_p, max_thresh);
+        EXPECT_GT(*thresh_p * 2, max_thresh);
+    }
+
+    std::string m_filename;
+};
+
+UCS_TEST_P(test_ucp_tag_proto_tune, sample_direction) {
+    ucp_ep_config_t *config = &sender().worker()->ep_config[sender().ep()->cfg_index];
+    ucp_proto_tune_t *tune  = config->tag.tune;
+
+    if ((tune == NULL) || !tune->rndv_enabled) {
+        UCS_TEST_SKIP_R("protocol tuning is not supported");
+    }
+
+    if (tune->zcopy_enabled) {
+        check_direction(config, &config->tag.eager.zcopy_thresh[0],
+                        tune->zcopy_base, UCP_PROTO_TUNE_BCOPY,
+                        UCP_PROTO_TUNE_ZCOPY);
+    }
+    check_direction(config, tune->rndv_thresh, tune->rndv_base,
+                    UCP_PROTO_TUNE_BCOPY, UCP_PROTO_TUNE_RNDV);
+}
+
+UCS_TEST_P(test_ucp_tag_proto_tune, send_recv_dump) {
+    static const size_t sizes[] = { 2048, 4096, 6000, 16384, 32767, 32768,
+                                    50000 };
+    ucp_proto_tune_entry_t *table;
+    ucp_ep_config_t *config;
+    ucp_tag_recv_info_t info;
+    ucs_status_t status;
+    unsigned count;
+
+    for (int iter = 0; iter < 32 / ucs::test_time_multiplier(); ++iter) {
+        for (size_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); ++i) {
+            std::vector<char> sendbuf(sizes[i], 0);
+            std::vector<char> recvbuf(sizes[i], 0);
+
+            /* send some messages with the protocol of the other side of the
+             * threshold, and check they are still delivered intact */
+            ucs::fill_random(sendbuf);
+            request *req = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, i);
+            ASSERT_TRUE(!UCS_PTR_IS_ERR(req));
+
+            status = recv_b(&recvbuf[0], recvbuf.size(), DATATYPE, i,
+                            (ucp_tag_t)-1, &info);
+            ASSERT_UCS_OK(status);
+            wait_and_validate(req);
+
+            EXPECT_EQ(sendbuf.size(), info.length);
+            EXPECT_EQ(sendbuf, recvbuf);
+        }
+    }
+
+    config = &sender().worker()->ep_config[sender().ep()->cfg_index];
+    if (config->tag.tune == NULL) {
+        UCS_TEST_SKIP_R("protocol tuning is not supported");
+    }
+
+    /* tuned thresholds are saved to the file, and loaded back */
+    ucp_proto_tune_dump(sender().worker());
+
+    status = ucp_proto_tune_load(m_filename.c_str(), &table, &count);
+    ASSERT_UCS_OK(status);
+    ASSERT_GE(count, 1u);
+
+    bool found = false;
+    for (unsigned i = 0; i < count; ++i) {
+        if (!strcmp(table[i].name, config->tag.tune->name)) {
+            EXPECT_EQ(*config->tag.tune->rndv_thresh, table[i].rndv_thresh);
+            EXPECT_EQ(config->tag.eager.zcopy_thresh[0], table[i].zcopy_thresh);
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found) << config->tag.tune->name;
+
+    ucs_free(table);
+}
+
+UCS_TEST_P(test_ucp_tag_proto_tune, eager_no_recv) {
+    static const size_t sizes[] = { 2048, 6000 };
+    static const int count      = 16;
+    std::vector<std::vector<char> > sendbufs;
+    std::vector<request*> reqs;
+    ucp_tag_recv_info_t info;
+    ucs_status_t status;
+
+    /* measured eager sends complete without waiting for the receiver */
+    for (int i = 0; i < count; ++i) {
+        size_t size = sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+        sendbufs.push_back(std::vector<char>(size, 0));
+        ucs::fill_random(sendbufs.back());
+        request *req = send_nb(&sendbufs.back()[0], size, DATATYPE, i);
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(req));
+        reqs.push_back(req);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        wait_and_validate(reqs[i]);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        std::vector<char> recvbuf(sendbufs[i].size(), 0);
+        status = recv_b(&recvbuf[0], recvbuf.size(), DATATYPE, i,
+                        (ucp_tag_t)-1, &info);
+        ASSERT_UCS_OK(status);
+        EXPECT_EQ(sendbufs[i], recvbuf);
+    }
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_proto_tune)
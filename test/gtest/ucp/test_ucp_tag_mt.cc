@@ -9,6 +9,10 @@
 
 #include <common/test_helpers.h>
 
+extern "C" {
+#include <ucp/core/ucp_worker.h>
+}
+
 #if _OPENMP
 #include "omp.h"
 #endif
@@ -50,9 +54,37 @@ public:
     {
         return GetParam().variant == RECV_REQ_EXTERNAL;
     }
+
+protected:
+    void test_send_recv();
+
+    static void *lock_worker_thread(void *arg);
+
+    ucp_worker_h        m_locked_worker;
+    volatile bool       m_worker_locked;
+    volatile bool       m_recv_posted;
+    bool                m_lock_timeout;
 };
 
-UCS_TEST_P(test_ucp_tag_mt, send_recv) {
+void *test_ucp_tag_mt::lock_worker_thread(void *arg)
+{
+    test_ucp_tag_mt *self = reinterpret_cast<test_ucp_tag_mt*>(arg);
+    ucs_time_t deadline   = ucs_get_time() +
+                            ucs_time_from_sec(10.0) *
+                            ucs::test_time_multiplier();
+
+    /* Hold the worker lock, as a thread inside ucp_worker_progress() would */
+    UCS_ASYNC_BLOCK(&self->m_locked_worker->async);
+    self->m_worker_locked = true;
+    while (!self->m_recv_posted && (ucs_get_time() < deadline)) {
+        sched_yield();
+    }
+    self->m_lock_timeout = !self->m_recv_posted;
+    UCS_ASYNC_UNBLOCK(&self->m_locked_worker->async);
+    return NULL;
+}
+
+void test_ucp_tag_mt::test_send_recv() {
     int i;
     uint64_t            send_data[MT_TEST_NUM_THREADS] GTEST_ATTRIBUTE_UNUSED_;
     uint64_t            recv_data[MT_TEST_NUM_THREADS] GTEST_ATTRIBUTE_UNUSED_;
@@ -88,4 +120,47 @@ UCS_TEST_P(test_ucp_tag_mt, send_recv) {
 #endif
 }
 
+UCS_TEST_P(test_ucp_tag_mt, send_recv) {
+    test_send_recv();
+}
+
+UCS_TEST_P(test_ucp_tag_mt, send_recv_progress_trylock, "PROGRESS_TRYLOCK=y") {
+    test_send_recv();
+}
+
+UCS_TEST_P(test_ucp_tag_mt, post_recv_worker_locked) {
+    uint64_t send_data = 0xdeadbeefdeadbeef;
+    uint64_t recv_data = 0;
+    pthread_t thread;
+    request *rreq;
+
+    if ((GetParam().thread_type != MULTI_THREAD_WORKER) ||
+        !is_external_request()) {
+        UCS_TEST_SKIP_R("posting a receive without the worker lock requires "
+                        "multi-threaded worker and external request");
+    }
+
+    m_locked_worker = receiver().worker();
+    m_worker_locked = false;
+    m_recv_posted   = false;
+    m_lock_timeout  = false;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, lock_worker_thread, this));
+    while (!m_worker_locked) {
+        sched_yield();
+    }
+
+    /* Posting an expected receive takes only the tag matching lock */
+    rreq          = recv_nb(&recv_data, sizeof(recv_data), DATATYPE, 0x1337,
+                            (ucp_tag_t)-1);
+    m_recv_posted = true;
+    pthread_join(thread, NULL);
+    EXPECT_FALSE(m_lock_timeout);
+
+    send_b(&send_data, sizeof(send_data), DATATYPE, 0x1337);
+    wait(rreq);
+    EXPECT_EQ(UCS_OK, rreq->status);
+    EXPECT_EQ(send_data, recv_data);
+    request_release(rreq);
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_mt)
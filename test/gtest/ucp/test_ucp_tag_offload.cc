@@ -353,18 +353,18 @@ UCS_TEST_P(test_ucp_tag_offload_multi, recv_from_multi)
     // Activate first offload iface. Tag hashing is not done yet, since we
     // have only one active iface so far.
     activate_offload_hashing(e(0), make_tag(e(0), tag));
-    EXPECT_EQ(0u, kh_size(&receiver().worker()->tm.offload.tag_hash));
+    EXPECT_EQ(0u, ucs_shash_size(&receiver().worker()->tm.offload.tag_hash));
 
     // Activate second offload iface. The tag has been added to the hash.
     // From now requests will be offloaded only for those tags which are
     // in the hash.
     activate_offload_hashing(e(1), make_tag(e(1), tag));
-    EXPECT_EQ(1u, kh_size(&receiver().worker()->tm.offload.tag_hash));
+    EXPECT_EQ(1u, ucs_shash_size(&receiver().worker()->tm.offload.tag_hash));
 
     // Need to send a message on the first iface again, for its 'tag_sender'
     // part of the tag to be added to the hash.
     send_recv(e(0), make_tag(e(0), tag), 2048);
-    EXPECT_EQ(2u, kh_size(&receiver().worker()->tm.offload.tag_hash));
+    EXPECT_EQ(2u, ucs_shash_size(&receiver().worker()->tm.offload.tag_hash));
 
     // Now requests from first two senders should be always offloaded regardless
     // of the tag value. Tag does not matter, because hashing is done with
@@ -378,7 +378,7 @@ UCS_TEST_P(test_ucp_tag_offload_multi, recv_from_multi)
     post_recv_and_check(e(2), 1u, tag, UCP_TAG_MASK_FULL);
 
     activate_offload_hashing(e(2), make_tag(e(2), tag));
-    EXPECT_EQ(3u, kh_size(&receiver().worker()->tm.offload.tag_hash));
+    EXPECT_EQ(3u, ucs_shash_size(&receiver().worker()->tm.offload.tag_hash));
 
     // Check that this sender was added as well
     post_recv_and_check(e(2), 0u, tag + 1, UCP_TAG_MASK_FULL);
@@ -88,6 +88,9 @@ public:
     void test_xfer_contig(size_t size, bool expected, bool sync, bool truncated);
     void test_xfer_generic(size_t size, bool expected, bool sync, bool truncated);
     void test_xfer_iov(size_t size, bool expected, bool sync, bool truncated);
+    void test_xfer_strided(size_t size, bool expected, bool sync, bool truncated);
+    void test_xfer_strided_large(size_t size, bool expected, bool sync,
+                                 bool truncated);
     void test_xfer_generic_err(size_t size, bool expected, bool sync, bool truncated);
 
 protected:
@@ -110,6 +113,9 @@ protected:
 
     void test_xfer_len_offset();
 
+    void do_xfer_strided(size_t size, size_t blocklength, bool expected,
+                         bool sync, bool truncated);
+
 private:
     request* do_send(const void *sendbuf, size_t count, ucp_datatype_t dt, bool sync);
 
@@ -391,6 +397,64 @@ void test_ucp_tag_xfer::test_xfer_iov(size_t size, bool expected, bool sync,
                                "IOV"));
 }
 
+void test_ucp_tag_xfer::do_xfer_strided(size_t size, size_t blocklength,
+                                        bool expected, bool sync, bool truncated)
+{
+    /* Blocks of 2x3 sub-matrices, every block is followed by a gap */
+    ucp_dt_strided_level_t levels[2];
+    levels[0].count  = 3;
+    levels[0].stride = blocklength + 8;
+    levels[1].count  = 2;
+    levels[1].stride = levels[0].count * levels[0].stride + 16;
+
+    const size_t elem_length = blocklength * levels[0].count * levels[1].count;
+    const size_t extent      = levels[1].count * levels[1].stride;
+    size_t count             = size / elem_length;
+    ucp_datatype_t dt;
+    ucs_status_t status;
+
+    if (truncated && (count < 2)) {
+        truncated = false;
+    }
+
+    status = ucp_dt_create_strided(blocklength, levels, 2, &dt);
+    ASSERT_UCS_OK(status);
+
+    std::vector<char> sendbuf(count * extent, 0);
+    std::vector<char> recvbuf(count * extent, 0);
+    for (size_t elem = 0; elem < count; ++elem) {
+        for (size_t i = 0; i < levels[1].count; ++i) {
+            for (size_t j = 0; j < levels[0].count; ++j) {
+                ucs::fill_random(&sendbuf[elem * extent + i * levels[1].stride +
+                                          j * levels[0].stride], blocklength);
+            }
+        }
+    }
+
+    size_t recvd = do_xfer(&sendbuf[0], &recvbuf[0], count, dt, dt, expected,
+                           sync, truncated);
+    if (!truncated) {
+        EXPECT_EQ(count * elem_length, recvd);
+        EXPECT_TRUE(!check_buffers(sendbuf, recvbuf, sendbuf.size(), count,
+                                   count, size, expected, sync, "strided"));
+    }
+
+    ucp_dt_destroy(dt);
+}
+
+void test_ucp_tag_xfer::test_xfer_strided(size_t size, bool expected,
+                                          bool sync, bool truncated)
+{
+    do_xfer_strided(size, sizeof(uint64_t), expected, sync, truncated);
+}
+
+void test_ucp_tag_xfer::test_xfer_strided_large(size_t size, bool expected,
+                                                bool sync, bool truncated)
+{
+    /* Large blocks are sent with zero copy */
+    do_xfer_strided(size, 2000, expected, sync, truncated);
+}
+
 void test_ucp_tag_xfer::test_xfer_generic_err(size_t size, bool expected,
                                               bool sync, bool truncated)
 {
@@ -583,6 +647,30 @@ UCS_TEST_P(test_ucp_tag_xfer, iov_unexp) {
     test_xfer(&test_ucp_tag_xfer::test_xfer_iov, false, false, false);
 }
 
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp_truncated) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, true, false, true);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_unexp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, false, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_large_exp, "ZCOPY_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_large, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_large_unexp, "ZCOPY_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_large, false, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_large_exp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_large, true, false, false);
+}
+
 UCS_TEST_P(test_ucp_tag_xfer, generic_err_exp) {
     test_xfer(&test_ucp_tag_xfer::test_xfer_generic_err, true, false, false);
 }
@@ -171,6 +171,53 @@ UCS_TEST_P(test_ucp_wakeup, signal)
     EXPECT_EQ(UCS_OK, ucp_worker_arm(worker));
 }
 
+UCS_TEST_P(test_ucp_wakeup, signal_spin, "WAIT_SPIN_TIME=10s",
+           "WAIT_SPIN_ADAPTIVE=n")
+{
+    ucs_time_t start_time;
+
+    /* signal must interrupt polling in ucp_worker_wait() */
+    ASSERT_UCS_OK(ucp_worker_signal(sender().worker()));
+    start_time = ucs_get_time();
+    ASSERT_UCS_OK(ucp_worker_wait(sender().worker()));
+    EXPECT_LT(ucs_time_to_sec(ucs_get_time() - start_time), 1.0);
+
+    /* the signal was consumed */
+    EXPECT_UCS_OK(ucp_worker_arm(sender().worker()));
+}
+
+UCS_TEST_P(test_ucp_wakeup, tx_wait_spin, "ZCOPY_THRESH=10000",
+           "WAIT_SPIN_TIME=1ms")
+{
+    const ucp_datatype_t DATATYPE = ucp_dt_make_contig(1);
+    const size_t COUNT            = 20000;
+    const uint64_t TAG            = 0xdeadbeef;
+    const int ITERS               = 100;
+    std::string send_data(COUNT, '2'), recv_data(COUNT, '1');
+    void *sreq, *rreq;
+
+    sender().connect(&receiver(), get_ep_params());
+
+    for (int i = 0; i < ITERS; ++i) {
+        rreq = ucp_tag_recv_nb(receiver().worker(), &recv_data[0], COUNT,
+                               DATATYPE, TAG, (ucp_tag_t)-1, recv_completion);
+        sreq = ucp_tag_send_nb(sender().ep(), &send_data[0], COUNT, DATATYPE,
+                               TAG, send_completion);
+        if (UCS_PTR_IS_PTR(sreq)) {
+            while (!ucp_request_is_completed(sreq)) {
+                ASSERT_UCS_OK(ucp_worker_wait(sender().worker()));
+                while (progress());
+            }
+            ucp_request_release(sreq);
+        } else {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(sreq));
+        }
+
+        wait(rreq);
+        EXPECT_EQ(send_data, recv_data);
+    }
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_wakeup)
 
 class test_ucp_wakeup_external_epollfd : public test_ucp_wakeup {
@@ -260,3 +307,75 @@ UCS_TEST_P(test_ucp_wakeup_external_epollfd, epoll_wait)
 }
 
 UCP_INSTANTIATE_TEST_CASE(test_ucp_wakeup_external_epollfd)
+
+class test_ucp_wakeup_progress_thread : public test_ucp_wakeup {
+public:
+    virtual ucp_worker_params_t get_worker_params() {
+        ucp_worker_params_t params = test_ucp_wakeup::get_worker_params();
+        params.field_mask |= UCP_WORKER_PARAM_FIELD_FLAGS;
+        params.flags       = UCP_WORKER_PARAM_FLAG_PROGRESS_THREAD;
+        return params;
+    }
+
+protected:
+    virtual void init() {
+#if !ENABLE_MT
+        UCS_TEST_SKIP_R("multi-threading support is disabled");
+#endif
+        test_ucp_wakeup::init();
+    }
+
+    /* Wait for completion without progressing the workers */
+    void wait_no_progress(void *req) {
+        ucs_time_t deadline = ucs::get_deadline();
+        while (!ucp_request_is_completed(req) &&
+               (ucs_get_time() < deadline)) {
+            sched_yield();
+        }
+        ASSERT_TRUE(ucp_request_is_completed(req));
+        ucp_request_release(req);
+    }
+};
+
+UCS_TEST_P(test_ucp_wakeup_progress_thread, rndv, "RNDV_THRESH=1024")
+{
+    const ucp_datatype_t DATATYPE = ucp_dt_make_contig(1);
+    const size_t COUNT            = 100000;
+    const uint64_t TAG            = 0xdeadbeef;
+    std::string send_data(COUNT, '2'), recv_data(COUNT, '1');
+    ucp_worker_attr_t attr;
+    void *sreq, *rreq;
+
+    attr.field_mask = UCP_WORKER_ATTR_FIELD_THREAD_MODE;
+    ASSERT_UCS_OK(ucp_worker_query(sender().worker(), &attr));
+    EXPECT_EQ(UCS_THREAD_MODE_MULTI, attr.thread_mode);
+
+    sender().connect(&receiver(), get_ep_params());
+
+    rreq = ucp_tag_recv_nb(receiver().worker(), &recv_data[0], COUNT, DATATYPE,
+                           TAG, (ucp_tag_t)-1, recv_completion);
+    ASSERT_TRUE(UCS_PTR_IS_PTR(rreq));
+
+    sreq = ucp_tag_send_nb(sender().ep(), &send_data[0], COUNT, DATATYPE,
+                           TAG, send_completion);
+    if (UCS_PTR_IS_PTR(sreq)) {
+        wait_no_progress(sreq);
+    } else {
+        ASSERT_UCS_OK(UCS_PTR_STATUS(sreq));
+    }
+
+    wait_no_progress(rreq);
+    EXPECT_EQ(send_data, recv_data);
+}
+
+UCS_TEST_P(test_ucp_wakeup_progress_thread, user_wakeup_unsupported)
+{
+    scoped_log_handler slh(hide_errors_logger);
+    int fd;
+
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED, ucp_worker_get_efd(sender().worker(), &fd));
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED, ucp_worker_arm(sender().worker()));
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED, ucp_worker_wait(sender().worker()));
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_wakeup_progress_thread)
@@ -436,6 +436,42 @@ UCS_TEST_P(test_ucp_wireup_1sided, empty_address) {
     ucs_free(buffer);
 }
 
+UCS_TEST_P(test_ucp_wireup_1sided, address_cache) {
+    ucp_worker_h worker = sender().worker();
+    std::vector<ucp_cached_address_t*> cached(2);
+    std::vector<size_t> sizes(2);
+    std::vector<void*> buffers(2);
+    unsigned order[UCP_MAX_RESOURCES];
+    ucs_status_t status;
+    void *restored;
+
+    status = ucp_address_pack(sender().worker(), NULL, -1, order, &sizes[0],
+                              &buffers[0]);
+    ASSERT_UCS_OK(status);
+    status = ucp_address_pack(receiver().worker(), NULL, -1, order, &sizes[1],
+                              &buffers[1]);
+    ASSERT_UCS_OK(status);
+
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        status = ucp_address_cache_insert(worker, buffers[i], &cached[i]);
+        ASSERT_UCS_OK(status);
+        EXPECT_EQ(sizes[i], cached[i]->length + cached[i]->tmpl->length);
+    }
+
+    /* both workers use the same devices and transports */
+    EXPECT_EQ(cached[0]->tmpl, cached[1]->tmpl);
+    EXPECT_EQ(2u, cached[0]->tmpl->refcount);
+
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        status = ucp_address_cache_restore(worker, cached[i], &restored);
+        ASSERT_UCS_OK(status);
+        EXPECT_EQ(0, memcmp(buffers[i], restored, sizes[i]));
+        ucs_free(restored);
+        ucp_address_cache_release(worker, cached[i]);
+        ucs_free(buffers[i]);
+    }
+}
+
 UCS_TEST_P(test_ucp_wireup_1sided, one_sided_wireup) {
     sender().connect(&receiver(), get_ep_params());
     send_recv(sender().ep(), receiver().worker(), receiver().ep(), 1, 1);
@@ -802,3 +838,47 @@ UCS_TEST_P(test_ucp_wireup_errh_peer, msg_before_ep_create) {
 }
 
 UCP_INSTANTIATE_TEST_CASE(test_ucp_wireup_errh_peer)
+
+class test_ucp_wireup_lazy : public test_ucp_wireup_1sided
+{
+public:
+    virtual void init() {
+        modify_config("LAZY_EP_CONNECT", "y");
+        test_ucp_wireup::init();
+        skip_loopback();
+    }
+};
+
+UCS_TEST_P(test_ucp_wireup_lazy, connect_on_first_use) {
+    sender().connect(&receiver(), get_ep_params());
+    short_progress_loop();
+    EXPECT_TRUE(sender().ep()->flags & UCP_EP_FLAG_CONNECT_LAZY);
+    EXPECT_FALSE(ucp_ep_is_sockaddr_stub(sender().ep()));
+
+    send_recv(sender().ep(), receiver().worker(), receiver().ep(), 8, 10);
+    EXPECT_FALSE(sender().ep()->flags & UCP_EP_FLAG_CONNECT_LAZY);
+    EXPECT_NE(UCP_NULL_RESOURCE, ucp_ep_get_rsc_index(sender().ep(), 0));
+    flush_worker(sender());
+}
+
+UCS_TEST_P(test_ucp_wireup_lazy, connect_by_peer) {
+    sender().connect(&receiver(), get_ep_params());
+    receiver().connect(&sender(), get_ep_params());
+
+    send_recv(sender().ep(), receiver().worker(), receiver().ep(), 8, 1);
+    flush_worker(sender());
+
+    send_recv(receiver().ep(), sender().worker(), sender().ep(), 8, 1);
+    flush_worker(receiver());
+    EXPECT_FALSE(sender().ep()->flags & UCP_EP_FLAG_CONNECT_LAZY);
+    EXPECT_FALSE(receiver().ep()->flags & UCP_EP_FLAG_CONNECT_LAZY);
+}
+
+UCS_TEST_P(test_ucp_wireup_lazy, close_unused) {
+    sender().connect(&receiver(), get_ep_params());
+    flush_worker(sender());
+    disconnect(sender());
+    EXPECT_EQ(0u, sender().worker()->flush_ops_count);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_wireup_lazy)
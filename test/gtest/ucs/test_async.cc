@@ -196,6 +196,10 @@ public:
         UCS_ASYNC_UNBLOCK(&m_async);
     }
 
+    bool try_block() {
+        return ucs_async_try_block(&m_async);
+    }
+
     void check_miss() {
         ucs_async_check_miss(&m_async);
     }
@@ -491,6 +495,32 @@ UCS_TEST_P(test_async, ctx_event_block) {
     EXPECT_GE(le.count(), 1);
 }
 
+static void* try_block_thread_func(void *arg)
+{
+    return (void*)(uintptr_t)((local*)arg)->try_block();
+}
+
+UCS_TEST_P(test_async, ctx_try_block) {
+    local_event le(GetParam());
+    pthread_t thread;
+    void *result;
+
+    /* The owner can always block again */
+    le.block();
+    EXPECT_TRUE(le.try_block());
+    le.unblock();
+
+    if ((GetParam() == UCS_ASYNC_MODE_THREAD_SPINLOCK) ||
+        (GetParam() == UCS_ASYNC_MODE_THREAD_MUTEX)) {
+        /* Another thread should not wait for the lock */
+        pthread_create(&thread, NULL, try_block_thread_func, (local*)&le);
+        pthread_join(thread, &result);
+        EXPECT_FALSE(result);
+    }
+
+    le.unblock();
+}
+
 UCS_TEST_P(test_async, ctx_event_block_two_miss) {
     local_event le(GetParam());
 
@@ -9,6 +9,7 @@ extern "C" {
 #include <ucs/datastruct/list.h>
 #include <ucs/datastruct/ptr_array.h>
 #include <ucs/datastruct/queue.h>
+#include <ucs/datastruct/shash.h>
 #include <ucs/time/time.h>
 }
 
@@ -18,6 +19,9 @@ extern "C" {
 class test_datatype : public ucs::test {
 };
 
+UCS_SHASH_INIT(test_shash, uint64_t, int, 1, ucs_shash_int64_hash_func,
+               ucs_shash_equal);
+
 typedef struct {
     int               i;
     ucs_list_link_t   list;
@@ -529,3 +533,103 @@ UCS_TEST_F(test_datatype, ptr_status) {
     void *ptr2 = (void*)(uintptr_t)(UCS_ERR_LAST + 1);
     EXPECT_TRUE(UCS_PTR_IS_ERR(ptr2));
 }
+
+UCS_TEST_F(test_datatype, shash_basic) {
+    ucs_shash_t(test_shash) h;
+    ucs_shash_iter_t iter;
+    int ret;
+
+    ucs_shash_init_inplace(test_shash, &h);
+    EXPECT_EQ(ucs_shash_end(&h), ucs_shash_get(test_shash, &h, 5));
+
+    iter = ucs_shash_put(test_shash, &h, 5, &ret);
+    EXPECT_GT(ret, 0);
+    ucs_shash_value(&h, iter) = 50;
+    EXPECT_EQ(1u, ucs_shash_size(&h));
+
+    iter = ucs_shash_put(test_shash, &h, 5, &ret);
+    EXPECT_EQ(0, ret);
+    EXPECT_EQ(50, ucs_shash_value(&h, iter));
+
+    iter = ucs_shash_get(test_shash, &h, 5);
+    ASSERT_NE(ucs_shash_end(&h), iter);
+    EXPECT_EQ(5u, ucs_shash_key(&h, iter));
+    EXPECT_EQ(50, ucs_shash_value(&h, iter));
+
+    ucs_shash_del(test_shash, &h, iter);
+    EXPECT_EQ(0u, ucs_shash_size(&h));
+    EXPECT_EQ(ucs_shash_end(&h), ucs_shash_get(test_shash, &h, 5));
+
+    ucs_shash_destroy_inplace(test_shash, &h);
+}
+
+UCS_TEST_F(test_datatype, shash_random) {
+    const unsigned count = 100000 / ucs::test_time_multiplier();
+    ucs_shash_t(test_shash) h;
+    std::map<uint64_t, int> map;
+    ucs_shash_iter_t iter;
+    uint64_t key;
+    int ret, value;
+
+    ucs_shash_init_inplace(test_shash, &h);
+
+    /* Keys from a small range, to exercise deleted slots reuse */
+    for (unsigned i = 0; i < count; ++i) {
+        key = ucs::rand() % 1000;
+        if (ucs::rand() % 2) {
+            iter = ucs_shash_put(test_shash, &h, key, &ret);
+            ASSERT_NE(ucs_shash_end(&h), iter);
+            EXPECT_EQ(map.find(key) == map.end(), ret > 0);
+            ucs_shash_value(&h, iter) = i;
+            map[key]                  = i;
+        } else {
+            iter = ucs_shash_get(test_shash, &h, key);
+            if (map.find(key) == map.end()) {
+                EXPECT_EQ(ucs_shash_end(&h), iter);
+            } else {
+                ASSERT_NE(ucs_shash_end(&h), iter);
+                EXPECT_EQ(map[key], ucs_shash_value(&h, iter));
+                ucs_shash_del(test_shash, &h, iter);
+                map.erase(key);
+            }
+        }
+        ASSERT_EQ(map.size(), ucs_shash_size(&h));
+    }
+
+    /* Check all elements, and remove them while iterating */
+    ucs_shash_foreach(&h, key, value, {
+        ASSERT_TRUE(map.find(key) != map.end());
+        EXPECT_EQ(map[key], value);
+        map.erase(key);
+        ucs_shash_del(test_shash, &h, __i);
+    });
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(0u, ucs_shash_size(&h));
+
+    ucs_shash_destroy_inplace(test_shash, &h);
+}
+
+UCS_TEST_F(test_datatype, shash_grow) {
+    const uint64_t count = 100000;
+    ucs_shash_t(test_shash) h;
+    ucs_shash_iter_t iter;
+    int ret;
+
+    ucs_shash_init_inplace(test_shash, &h);
+
+    /* Keys which differ only in their upper bits */
+    for (uint64_t i = 0; i < count; ++i) {
+        iter = ucs_shash_put(test_shash, &h, i << 32, &ret);
+        ASSERT_GT(ret, 0);
+        ucs_shash_value(&h, iter) = i;
+    }
+
+    EXPECT_EQ(count, ucs_shash_size(&h));
+    for (uint64_t i = 0; i < count; ++i) {
+        iter = ucs_shash_get(test_shash, &h, i << 32);
+        ASSERT_NE(ucs_shash_end(&h), iter);
+        EXPECT_EQ((int)i, ucs_shash_value(&h, iter));
+    }
+
+    ucs_shash_destroy_inplace(test_shash, &h);
+}
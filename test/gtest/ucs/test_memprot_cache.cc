@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include <common/test.h>
+extern "C" {
+#include <ucs/memory/memprot_cache.h>
+#include <ucs/sys/sys.h>
+}
+
+#include <sys/mman.h>
+
+
+class test_memprot_cache : public ucs::test {
+protected:
+
+    virtual void init() {
+        ucs_status_t status;
+
+        ucs::test::init();
+        status = ucs_memprot_cache_create(&m_memprot_cache);
+        if (status == UCS_ERR_UNSUPPORTED) {
+            UCS_TEST_SKIP_R("memory events are not supported");
+        }
+        ASSERT_UCS_OK(status);
+    }
+
+    virtual void cleanup() {
+        ucs_memprot_cache_destroy(m_memprot_cache);
+        ucs::test::cleanup();
+    }
+
+    /* Cached protection should be the same as in /proc/self/maps */
+    void check_prot(void *address, size_t size, int expected_prot) {
+        unsigned long start = (uintptr_t)address;
+        unsigned long end   = start + size;
+
+        EXPECT_EQ(ucs_get_mem_prot(start, end),
+                  ucs_memprot_cache_get(m_memprot_cache, start, end));
+        EXPECT_EQ(expected_prot,
+                  ucs_memprot_cache_get(m_memprot_cache, start, end) &
+                  (PROT_READ | PROT_WRITE));
+    }
+
+    ucs_memprot_cache_t *m_memprot_cache;
+};
+
+UCS_TEST_F(test_memprot_cache, mmap_mprotect_munmap) {
+    const size_t size = 16 * ucs_get_page_size();
+    char *mem;
+    int ret;
+
+    mem = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, mem) << strerror(errno);
+    check_prot(mem, size, PROT_READ | PROT_WRITE);
+
+    /* Change protection of the middle part */
+    ret = mprotect(mem + 4 * ucs_get_page_size(), 4 * ucs_get_page_size(),
+                   PROT_READ);
+    ASSERT_EQ(0, ret) << strerror(errno);
+    check_prot(mem, 4 * ucs_get_page_size(), PROT_READ | PROT_WRITE);
+    check_prot(mem + 4 * ucs_get_page_size(), 4 * ucs_get_page_size(),
+               PROT_READ);
+    check_prot(mem + 8 * ucs_get_page_size(), 8 * ucs_get_page_size(),
+               PROT_READ | PROT_WRITE);
+    check_prot(mem, size, PROT_READ);
+
+    /* Unmap the last part */
+    ret = munmap(mem + 12 * ucs_get_page_size(), 4 * ucs_get_page_size());
+    ASSERT_EQ(0, ret) << strerror(errno);
+    check_prot(mem + 12 * ucs_get_page_size(), 4 * ucs_get_page_size(),
+               PROT_NONE);
+    check_prot(mem + 8 * ucs_get_page_size(), 4 * ucs_get_page_size(),
+               PROT_READ | PROT_WRITE);
+
+    munmap(mem, 12 * ucs_get_page_size());
+}
+
+UCS_TEST_F(test_memprot_cache, remap_fixed) {
+    const size_t size = 8 * ucs_get_page_size();
+    void *mem, *ptr;
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, mem) << strerror(errno);
+    check_prot(mem, size, PROT_READ | PROT_WRITE);
+
+    ptr = mmap(mem, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+               -1, 0);
+    ASSERT_EQ(mem, ptr) << strerror(errno);
+    check_prot(mem, size, PROT_READ);
+
+    munmap(mem, size);
+}
+
+UCS_TEST_F(test_memprot_cache, many_events) {
+    const size_t size = ucs_get_page_size();
+    const unsigned count = UCS_MEMPROT_CACHE_MAX_OPS * 2;
+    void *mem;
+    int ret;
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, mem) << strerror(errno);
+    check_prot(mem, size, PROT_READ | PROT_WRITE);
+
+    /* Overflow the pending events queue */
+    for (unsigned i = 0; i < count; ++i) {
+        ret = mprotect(mem, size, (i % 2) ? PROT_READ : PROT_WRITE);
+        ASSERT_EQ(0, ret) << strerror(errno);
+    }
+    check_prot(mem, size, PROT_READ);
+
+    munmap(mem, size);
+}
+
+UCS_TEST_F(test_memprot_cache, unmapped_range) {
+    const size_t size = 4 * ucs_get_page_size();
+    unsigned long num_reloads;
+    void *mem, *ptr;
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, mem) << strerror(errno);
+    munmap(mem, size);
+
+    /* The first query reads /proc/self/maps, and the next ones use the
+     * cached unmapped range */
+    check_prot(mem, size, PROT_NONE);
+    num_reloads = m_memprot_cache->num_reloads;
+    check_prot(mem, size, PROT_NONE);
+    check_prot(mem, ucs_get_page_size(), PROT_NONE);
+    EXPECT_EQ(num_reloads, m_memprot_cache->num_reloads);
+
+    /* Mapping the range again replaces the unmapped range */
+    ptr = mmap(mem, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+               -1, 0);
+    ASSERT_EQ(mem, ptr) << strerror(errno);
+    check_prot(mem, size, PROT_READ);
+
+    munmap(mem, size);
+}
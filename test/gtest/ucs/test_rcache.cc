@@ -12,6 +12,7 @@ extern "C" {
 #include <ucs/memory/rcache.h>
 #include <ucs/memory/rcache_int.h>
 #include <ucs/sys/sys.h>
+#include <ucs/time/time.h>
 #include <ucm/api/ucm.h>
 }
 
@@ -28,8 +29,7 @@ protected:
     test_rcache() : m_reg_count(0), m_ptr(NULL) {
     }
 
-    virtual void init() {
-        ucs::test::init();
+    virtual ucs_rcache_params_t rcache_params() {
         static const ucs_rcache_ops_t ops = {
             mem_reg_cb,
             mem_dereg_cb,
@@ -42,8 +42,17 @@ protected:
             UCM_EVENT_VM_UNMAPPED,
             1000,
             &ops,
-            reinterpret_cast<void*>(this)
+            reinterpret_cast<void*>(this),
+            ULONG_MAX,
+            SIZE_MAX,
+            0
         };
+        return params;
+    }
+
+    virtual void init() {
+        ucs::test::init();
+        ucs_rcache_params_t params = rcache_params();
         UCS_TEST_CREATE_HANDLE(ucs_rcache_t*, m_rcache, ucs_rcache_destroy,
                                ucs_rcache_create, &params, "test", ucs_stats_get_root());
     }
@@ -608,6 +617,179 @@ UCS_MT_TEST_F(test_rcache_no_register, merge_invalid_prot_slow, 5)
     munmap(mem, size1+size2);
 }
 
+class test_rcache_lru : public test_rcache {
+protected:
+    static const unsigned MAX_REGIONS = 4;
+
+    virtual ucs_rcache_params_t rcache_params() {
+        ucs_rcache_params_t params = test_rcache::rcache_params();
+        params.max_regions = MAX_REGIONS;
+        params.max_size    = MAX_REGIONS * 2 * ucs_get_page_size();
+        return params;
+    }
+
+    /* Regions are separated by a gap, so they would not be merged */
+    void *region_ptr(void *mem, unsigned index) {
+        return (char*)mem + (index * 4 * ucs_get_page_size());
+    }
+};
+
+const unsigned test_rcache_lru::MAX_REGIONS;
+
+UCS_TEST_F(test_rcache_lru, evict_by_count) {
+    static const unsigned count = MAX_REGIONS * 3;
+    const size_t size           = ucs_get_page_size();
+    void *mem = alloc_pages(count * 4 * size, PROT_READ|PROT_WRITE);
+
+    for (unsigned i = 0; i < count; ++i) {
+        put(get(region_ptr(mem, i), size));
+        EXPECT_LE(m_reg_count, MAX_REGIONS);
+    }
+    EXPECT_EQ(MAX_REGIONS, m_reg_count);
+
+    munmap(mem, count * 4 * size);
+}
+
+UCS_TEST_F(test_rcache_lru, evict_by_size) {
+    static const unsigned count = MAX_REGIONS;
+    const size_t size           = 3 * ucs_get_page_size();
+    void *mem = alloc_pages(count * 4 * ucs_get_page_size(),
+                            PROT_READ|PROT_WRITE);
+
+    /* Max size allows only 2 regions of 3 pages each */
+    for (unsigned i = 0; i < count; ++i) {
+        put(get(region_ptr(mem, i), size));
+        EXPECT_LE(m_reg_count, 2u);
+    }
+
+    munmap(mem, count * 4 * ucs_get_page_size());
+}
+
+UCS_TEST_F(test_rcache_lru, inuse_not_evicted) {
+    static const unsigned count = MAX_REGIONS * 2;
+    const size_t size           = ucs_get_page_size();
+    void *mem = alloc_pages((count + 1) * 4 * size, PROT_READ|PROT_WRITE);
+    std::vector<region*> regions;
+
+    for (unsigned i = 0; i < count; ++i) {
+        regions.push_back(get(region_ptr(mem, i), size));
+    }
+    EXPECT_EQ(count, m_reg_count);
+
+    /* All regions are still valid */
+    for (unsigned i = 0; i < count; ++i) {
+        EXPECT_EQ(uint32_t(MAGIC), regions[i]->magic);
+        put(regions[i]);
+    }
+
+    /* Creating a new region evicts the unused ones */
+    put(get(region_ptr(mem, count), size));
+    EXPECT_EQ(MAX_REGIONS, m_reg_count);
+
+    munmap(mem, (count + 1) * 4 * size);
+}
+
+UCS_TEST_F(test_rcache_lru, lru_order) {
+    const size_t size = ucs_get_page_size();
+    void *mem = alloc_pages((MAX_REGIONS + 1) * 4 * size, PROT_READ|PROT_WRITE);
+    region *r0, *r1;
+    uint32_t id0, id1;
+
+    r0  = get(region_ptr(mem, 0), size);
+    id0 = r0->id;
+    put(r0);
+
+    r1  = get(region_ptr(mem, 1), size);
+    id1 = r1->id;
+    put(r1);
+
+    for (unsigned i = 2; i < MAX_REGIONS; ++i) {
+        put(get(region_ptr(mem, i), size));
+    }
+
+    /* Use region 0 again, so region 1 becomes the least recently used */
+    r0 = get(region_ptr(mem, 0), size);
+    EXPECT_EQ(id0, r0->id);
+    put(r0);
+
+    /* Should evict region 1 */
+    put(get(region_ptr(mem, MAX_REGIONS), size));
+    EXPECT_EQ(MAX_REGIONS, m_reg_count);
+
+    r0 = get(region_ptr(mem, 0), size);
+    EXPECT_EQ(id0, r0->id);
+    put(r0);
+
+    r1 = get(region_ptr(mem, 1), size);
+    EXPECT_NE(id1, r1->id);
+    put(r1);
+
+    munmap(mem, (MAX_REGIONS + 1) * 4 * size);
+}
+
+class test_rcache_async_dereg : public test_rcache {
+protected:
+    virtual ucs_rcache_params_t rcache_params() {
+        ucs_rcache_params_t params = test_rcache::rcache_params();
+        params.flags |= UCS_RCACHE_FLAG_ASYNC_DEREG |
+                        UCS_RCACHE_FLAG_MERGE_ADJACENT;
+        return params;
+    }
+
+    void wait_for_reg_count(uint32_t count) {
+        ucs_time_t deadline = ucs_get_time() + ucs_time_from_sec(10.0);
+        while ((m_reg_count != count) && (ucs_get_time() < deadline)) {
+            sched_yield();
+        }
+        EXPECT_EQ(count, m_reg_count);
+    }
+};
+
+UCS_MT_TEST_F(test_rcache_async_dereg, basic, 6) {
+    static const size_t size = 1 * 1024 * 1024;
+    void *ptr = malloc(size);
+    region *region = get(ptr, size);
+    put(region);
+    free(ptr);
+}
+
+UCS_TEST_F(test_rcache_async_dereg, unmap_dereg) {
+    static const size_t size = 64 * ucs_get_page_size();
+    void *mem1, *mem2;
+    region *r;
+
+    mem1 = alloc_pages(size, PROT_READ|PROT_WRITE);
+    put(get(mem1, size));
+    EXPECT_EQ(1u, m_reg_count);
+
+    /* Invalidation is detected on next access, deregistration is deferred */
+    munmap(mem1, size);
+    mem2 = alloc_pages(size, PROT_READ|PROT_WRITE);
+    r = get(mem2, size);
+    wait_for_reg_count(1);
+
+    put(r);
+    munmap(mem2, size);
+}
+
+UCS_TEST_F(test_rcache_async_dereg, merge_adjacent) {
+    const size_t size = 8 * ucs_get_page_size();
+    void *mem         = alloc_pages(2 * size, PROT_READ|PROT_WRITE);
+    region *r1, *r2;
+
+    r1 = get(mem, size);
+    put(r1);
+
+    /* Second region touches the first one, so they should be merged */
+    r2 = get((char*)mem + size, size);
+    EXPECT_EQ((uintptr_t)mem, r2->super.super.start);
+    EXPECT_EQ((uintptr_t)mem + 2 * size, r2->super.super.end);
+    wait_for_reg_count(1);
+
+    put(r2);
+    munmap(mem, 2 * size);
+}
+
 #if ENABLE_STATS
 class test_rcache_stats : public test_rcache {
 protected:
@@ -636,7 +818,7 @@ protected:
     /* a helper function for stats tests debugging */
     void dump_stats() {
         printf("gets %d hf %d hs %d misses %d merges %d unmaps %d"
-               " unmaps_inv %d puts %d regs %d deregs %d\n",
+               " unmaps_inv %d puts %d regs %d deregs %d evicts %d\n",
                get_counter(UCS_RCACHE_GETS),
                get_counter(UCS_RCACHE_HITS_FAST),
                get_counter(UCS_RCACHE_HITS_SLOW),
@@ -646,7 +828,8 @@ protected:
                get_counter(UCS_RCACHE_UNMAP_INVALIDATES),
                get_counter(UCS_RCACHE_PUTS),
                get_counter(UCS_RCACHE_REGS),
-               get_counter(UCS_RCACHE_DEREGS));
+               get_counter(UCS_RCACHE_DEREGS),
+               get_counter(UCS_RCACHE_EVICTS));
     }
 };
 
@@ -6,6 +6,7 @@
 
 #include <common/test.h>
 extern "C" {
+#include <ucs/arch/cpu.h>
 #include <ucs/sys/module.h>
 #include <ucs/sys/sys.h>
 #include <ucs/type/spinlock.h>
@@ -135,3 +136,26 @@ UCS_TEST_F(test_sys, memunits_to_str) {
     test_memunits(UCS_TBYTE, "1T");
     test_memunits(UCS_TBYTE * 1024, "1024T");
 }
+
+UCS_TEST_F(test_sys, memcpy_nontemporal) {
+    const size_t max_size = 64 * UCS_KBYTE;
+    std::vector<char> src(max_size + 64), dst(max_size + 64);
+
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = ucs::rand();
+    }
+
+    /* Check various sizes and misalignments of source and destination */
+    for (size_t size = 1; size <= max_size; size = size * 2 + 7) {
+        for (unsigned offset = 0; offset < 64; offset += 13) {
+            std::fill(dst.begin(), dst.end(), 0);
+            ucs_memcpy_nontemporal(&dst[offset], &src[64 - offset], size);
+            ASSERT_EQ(0, memcmp(&dst[offset], &src[64 - offset], size))
+                << "size=" << size << " offset=" << offset;
+            EXPECT_EQ(0, dst[offset + size]) << "size=" << size;
+            if (offset > 0) {
+                EXPECT_EQ(0, dst[offset - 1]) << "size=" << size;
+            }
+        }
+    }
+}